@@ -1,10 +1,24 @@
 #include <benchmark/benchmark.h>
 #include "core/PointCloud.h"
 #include "core/Octree.h"
+#include "core/LeafKernels.h"
+#include "core/KDTree.h"
+#include "core/MemoryPool.h"
 #include "processing/OutlierRemoval.h"
 #include "processing/VoxelDownsampling.h"
 #include "processing/Filters.h"
+#include "processing/NormalEstimation.h"
+#include "utils/TextParser.h"
+#include "utils/PointCache.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <cstdio>
+#include <cmath>
 #include <random>
+#include <sstream>
+#include <string>
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
 
 using namespace pcv;
 
@@ -35,22 +49,63 @@ static void BM_OctreeConstruction(benchmark::State& state) {
     auto cloud = generatePointCloud(state.range(0));
     
     for (auto _ : state) {
-        Octree octree(*cloud);
+        Octree octree(*cloud, static_cast<Octree::BuildMode>(state.range(1)));
         octree.build();
         benchmark::DoNotOptimize(octree.getMaxDepth());
     }
     
     state.SetItemsProcessed(state.iterations() * state.range(0));
 }
-BENCHMARK(BM_OctreeConstruction)->Range(1000, 1000000);
+BENCHMARK(BM_OctreeConstruction)
+    ->ArgsProduct({benchmark::CreateRange(1000, 1000000, 8), {Octree::MORTON, Octree::INSERTION}})
+    ->ArgNames({"points", "mode"});
 
-// Benchmark frustum culling
-static void BM_FrustumCulling(benchmark::State& state) {
+// Benchmark parallel Morton octree construction across thread counts
+static void BM_OctreeConstructionThreads(benchmark::State& state) {
+    auto cloud = generatePointCloud(state.range(0));
+    
+    for (auto _ : state) {
+        Octree octree(*cloud);
+        octree.setNumThreads(static_cast<int>(state.range(1)));
+        octree.build();
+        benchmark::DoNotOptimize(octree.getNodeCount());
+    }
+    
+    state.counters["threads"] = static_cast<double>(state.range(1));
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_OctreeConstructionThreads)
+    ->ArgsProduct({{10000000, 50000000}, {1, 2, 4, 8, 16, 32}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+// Benchmark incremental octree insertion of batches into an existing tree
+static void BM_OctreeIncrementalInsert(benchmark::State& state) {
     auto cloud = generatePointCloud(state.range(0));
+    auto batch = generatePointCloud(state.range(1));
     Octree octree(*cloud);
     octree.build();
     
-    // Create a frustum that captures about half the points
+    for (auto _ : state) {
+        state.PauseTiming();
+        size_t first = cloud->size();
+        for (size_t i = 0; i < batch->size(); ++i) {
+            cloud->addPoint(batch->getPosition(i), batch->getColor(i));
+        }
+        state.ResumeTiming();
+        
+        octree.insert(first, cloud->size());
+        benchmark::DoNotOptimize(octree.getNodeCount());
+    }
+    
+    state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+BENCHMARK(BM_OctreeIncrementalInsert)
+    ->ArgsProduct({{100000, 1000000}, {1000, 10000}})
+    ->ArgNames({"points", "batch"});
+
+// Frustum that captures the central part of a generated cloud
+static Octree::FrustumPlanes centralFrustum() {
     Octree::FrustumPlanes frustum;
     frustum[0] = glm::vec4(0, 0, 1, 5);    // Near
     frustum[1] = glm::vec4(0, 0, -1, 5);   // Far
@@ -58,6 +113,16 @@ static void BM_FrustumCulling(benchmark::State& state) {
     frustum[3] = glm::vec4(-1, 0, 0, 5);   // Right
     frustum[4] = glm::vec4(0, 1, 0, 5);    // Bottom
     frustum[5] = glm::vec4(0, -1, 0, 5);   // Top
+    return frustum;
+}
+
+// Benchmark frustum culling
+static void BM_FrustumCulling(benchmark::State& state) {
+    auto cloud = generatePointCloud(state.range(0));
+    Octree octree(*cloud);
+    octree.build();
+    
+    Octree::FrustumPlanes frustum = centralFrustum();
     
     for (auto _ : state) {
         auto results = octree.queryFrustum(frustum);
@@ -68,6 +133,43 @@ static void BM_FrustumCulling(benchmark::State& state) {
 }
 BENCHMARK(BM_FrustumCulling)->Range(1000, 1000000);
 
+// Benchmark frustum culling into a reused 32-bit buffer (no allocation per query)
+static void BM_FrustumCullingBuffer(benchmark::State& state) {
+    auto cloud = generatePointCloud(state.range(0));
+    Octree octree(*cloud);
+    octree.build();
+    
+    Octree::FrustumPlanes frustum = centralFrustum();
+    std::vector<uint32_t> results;
+    
+    for (auto _ : state) {
+        results.clear();
+        octree.queryFrustum(frustum, results);
+        benchmark::DoNotOptimize(results.data());
+    }
+    
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FrustumCullingBuffer)->Range(1000, 1000000);
+
+// Benchmark frustum culling through a visitor that only counts the matches
+static void BM_FrustumCullingVisitor(benchmark::State& state) {
+    auto cloud = generatePointCloud(state.range(0));
+    Octree octree(*cloud);
+    octree.build();
+    
+    Octree::FrustumPlanes frustum = centralFrustum();
+    
+    for (auto _ : state) {
+        size_t count = 0;
+        octree.visitFrustum(frustum, [&count](const uint32_t*, size_t run) { count += run; });
+        benchmark::DoNotOptimize(count);
+    }
+    
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FrustumCullingVisitor)->Range(1000, 1000000);
+
 // Benchmark radius query
 static void BM_RadiusQuery(benchmark::State& state) {
     auto cloud = generatePointCloud(state.range(0));
@@ -86,6 +188,66 @@ static void BM_RadiusQuery(benchmark::State& state) {
 }
 BENCHMARK(BM_RadiusQuery)->Range(1000, 1000000);
 
+// Benchmark box queries (boundary leaves go through the batched leaf kernels)
+static void BM_BoxQuery(benchmark::State& state) {
+    auto cloud = generatePointCloud(state.range(0));
+    Octree octree(*cloud);
+    octree.build();
+    
+    glm::vec3 min_bound(-3.3f, -4.1f, -2.7f);
+    glm::vec3 max_bound(5.9f, 4.3f, 6.1f);
+    
+    for (auto _ : state) {
+        auto results = octree.queryBox(min_bound, max_bound);
+        benchmark::DoNotOptimize(results.size());
+    }
+    
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetLabel(LeafKernels::getInstructionSet());
+}
+BENCHMARK(BM_BoxQuery)->Range(1000, 1000000);
+
+// Benchmark k-nearest neighbor queries
+static void BM_KNNQuery(benchmark::State& state) {
+    auto cloud = generatePointCloud(state.range(0));
+    KDTree tree(*cloud);
+    tree.build();
+    
+    std::vector<KDTree::Neighbor> neighbors;
+    size_t query_index = 0;
+    
+    for (auto _ : state) {
+        tree.knnSearch(cloud->getPosition(query_index), 20, neighbors);
+        benchmark::DoNotOptimize(neighbors.data());
+        query_index = (query_index + 1) % cloud->size();
+    }
+    
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_KNNQuery)->Range(1000, 1000000);
+
+// Benchmark rigid cloud transforms (one fused position and bounds pass, plus normals)
+static void BM_PointCloudTransform(benchmark::State& state) {
+    auto cloud = generatePointCloud(state.range(0));
+    if (state.range(1)) {
+        cloud->enableChannels(PointCloud::NORMAL);
+    }
+    glm::mat4 step = glm::rotate(glm::mat4(1.0f), 0.01f, glm::vec3(0.0f, 1.0f, 0.0f));
+    
+    for (auto _ : state) {
+        cloud->transform(step);
+        benchmark::DoNotOptimize(cloud->getMaxBound());
+    }
+    
+    state.SetLabel(LeafKernels::getInstructionSet());
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_PointCloudTransform)
+    ->ArgsProduct({benchmark::CreateRange(1000, 10000000, 10), {0, 1}})
+    ->ArgNames({"points", "normals"})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
 // Benchmark voxel downsampling
 static void BM_VoxelDownsampling(benchmark::State& state) {
     auto original_cloud = generatePointCloud(state.range(0));
@@ -101,7 +263,22 @@ static void BM_VoxelDownsampling(benchmark::State& state) {
     
     state.SetItemsProcessed(state.iterations() * state.range(0));
 }
-BENCHMARK(BM_VoxelDownsampling)->Range(1000, 100000);
+BENCHMARK(BM_VoxelDownsampling)->Range(1000, 10000000)->Unit(benchmark::kMillisecond);
+
+// Benchmark voxel counting (what getStatistics does on every load)
+static void BM_VoxelCount(benchmark::State& state) {
+    auto cloud = generatePointCloud(state.range(0));
+    
+    VoxelDownsampling::Parameters params;
+    params.leaf_size = 0.1f;
+    
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(VoxelDownsampling::countVoxels(*cloud, params));
+    }
+    
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_VoxelCount)->Range(1000, 10000000)->Unit(benchmark::kMillisecond);
 
 // Benchmark statistical outlier removal
 static void BM_StatisticalOutlierRemoval(benchmark::State& state) {
@@ -119,24 +296,115 @@ static void BM_StatisticalOutlierRemoval(benchmark::State& state) {
     
     state.SetItemsProcessed(state.iterations() * state.range(0));
 }
-BENCHMARK(BM_StatisticalOutlierRemoval)->Range(1000, 10000);
+BENCHMARK(BM_StatisticalOutlierRemoval)->Range(1000, 100000);
+
+// Benchmark outlier removal scaling across thread counts
+static void BM_OutlierRemovalThreads(benchmark::State& state) {
+    auto cloud = generatePointCloud(state.range(0));
+    
+    OutlierRemoval::StatisticalParams params;
+    params.k_neighbors = 20;
+    params.std_multiplier = 1.0f;
+    params.num_threads = static_cast<int>(state.range(1));
+    
+    for (auto _ : state) {
+        auto outliers = OutlierRemoval::findStatisticalOutliers(*cloud, params);
+        benchmark::DoNotOptimize(outliers.size());
+    }
+    
+    state.counters["threads"] = static_cast<double>(state.range(1));
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_OutlierRemovalThreads)
+    ->ArgsProduct({{100000, 1000000}, {1, 2, 4, 8, 16, 32}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+// Benchmark PCA normal estimation (k = 10) across thread counts
+static void BM_NormalEstimation(benchmark::State& state) {
+    auto cloud = generatePointCloud(state.range(0));
+    
+    NormalEstimation::Parameters params;
+    params.k_neighbors = 10;
+    params.num_threads = static_cast<int>(state.range(1));
+    
+    for (auto _ : state) {
+        NormalEstimation::compute(*cloud, params);
+        benchmark::DoNotOptimize(cloud->getNormals().data());
+    }
+    
+    state.counters["threads"] = static_cast<double>(state.range(1));
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_NormalEstimation)
+    ->ArgsProduct({{100000, 5000000}, {1, 8, 32}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+// Peak resident set size of the process so far, in MB (0 where unsupported).
+// The peak never drops, so run each pipeline benchmark in its own process
+// (--benchmark_filter) to compare them.
+static double peakRSSMegabytes() {
+#if defined(_WIN32)
+    return 0.0;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return usage.ru_maxrss / (1024.0 * 1024.0);   // Bytes
+#else
+    return usage.ru_maxrss / 1024.0;              // Kilobytes
+#endif
+#endif
+}
 
-// Benchmark filter pipeline
+// Benchmark filter pipeline (one shared tree, no whole-cloud copies)
 static void BM_FilterPipeline(benchmark::State& state) {
     auto original_cloud = generatePointCloud(state.range(0));
+    const PointCloud& input = *original_cloud;
     
     FilterPipeline pipeline;
     pipeline.addVoxelDownsampling(0.1f)
-            .addStatisticalOutlierRemoval(20, 1.0f);
+            .addStatisticalOutlierRemoval(20, 1.0f)
+            .addRadiusOutlierRemoval(0.3f, 4);
+    
+    for (auto _ : state) {
+        auto filtered = pipeline.apply(input);
+        benchmark::DoNotOptimize(filtered->size());
+    }
+    
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["peak_rss_mb"] = peakRSSMegabytes();
+}
+BENCHMARK(BM_FilterPipeline)->Range(1000, 1000000)->Unit(benchmark::kMillisecond);
+
+// The same stages run one by one, as the pipeline used to: copy the input, downsample
+// into a new cloud copied back, and build a tree per outlier stage
+static void BM_FilterPipelineStaged(benchmark::State& state) {
+    auto original_cloud = generatePointCloud(state.range(0));
+    
+    VoxelDownsampling::Parameters voxel_params;
+    voxel_params.leaf_size = 0.1f;
+    OutlierRemoval::StatisticalParams statistical_params;
+    statistical_params.k_neighbors = 20;
+    statistical_params.std_multiplier = 1.0f;
+    OutlierRemoval::RadiusParams radius_params;
+    radius_params.radius = 0.3f;
+    radius_params.min_neighbors = 4;
     
     for (auto _ : state) {
-        auto filtered = pipeline.apply(*original_cloud);
+        auto filtered = std::make_shared<PointCloud>(*original_cloud);
+        auto downsampled = VoxelDownsampling::createDownsampled(*filtered, voxel_params);
+        *filtered = *downsampled;
+        OutlierRemoval::removeStatisticalOutliers(*filtered, statistical_params);
+        OutlierRemoval::removeRadiusOutliers(*filtered, radius_params);
         benchmark::DoNotOptimize(filtered->size());
     }
     
     state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["peak_rss_mb"] = peakRSSMegabytes();
 }
-BENCHMARK(BM_FilterPipeline)->Range(1000, 50000);
+BENCHMARK(BM_FilterPipelineStaged)->Range(1000, 1000000)->Unit(benchmark::kMillisecond);
 
 // Benchmark memory allocation
 static void BM_PointCloudAllocation(benchmark::State& state) {
@@ -157,6 +425,100 @@ static void BM_PointCloudAllocation(benchmark::State& state) {
 }
 BENCHMARK(BM_PointCloudAllocation)->Range(1000, 100000);
 
+// Node-sized object for the allocator benchmarks
+struct PooledItem {
+    double values[8];
+};
+
+// Benchmark slab pool allocate/free bursts, with every thread sharing one pool
+static void BM_MemoryPool(benchmark::State& state) {
+    static MemoryPool<PooledItem> pool(4096);
+    std::vector<PooledItem*> items(256);
+    
+    for (auto _ : state) {
+        for (auto& item : items) {
+            item = pool.allocate();
+        }
+        benchmark::DoNotOptimize(items.data());
+        for (auto* item : items) {
+            pool.deallocate(item);
+        }
+    }
+    
+    state.SetItemsProcessed(state.iterations() * items.size());
+}
+BENCHMARK(BM_MemoryPool)->ThreadRange(1, 16)->UseRealTime();
+
+// Same bursts through operator new, for comparison
+static void BM_HeapAllocation(benchmark::State& state) {
+    std::vector<PooledItem*> items(256);
+    
+    for (auto _ : state) {
+        for (auto& item : items) {
+            item = new PooledItem;
+        }
+        benchmark::DoNotOptimize(items.data());
+        for (auto* item : items) {
+            delete item;
+        }
+    }
+    
+    state.SetItemsProcessed(state.iterations() * items.size());
+}
+BENCHMARK(BM_HeapAllocation)->ThreadRange(1, 16)->UseRealTime();
+
+// Benchmark ASCII XYZ RGB parsing across thread counts
+static void BM_TextParse(benchmark::State& state) {
+    auto cloud = generatePointCloud(state.range(0));
+    std::ostringstream text;
+    for (const auto& point : *cloud) {
+        text << point.position.x << " " << point.position.y << " " << point.position.z << " "
+             << point.color.r << " " << point.color.g << " " << point.color.b << "\n";
+    }
+    const std::string data = text.str();
+    
+    for (auto _ : state) {
+        PointCloud parsed;
+        TextParser::parse(data.data(), data.data() + data.size(), TextParser::xyzLayout(),
+                          parsed, static_cast<int>(state.range(1)));
+        benchmark::DoNotOptimize(parsed.size());
+    }
+    
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(data.size()));
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_TextParse)
+    ->ArgsProduct({{100000, 1000000}, {1, 4, 0}})
+    ->ArgNames({"points", "threads"})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+// Benchmark opening a binary point cache and restoring the cloud and its octree
+static void BM_CacheLoad(benchmark::State& state) {
+    auto cloud = generatePointCloud(state.range(0));
+    Octree octree(*cloud);
+    octree.build();
+    const std::string filename = "benchmark_cache.pcvc";
+    if (!PointCache::write(filename, *cloud, octree)) {
+        state.SkipWithError("Failed to write point cache");
+        return;
+    }
+    
+    for (auto _ : state) {
+        PointCache cache;
+        PointCloud loaded;
+        cache.open(filename);
+        cache.load(loaded);
+        Octree restored(loaded);
+        cache.loadOctree(restored);
+        benchmark::DoNotOptimize(restored.getNodeCount());
+    }
+    
+    std::remove(filename.c_str());
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CacheLoad)->Range(100000, 4000000)->UseRealTime()->Unit(benchmark::kMillisecond);
+
 // Benchmark LOD query
 static void BM_LODQuery(benchmark::State& state) {
     auto cloud = generatePointCloud(state.range(0));
@@ -173,13 +535,57 @@ static void BM_LODQuery(benchmark::State& state) {
     frustum[4] = glm::vec4(0, 0.894f, -0.447f, 0);   // Bottom
     frustum[5] = glm::vec4(0, -0.894f, 0.447f, 0);   // Top
     
+    // 1080p viewport with a 45 degree vertical field of view
+    Octree::LODParameters lod_params;
+    lod_params.projection_scale = 540.0f / std::tan(glm::radians(22.5f));
+    
     for (auto _ : state) {
-        auto results = octree.queryLOD(view_position, frustum, 10.0f);
+        auto results = octree.queryLOD(view_position, frustum, lod_params);
         benchmark::DoNotOptimize(results.size());
     }
     
+    state.counters["points"] = static_cast<double>(octree.queryLOD(view_position, frustum, lod_params).size());
     state.SetItemsProcessed(state.iterations() * state.range(0));
 }
-BENCHMARK(BM_LODQuery)->Range(10000, 1000000);
+BENCHMARK(BM_LODQuery)->Range(10000, 10000000);
+
+// Benchmark budget-limited LOD span selection (range(1) = point budget)
+static void BM_LODQueryBudget(benchmark::State& state) {
+    auto cloud = generatePointCloud(state.range(0));
+    Octree octree(*cloud);
+    octree.build();
+    
+    glm::vec3 view_position(15.0f, 15.0f, 15.0f);
+    Octree::FrustumPlanes frustum;
+    frustum[0] = glm::vec4(0.707f, 0, 0.707f, 0);
+    frustum[1] = glm::vec4(-0.707f, 0, -0.707f, 30);
+    frustum[2] = glm::vec4(0.894f, 0, -0.447f, 0);
+    frustum[3] = glm::vec4(-0.894f, 0, 0.447f, 0);
+    frustum[4] = glm::vec4(0, 0.894f, -0.447f, 0);
+    frustum[5] = glm::vec4(0, -0.894f, 0.447f, 0);
+    
+    Octree::LODParameters lod_params;
+    lod_params.projection_scale = 540.0f / std::tan(glm::radians(22.5f));
+    lod_params.pixel_threshold = 0.5f;
+    lod_params.point_budget = static_cast<size_t>(state.range(1));
+    
+    std::vector<Octree::Span> spans;
+    for (auto _ : state) {
+        spans.clear();
+        octree.queryLODSpans(view_position, frustum, lod_params, spans);
+        benchmark::DoNotOptimize(spans.data());
+    }
+    
+    size_t points = 0;
+    for (const auto& span : spans) {
+        points += span.end - span.begin;
+    }
+    state.counters["points"] = static_cast<double>(points);
+    state.counters["spans"] = static_cast<double>(spans.size());
+}
+BENCHMARK(BM_LODQueryBudget)
+    ->ArgsProduct({{1000000, 10000000}, {0, 100000, 1000000}})
+    ->ArgNames({"points", "budget"})
+    ->Unit(benchmark::kMicrosecond);
 
 BENCHMARK_MAIN();
\ No newline at end of file
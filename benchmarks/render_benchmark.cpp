@@ -0,0 +1,414 @@
+// Headless frame benchmark: renders each dataset along a camera path in a hidden
+// window and writes frame-time percentiles, points drawn, upload bytes and peak memory
+// as JSON. Needs a GL 3.3 context (a display, or e.g. xvfb-run on CI machines).
+//
+// render_benchmark [--frames N] [--warmup N] [--path file.path] [--size W H]
+//                  [--async-culling] [--gpu-culling] [--edl] [--frame-reuse] [--quantize] [--point-budget N]
+//                  [--tiles N] [--out results.json]
+//                  [dataset ...]
+//
+// Without datasets a generated 1M-point cloud is used; without --path the camera orbits
+// the cloud for 600 frames. Paths recorded with PointCloudViewer --record-path replay
+// frame by frame, once through unless --frames says otherwise.
+// --tiles cuts each dataset into N slabs along x and renders them as one scene.
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+#include "core/Octree.h"
+#include "core/PointCloud.h"
+#include "rendering/Camera.h"
+#include "rendering/CameraPath.h"
+#include "rendering/Renderer.h"
+#include "utils/FileIO.h"
+#include "utils/Profiler.h"
+#include "utils/Timer.h"
+
+using namespace pcv;
+
+namespace {
+
+constexpr size_t ORBIT_FRAMES = 600;
+
+struct Options {
+    size_t frames = 0;   // 0 = the path's length, or ORBIT_FRAMES for the orbit
+    size_t warmup = 60;
+    int width = 1920;
+    int height = 1080;
+    bool async_culling = false;
+    bool gpu_culling = false;
+    bool edl = false;
+    bool frame_reuse = false;
+    bool quantize = false;
+    size_t point_budget = 0;
+    size_t tiles = 1;
+    std::string path_file;
+    std::string out_file;
+    std::vector<std::string> datasets;
+};
+
+struct Range {
+    double mean = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+};
+
+// Peak resident set size of the process so far
+size_t peakMemoryBytes() {
+#if defined(__APPLE__)
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<size_t>(usage.ru_maxrss);            // Bytes
+#elif defined(__unix__)
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;     // Kilobytes
+#else
+    return 0;
+#endif
+}
+
+std::string escapeJSON(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') escaped += '\\';
+        if (static_cast<unsigned char>(c) >= 0x20) escaped += c;
+    }
+    return escaped;
+}
+
+template<typename T>
+Range summarize(const std::vector<T>& values) {
+    Range range;
+    if (values.empty()) return range;
+    range.min = static_cast<double>(*std::min_element(values.begin(), values.end()));
+    range.max = static_cast<double>(*std::max_element(values.begin(), values.end()));
+    for (T value : values) {
+        range.mean += static_cast<double>(value);
+    }
+    range.mean /= values.size();
+    return range;
+}
+
+// Same shape as benchmark_rendering's generator, fixed seed
+PointCloud::Ptr generateCloud(size_t num_points) {
+    auto cloud = std::make_shared<PointCloud>();
+    cloud->reserve(num_points);
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> pos(-10.0f, 10.0f);
+    std::uniform_real_distribution<float> col(0.0f, 1.0f);
+    for (size_t i = 0; i < num_points; ++i) {
+        cloud->addPoint(glm::vec3(pos(gen), pos(gen), pos(gen)), glm::vec3(col(gen), col(gen), col(gen)));
+    }
+    return cloud;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--frames" && i + 1 < argc) {
+            options.frames = std::max<size_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else if (arg == "--warmup" && i + 1 < argc) {
+            options.warmup = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--size" && i + 2 < argc) {
+            options.width = std::max(std::atoi(argv[++i]), 1);
+            options.height = std::max(std::atoi(argv[++i]), 1);
+        } else if (arg == "--path" && i + 1 < argc) {
+            options.path_file = argv[++i];
+        } else if (arg == "--out" && i + 1 < argc) {
+            options.out_file = argv[++i];
+        } else if (arg == "--point-budget" && i + 1 < argc) {
+            options.point_budget = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--tiles" && i + 1 < argc) {
+            options.tiles = std::min<size_t>(std::max<size_t>(std::strtoull(argv[++i], nullptr, 10), 1),
+                                             Renderer::MAX_TILES);
+        } else if (arg == "--async-culling") {
+            options.async_culling = true;
+        } else if (arg == "--gpu-culling") {
+            options.gpu_culling = true;
+        } else if (arg == "--edl") {
+            options.edl = true;
+        } else if (arg == "--frame-reuse") {
+            options.frame_reuse = true;
+        } else if (arg == "--quantize") {
+            options.quantize = true;
+        } else if (!arg.empty() && arg[0] == '-') {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return false;
+        } else {
+            options.datasets.push_back(arg);
+        }
+    }
+    return true;
+}
+
+// Slabs of equal width along x, each moved to its own origin with a transform back
+void splitIntoTiles(const PointCloud& cloud, size_t tiles, std::vector<std::unique_ptr<PointCloud>>& clouds,
+                    std::vector<glm::mat4>& transforms) {
+    const float min_x = cloud.getMinBound().x;
+    const float width = std::max(cloud.getMaxBound().x - min_x, 1e-6f);
+    std::vector<uint8_t> keep(cloud.size());
+    for (size_t tile = 0; tile < tiles; ++tile) {
+        for (size_t i = 0; i < cloud.size(); ++i) {
+            size_t slab = static_cast<size_t>((cloud.getPosition(i).x - min_x) / width * tiles);
+            keep[i] = std::min(slab, tiles - 1) == tile;
+        }
+        auto tile_cloud = std::make_unique<PointCloud>();
+        cloud.extract(keep, *tile_cloud);
+        if (tile_cloud->empty()) continue;
+        
+        glm::vec3 origin = tile_cloud->getMinBound();
+        tile_cloud->transform(glm::translate(glm::mat4(1.0f), -origin));
+        transforms.push_back(glm::translate(glm::mat4(1.0f), origin));
+        clouds.push_back(std::move(tile_cloud));
+    }
+}
+
+// Render one dataset along the path and append its JSON object to out
+bool runDataset(const std::string& name, const PointCloud& cloud, float load_ms, const Options& options,
+                const CameraPath& recorded_path, GLFWwindow* window, std::ostringstream& out) {
+    Timer build_timer;
+    Octree octree(cloud);
+    std::vector<std::unique_ptr<PointCloud>> tile_clouds;
+    std::vector<std::unique_ptr<Octree>> tile_octrees;
+    std::vector<glm::mat4> tile_transforms;
+    size_t octree_nodes = 0;
+    if (options.tiles > 1) {
+        splitIntoTiles(cloud, options.tiles, tile_clouds, tile_transforms);
+        for (const auto& tile_cloud : tile_clouds) {
+            tile_octrees.push_back(std::make_unique<Octree>(*tile_cloud));
+            tile_octrees.back()->build();
+            octree_nodes += tile_octrees.back()->getNodeCount();
+        }
+    } else {
+        octree.build();
+        octree_nodes = octree.getNodeCount();
+    }
+    float build_ms = build_timer.elapsed();
+    
+    glm::vec3 center = (cloud.getMinBound() + cloud.getMaxBound()) * 0.5f;
+    float radius = glm::length(cloud.getMaxBound() - cloud.getMinBound()) * 0.75f;
+    
+    CameraPath path = recorded_path;
+    if (path.empty()) {
+        path = CameraPath::orbit(center, radius, radius * 0.3f, options.frames);
+    }
+    
+    Camera camera;
+    camera.setPerspective(45.0f, static_cast<float>(options.width) / options.height, 0.1f, radius * 4.0f);
+    
+    Profiler::Parameters profiler_params;
+    profiler_params.history_frames = options.frames;
+    profiler_params.max_events = 1;
+    Profiler profiler(profiler_params);
+    
+    std::vector<size_t> points_drawn;
+    size_t upload_total = 0;
+    size_t upload_first = 0;
+    {
+        // A fresh renderer per dataset so every run starts with the same uploads
+        Renderer renderer(options.width, options.height);
+        if (!renderer.initialize()) return false;
+        renderer.resize(options.width, options.height);
+        renderer.enableGPUCulling(options.gpu_culling && renderer.isGPUCullingSupported());
+        renderer.enableAsyncCulling(options.async_culling);
+        renderer.setShading(options.edl ? Renderer::Shading::EDL : Renderer::Shading::BASIC);
+        renderer.enableFrameReuse(options.frame_reuse);
+        renderer.enablePositionQuantization(options.quantize);
+        renderer.setPointBudget(options.point_budget);
+        renderer.setProfiler(&profiler);
+        for (size_t tile = 0; tile < tile_clouds.size(); ++tile) {
+            renderer.addTile(*tile_clouds[tile], tile_octrees[tile].get(), tile_transforms[tile]);
+        }
+        
+        for (size_t frame = 0; frame < options.warmup + options.frames; ++frame) {
+            if (frame == options.warmup) {
+                profiler.clear();
+            }
+            profiler.beginFrame();
+            path.apply(frame < options.warmup ? 0 : frame - options.warmup, camera);
+            if (tile_clouds.empty()) {
+                renderer.renderWithOctree(cloud, octree, camera);
+            } else {
+                renderer.renderScene(camera);
+            }
+            {
+                ScopedTimer stage(&profiler, "swap");
+                glfwSwapBuffers(window);
+            }
+            glfwPollEvents();
+            
+            const RenderStatistics& stats = renderer.getStatistics();
+            if (frame == 0) {
+                upload_first = stats.uploaded_bytes;
+            }
+            upload_total += stats.uploaded_bytes;
+            if (frame >= options.warmup) {
+                points_drawn.push_back(stats.points_rendered);
+            }
+        }
+        
+        // The last frame's interval and queries are only seen by another begin
+        renderer.waitForCulling();
+        glFinish();
+        profiler.beginFrame();
+        renderer.setProfiler(nullptr);
+        renderer.shutdown();
+    }
+    
+    Range drawn = summarize(points_drawn);
+    std::vector<Profiler::StageSummary> stages = profiler.getSummary();
+    auto stageOf = [&stages](const char* stage_name, Profiler::Domain domain) {
+        for (const auto& stage : stages) {
+            if (stage.name == stage_name && stage.domain == domain) return stage;
+        }
+        return Profiler::StageSummary();
+    };
+    auto writeTimes = [&out](const Profiler::StageSummary& stage) {
+        out << "{\"mean\": " << stage.mean_ms << ", \"p50\": " << stage.p50_ms << ", \"p95\": " << stage.p95_ms
+            << ", \"p99\": " << stage.p99_ms << ", \"samples\": " << stage.samples << "}";
+    };
+    
+    out << "    {\n";
+    out << "      \"dataset\": \"" << escapeJSON(name) << "\",\n";
+    out << "      \"points\": " << cloud.size() << ",\n";
+    out << "      \"load_ms\": " << load_ms << ",\n";
+    out << "      \"octree_build_ms\": " << build_ms << ",\n";
+    out << "      \"tiles\": " << std::max<size_t>(tile_clouds.size(), 1) << ",\n";
+    out << "      \"octree_nodes\": " << octree_nodes << ",\n";
+    out << "      \"frames\": " << options.frames << ",\n";
+    out << "      \"frame_ms\": ";
+    writeTimes(stageOf("frame", Profiler::Domain::CPU));
+    out << ",\n      \"gpu_draw_ms\": ";
+    writeTimes(stageOf("draw", Profiler::Domain::GPU));
+    out << ",\n      \"points_drawn\": {\"mean\": " << drawn.mean << ", \"min\": " << drawn.min
+        << ", \"max\": " << drawn.max << "},\n";
+    out << "      \"upload_bytes\": {\"total\": " << upload_total << ", \"first_frame\": " << upload_first << "},\n";
+    out << "      \"peak_memory_bytes\": " << peakMemoryBytes() << ",\n";
+    out << "      \"stages\": [";
+    for (size_t i = 0; i < stages.size(); ++i) {
+        out << (i ? ",\n" : "\n") << "        {\"name\": \"" << escapeJSON(stages[i].name) << "\", \"domain\": \""
+            << (stages[i].domain == Profiler::Domain::GPU ? "gpu" : "cpu") << "\", \"times\": ";
+        writeTimes(stages[i]);
+        out << "}";
+    }
+    out << "\n      ]\n    }";
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) return 1;
+    
+    // Frames past the end of a recorded path would all repeat its last pose (and be
+    // reused whole with --frame-reuse), so by default the path plays exactly once
+    CameraPath recorded_path;
+    if (!options.path_file.empty() && !recorded_path.load(options.path_file)) return 1;
+    if (options.frames == 0) {
+        options.frames = recorded_path.empty() ? ORBIT_FRAMES : recorded_path.size();
+    }
+    
+    if (!glfwInit()) {
+        std::cerr << "Failed to initialize GLFW" << std::endl;
+        return 1;
+    }
+    
+    // Hidden window: a real default framebuffer without anything on screen
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, options.gpu_culling ? 4 : 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    GLFWwindow* window = glfwCreateWindow(options.width, options.height, "render_benchmark", nullptr, nullptr);
+    if (!window) {
+        std::cerr << "Failed to create an OpenGL context" << std::endl;
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);   // Measure the renderer, not the display refresh
+    
+    const GLubyte* gl_renderer = glGetString(GL_RENDERER);
+    const GLubyte* gl_version = glGetString(GL_VERSION);
+    
+    // Shaders are loaded relative to the working directory
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3);
+    out << "{\n";
+    out << "  \"config\": {\"frames\": " << options.frames << ", \"warmup\": " << options.warmup
+        << ", \"width\": " << options.width << ", \"height\": " << options.height
+        << ", \"async_culling\": " << (options.async_culling ? "true" : "false")
+        << ", \"gpu_culling\": " << (options.gpu_culling ? "true" : "false")
+        << ", \"edl\": " << (options.edl ? "true" : "false")
+        << ", \"frame_reuse\": " << (options.frame_reuse ? "true" : "false")
+        << ", \"quantize\": " << (options.quantize ? "true" : "false")
+        << ", \"point_budget\": " << options.point_budget
+        << ", \"tiles\": " << options.tiles
+        << ", \"path\": \"" << escapeJSON(options.path_file.empty() ? "orbit" : options.path_file) << "\""
+        << ", \"hardware_threads\": " << std::thread::hardware_concurrency()
+        << ", \"gl_renderer\": \"" << escapeJSON(gl_renderer ? reinterpret_cast<const char*>(gl_renderer) : "")
+        << "\", \"gl_version\": \"" << escapeJSON(gl_version ? reinterpret_cast<const char*>(gl_version) : "")
+        << "\"},\n";
+    
+    bool ok = true;
+    std::vector<std::string> datasets = options.datasets;
+    if (datasets.empty()) {
+        datasets.push_back("");
+    }
+    out << "  \"results\": [\n";
+    for (size_t i = 0; i < datasets.size() && ok; ++i) {
+        Timer load_timer;
+        PointCloud::Ptr cloud;
+        std::string name = datasets[i];
+        if (name.empty()) {
+            name = "generated_1000000";
+            cloud = generateCloud(1000000);
+        } else {
+            cloud = std::make_shared<PointCloud>();
+            if (!FileIO::load(name, *cloud) || cloud->empty()) {
+                std::cerr << "Failed to load " << name << std::endl;
+                ok = false;
+                break;
+            }
+        }
+        float load_ms = load_timer.elapsed();
+        
+        if (i > 0) out << ",\n";
+        std::cerr << "Rendering " << name << " (" << cloud->size() << " points)" << std::endl;
+        ok = runDataset(name, *cloud, load_ms, options, recorded_path, window, out);
+    }
+    out << "\n  ]\n}\n";
+    
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    if (!ok) return 1;
+    
+    if (options.out_file.empty()) {
+        std::cout << out.str();
+    } else {
+        std::ofstream file(options.out_file);
+        file << out.str();
+        if (!file.good()) {
+            std::cerr << "Failed to write " << options.out_file << std::endl;
+            return 1;
+        }
+        std::cerr << "Results written to " << options.out_file << std::endl;
+    }
+    return 0;
+}
\ No newline at end of file
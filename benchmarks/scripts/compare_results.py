@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+"""Compare two benchmark result directories from run_benchmarks.sh.
+
+Exits with status 1 when any micro-benchmark time or per-dataset frame time
+percentile regressed by more than the threshold.
+"""
+import argparse
+import json
+import os
+import sys
+
+
+def load(path):
+    if not os.path.exists(path):
+        return None
+    with open(path) as f:
+        return json.load(f)
+
+
+def micro_times(results):
+    times = {}
+    for bench in results.get("benchmarks", []):
+        if bench.get("run_type", "iteration") == "iteration":
+            times[bench["name"]] = bench["real_time"]
+    return times
+
+
+def frame_times(results):
+    times = {}
+    for dataset in results.get("results", []):
+        name = os.path.basename(dataset["dataset"])
+        for percentile in ("p50", "p95", "p99"):
+            times[f"{name} frame {percentile}"] = dataset["frame_ms"][percentile]
+    return times
+
+
+def compare(label, base, current, threshold):
+    regressions = 0
+    for name, base_time in sorted(base.items()):
+        if name not in current or base_time <= 0:
+            continue
+        change = current[name] / base_time - 1.0
+        flag = ""
+        if change > threshold:
+            flag = "  REGRESSION"
+            regressions += 1
+        print(f"{label:6} {name:60} {base_time:12.3f} {current[name]:12.3f} {change:+8.1%}{flag}")
+    return regressions
+
+
+parser = argparse.ArgumentParser(description=__doc__)
+parser.add_argument("baseline", help="results directory of the reference run")
+parser.add_argument("current", help="results directory of the run to check")
+parser.add_argument("--threshold", type=float, default=0.10, help="allowed slowdown (default 0.10)")
+args = parser.parse_args()
+
+regressions = 0
+for filename, label, extract in (("micro.json", "micro", micro_times), ("render.json", "render", frame_times)):
+    base = load(os.path.join(args.baseline, filename))
+    current = load(os.path.join(args.current, filename))
+    if base is None or current is None:
+        print(f"{filename}: missing in one of the runs, skipped")
+        continue
+    regressions += compare(label, extract(base), extract(current), args.threshold)
+
+print(f"\n{regressions} regression(s) above {args.threshold:.0%}")
+sys.exit(1 if regressions else 0)
@@ -1,4 +1,6 @@
 #!/usr/bin/env python3
+import argparse
+import os
 import numpy as np
 import time
 
@@ -60,19 +62,25 @@ def generate_point_cloud(filename, num_points):
     return elapsed
 
 # Test different sizes
-sizes = [10_000, 50_000, 100_000, 250_000, 500_000, 1_000_000, 2_000_000]
+parser = argparse.ArgumentParser(description="Generate XYZ RGB test point clouds")
+parser.add_argument("sizes", nargs="*", type=int,
+                    default=[10_000, 50_000, 100_000, 250_000, 500_000, 1_000_000, 2_000_000],
+                    help="point counts to generate")
+parser.add_argument("--out", default="test_data", help="output directory")
+args = parser.parse_args()
+os.makedirs(args.out, exist_ok=True)
 
 print("3D Point Cloud Viewer - Test Data Generator")
 print("=" * 50)
 print()
 
 total_time = 0
-for size in sizes:
-    filename = f"test_data/test_{size}.xyz"
+for size in args.sizes:
+    filename = os.path.join(args.out, f"test_{size}.xyz")
     elapsed = generate_point_cloud(filename, size)
     total_time += elapsed
     file_size_mb = size * 6 * 4 / (1024 * 1024)  # Approximate
     print(f"  File size: ~{file_size_mb:.1f} MB")
 
 print(f"\nTotal generation time: {total_time:.2f}s")
-print("\nTest files created in test_data/")
+print(f"\nTest files created in {args.out}/")
@@ -0,0 +1,57 @@
+#!/bin/bash
+# Non-interactive benchmark run for CI. Expects a build configured with
+# -DBUILD_BENCHMARKS=ON in ./build and writes JSON results to ./benchmark_results.
+#
+# Usage: benchmarks/scripts/run_benchmarks.sh [build_dir] [results_dir]
+# Compare two runs with benchmarks/scripts/compare_results.py.
+
+set -e
+
+ROOT="$(cd "$(dirname "$0")/../.." && pwd)"
+BUILD_DIR="$(cd "${1:-$ROOT/build}" && pwd)"
+mkdir -p "${2:-$ROOT/benchmark_results}"
+RESULTS_DIR="$(cd "${2:-$ROOT/benchmark_results}" && pwd)"
+DATA_DIR="$ROOT/test_data"
+SIZES="100000 1000000"
+
+
+# Datasets from the generator, created once
+MISSING=""
+for points in $SIZES; do
+    [ -f "$DATA_DIR/test_${points}.xyz" ] || MISSING="$MISSING $points"
+done
+if [ -n "$MISSING" ]; then
+    python3 "$ROOT/benchmarks/scripts/generate_test_data.py" $MISSING --out "$DATA_DIR"
+fi
+
+# CI-sized micro-benchmarks: only cases whose every argument is at most 1M. This
+# drops the 10M/50M thread sweeps and the other multi-GB cases; run benchmark_rendering
+# without a filter (or set BENCHMARK_FILTER=.) for the full set.
+CI_FILTER='^BM_[A-Za-z]+(/([a-z_]+:)?([0-9]{1,6}|1000000))*(/threads:[0-9]+)?(/real_time)?$'
+FILTER="${BENCHMARK_FILTER:-$CI_FILTER}"
+
+echo "Micro-benchmarks"
+"$BUILD_DIR/benchmarks/benchmark_rendering" --benchmark_filter="$FILTER" \
+    --benchmark_out="$RESULTS_DIR/micro.json" --benchmark_out_format=json
+
+echo "Octree construction"
+"$BUILD_DIR/benchmarks/octree_timing" | tee "$RESULTS_DIR/octree_timing.txt"
+
+# The frame benchmark needs a GL context; use a virtual display when there is none
+RUN=()
+if [ "$(uname -s)" != "Darwin" ] && [ -z "$DISPLAY" ] && [ -z "$WAYLAND_DISPLAY" ]; then
+    if command -v xvfb-run > /dev/null; then
+        RUN=(xvfb-run -a -s "-screen 0 1920x1080x24")
+    else
+        echo "No display and no xvfb-run - skipping render_benchmark"
+        exit 0
+    fi
+fi
+
+echo "Frame benchmark"
+DATASETS=()
+for points in $SIZES; do
+    DATASETS+=("$DATA_DIR/test_${points}.xyz")
+done
+cd "$BUILD_DIR"
+"${RUN[@]}" ./render_benchmark --frames 600 --out "$RESULTS_DIR/render.json" "${DATASETS[@]}"
@@ -4,9 +4,15 @@ echo "3D Point Cloud Viewer - Performance Benchmark"
 echo "============================================="
 echo
 echo "System Info:"
-echo "- OS: $(sw_vers -productName) $(sw_vers -productVersion)"
-echo "- CPU: $(sysctl -n machdep.cpu.brand_string)"
-echo "- Memory: $(( $(sysctl -n hw.memsize) / 1024 / 1024 / 1024 )) GB"
+if [ "$(uname -s)" = "Darwin" ]; then
+    echo "- OS: $(sw_vers -productName) $(sw_vers -productVersion)"
+    echo "- CPU: $(sysctl -n machdep.cpu.brand_string)"
+    echo "- Memory: $(( $(sysctl -n hw.memsize) / 1024 / 1024 / 1024 )) GB"
+else
+    echo "- OS: $(uname -sr)"
+    echo "- CPU: $(grep -m1 'model name' /proc/cpuinfo | cut -d: -f2 | sed 's/^ *//') ($(nproc) threads)"
+    echo "- Memory: $(( $(grep MemTotal /proc/meminfo | awk '{print $2}') / 1024 / 1024 )) GB"
+fi
 echo
 echo "Instructions:"
 echo "1. For each test, the viewer will open"
@@ -18,7 +24,7 @@ echo
 echo "Press Enter to begin..."
 read
 
-cd build
+cd "$(dirname "$0")/../../build" || exit 1
 
 # Test each file
 for points in 10000 50000 100000 250000 500000 1000000 2000000; do
@@ -0,0 +1,91 @@
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "core/Octree.h"
+
+using namespace pcv;
+
+// Points of the original cloud in a LOD query; they are the first original_count indices
+static size_t countOriginal(const Octree& octree, size_t original_count, const glm::vec3& view_position) {
+    Octree::FrustumPlanes frustum;
+    frustum.fill(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)); // Everything inside
+    
+    Octree::LODParameters lod_params;
+    lod_params.projection_scale = 540.0f / std::tan(glm::radians(22.5f));
+    
+    std::vector<uint32_t> results;
+    octree.queryLOD(view_position, frustum, lod_params, results);
+    size_t count = 0;
+    for (uint32_t idx : results) {
+        if (idx < original_count) count++;
+    }
+    return count;
+}
+
+// Interior nodes that hold points but no LOD samples
+static size_t countUnsampled(const Octree& octree) {
+    size_t count = 0;
+    for (const auto& node : octree.getNodes()) {
+        if (!node.isLeaf() && node.point_count > 0 && node.sample_begin == node.sample_end) count++;
+    }
+    return count;
+}
+
+// Inserts batches that need several root doublings and checks that the LOD levels
+// above the old root still represent the points it held, as a rebuilt tree does
+int main() {
+    std::cout << "Octree LOD Insert Check\n";
+    std::cout << "=======================\n\n";
+    
+    const size_t original_count = 5000;
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    
+    int failures = 0;
+    for (float offset : {20.0f, -50.0f, 1000.0f}) {
+        PointCloud cloud;
+        cloud.reserve(2 * original_count);
+        for (size_t i = 0; i < original_count; ++i) {
+            cloud.addPoint(glm::vec3(unit(gen), unit(gen), unit(gen)));
+        }
+        Octree octree(cloud);
+        octree.build();
+        
+        // A batch far outside the root's bounds
+        for (size_t i = 0; i < original_count; ++i) {
+            cloud.addPoint(glm::vec3(offset + unit(gen), unit(gen), unit(gen)));
+        }
+        octree.insert(original_count, cloud.size());
+        
+        Octree rebuilt(cloud);
+        rebuilt.build();
+        
+        size_t unsampled = countUnsampled(octree);
+        if (unsampled > 0) {
+            std::cerr << "offset " << offset << ": " << unsampled << " interior nodes without samples\n";
+            ++failures;
+        }
+        
+        // Zoomed out in proportion to the combined extent
+        for (float distance : {200.0f, 1000.0f, 5000.0f}) {
+            glm::vec3 view_position(0.5f * offset, 0.5f, distance * std::abs(offset) / 20.0f);
+            size_t inserted = countOriginal(octree, original_count, view_position);
+            size_t expected = countOriginal(rebuilt, original_count, view_position);
+            std::cout << "offset " << offset << ", distance " << view_position.z << ": " << inserted
+                      << " original points (rebuilt: " << expected << ")\n";
+            if (expected > 0 && inserted == 0) {
+                std::cerr << "offset " << offset << ": the original points vanish from the LOD\n";
+                ++failures;
+            }
+        }
+    }
+    
+    if (failures > 0) {
+        std::cout << "\n" << failures << " failures\n";
+        return 1;
+    }
+    std::cout << "\nInserted trees keep their LOD coverage\n";
+    return 0;
+}
\ No newline at end of file
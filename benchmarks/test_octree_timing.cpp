@@ -1,39 +1,74 @@
-#include <iostream>
+#include <algorithm>
 #include <chrono>
-#include <vector>
-#include <random>
 #include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "core/Octree.h"
+#include "core/PointCloud.h"
+
+using namespace pcv;
+
+// Best of a few runs, in milliseconds
+template<typename Fn>
+double bestOf(int runs, Fn fn) {
+    double best = 0.0;
+    for (int run = 0; run < runs; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto end = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(end - start).count();
+        best = run == 0 ? ms : std::min(best, ms);
+    }
+    return best;
+}
 
 int main() {
     std::cout << "Octree Construction Timing Test\n";
     std::cout << "==============================\n\n";
+    std::cout << std::setw(10) << "points" << std::setw(12) << "morton" << std::setw(12) << "serial"
+              << std::setw(12) << "insertion" << std::setw(12) << "insert 10%" << "   (ms, best of 3)\n";
     
     std::vector<size_t> sizes = {10000, 100000, 1000000};
     
     for (auto size : sizes) {
-        // Simulate octree construction
-        std::vector<float> points(size * 3);
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_real_distribution<> dis(-10.0, 10.0);
-        
-        // Generate points
-        for (size_t i = 0; i < size * 3; ++i) {
-            points[i] = dis(gen);
+        // Fixed seed so runs are comparable
+        PointCloud cloud;
+        cloud.reserve(size + size / 10);
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<float> dis(-10.0f, 10.0f);
+        for (size_t i = 0; i < size; ++i) {
+            cloud.addPoint(glm::vec3(dis(gen), dis(gen), dis(gen)));
         }
         
-        // Time "octree construction" (simplified)
-        auto start = std::chrono::high_resolution_clock::now();
+        double morton = bestOf(3, [&cloud]() {
+            Octree octree(cloud, Octree::MORTON);
+            octree.build();
+        });
+        double serial = bestOf(3, [&cloud]() {
+            Octree octree(cloud, Octree::MORTON);
+            octree.setNumThreads(1);
+            octree.build();
+        });
+        double insertion = bestOf(3, [&cloud]() {
+            Octree octree(cloud, Octree::INSERTION);
+            octree.build();
+        });
         
-        // Simulate spatial indexing
-        std::sort(points.begin(), points.end());
-        
-        auto end = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+        // Streaming a further 10% into a built tree
+        Octree octree(cloud);
+        octree.build();
+        size_t first = cloud.size();
+        for (size_t i = 0; i < size / 10; ++i) {
+            cloud.addPoint(glm::vec3(dis(gen), dis(gen), dis(gen)));
+        }
+        double insert = bestOf(1, [&]() { octree.insert(first, cloud.size()); });
         
-        std::cout << std::setw(10) << size << " points: " 
-                  << std::setw(6) << duration.count() << " ms\n";
+        std::cout << std::fixed << std::setprecision(2)
+                  << std::setw(10) << size << std::setw(12) << morton << std::setw(12) << serial
+                  << std::setw(12) << insertion << std::setw(12) << insert << "\n";
     }
     
     return 0;
-}
+}
\ No newline at end of file
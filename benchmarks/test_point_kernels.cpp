@@ -0,0 +1,100 @@
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "core/PointKernels.h"
+
+using namespace pcv;
+
+// Compares the bulk kernels against the scalar glm loops they replaced, across sizes
+// around the block and task boundaries and with serial, default and odd thread counts.
+// Positions and bounds must match exactly; normals within one step of the encoding.
+int main() {
+    std::cout << "Point Kernel Check\n";
+    std::cout << "==================\n\n";
+    
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> dis(-100.0f, 100.0f);
+    
+    glm::mat4 transformation = glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 2.0f, 3.0f));
+    transformation = glm::rotate(transformation, 0.7f, glm::normalize(glm::vec3(1.0f, 2.0f, 0.5f)));
+    transformation = glm::scale(transformation, glm::vec3(1.5f));
+    glm::mat3 normal_matrix = glm::transpose(glm::inverse(glm::mat3(transformation)));
+    
+    std::vector<size_t> sizes = {0, 1, 7, 63, 64, 65, 1000, PointKernels::GRAIN_SIZE + 7, 300001};
+    std::vector<size_t> thread_counts = {1, 0, 3};
+    int failures = 0;
+    
+    for (auto size : sizes) {
+        std::vector<glm::vec3> positions(size);
+        std::vector<PackedNormal> normals(size);
+        for (size_t i = 0; i < size; ++i) {
+            positions[i] = glm::vec3(dis(gen), dis(gen), dis(gen));
+            normals[i] = packNormal(glm::vec3(dis(gen), dis(gen), dis(gen)));
+        }
+        
+        // Scalar references
+        std::vector<glm::vec3> expected_positions(positions);
+        glm::vec3 expected_min(std::numeric_limits<float>::max());
+        glm::vec3 expected_max(std::numeric_limits<float>::lowest());
+        for (auto& position : expected_positions) {
+            position = glm::vec3(transformation * glm::vec4(position, 1.0f));
+            expected_min = glm::min(expected_min, position);
+            expected_max = glm::max(expected_max, position);
+        }
+        std::vector<PackedNormal> expected_normals(normals);
+        for (auto& normal : expected_normals) {
+            normal = packNormal(glm::normalize(normal_matrix * unpackNormal(normal)));
+        }
+        
+        for (auto threads : thread_counts) {
+            std::vector<glm::vec3> result(positions);
+            glm::vec3 min_bound, max_bound;
+            PointKernels::transformPositions(result.data(), size, transformation, min_bound, max_bound, threads);
+            bool bounds_ok = size > 0 ? (min_bound == expected_min && max_bound == expected_max)
+                                      : (min_bound.x > max_bound.x);
+            if (size > 0 && std::memcmp(result.data(), expected_positions.data(), size * sizeof(glm::vec3)) != 0) {
+                std::cerr << "transformPositions differs from glm: " << size << " points, " << threads << " threads\n";
+                ++failures;
+            }
+            if (!bounds_ok) {
+                std::cerr << "transformPositions bounds differ: " << size << " points, " << threads << " threads\n";
+                ++failures;
+            }
+            
+            PointKernels::computeBounds(expected_positions.data(), size, min_bound, max_bound, threads);
+            bounds_ok = size > 0 ? (min_bound == expected_min && max_bound == expected_max)
+                                 : (min_bound.x > max_bound.x);
+            if (!bounds_ok) {
+                std::cerr << "computeBounds differs: " << size << " points, " << threads << " threads\n";
+                ++failures;
+            }
+            
+            std::vector<PackedNormal> packed(normals);
+            PointKernels::transformNormals(packed.data(), size, normal_matrix, threads);
+            for (size_t i = 0; i < size; ++i) {
+                if (std::abs(packed[i].x - expected_normals[i].x) > 1 ||
+                    std::abs(packed[i].y - expected_normals[i].y) > 1) {
+                    std::cerr << "transformNormals differs at " << i << ": " << size << " points, "
+                              << threads << " threads\n";
+                    ++failures;
+                    break;
+                }
+            }
+        }
+        std::cout << std::setw(10) << size << " points checked\n";
+    }
+    
+    if (failures > 0) {
+        std::cout << "\n" << failures << " mismatches\n";
+        return 1;
+    }
+    std::cout << "\nAll kernels match scalar glm\n";
+    return 0;
+}
\ No newline at end of file
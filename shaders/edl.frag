@@ -0,0 +1,47 @@
+#version 330 core
+
+out vec4 FragColor;
+
+uniform sampler2D accumulation;     // Weighted colour sum, weight sum
+uniform sampler2D depthTexture;
+uniform vec3 backgroundColor;
+uniform vec3 projectionDepth;       // projection[2][2], projection[3][2], 1 for perspective
+uniform float edlStrength;
+uniform float edlRadius;            // Neighbour distance in pixels
+
+const float PI = 3.14159265;
+
+// Window depth to log2 of the view distance, so the response doesn't depend on scale
+float logDepth(float depth) {
+    float ndc = depth * 2.0 - 1.0;
+    float dist = projectionDepth.z > 0.0 ? projectionDepth.y / (ndc + projectionDepth.x)
+                                         : (projectionDepth.y - ndc) / projectionDepth.x;
+    return log2(max(dist, 1e-6));
+}
+
+void main() {
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    vec4 sum = texelFetch(accumulation, pixel, 0);
+    float depth = texelFetch(depthTexture, pixel, 0).r;
+    if (sum.a <= 0.0 || depth >= 1.0) {
+        FragColor = vec4(backgroundColor, 1.0);
+        return;
+    }
+    vec3 color = sum.rgb / sum.a;
+    
+    // Eye-dome lighting: darken by how far the pixel lies behind its neighbours.
+    // Background neighbours count as log depth 0, which outlines silhouettes.
+    float center = logDepth(depth);
+    ivec2 last = textureSize(depthTexture, 0) - 1;
+    float response = 0.0;
+    for (int i = 0; i < 8; ++i) {
+        float angle = float(i) * (PI / 4.0);
+        ivec2 offset = ivec2(round(edlRadius * vec2(cos(angle), sin(angle))));
+        float neighbour_depth = texelFetch(depthTexture, clamp(pixel + offset, ivec2(0), last), 0).r;
+        float neighbour = neighbour_depth < 1.0 ? logDepth(neighbour_depth) : 0.0;
+        response += max(center - neighbour, 0.0);
+    }
+    float shade = exp(-response / 8.0 * 300.0 * edlStrength);
+    
+    FragColor = vec4(color * shade, 1.0);
+}
\ No newline at end of file
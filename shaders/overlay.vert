@@ -0,0 +1,13 @@
+#version 330 core
+
+layout (location = 0) in vec2 aPos;         // Pixels from the bottom left
+layout (location = 1) in vec4 aColor;
+
+out vec4 Color;
+
+uniform vec2 viewport;
+
+void main() {
+    gl_Position = vec4(aPos / viewport * 2.0 - 1.0, 0.0, 1.0);
+    Color = aColor;
+}
\ No newline at end of file
@@ -11,11 +11,11 @@ uniform vec3 viewPos;
 void main() {
     // Simple shading with ambient and diffuse
     vec3 lightDir = normalize(viewPos - FragPos);
-    vec3 norm = normalize(Normal);
+    vec3 norm = lightDir;
     
     // If normal is zero, use light direction
-    if (length(norm) < 0.01) {
-        norm = lightDir;
+    if (length(Normal) >= 0.01) {
+        norm = normalize(Normal);
     }
     
     float diff = max(dot(norm, lightDir), 0.0);
@@ -1,8 +1,9 @@
 #version 330 core
 
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aColor;
-layout (location = 2) in vec3 aNormal;
+layout (location = 0) in vec4 aPos;         // Float xyz, or unorm16 xyz within the node and w: node range
+layout (location = 1) in vec4 aColor;       // RGBA8, normalized
+layout (location = 2) in vec2 aNormal;      // Octahedral snorm16x2
+layout (location = 3) in uint aTile;        // Scene tile, selects the model transform
 
 out vec3 FragPos;
 out vec3 Color;
@@ -11,16 +12,41 @@ out vec3 Normal;
 uniform mat4 view;
 uniform mat4 projection;
 uniform float pointSize;
+uniform bool quantizedPositions;
+uniform usamplerBuffer rangeBases;  // Node range of each 65536-vertex window's first vertex
+uniform samplerBuffer rangeBounds;  // Per range: node min bound, then extent
+uniform bool hasNormals;
+uniform bool useTiles;
+
+layout (std140) uniform Tiles {
+    mat4 tileTransforms[256];   // Renderer::MAX_TILES
+};
+
+vec3 decodeOctahedral(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0) {
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(n);
+}
 
 void main() {
-    FragPos = aPos;
-    Color = aColor;
-    Normal = aNormal;
+    vec3 pos = aPos.xyz;
+    if (quantizedPositions) {
+        int range = int(texelFetch(rangeBases, gl_VertexID >> 16).r) + int(aPos.w * 65535.0 + 0.5);
+        pos = texelFetch(rangeBounds, 2 * range).xyz + aPos.xyz * texelFetch(rangeBounds, 2 * range + 1).xyz;
+    }
+    if (useTiles) {
+        pos = (tileTransforms[aTile] * vec4(pos, 1.0)).xyz;
+    }
+    FragPos = pos;
+    Color = aColor.rgb;
+    Normal = hasNormals ? decodeOctahedral(aNormal) : vec3(0.0);
     
-    gl_Position = projection * view * vec4(aPos, 1.0);
+    gl_Position = projection * view * vec4(pos, 1.0);
     
     // Adjust point size based on distance
-    vec4 viewPos = view * vec4(aPos, 1.0);
+    vec4 viewPos = view * vec4(pos, 1.0);
     float dist = length(viewPos.xyz);
     gl_PointSize = pointSize * (50.0 / dist);
     gl_PointSize = clamp(gl_PointSize, 1.0, 10.0);
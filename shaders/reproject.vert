@@ -0,0 +1,27 @@
+#version 330 core
+
+// One point per pixel of the previous image, drawn without vertex buffers
+out vec3 Color;
+
+uniform sampler2D previousColor;
+uniform sampler2D previousDepth;
+uniform mat4 reprojection;      // This view-projection times the inverse of the previous one
+
+void main() {
+    ivec2 size = textureSize(previousDepth, 0);
+    ivec2 pixel = ivec2(gl_VertexID % size.x, gl_VertexID / size.x);
+    float depth = texelFetch(previousDepth, pixel, 0).r;
+    Color = texelFetch(previousColor, pixel, 0).rgb;
+    gl_PointSize = 1.0;
+    
+    // Background pixels are dropped outside the clip volume
+    if (depth >= 1.0) {
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        return;
+    }
+    
+    // Homogeneous throughout: the inverse maps to world space with w = 1 / clip w, which
+    // only scales the new clip position
+    vec2 ndc = (vec2(pixel) + 0.5) / vec2(size) * 2.0 - 1.0;
+    gl_Position = reprojection * vec4(ndc, depth * 2.0 - 1.0, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+#version 330 core
+
+in vec3 Color;
+
+out vec4 Accumulation;
+
+void main() {
+    // Weight falls to zero at the sprite's circle instead of discarding outside it, so
+    // early depth testing against the visibility pass stays on
+    vec2 coord = gl_PointCoord * 2.0 - 1.0;
+    float weight = max(1.0 - dot(coord, coord), 0.0);
+    Accumulation = vec4(Color * weight, weight);
+}
\ No newline at end of file
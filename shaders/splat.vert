@@ -0,0 +1,44 @@
+#version 330 core
+
+layout (location = 0) in vec4 aPos;         // Float xyz, or unorm16 xyz within the node and w: node range
+layout (location = 1) in vec4 aColor;       // RGBA8, normalized
+layout (location = 3) in uint aTile;        // Scene tile, selects the model transform
+
+out vec3 Color;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform float pointSize;
+uniform float projectionScale;  // Pixels per unit at distance 1: 0.5 * height * projection[1][1]
+uniform float depthOffset;      // Push away from the camera, in splat radii
+uniform bool quantizedPositions;
+uniform usamplerBuffer rangeBases;  // Node range of each 65536-vertex window's first vertex
+uniform samplerBuffer rangeBounds;  // Per range: node min bound, then extent
+uniform bool useTiles;
+
+layout (std140) uniform Tiles {
+    mat4 tileTransforms[256];   // Renderer::MAX_TILES
+};
+
+void main() {
+    vec3 pos = aPos.xyz;
+    if (quantizedPositions) {
+        int range = int(texelFetch(rangeBases, gl_VertexID >> 16).r) + int(aPos.w * 65535.0 + 0.5);
+        pos = texelFetch(rangeBounds, 2 * range).xyz + aPos.xyz * texelFetch(rangeBounds, 2 * range + 1).xyz;
+    }
+    if (useTiles) {
+        pos = (tileTransforms[aTile] * vec4(pos, 1.0)).xyz;
+    }
+    Color = aColor.rgb;
+    
+    // Same sprite size as point.vert
+    vec4 viewPos = view * vec4(pos, 1.0);
+    float dist = length(viewPos.xyz);
+    gl_PointSize = clamp(pointSize * (50.0 / dist), 1.0, 10.0);
+    
+    // The depth pass moves every splat back by its radius, so splats of one surface
+    // overlapping in depth all pass the attribute pass and blend
+    float radius = 0.5 * gl_PointSize * -viewPos.z / projectionScale;
+    viewPos.z -= depthOffset * radius;
+    gl_Position = projection * viewPos;
+}
\ No newline at end of file
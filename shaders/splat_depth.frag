@@ -0,0 +1,6 @@
+#version 330 core
+
+// Visibility pass: square sprites write depth only. No discard and no gl_FragDepth,
+// so early depth testing stays on.
+void main() {
+}
\ No newline at end of file
@@ -0,0 +1,237 @@
+#include "core/KDTree.h"
+#include <algorithm>
+#include <limits>
+#include <glm/geometric.hpp>
+
+namespace pcv {
+
+namespace {
+
+bool compareNeighbors(const KDTree::Neighbor& a, const KDTree::Neighbor& b) {
+    return a.squared_distance < b.squared_distance;
+}
+
+float distanceSq(const glm::vec3& a, const glm::vec3& b) {
+    glm::vec3 diff = a - b;
+    return glm::dot(diff, diff);
+}
+
+} // namespace
+
+KDTree::KDTree(const PointCloud& cloud, size_t max_leaf_size)
+    : cloud_(cloud), max_leaf_size_(std::max<size_t>(1, max_leaf_size)) {
+}
+
+void KDTree::build() {
+    nodes_.clear();
+    positions_.clear();
+    indices_.clear();
+    
+    if (cloud_.empty()) return;
+    
+    // Sort (position, index) pairs in place so partitioning stays cache friendly
+    const auto& positions = cloud_.getPositions();
+    std::vector<BuildEntry> entries(positions.size());
+    for (size_t i = 0; i < positions.size(); ++i) {
+        entries[i].position = positions[i];
+        entries[i].index = static_cast<uint32_t>(i);
+    }
+    
+    // A balanced tree has at most 2 * (n / leaf_size) + 1 nodes
+    nodes_.reserve(2 * (entries.size() / max_leaf_size_) + 1);
+    buildRecursive(entries, 0, static_cast<uint32_t>(entries.size()));
+    
+    positions_.resize(entries.size());
+    indices_.resize(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        positions_[i] = entries[i].position;
+        indices_[i] = entries[i].index;
+    }
+}
+
+uint32_t KDTree::buildRecursive(std::vector<BuildEntry>& entries, uint32_t begin, uint32_t end) {
+    uint32_t node_index = static_cast<uint32_t>(nodes_.size());
+    nodes_.emplace_back();
+    
+    if (end - begin <= max_leaf_size_) {
+        Node& leaf = nodes_[node_index];
+        leaf.begin = begin;
+        leaf.end = end;
+        leaf.min_bound = glm::vec3(std::numeric_limits<float>::max());
+        leaf.max_bound = glm::vec3(std::numeric_limits<float>::lowest());
+        for (uint32_t i = begin; i < end; ++i) {
+            leaf.min_bound = glm::min(leaf.min_bound, entries[i].position);
+            leaf.max_bound = glm::max(leaf.max_bound, entries[i].position);
+        }
+        return node_index;
+    }
+    
+    // Split along the axis of largest spread at the median
+    glm::vec3 min_bound(std::numeric_limits<float>::max());
+    glm::vec3 max_bound(std::numeric_limits<float>::lowest());
+    for (uint32_t i = begin; i < end; ++i) {
+        min_bound = glm::min(min_bound, entries[i].position);
+        max_bound = glm::max(max_bound, entries[i].position);
+    }
+    
+    glm::vec3 extent = max_bound - min_bound;
+    int axis = 0;
+    if (extent.y > extent[axis]) axis = 1;
+    if (extent.z > extent[axis]) axis = 2;
+    
+    uint32_t mid = begin + (end - begin) / 2;
+    std::nth_element(entries.begin() + begin, entries.begin() + mid, entries.begin() + end,
+                     [axis](const BuildEntry& a, const BuildEntry& b) {
+                         return a.position[axis] < b.position[axis];
+                     });
+    
+    uint32_t left = buildRecursive(entries, begin, mid);
+    uint32_t right = buildRecursive(entries, mid, end);
+    
+    // nodes_ may have reallocated during recursion
+    Node& node = nodes_[node_index];
+    node.begin = begin;
+    node.end = end;
+    node.left = left;
+    node.right = right;
+    node.min_bound = min_bound;
+    node.max_bound = max_bound;
+    return node_index;
+}
+
+size_t KDTree::knnSearch(const glm::vec3& query, size_t k, std::vector<Neighbor>& results,
+                         const uint8_t* active) const {
+    results.clear();
+    if (nodes_.empty() || k == 0) return 0;
+    
+    knnRecursive(0, query, k, results, active);
+    
+    // results is a max-heap on distance; sort_heap leaves it ascending
+    std::sort_heap(results.begin(), results.end(), compareNeighbors);
+    return results.size();
+}
+
+size_t KDTree::radiusSearch(const glm::vec3& query, float radius, std::vector<Neighbor>& results) const {
+    results.clear();
+    if (nodes_.empty() || radius < 0.0f) return 0;
+    
+    radiusRecursive(0, query, radius * radius, results);
+    return results.size();
+}
+
+size_t KDTree::radiusCount(const glm::vec3& query, float radius, size_t max_count,
+                           const uint8_t* active) const {
+    if (nodes_.empty() || radius < 0.0f || max_count == 0) return 0;
+    return radiusCountRecursive(0, query, radius * radius, 0, max_count, active);
+}
+
+void KDTree::knnRecursive(uint32_t node_index, const glm::vec3& query, size_t k,
+                          std::vector<Neighbor>& heap, const uint8_t* active) const {
+    const Node& node = nodes_[node_index];
+    
+    if (node.isLeaf()) {
+        for (uint32_t i = node.begin; i < node.end; ++i) {
+            if (active && !active[indices_[i]]) continue;
+            float dist_sq = distanceSq(query, positions_[i]);
+            
+            if (heap.size() < k) {
+                heap.push_back({indices_[i], dist_sq});
+                std::push_heap(heap.begin(), heap.end(), compareNeighbors);
+            } else if (dist_sq < heap.front().squared_distance) {
+                // Replace the current worst neighbor
+                std::pop_heap(heap.begin(), heap.end(), compareNeighbors);
+                heap.back() = {indices_[i], dist_sq};
+                std::push_heap(heap.begin(), heap.end(), compareNeighbors);
+            }
+        }
+        return;
+    }
+    
+    // Visit the nearer child first so the heap bound tightens early
+    float left_dist = boxDistanceSq(nodes_[node.left], query);
+    float right_dist = boxDistanceSq(nodes_[node.right], query);
+    
+    uint32_t first = node.left;
+    uint32_t second = node.right;
+    if (right_dist < left_dist) {
+        std::swap(first, second);
+        std::swap(left_dist, right_dist);
+    }
+    
+    if (heap.size() < k || left_dist < heap.front().squared_distance) {
+        knnRecursive(first, query, k, heap, active);
+    }
+    if (heap.size() < k || right_dist < heap.front().squared_distance) {
+        knnRecursive(second, query, k, heap, active);
+    }
+}
+
+void KDTree::radiusRecursive(uint32_t node_index, const glm::vec3& query, float radius_sq,
+                             std::vector<Neighbor>& results) const {
+    const Node& node = nodes_[node_index];
+    
+    if (boxDistanceSq(node, query) > radius_sq) {
+        return; // No intersection
+    }
+    
+    if (node.isLeaf()) {
+        for (uint32_t i = node.begin; i < node.end; ++i) {
+            float dist_sq = distanceSq(query, positions_[i]);
+            if (dist_sq <= radius_sq) {
+                results.push_back({indices_[i], dist_sq});
+            }
+        }
+        return;
+    }
+    
+    radiusRecursive(node.left, query, radius_sq, results);
+    radiusRecursive(node.right, query, radius_sq, results);
+}
+
+size_t KDTree::radiusCountRecursive(uint32_t node_index, const glm::vec3& query, float radius_sq,
+                                    size_t count, size_t max_count, const uint8_t* active) const {
+    const Node& node = nodes_[node_index];
+    
+    if (boxDistanceSq(node, query) > radius_sq) {
+        return count;
+    }
+    
+    // Whole node inside the sphere - no distance tests needed
+    if (boxFarthestDistanceSq(node, query) <= radius_sq) {
+        if (!active) {
+            return std::min(max_count, count + (node.end - node.begin));
+        }
+        for (uint32_t i = node.begin; i < node.end && count < max_count; ++i) {
+            count += active[indices_[i]] != 0;
+        }
+        return count;
+    }
+    
+    if (node.isLeaf()) {
+        for (uint32_t i = node.begin; i < node.end && count < max_count; ++i) {
+            if (active && !active[indices_[i]]) continue;
+            if (distanceSq(query, positions_[i]) <= radius_sq) {
+                count++;
+            }
+        }
+        return count;
+    }
+    
+    count = radiusCountRecursive(node.left, query, radius_sq, count, max_count, active);
+    if (count < max_count) {
+        count = radiusCountRecursive(node.right, query, radius_sq, count, max_count, active);
+    }
+    return count;
+}
+
+float KDTree::boxDistanceSq(const Node& node, const glm::vec3& query) {
+    glm::vec3 closest = glm::clamp(query, node.min_bound, node.max_bound);
+    return distanceSq(query, closest);
+}
+
+float KDTree::boxFarthestDistanceSq(const Node& node, const glm::vec3& query) {
+    glm::vec3 far_corner = glm::max(glm::abs(query - node.min_bound), glm::abs(query - node.max_bound));
+    return glm::dot(far_corner, far_corner);
+}
+
+} // namespace pcv
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "core/PointCloud.h"
+#include <vector>
+#include <cstdint>
+
+namespace pcv {
+
+// Static k-d tree over the positions of a point cloud.
+// Positions are copied into tree order so leaf scans walk contiguous memory.
+class KDTree {
+public:
+    struct Neighbor {
+        size_t index;            // Index into the source cloud
+        float squared_distance;
+    };
+    
+    explicit KDTree(const PointCloud& cloud, size_t max_leaf_size = 16);
+    
+    // Build the tree
+    void build();
+    
+    // Queries taking an active mask (one flag per cloud point) only see points whose
+    // flag is set, so filters can keep querying one tree while they remove points.
+    
+    // k nearest neighbors of query, sorted by ascending distance.
+    // Uses results as a bounded max-heap, so reusing the vector avoids allocations.
+    size_t knnSearch(const glm::vec3& query, size_t k, std::vector<Neighbor>& results,
+                     const uint8_t* active = nullptr) const;
+    
+    // All points within radius of query (unsorted)
+    size_t radiusSearch(const glm::vec3& query, float radius, std::vector<Neighbor>& results) const;
+    
+    // Number of points within radius of query; stops counting at max_count
+    size_t radiusCount(const glm::vec3& query, float radius,
+                       size_t max_count = static_cast<size_t>(-1),
+                       const uint8_t* active = nullptr) const;
+    
+    // Statistics
+    size_t size() const { return indices_.size(); }
+    bool empty() const { return indices_.empty(); }
+    size_t getNodeCount() const { return nodes_.size(); }
+    
+    // Cloud indices in tree order; walking them keeps consecutive queries close in space
+    const std::vector<uint32_t>& getIndices() const { return indices_; }
+    
+private:
+    struct Node {
+        glm::vec3 min_bound;
+        glm::vec3 max_bound;
+        uint32_t begin = 0;      // Range into positions_/indices_
+        uint32_t end = 0;
+        uint32_t left = 0;       // Child node indices, 0 for leaves (root is never a child)
+        uint32_t right = 0;
+        
+        bool isLeaf() const { return left == 0; }
+    };
+    
+    struct BuildEntry {
+        glm::vec3 position;
+        uint32_t index;
+    };
+    
+    const PointCloud& cloud_;
+    size_t max_leaf_size_;
+    
+    std::vector<Node> nodes_;
+    std::vector<glm::vec3> positions_;
+    std::vector<uint32_t> indices_;
+    
+    uint32_t buildRecursive(std::vector<BuildEntry>& entries, uint32_t begin, uint32_t end);
+    
+    void knnRecursive(uint32_t node_index, const glm::vec3& query, size_t k,
+                      std::vector<Neighbor>& heap, const uint8_t* active) const;
+    void radiusRecursive(uint32_t node_index, const glm::vec3& query, float radius_sq,
+                         std::vector<Neighbor>& results) const;
+    size_t radiusCountRecursive(uint32_t node_index, const glm::vec3& query, float radius_sq,
+                                size_t count, size_t max_count, const uint8_t* active) const;
+    
+    static float boxDistanceSq(const Node& node, const glm::vec3& query);
+    static float boxFarthestDistanceSq(const Node& node, const glm::vec3& query);
+};
+
+} // namespace pcv
\ No newline at end of file
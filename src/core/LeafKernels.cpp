@@ -0,0 +1,103 @@
+#include "core/LeafKernels.h"
+
+#include "core/SimdLanes.h"
+
+namespace pcv {
+
+namespace {
+
+using simd::Lanes;
+
+// One block of gathered positions; lanes past the point count repeat the first point
+struct Block {
+    alignas(32) float x[LeafKernels::BLOCK_SIZE];
+    alignas(32) float y[LeafKernels::BLOCK_SIZE];
+    alignas(32) float z[LeafKernels::BLOCK_SIZE];
+};
+
+void gather(const glm::vec3* positions, const uint32_t* indices, size_t count, Block& block) {
+    for (size_t i = 0; i < LeafKernels::BLOCK_SIZE; ++i) {
+        const glm::vec3& position = positions[indices[i < count ? i : 0]];
+        block.x[i] = position.x;
+        block.y[i] = position.y;
+        block.z[i] = position.z;
+    }
+}
+
+uint32_t laneMask(size_t count) {
+    return count >= 32 ? ~0u : (1u << count) - 1u;
+}
+
+static_assert(LeafKernels::BLOCK_SIZE % Lanes::WIDTH == 0, "leaf blocks must be whole lane groups");
+
+} // namespace
+
+uint32_t LeafKernels::frustumMask(const glm::vec3* positions, const uint32_t* indices, size_t count,
+                                  const std::array<glm::vec4, 6>& planes) {
+    Block block;
+    gather(positions, indices, count, block);
+    
+    const Lanes::Float zero = Lanes::splat(0.0f);
+    uint32_t mask = 0;
+    for (size_t lane = 0; lane < BLOCK_SIZE; lane += Lanes::WIDTH) {
+        Lanes::Float x = Lanes::load(block.x + lane);
+        Lanes::Float y = Lanes::load(block.y + lane);
+        Lanes::Float z = Lanes::load(block.z + lane);
+        
+        // Same evaluation order as the scalar plane distance
+        Lanes::Bool inside = Lanes::all();
+        for (const auto& plane : planes) {
+            Lanes::Float distance = Lanes::mul(Lanes::splat(plane.x), x);
+            distance = Lanes::add(distance, Lanes::mul(Lanes::splat(plane.y), y));
+            distance = Lanes::add(distance, Lanes::mul(Lanes::splat(plane.z), z));
+            distance = Lanes::add(distance, Lanes::splat(plane.w));
+            inside = Lanes::both(inside, Lanes::notLess(distance, zero));
+        }
+        mask |= Lanes::bits(inside) << lane;
+    }
+    return mask & laneMask(count);
+}
+
+uint32_t LeafKernels::boxMask(const glm::vec3* positions, const uint32_t* indices, size_t count,
+                              const glm::vec3& min_bound, const glm::vec3& max_bound) {
+    Block block;
+    gather(positions, indices, count, block);
+    
+    uint32_t mask = 0;
+    for (size_t lane = 0; lane < BLOCK_SIZE; lane += Lanes::WIDTH) {
+        Lanes::Float x = Lanes::load(block.x + lane);
+        Lanes::Float y = Lanes::load(block.y + lane);
+        Lanes::Float z = Lanes::load(block.z + lane);
+        
+        Lanes::Bool inside = Lanes::both(
+            Lanes::both(Lanes::greaterEqual(x, Lanes::splat(min_bound.x)), Lanes::lessEqual(x, Lanes::splat(max_bound.x))),
+            Lanes::both(Lanes::greaterEqual(y, Lanes::splat(min_bound.y)), Lanes::lessEqual(y, Lanes::splat(max_bound.y))));
+        inside = Lanes::both(inside,
+            Lanes::both(Lanes::greaterEqual(z, Lanes::splat(min_bound.z)), Lanes::lessEqual(z, Lanes::splat(max_bound.z))));
+        mask |= Lanes::bits(inside) << lane;
+    }
+    return mask & laneMask(count);
+}
+
+uint32_t LeafKernels::sphereMask(const glm::vec3* positions, const uint32_t* indices, size_t count,
+                                 const glm::vec3& center, float radius_sq) {
+    Block block;
+    gather(positions, indices, count, block);
+    
+    uint32_t mask = 0;
+    for (size_t lane = 0; lane < BLOCK_SIZE; lane += Lanes::WIDTH) {
+        Lanes::Float dx = Lanes::sub(Lanes::load(block.x + lane), Lanes::splat(center.x));
+        Lanes::Float dy = Lanes::sub(Lanes::load(block.y + lane), Lanes::splat(center.y));
+        Lanes::Float dz = Lanes::sub(Lanes::load(block.z + lane), Lanes::splat(center.z));
+        
+        Lanes::Float distance_sq = Lanes::add(Lanes::add(Lanes::mul(dx, dx), Lanes::mul(dy, dy)), Lanes::mul(dz, dz));
+        mask |= Lanes::bits(Lanes::lessEqual(distance_sq, Lanes::splat(radius_sq))) << lane;
+    }
+    return mask & laneMask(count);
+}
+
+const char* LeafKernels::getInstructionSet() {
+    return simd::INSTRUCTION_SET;
+}
+
+} // namespace pcv
\ No newline at end of file
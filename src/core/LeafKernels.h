@@ -0,0 +1,48 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace pcv {
+
+// Batched point tests for octree leaves.
+// Each call gathers up to BLOCK_SIZE points (positions[indices[i]]) into SoA lanes and
+// tests them together, branch-free. Bit i of the returned mask is set if point i
+// passes. Every path evaluates the scalar expressions in the same order, and the build
+// compiles this file with -ffp-contract=off so none of them become fused multiply-adds;
+// boundary points get the same answer whichever one is compiled in. AVX, SSE2 or NEON
+// is chosen at compile time (the Release build uses -march=native), with a scalar fallback.
+class LeafKernels {
+public:
+    static constexpr size_t BLOCK_SIZE = 8;
+    
+    // Inside (or on) all six planes: dot(plane.xyz, p) + plane.w >= 0
+    static uint32_t frustumMask(const glm::vec3* positions, const uint32_t* indices, size_t count,
+                                const std::array<glm::vec4, 6>& planes);
+    
+    // min_bound <= p <= max_bound on every axis
+    static uint32_t boxMask(const glm::vec3* positions, const uint32_t* indices, size_t count,
+                            const glm::vec3& min_bound, const glm::vec3& max_bound);
+    
+    // |p - center|^2 <= radius_sq
+    static uint32_t sphereMask(const glm::vec3* positions, const uint32_t* indices, size_t count,
+                               const glm::vec3& center, float radius_sq);
+    
+    // Name of the compiled-in instruction set ("AVX", "SSE2", "NEON" or "scalar")
+    static const char* getInstructionSet();
+    
+    // Write indices[i] for every set bit i of mask to out (room for BLOCK_SIZE) and
+    // return how many were written
+    static size_t compact(const uint32_t* indices, uint32_t mask, uint32_t* out) {
+        size_t count = 0;
+        for (size_t i = 0; mask != 0; ++i, mask >>= 1) {
+            out[count] = indices[i];
+            count += mask & 1u;
+        }
+        return count;
+    }
+};
+
+} // namespace pcv
\ No newline at end of file
@@ -1,4 +1,291 @@
 #include "core/MemoryPool.h"
-#include "core/PointCloud.h"
-// This file exists to satisfy the build system
-// All template implementations are in the header
\ No newline at end of file
+#include <algorithm>
+#include <cstring>
+
+namespace pcv {
+
+namespace {
+
+size_t roundUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+int highestBit(uint64_t value) {
+#if defined(__GNUC__)
+    return 63 - __builtin_clzll(value);
+#else
+    int bit = 0;
+    while (value >>= 1) bit++;
+    return bit;
+#endif
+}
+
+} // namespace
+
+// Blocks double in size: block b holds slots [S * (2^b - 1), S * (2^(b+1) - 1)) for
+// S = slots_per_block, so a handful of blocks address every 32-bit slot index
+
+SlabPool::SlabPool(size_t slot_size, size_t alignment, size_t slots_per_block)
+    : slot_size_(slot_size),
+      alignment_(std::max(alignment, alignof(uint32_t))),
+      stride_(0),
+      slots_per_block_(std::max<size_t>(slots_per_block, CACHE_BATCH)),
+      free_head_(NIL),
+      caches_(new ThreadCache[THREAD_CACHES]) {
+    // Room for the free-list link, then the slot's own index at the end
+    stride_ = roundUp(std::max(slot_size_, sizeof(uint32_t)) + sizeof(uint32_t), alignment_);
+    for (size_t b = 0; b < MAX_BLOCKS; ++b) {
+        blocks_[b].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+SlabPool::~SlabPool() {
+    for (size_t b = 0; b < MAX_BLOCKS; ++b) {
+        unsigned char* block = blocks_[b].load(std::memory_order_relaxed);
+        if (block) {
+            ::operator delete(block, std::align_val_t(alignment_));
+        }
+    }
+}
+
+size_t SlabPool::threadCacheIndex() {
+    static std::atomic<size_t> next_thread{0};
+    thread_local size_t index = next_thread.fetch_add(1, std::memory_order_relaxed) % THREAD_CACHES;
+    return index;
+}
+
+unsigned char* SlabPool::slotAddress(uint32_t index) const {
+    const int block = highestBit(index / slots_per_block_ + 1);
+    const size_t first = slots_per_block_ * ((size_t(1) << block) - 1);
+    return blocks_[block].load(std::memory_order_acquire) + (index - first) * stride_;
+}
+
+uint32_t& SlabPool::nextOf(uint32_t index) const {
+    return *reinterpret_cast<uint32_t*>(slotAddress(index));
+}
+
+void SlabPool::ensureBlock(size_t block) {
+    if (blocks_[block].load(std::memory_order_acquire)) return;
+    
+    std::lock_guard<std::mutex> lock(grow_mutex_);
+    if (blocks_[block].load(std::memory_order_relaxed)) return;
+    
+    const size_t bytes = (slots_per_block_ << block) * stride_;
+    auto* memory = static_cast<unsigned char*>(::operator new(bytes, std::align_val_t(alignment_)));
+    blocks_[block].store(memory, std::memory_order_release);
+}
+
+uint32_t SlabPool::takeFresh(uint32_t count) {
+    const size_t first = next_fresh_.fetch_add(count, std::memory_order_relaxed);
+    if (first + count >= NIL) {
+        throw std::bad_alloc();
+    }
+    
+    const int first_block = highestBit(first / slots_per_block_ + 1);
+    const int last_block = highestBit((first + count - 1) / slots_per_block_ + 1);
+    for (int block = first_block; block <= last_block; ++block) {
+        ensureBlock(static_cast<size_t>(block));
+    }
+    
+    // Stamp each slot with its index and chain the batch in order
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint32_t index = static_cast<uint32_t>(first + i);
+        unsigned char* slot = slotAddress(index);
+        std::memcpy(slot + stride_ - sizeof(uint32_t), &index, sizeof(uint32_t));
+        nextOf(index) = i + 1 < count ? index + 1 : NIL;
+    }
+    return static_cast<uint32_t>(first);
+}
+
+uint32_t SlabPool::popFree() {
+    // The tag changes with every update, so a head that was popped and pushed back
+    // in between (ABA) fails the exchange
+    uint64_t head = free_head_.load(std::memory_order_acquire);
+    for (;;) {
+        const uint32_t index = static_cast<uint32_t>(head);
+        if (index == NIL) return NIL;
+        
+        const uint32_t next = nextOf(index);
+        const uint64_t replacement = (((head >> 32) + 1) << 32) | next;
+        if (free_head_.compare_exchange_weak(head, replacement, std::memory_order_acq_rel,
+                                             std::memory_order_acquire)) {
+            return index;
+        }
+    }
+}
+
+void SlabPool::pushFree(uint32_t first, uint32_t last) {
+    uint64_t head = free_head_.load(std::memory_order_relaxed);
+    uint64_t replacement;
+    do {
+        nextOf(last) = static_cast<uint32_t>(head);
+        replacement = (((head >> 32) + 1) << 32) | first;
+    } while (!free_head_.compare_exchange_weak(head, replacement, std::memory_order_release,
+                                               std::memory_order_relaxed));
+}
+
+void SlabPool::refill(ThreadCache& cache) {
+    for (uint32_t i = 0; i < CACHE_BATCH; ++i) {
+        const uint32_t index = popFree();
+        if (index == NIL) break;
+        nextOf(index) = cache.head;
+        cache.head = index;
+        cache.count++;
+    }
+    
+    if (cache.count == 0) {
+        cache.head = takeFresh(CACHE_BATCH);
+        cache.count = CACHE_BATCH;
+    }
+}
+
+void SlabPool::spill(ThreadCache& cache, uint32_t count) {
+    const uint32_t first = cache.head;
+    uint32_t last = first;
+    for (uint32_t i = 1; i < count; ++i) {
+        last = nextOf(last);
+    }
+    cache.head = nextOf(last);
+    cache.count -= count;
+    pushFree(first, last);
+}
+
+void* SlabPool::allocate() {
+    ThreadCache& cache = caches_[threadCacheIndex()];
+    if (!cache.busy.exchange(true, std::memory_order_acquire)) {
+        try {
+            if (cache.head == NIL) {
+                refill(cache);
+            }
+        } catch (...) {
+            cache.busy.store(false, std::memory_order_release);
+            throw;
+        }
+        const uint32_t index = cache.head;
+        cache.head = nextOf(index);
+        cache.count--;
+        cache.allocations.store(cache.allocations.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        cache.busy.store(false, std::memory_order_release);
+        return slotAddress(index);
+    }
+    
+    // Another thread shares this cache slot - go to the global list directly
+    uint32_t index = popFree();
+    if (index == NIL) {
+        index = takeFresh(1);
+    }
+    shared_allocations_.fetch_add(1, std::memory_order_relaxed);
+    return slotAddress(index);
+}
+
+void SlabPool::deallocate(void* ptr) {
+    if (!ptr) return;
+    
+    uint32_t index;
+    std::memcpy(&index, static_cast<unsigned char*>(ptr) + stride_ - sizeof(uint32_t), sizeof(uint32_t));
+    
+    ThreadCache& cache = caches_[threadCacheIndex()];
+    if (!cache.busy.exchange(true, std::memory_order_acquire)) {
+        nextOf(index) = cache.head;
+        cache.head = index;
+        cache.count++;
+        if (cache.count >= 2 * CACHE_BATCH) {
+            spill(cache, CACHE_BATCH);
+        }
+        cache.deallocations.store(cache.deallocations.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        cache.busy.store(false, std::memory_order_release);
+        return;
+    }
+    
+    pushFree(index, index);
+    shared_deallocations_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void SlabPool::reset() {
+    for (size_t c = 0; c < THREAD_CACHES; ++c) {
+        caches_[c].head = NIL;
+        caches_[c].count = 0;
+        caches_[c].allocations.store(0, std::memory_order_relaxed);
+        caches_[c].deallocations.store(0, std::memory_order_relaxed);
+    }
+    
+    uint64_t head = free_head_.load(std::memory_order_relaxed);
+    free_head_.store((((head >> 32) + 1) << 32) | NIL, std::memory_order_release);
+    next_fresh_.store(0, std::memory_order_relaxed);
+    shared_allocations_.store(0, std::memory_order_relaxed);
+    shared_deallocations_.store(0, std::memory_order_relaxed);
+}
+
+PoolStatistics SlabPool::getStatistics() const {
+    PoolStatistics stats;
+    stats.allocations = shared_allocations_.load(std::memory_order_relaxed);
+    stats.deallocations = shared_deallocations_.load(std::memory_order_relaxed);
+    for (size_t c = 0; c < THREAD_CACHES; ++c) {
+        stats.allocations += caches_[c].allocations.load(std::memory_order_relaxed);
+        stats.deallocations += caches_[c].deallocations.load(std::memory_order_relaxed);
+    }
+    stats.live = stats.allocations - std::min(stats.deallocations, stats.allocations);
+    
+    for (size_t b = 0; b < MAX_BLOCKS; ++b) {
+        if (blocks_[b].load(std::memory_order_relaxed)) {
+            stats.capacity += slots_per_block_ << b;
+        }
+    }
+    stats.memory_usage = stats.capacity * stride_;
+    return stats;
+}
+
+Arena::Arena(size_t block_bytes) : block_bytes_(std::max<size_t>(block_bytes, 64)) {
+}
+
+void* Arena::allocate(size_t bytes, size_t alignment) {
+    allocations_++;
+    
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        if (!blocks_.empty()) {
+            Block& block = blocks_.back();
+            const uintptr_t base = reinterpret_cast<uintptr_t>(block.memory.get());
+            const uintptr_t start = base + offset_;
+            const uintptr_t aligned = roundUp(start, alignment);
+            if (aligned + bytes <= base + block.size) {
+                bytes_used_ += aligned + bytes - start;
+                offset_ = aligned + bytes - base;
+                return reinterpret_cast<void*>(aligned);
+            }
+        }
+        
+        // Start a block, large enough for this request even past the block size
+        const size_t size = std::max(block_bytes_, bytes + alignment);
+        blocks_.push_back({std::unique_ptr<unsigned char[]>(new unsigned char[size]), size});
+        offset_ = 0;
+    }
+    throw std::bad_alloc();
+}
+
+void Arena::reset() {
+    peak_bytes_ = std::max(peak_bytes_, bytes_used_);
+    if (blocks_.size() > 1) {
+        size_t total = 0;
+        for (const Block& block : blocks_) {
+            total += block.size;
+        }
+        blocks_.clear();
+        blocks_.push_back({std::unique_ptr<unsigned char[]>(new unsigned char[total]), total});
+    }
+    offset_ = 0;
+    allocations_ = 0;
+    bytes_used_ = 0;
+}
+
+ArenaStatistics Arena::getStatistics() const {
+    ArenaStatistics stats;
+    stats.allocations = allocations_;
+    stats.bytes_used = bytes_used_;
+    stats.peak_bytes = std::max(peak_bytes_, bytes_used_);
+    for (const Block& block : blocks_) {
+        stats.capacity += block.size;
+    }
+    return stats;
+}
+
+} // namespace pcv
\ No newline at end of file
@@ -1,133 +1,269 @@
 #pragma once
 
-#include <vector>
-#include <memory>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace pcv {
 
-// Forward declaration
-struct Point;
+// Allocation counters for profiling
+struct PoolStatistics {
+    size_t allocations = 0;     // Since construction or the last reset()
+    size_t deallocations = 0;
+    size_t live = 0;            // Allocated and not yet freed
+    size_t capacity = 0;        // Slots backed by memory
+    size_t memory_usage = 0;    // Bytes reserved from the system
+};
 
-template<typename T>
-class MemoryPool {
+// Fixed-size slot allocator over raw blocks; no constructors are run.
+// Freed slots go to a cache owned by the calling thread and spill in batches to a
+// global lock-free free list (a tagged stack of slot indices), so steady-state
+// allocate()/deallocate() touch only that thread's cache. Caches refill from the
+// free list, then from fresh slots, a batch at a time; the mutex is only taken to add
+// a block. Slots may be freed on any thread.
+// reset() frees every slot at once, keeping the blocks and running no destructors;
+// it must not race with other calls.
+class SlabPool {
 public:
-    explicit MemoryPool(size_t block_size = 1024);
-    ~MemoryPool();
+    explicit SlabPool(size_t slot_size, size_t alignment = alignof(std::max_align_t),
+                      size_t slots_per_block = 4096);
+    ~SlabPool();
     
-    // Allocate a single object
-    T* allocate();
+    SlabPool(const SlabPool&) = delete;
+    SlabPool& operator=(const SlabPool&) = delete;
     
-    // Deallocate a single object
-    void deallocate(T* ptr);
-    
-    // Reset the pool (deallocate all)
+    void* allocate();
+    void deallocate(void* ptr);
     void reset();
     
-    // Get statistics
-    size_t getAllocatedCount() const { return allocated_count_; }
-    size_t getCapacity() const { return blocks_.size() * block_size_; }
-    size_t getMemoryUsage() const { return blocks_.size() * block_size_ * sizeof(T); }
+    size_t getSlotSize() const { return slot_size_; }
+    size_t getAlignment() const { return alignment_; }
+    PoolStatistics getStatistics() const;
     
 private:
-    struct Block {
-        std::unique_ptr<T[]> memory;
-        size_t used = 0;
-        
-        explicit Block(size_t size) : memory(std::make_unique<T[]>(size)) {}
+    static constexpr size_t MAX_BLOCKS = 32;   // Blocks double, so 32 cover every index
+    static constexpr size_t THREAD_CACHES = 64;
+    static constexpr uint32_t CACHE_BATCH = 64;
+    static constexpr uint32_t NIL = ~0u;
+    
+    // Free slots store the next slot index in their first bytes; every slot ends with
+    // its own index so deallocate() can find it
+    struct alignas(64) ThreadCache {
+        std::atomic<bool> busy{false};   // Held by the thread using it; others bypass it
+        uint32_t head = NIL;
+        uint32_t count = 0;
+        std::atomic<size_t> allocations{0};     // Written by the holder only
+        std::atomic<size_t> deallocations{0};
     };
     
-    size_t block_size_;
-    std::vector<std::unique_ptr<Block>> blocks_;
-    std::vector<T*> free_list_;
-    size_t allocated_count_ = 0;
+    size_t slot_size_;
+    size_t alignment_;
+    size_t stride_;
+    size_t slots_per_block_;
+    
+    std::atomic<unsigned char*> blocks_[MAX_BLOCKS];
+    std::atomic<size_t> next_fresh_{0};       // Slots handed out from blocks so far
+    std::mutex grow_mutex_;
+    
+    std::atomic<uint64_t> free_head_;         // (tag << 32) | slot index
+    std::unique_ptr<ThreadCache[]> caches_;
+    std::atomic<size_t> shared_allocations_{0};     // Calls that bypassed a busy cache
+    std::atomic<size_t> shared_deallocations_{0};
     
-    mutable std::mutex mutex_; // For thread safety
+    unsigned char* slotAddress(uint32_t index) const;
+    uint32_t& nextOf(uint32_t index) const;
+    void ensureBlock(size_t block);
     
-    void allocateNewBlock();
+    uint32_t popFree();
+    void pushFree(uint32_t first, uint32_t last);
+    uint32_t takeFresh(uint32_t count);
+    void refill(ThreadCache& cache);
+    void spill(ThreadCache& cache, uint32_t count);
+    
+    static size_t threadCacheIndex();
 };
 
-// Template implementation
+// Typed slab pool. allocate() returns uninitialized storage for one T; create() and
+// destroy() add construction and destruction.
 template<typename T>
-MemoryPool<T>::MemoryPool(size_t block_size) : block_size_(block_size) {
-    allocateNewBlock();
-}
+class MemoryPool {
+public:
+    explicit MemoryPool(size_t block_size = 1024) : slab_(sizeof(T), alignof(T), block_size) {}
+    
+    T* allocate() { return static_cast<T*>(slab_.allocate()); }
+    void deallocate(T* ptr) {
+        if (ptr) slab_.deallocate(ptr);
+    }
+    
+    template<typename... Args>
+    T* create(Args&&... args) {
+        T* ptr = allocate();
+        try {
+            return new (ptr) T(std::forward<Args>(args)...);
+        } catch (...) {
+            deallocate(ptr);
+            throw;
+        }
+    }
+    
+    void destroy(T* ptr) {
+        if (!ptr) return;
+        ptr->~T();
+        deallocate(ptr);
+    }
+    
+    // Free everything without running destructors
+    void reset() { slab_.reset(); }
+    
+    // Get statistics
+    PoolStatistics getStatistics() const { return slab_.getStatistics(); }
+    size_t getAllocatedCount() const { return getStatistics().live; }
+    size_t getCapacity() const { return getStatistics().capacity; }
+    size_t getMemoryUsage() const { return getStatistics().memory_usage; }
+    
+private:
+    SlabPool slab_;
+};
 
-template<typename T>
-MemoryPool<T>::~MemoryPool() {
-    reset();
-}
+// Pool shared by a PoolAllocator, its copies and its rebinds
+struct PoolAllocatorState {
+    std::unique_ptr<SlabPool> pool;
+    size_t slots_per_block;
+};
 
+// STL allocator for node-based containers (std::unordered_map, std::map, std::list).
+// Copies and rebinds share one SlabPool, created for the first single-object type
+// requested (the container's node); arrays such as hash buckets, and other types,
+// go to operator new. Like the container, it is not thread-safe.
 template<typename T>
-T* MemoryPool<T>::allocate() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    if (free_list_.empty()) {
-        // Check if current block has space
-        auto& current_block = blocks_.back();
-        if (current_block->used < block_size_) {
-            T* ptr = &current_block->memory[current_block->used++];
-            allocated_count_++;
-            return ptr;
-        } else {
-            // Need new block
-            allocateNewBlock();
+class PoolAllocator {
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    
+    explicit PoolAllocator(size_t slots_per_block = 4096)
+        : shared_(std::make_shared<PoolAllocatorState>(PoolAllocatorState{nullptr, slots_per_block})) {}
+    
+    template<typename U>
+    PoolAllocator(const PoolAllocator<U>& other) : shared_(other.getShared()) {}
+    
+    T* allocate(size_t count) {
+        if (count == 1) {
+            if (!shared_->pool) {
+                shared_->pool = std::make_unique<SlabPool>(sizeof(T), alignof(T), shared_->slots_per_block);
+            }
+            if (usesPool(count)) {
+                return static_cast<T*>(shared_->pool->allocate());
+            }
         }
+        return static_cast<T*>(::operator new(count * sizeof(T)));
     }
     
-    // Get from free list
-    T* ptr = free_list_.back();
-    free_list_.pop_back();
-    allocated_count_++;
-    return ptr;
-}
-
-template<typename T>
-void MemoryPool<T>::deallocate(T* ptr) {
-    if (!ptr) return;
+    void deallocate(T* ptr, size_t count) {
+        if (usesPool(count)) {
+            shared_->pool->deallocate(ptr);
+        } else {
+            ::operator delete(ptr);
+        }
+    }
     
-    std::lock_guard<std::mutex> lock(mutex_);
+    // Statistics of the shared pool (empty until the first node is allocated)
+    PoolStatistics getStatistics() const {
+        return shared_->pool ? shared_->pool->getStatistics() : PoolStatistics();
+    }
     
-    // Call destructor
-    ptr->~T();
+    const std::shared_ptr<PoolAllocatorState>& getShared() const { return shared_; }
     
-    // Add to free list
-    free_list_.push_back(ptr);
-    allocated_count_--;
-}
-
-template<typename T>
-void MemoryPool<T>::reset() {
-    std::lock_guard<std::mutex> lock(mutex_);
+    template<typename U>
+    bool operator==(const PoolAllocator<U>& other) const { return shared_ == other.getShared(); }
+    template<typename U>
+    bool operator!=(const PoolAllocator<U>& other) const { return shared_ != other.getShared(); }
     
-    // Clear all blocks
-    blocks_.clear();
-    free_list_.clear();
-    allocated_count_ = 0;
+private:
+    std::shared_ptr<PoolAllocatorState> shared_;
     
-    // Allocate initial block
-    allocateNewBlock();
-}
+    bool usesPool(size_t count) const {
+        return count == 1 && shared_->pool && shared_->pool->getSlotSize() == sizeof(T) &&
+               shared_->pool->getAlignment() >= alignof(T);
+    }
+};
 
-template<typename T>
-void MemoryPool<T>::allocateNewBlock() {
-    blocks_.push_back(std::make_unique<Block>(block_size_));
-}
+// Arena counters for profiling
+struct ArenaStatistics {
+    size_t allocations = 0;     // Since the last reset()
+    size_t bytes_used = 0;      // Since the last reset(), including alignment padding
+    size_t peak_bytes = 0;      // Largest bytes_used seen at a reset()
+    size_t capacity = 0;        // Bytes reserved from the system
+};
 
-// Specialized pool for Point structures
-class PointMemoryPool {
+// Bump allocator for scratch memory with one lifetime, e.g. a frame.
+// allocate() carves aligned bytes from the current block; reset() frees everything at
+// once and merges the blocks into one that fits the peak, so steady-state frames
+// allocate nothing. No destructors are run. Not thread-safe - one arena per thread.
+class Arena {
 public:
-    static PointMemoryPool& getInstance() {
-        static PointMemoryPool instance;
-        return instance;
+    explicit Arena(size_t block_bytes = size_t(1) << 20);
+    
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+    
+    template<typename T>
+    T* allocateArray(size_t count) {
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
     }
     
-    MemoryPool<Point>& getPool() { return pool_; }
+    void reset();
+    
+    ArenaStatistics getStatistics() const;
     
 private:
-    PointMemoryPool() : pool_(4096) {} // 4K points per block
-    MemoryPool<Point> pool_;
+    struct Block {
+        std::unique_ptr<unsigned char[]> memory;
+        size_t size;
+    };
+    
+    size_t block_bytes_;
+    std::vector<Block> blocks_;
+    size_t offset_ = 0;             // Into blocks_.back()
+    size_t allocations_ = 0;
+    size_t bytes_used_ = 0;
+    size_t peak_bytes_ = 0;
+};
+
+// STL allocator over an Arena for per-frame containers; deallocation is a no-op until
+// the arena is reset, so the container must not outlive the reset
+template<typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(Arena& arena) : arena_(&arena) {}
+
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.getArena()) {}
+
+    T* allocate(size_t count) { return arena_->allocateArray<T>(count); }
+    void deallocate(T*, size_t) {}
+
+    Arena* getArena() const { return arena_; }
+
+    template<typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena_ == other.getArena(); }
+    template<typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena_ != other.getArena(); }
+
+private:
+    Arena* arena_;
 };
 
 } // namespace pcv
\ No newline at end of file
@@ -1,12 +1,163 @@
 #include "core/Octree.h"
+#include "processing/VoxelDownsampling.h"
+#include "utils/Parallel.h"
+#include "utils/RadixSort.h"
 #include <algorithm>
+#include <bitset>
+#include <limits>
+#include <unordered_map>
 #include <glm/geometric.hpp>
 
 namespace pcv {
 
+namespace {
+
+// Spread the low 10 bits of v so there are two zero bits between each
+uint32_t expandBits(uint32_t v) {
+    v = (v | (v << 16)) & 0x030000FF;
+    v = (v | (v << 8)) & 0x0300F00F;
+    v = (v | (v << 4)) & 0x030C30C3;
+    v = (v | (v << 2)) & 0x09249249;
+    return v;
+}
+
+// Interleave so each 3-bit digit is an octant index (x = bit 0, y = bit 1, z = bit 2),
+// matching OctreeNode::getOctant
+uint32_t mortonEncode(uint32_t x, uint32_t y, uint32_t z) {
+    return expandBits(x) | (expandBits(y) << 1) | (expandBits(z) << 2);
+}
+
+glm::vec3 childMinBound(const glm::vec3& min_bound, const glm::vec3& center, int octant) {
+    return glm::vec3(octant & 1 ? center.x : min_bound.x,
+                     octant & 2 ? center.y : min_bound.y,
+                     octant & 4 ? center.z : min_bound.z);
+}
+
+glm::vec3 childMaxBound(const glm::vec3& max_bound, const glm::vec3& center, int octant) {
+    return glm::vec3(octant & 1 ? max_bound.x : center.x,
+                     octant & 2 ? max_bound.y : center.y,
+                     octant & 4 ? max_bound.z : center.z);
+}
+
+// Subtrees below this depth are built as independent parallel tasks.
+// Fixed, so the task split - and the resulting layout - never depends on thread count.
+constexpr int PARALLEL_SPLIT_DEPTH = 3;
+
+// Below this many points one thread builds the whole tree
+constexpr size_t PARALLEL_MIN_POINTS = size_t(1) << 16;
+
+// Incremental updates compact the buffers once dead entries outnumber live ones
+constexpr size_t COMPACT_MIN_GARBAGE = 4096;
+
+// Slack reserved when a leaf outgrows its slots
+uint32_t grownLeafCapacity(uint32_t required) {
+    return std::max<uint32_t>(16, required + required / 2);
+}
+
+// Cubic LOD cells sized by the node's longest axis, so flat nodes get flat sample sets
+float lodCellScale(const Octree::Node& node) {
+    glm::vec3 extent = node.max_bound - node.min_bound;
+    float max_extent = std::max(extent.x, std::max(extent.y, extent.z));
+    return max_extent > 0.0f ? Octree::LOD_GRID_SIZE / max_extent : 0.0f;
+}
+
+uint32_t lodCell(const Octree::Node& node, float scale, const glm::vec3& position) {
+    constexpr int grid_size = Octree::LOD_GRID_SIZE;
+    glm::vec3 cell = glm::clamp((position - node.min_bound) * scale,
+                                glm::vec3(0.0f), glm::vec3(static_cast<float>(grid_size - 1)));
+    return static_cast<uint32_t>(cell.x) +
+           grid_size * (static_cast<uint32_t>(cell.y) + grid_size * static_cast<uint32_t>(cell.z));
+}
+
+// Extend the previous span when the new one continues it (siblings are laid out in order)
+void appendSpan(std::vector<Octree::Span>& spans, const Octree::Span& span) {
+    if (span.begin == span.end) return;
+    if (!spans.empty() && spans.back().samples == span.samples && spans.back().end == span.begin) {
+        spans.back().end = span.end;
+    } else {
+        spans.push_back(span);
+    }
+}
+
+// Query visitor that appends every run to results
+template<typename Index>
+auto appendTo(std::vector<Index>& results) {
+    return [&results](const uint32_t* indices, size_t count) {
+        results.insert(results.end(), indices, indices + count);
+    };
+}
+
+int octantOf(const glm::vec3& point, const glm::vec3& center) {
+    return (point.x >= center.x ? 1 : 0) | (point.y >= center.y ? 2 : 0) | (point.z >= center.z ? 4 : 0);
+}
+
+} // namespace
+
+// Reused per thread while selecting LOD samples
+struct Octree::SampleScratch {
+    std::vector<int> voxel_of_cell;     // Dense LOD grid, -1 for empty cells
+    std::vector<uint32_t> touched_cells;
+    std::vector<VoxelDownsampling::Voxel> voxels;
+    std::vector<uint32_t> candidate_voxel;
+    std::vector<float> best_distance;
+    std::vector<uint32_t> candidates;
+};
+
+// Bucket candidates into a LOD grid over the node; each occupied voxel is represented
+// by its real point closest to the voxel centroid
+void Octree::selectSamples(const std::vector<glm::vec3>& positions, const Node& node,
+                           SampleScratch& scratch, std::vector<uint32_t>& samples) {
+    const auto& candidates = scratch.candidates;
+    const float scale = lodCellScale(node);
+    
+    scratch.voxel_of_cell.resize(static_cast<size_t>(LOD_GRID_SIZE) * LOD_GRID_SIZE * LOD_GRID_SIZE, -1);
+    scratch.touched_cells.clear();
+    scratch.voxels.clear();
+    scratch.candidate_voxel.resize(candidates.size());
+    
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        const glm::vec3& position = positions[candidates[i]];
+        const uint32_t cell_id = lodCell(node, scale, position);
+        int& voxel_index = scratch.voxel_of_cell[cell_id];
+        if (voxel_index < 0) {
+            voxel_index = static_cast<int>(scratch.voxels.size());
+            scratch.voxels.emplace_back();
+            scratch.touched_cells.push_back(cell_id);
+        }
+        
+        VoxelDownsampling::Voxel& voxel = scratch.voxels[voxel_index];
+        voxel.position_sum += position;
+        voxel.point_count++;
+        scratch.candidate_voxel[i] = static_cast<uint32_t>(voxel_index);
+    }
+    
+    for (uint32_t cell_id : scratch.touched_cells) {
+        scratch.voxel_of_cell[cell_id] = -1;
+    }
+    
+    scratch.best_distance.assign(scratch.voxels.size(), std::numeric_limits<float>::max());
+    samples.resize(scratch.voxels.size());
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        uint32_t voxel_index = scratch.candidate_voxel[i];
+        const VoxelDownsampling::Voxel& voxel = scratch.voxels[voxel_index];
+        glm::vec3 diff = positions[candidates[i]] - voxel.position_sum / static_cast<float>(voxel.point_count);
+        float dist_sq = glm::dot(diff, diff);
+        if (dist_sq < scratch.best_distance[voxel_index]) {
+            scratch.best_distance[voxel_index] = dist_sq;
+            samples[voxel_index] = candidates[i];
+        }
+    }
+}
+
 // OctreeNode Implementation
-OctreeNode::OctreeNode(const glm::vec3& min_bound, const glm::vec3& max_bound, int depth)
-    : min_bound_(min_bound), max_bound_(max_bound), depth_(depth) {
+OctreeNode::OctreeNode(const glm::vec3& min_bound, const glm::vec3& max_bound, Pool& pool, int depth)
+    : min_bound_(min_bound), max_bound_(max_bound), depth_(depth), pool_(pool) {
+}
+
+OctreeNode::~OctreeNode() {
+    for (OctreeNode* child : children_) {
+        pool_.destroy(child);
+    }
 }
 
 void OctreeNode::insertPoint(size_t point_index, const glm::vec3& position, const PointCloud& cloud) {
@@ -36,7 +187,7 @@ void OctreeNode::subdivide(const PointCloud& cloud) {
         if (i & 2) child_min.y = center.y; else child_max.y = center.y;
         if (i & 4) child_min.z = center.z; else child_max.z = center.z;
         
-        children_[i] = std::make_unique<OctreeNode>(child_min, child_max, depth_ + 1);
+        children_[i] = pool_.create(child_min, child_max, pool_, depth_ + 1);
     }
     
     // Redistribute points to children
@@ -44,7 +195,7 @@ void OctreeNode::subdivide(const PointCloud& cloud) {
     point_indices_.clear();
     
     for (size_t idx : temp_indices) {
-        const glm::vec3& pos = cloud[idx].position;
+        const glm::vec3& pos = cloud.getPosition(idx);
         int octant = getOctant(pos);
         children_[octant]->insertPoint(idx, pos, cloud);
     }
@@ -62,266 +213,1078 @@ int OctreeNode::getOctant(const glm::vec3& point) const {
 }
 
 // Octree Implementation
-Octree::Octree(const PointCloud& cloud) : cloud_(cloud) {
+int Octree::Node::getChildCount() const {
+    return static_cast<int>(std::bitset<8>(child_mask).count());
+}
+
+Octree::Octree(const PointCloud& cloud, BuildMode mode) : cloud_(cloud), build_mode_(mode) {
 }
 
 void Octree::build() {
+    revision_++;
+    nodes_.clear();
+    indices_.clear();
+    samples_.clear();
+    resetStatistics();
+    
     if (cloud_.empty()) return;
     
-    // Create root node with cloud bounds
-    root_ = std::make_unique<OctreeNode>(cloud_.getMinBound(), cloud_.getMaxBound());
+    // Cubic root around the cloud bounds keeps every node cubic, so node size
+    // is a meaningful measure of sample spacing
+    glm::vec3 center = (cloud_.getMinBound() + cloud_.getMaxBound()) * 0.5f;
+    glm::vec3 extent = cloud_.getMaxBound() - cloud_.getMinBound();
+    float half_size = 0.5f * std::max(extent.x, std::max(extent.y, extent.z));
+    glm::vec3 root_min = center - glm::vec3(half_size);
+    glm::vec3 root_max = center + glm::vec3(half_size);
     
-    // Insert all points
-    for (size_t i = 0; i < cloud_.size(); ++i) {
-        root_->insertPoint(i, cloud_[i].position, cloud_);
+    if (build_mode_ == INSERTION) {
+        buildInsertion(root_min, root_max);
+    } else {
+        buildMorton(root_min, root_max);
+    }
+    
+    // Leaves start with exactly as many slots as points
+    for (auto& node : nodes_) {
+        node.point_count = node.end - node.begin;
+        node.capacity = node.isLeaf() ? node.point_count : 0;
     }
+    
+    updateStatistics();
+    buildLOD();
 }
 
-std::vector<size_t> Octree::queryFrustum(const FrustumPlanes& frustum) const {
-    std::vector<size_t> results;
-    if (root_) {
-        queryFrustumRecursive(root_.get(), frustum, results);
+void Octree::buildMorton(const glm::vec3& root_min, const glm::vec3& root_max) {
+    const auto& positions = cloud_.getPositions();
+    const size_t count = positions.size();
+    
+    // Quantize positions onto the finest grid the tree can reach
+    constexpr uint32_t grid_size = 1u << OctreeNode::MAX_DEPTH;
+    glm::vec3 min_bound = root_min;
+    glm::vec3 extent = root_max - root_min;
+    glm::vec3 scale(0.0f);
+    for (int axis = 0; axis < 3; ++axis) {
+        if (extent[axis] > 0.0f) scale[axis] = grid_size / extent[axis];
+    }
+    
+    // Morton code in the high half, point index in the low half
+    const size_t num_threads = resolveThreadCount(std::max(num_threads_, 0));
+    
+    std::vector<uint64_t> keys(count);
+    parallelFor(count, num_threads, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            glm::vec3 cell = glm::clamp((positions[i] - min_bound) * scale,
+                                        glm::vec3(0.0f), glm::vec3(grid_size - 1));
+            uint32_t code = mortonEncode(static_cast<uint32_t>(cell.x),
+                                         static_cast<uint32_t>(cell.y),
+                                         static_cast<uint32_t>(cell.z));
+            keys[i] = (static_cast<uint64_t>(code) << 32) | i;
+        }
+    });
+    
+    // One sort puts every subtree in a contiguous run
+    radixSort(keys, 32, 32 + 3 * OctreeNode::MAX_DEPTH, num_threads);
+    
+    indices_.resize(count);
+    parallelFor(count, num_threads, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            indices_[i] = static_cast<uint32_t>(keys[i]);
+        }
+    });
+    
+    Node root;
+    root.min_bound = root_min;
+    root.max_bound = root_max;
+    root.begin = 0;
+    root.end = static_cast<uint32_t>(count);
+    nodes_.push_back(root);
+    
+    if (num_threads > 1 && count >= PARALLEL_MIN_POINTS) {
+        buildMortonParallel(keys, num_threads);
+    } else {
+        buildMortonRange(nodes_, 0, keys, OctreeNode::MAX_DEPTH);
     }
-    return results;
 }
 
-std::vector<size_t> Octree::queryRadius(const glm::vec3& center, float radius) const {
-    std::vector<size_t> results;
-    if (root_) {
-        queryRadiusRecursive(root_.get(), center, radius, results);
+void Octree::buildMortonParallel(const std::vector<uint64_t>& keys, size_t num_threads) {
+    // Split the top levels, then build every subtree that still needs splitting on its own
+    std::vector<Node> top(1, nodes_[0]);
+    buildMortonRange(top, 0, keys, PARALLEL_SPLIT_DEPTH);
+    
+    std::vector<uint32_t> task_nodes;
+    std::vector<int> task_of(top.size(), -1);
+    for (uint32_t i = 0; i < top.size(); ++i) {
+        if (top[i].depth == PARALLEL_SPLIT_DEPTH &&
+            top[i].end - top[i].begin > OctreeNode::MAX_POINTS_PER_LEAF) {
+            task_of[i] = static_cast<int>(task_nodes.size());
+            task_nodes.push_back(i);
+        }
     }
-    return results;
+    
+    std::vector<std::vector<Node>> subtrees(task_nodes.size());
+    parallelFor(task_nodes.size(), num_threads, [&](size_t, size_t begin, size_t end) {
+        for (size_t task = begin; task < end; ++task) {
+            subtrees[task].assign(1, top[task_nodes[task]]);
+            buildMortonRange(subtrees[task], 0, keys, OctreeNode::MAX_DEPTH);
+        }
+    }, 1);
+    
+    // Reassemble in the order the serial recursion emits nodes
+    nodes_.assign(1, top[0]);
+    spliceSubtrees(top, task_of, subtrees, 0, 0);
 }
 
-std::vector<size_t> Octree::queryBox(const glm::vec3& min_bound, const glm::vec3& max_bound) const {
-    std::vector<size_t> results;
-    if (root_) {
-        queryBoxRecursive(root_.get(), min_bound, max_bound, results);
+void Octree::spliceSubtrees(const std::vector<Node>& top, const std::vector<int>& task_of,
+                            const std::vector<std::vector<Node>>& subtrees,
+                            uint32_t top_index, uint32_t node_index) {
+    const Node& source = top[top_index];
+    
+    if (task_of[top_index] >= 0) {
+        // Local node i of the subtree (root excluded) lands at offset + i
+        const auto& subtree = subtrees[task_of[top_index]];
+        const uint32_t offset = static_cast<uint32_t>(nodes_.size()) - 1;
+        nodes_[node_index].first_child = subtree[0].first_child + offset;
+        nodes_[node_index].child_mask = subtree[0].child_mask;
+        for (size_t i = 1; i < subtree.size(); ++i) {
+            Node node = subtree[i];
+            if (!node.isLeaf()) node.first_child += offset;
+            nodes_.push_back(node);
+        }
+        return;
+    }
+    
+    if (source.isLeaf()) return;
+    
+    const uint32_t first_child = static_cast<uint32_t>(nodes_.size());
+    const int child_count = source.getChildCount();
+    nodes_[node_index].first_child = first_child;
+    nodes_[node_index].child_mask = source.child_mask;
+    for (int i = 0; i < child_count; ++i) {
+        Node child = top[source.first_child + i];
+        child.first_child = 0;
+        child.child_mask = 0;
+        nodes_.push_back(child);
+    }
+    
+    for (int i = 0; i < child_count; ++i) {
+        spliceSubtrees(top, task_of, subtrees, source.first_child + i, first_child + i);
     }
-    return results;
 }
 
-std::vector<size_t> Octree::queryLOD(const glm::vec3& view_position, 
-                                     const FrustumPlanes& frustum,
-                                     float base_distance) const {
-    std::vector<size_t> results;
-    if (root_) {
-        queryLODRecursive(root_.get(), view_position, frustum, base_distance, results);
+void Octree::buildMortonRange(std::vector<Node>& nodes, uint32_t node_index,
+                              const std::vector<uint64_t>& keys, int max_depth) {
+    // Copy - nodes grows below
+    const Node node = nodes[node_index];
+    if (node.end - node.begin <= OctreeNode::MAX_POINTS_PER_LEAF || node.depth >= max_depth) {
+        return;
+    }
+    
+    // Keys in the range share their leading digits; the next digit is the octant
+    const int shift = 32 + 3 * (OctreeNode::MAX_DEPTH - 1 - node.depth);
+    const glm::vec3 center = node.getCenter();
+    const uint32_t first_child = static_cast<uint32_t>(nodes.size());
+    uint8_t child_mask = 0;
+    
+    uint32_t child_begin = node.begin;
+    for (int octant = 0; octant < 8 && child_begin < node.end; ++octant) {
+        auto split = std::partition_point(keys.begin() + child_begin, keys.begin() + node.end,
+                                          [shift, octant](uint64_t key) {
+                                              return static_cast<int>((key >> shift) & 7) <= octant;
+                                          });
+        uint32_t child_end = static_cast<uint32_t>(split - keys.begin());
+        if (child_end == child_begin) continue;
+        
+        Node child;
+        child.min_bound = childMinBound(node.min_bound, center, octant);
+        child.max_bound = childMaxBound(node.max_bound, center, octant);
+        child.begin = child_begin;
+        child.end = child_end;
+        child.depth = static_cast<uint8_t>(node.depth + 1);
+        nodes.push_back(child);
+        
+        child_mask |= static_cast<uint8_t>(1u << octant);
+        child_begin = child_end;
+    }
+    
+    nodes[node_index].first_child = first_child;
+    nodes[node_index].child_mask = child_mask;
+    
+    // Children are contiguous, so recursion appends grandchildren after them
+    const int child_count = nodes[node_index].getChildCount();
+    for (int i = 0; i < child_count; ++i) {
+        buildMortonRange(nodes, first_child + i, keys, max_depth);
     }
-    return results;
 }
 
-bool Octree::isNodeInFrustum(const OctreeNode* node, const FrustumPlanes& frustum) const {
-    // Check if bounding box intersects frustum
-    const glm::vec3& min_bound = node->getMinBound();
-    const glm::vec3& max_bound = node->getMaxBound();
+void Octree::buildInsertion(const glm::vec3& root_min, const glm::vec3& root_max) {
+    // Create root node; the whole temporary tree lives in one pool
+    OctreeNode::Pool pool(4096);
+    OctreeNode* root = pool.create(root_min, root_max, pool);
     
-    for (const auto& plane : frustum) {
-        glm::vec3 p_vertex(
-            plane.x > 0 ? max_bound.x : min_bound.x,
-            plane.y > 0 ? max_bound.y : min_bound.y,
-            plane.z > 0 ? max_bound.z : min_bound.z
-        );
+    // Insert all points
+    for (size_t i = 0; i < cloud_.size(); ++i) {
+        root->insertPoint(i, cloud_.getPosition(i), cloud_);
+    }
+    
+    indices_.reserve(cloud_.size());
+    
+    Node flat_root;
+    flat_root.min_bound = root->getMinBound();
+    flat_root.max_bound = root->getMaxBound();
+    nodes_.push_back(flat_root);
+    
+    flattenRecursive(root, 0);
+    pool.destroy(root);
+}
+
+void Octree::flattenRecursive(const OctreeNode* source, uint32_t node_index) {
+    nodes_[node_index].begin = static_cast<uint32_t>(indices_.size());
+    
+    if (source->isLeaf()) {
+        for (size_t idx : source->getPointIndices()) {
+            indices_.push_back(static_cast<uint32_t>(idx));
+        }
+    } else {
+        // Subdivided nodes always have all eight children
+        uint32_t first_child = static_cast<uint32_t>(nodes_.size());
+        nodes_[node_index].first_child = first_child;
+        nodes_[node_index].child_mask = 0xFF;
         
-        if (distanceToPlane(p_vertex, plane) < 0) {
-            return false; // Outside this plane
+        for (int i = 0; i < 8; ++i) {
+            const OctreeNode* child = source->getChild(i);
+            Node flat_child;
+            flat_child.min_bound = child->getMinBound();
+            flat_child.max_bound = child->getMaxBound();
+            flat_child.depth = static_cast<uint8_t>(child->getDepth());
+            nodes_.push_back(flat_child);
+        }
+        
+        for (int i = 0; i < 8; ++i) {
+            flattenRecursive(source->getChild(i), first_child + i);
         }
     }
     
-    return true; // Inside all planes
+    nodes_[node_index].end = static_cast<uint32_t>(indices_.size());
 }
 
-bool Octree::isPointInFrustum(const glm::vec3& point, const FrustumPlanes& frustum) const {
-    for (const auto& plane : frustum) {
-        if (distanceToPlane(point, plane) < 0) {
-            return false;
-        }
+void Octree::resetStatistics() {
+    live_nodes_ = 0;
+    leaf_count_ = 0;
+    depth_counts_.clear();
+    garbage_nodes_ = 0;
+    garbage_indices_ = 0;
+    garbage_samples_ = 0;
+}
+
+void Octree::updateStatistics() {
+    resetStatistics();
+    for (const auto& node : nodes_) {
+        countNode(node, 1);
     }
-    return true;
 }
 
-float Octree::distanceToPlane(const glm::vec3& point, const glm::vec4& plane) const {
-    return plane.x * point.x + plane.y * point.y + plane.z * point.z + plane.w;
+void Octree::countNode(const Node& node, int delta) {
+    live_nodes_ += delta;
+    if (node.isLeaf()) leaf_count_ += delta;
+    if (depth_counts_.size() <= node.depth) depth_counts_.resize(node.depth + 1, 0);
+    depth_counts_[node.depth] += delta;
 }
 
-void Octree::queryFrustumRecursive(const OctreeNode* node, 
-                                   const FrustumPlanes& frustum,
-                                   std::vector<size_t>& results) const {
-    if (!isNodeInFrustum(node, frustum)) {
-        return; // Early rejection
+int Octree::getMaxDepth() const {
+    for (size_t depth = depth_counts_.size(); depth > 0; --depth) {
+        if (depth_counts_[depth - 1] > 0) return static_cast<int>(depth - 1);
+    }
+    return 0;
+}
+
+void Octree::buildLOD() {
+    samples_.clear();
+    if (nodes_.empty()) return;
+    
+    // Group interior nodes by depth; children are always complete before their parent's level runs
+    const int max_depth = getMaxDepth();
+    std::vector<std::vector<uint32_t>> levels(max_depth + 1);
+    for (uint32_t i = 0; i < nodes_.size(); ++i) {
+        if (!nodes_[i].isLeaf()) levels[nodes_[i].depth].push_back(i);
     }
     
-    if (node->isLeaf()) {
-        // Add all points in this leaf that are inside frustum
-        for (size_t idx : node->getPointIndices()) {
-            if (isPointInFrustum(cloud_[idx].position, frustum)) {
-                results.push_back(idx);
+    std::vector<std::vector<uint32_t>> node_samples(nodes_.size());
+    const size_t num_threads = resolveThreadCount(std::max(num_threads_, 0));
+    std::vector<SampleScratch> thread_scratch(num_threads);
+    const auto& positions = cloud_.getPositions();
+    
+    for (int depth = max_depth; depth >= 0; --depth) {
+        const auto& level = levels[depth];
+        parallelFor(level.size(), num_threads, [&](size_t thread_index, size_t begin, size_t end) {
+            SampleScratch& scratch = thread_scratch[thread_index];
+            auto& candidates = scratch.candidates;
+            for (size_t l = begin; l < end; ++l) {
+                const Node& node = nodes_[level[l]];
+                
+                // Leaves offer all their points, interior children their own samples
+                candidates.clear();
+                for (int c = 0; c < node.getChildCount(); ++c) {
+                    uint32_t child_index = node.first_child + c;
+                    const Node& child = nodes_[child_index];
+                    if (child.isLeaf()) {
+                        candidates.insert(candidates.end(), indices_.begin() + child.begin,
+                                          indices_.begin() + child.end);
+                    } else {
+                        candidates.insert(candidates.end(), node_samples[child_index].begin(),
+                                          node_samples[child_index].end());
+                    }
+                }
+                
+                selectSamples(positions, node, scratch, node_samples[level[l]]);
             }
-        }
+        }, 1);
+    }
+    
+    // Pack into one buffer in node order
+    for (uint32_t i = 0; i < nodes_.size(); ++i) {
+        nodes_[i].sample_begin = static_cast<uint32_t>(samples_.size());
+        samples_.insert(samples_.end(), node_samples[i].begin(), node_samples[i].end());
+        nodes_[i].sample_end = static_cast<uint32_t>(samples_.size());
+    }
+}
+
+void Octree::insert(size_t begin, size_t end) {
+    end = std::min(end, cloud_.size());
+    if (begin >= end) return;
+    
+    // The whole cloud into an empty tree (e.g. the first streamed batch): a full build is faster
+    if (nodes_.empty() && begin == 0 && end == cloud_.size()) {
+        build();
+        return;
+    }
+    revision_++;
+    
+    std::vector<uint32_t> batch(end - begin);
+    glm::vec3 batch_min(std::numeric_limits<float>::max());
+    glm::vec3 batch_max(std::numeric_limits<float>::lowest());
+    for (size_t i = begin; i < end; ++i) {
+        batch[i - begin] = static_cast<uint32_t>(i);
+        batch_min = glm::min(batch_min, cloud_.getPosition(i));
+        batch_max = glm::max(batch_max, cloud_.getPosition(i));
+    }
+    
+    SampleScratch scratch;
+    if (nodes_.empty()) {
+        // First batch into an empty tree: cubic root around the batch
+        glm::vec3 center = (batch_min + batch_max) * 0.5f;
+        glm::vec3 extent = batch_max - batch_min;
+        float half_size = 0.5f * std::max(extent.x, std::max(extent.y, extent.z));
+        
+        Node root;
+        root.min_bound = center - glm::vec3(half_size);
+        root.max_bound = center + glm::vec3(half_size);
+        nodes_.push_back(root);
+        countNode(root, 1);
     } else {
-        // Recurse into children
-        for (int i = 0; i < 8; ++i) {
-            if (node->getChild(i)) {
-                queryFrustumRecursive(node->getChild(i), frustum, results);
+        growRoot(batch_min, batch_max, scratch);
+    }
+    
+    insertRecursive(0, batch, scratch);
+    compactIfFragmented();
+}
+
+void Octree::erase(const std::vector<size_t>& point_indices) {
+    if (nodes_.empty() || point_indices.empty()) return;
+    revision_++;
+    
+    std::vector<uint32_t> batch;
+    batch.reserve(point_indices.size());
+    for (size_t idx : point_indices) {
+        if (idx < cloud_.size()) batch.push_back(static_cast<uint32_t>(idx));
+    }
+    
+    SampleScratch scratch;
+    eraseRecursive(0, batch, scratch);
+    compactIfFragmented();
+}
+
+void Octree::growRoot(const glm::vec3& min_bound, const glm::vec3& max_bound, SampleScratch& scratch) {
+    auto contains = [&](const Node& node) {
+        for (int axis = 0; axis < 3; ++axis) {
+            if (min_bound[axis] < node.min_bound[axis] || max_bound[axis] > node.max_bound[axis]) return false;
+        }
+        return true;
+    };
+    
+    // Double the root towards the new points until it contains them; the old root
+    // becomes one octant of the new one. Bounded so non-finite input cannot loop forever.
+    for (int step = 0; step < 64 && !contains(nodes_[0]); ++step) {
+        Node old_root = nodes_[0];
+        glm::vec3 extent = old_root.max_bound - old_root.min_bound;
+        float size = std::max(extent.x, std::max(extent.y, extent.z));
+        if (size <= 0.0f) {
+            glm::vec3 span = glm::max(max_bound - old_root.min_bound, old_root.max_bound - min_bound);
+            size = std::max(std::max(span.x, std::max(span.y, span.z)), 1e-6f);
+        }
+        
+        Node root;
+        int octant = 0;
+        for (int axis = 0; axis < 3; ++axis) {
+            if (min_bound[axis] < old_root.min_bound[axis]) {
+                // Grow downwards: the old root is the upper half on this axis
+                root.min_bound[axis] = old_root.min_bound[axis] - size;
+                root.max_bound[axis] = old_root.min_bound[axis] + size;
+                octant |= 1 << axis;
+            } else {
+                root.min_bound[axis] = old_root.min_bound[axis];
+                root.max_bound[axis] = old_root.min_bound[axis] + 2.0f * size;
             }
         }
+        
+        // Every existing node moves one level down (rare: once per doubling of the extent)
+        for (auto& node : nodes_) {
+            node.depth++;
+        }
+        depth_counts_.insert(depth_counts_.begin(), 0);
+        
+        old_root.depth = 1;
+        old_root.max_bound = old_root.min_bound + glm::vec3(size);
+        const uint32_t old_root_index = static_cast<uint32_t>(nodes_.size());
+        nodes_.push_back(old_root);
+        
+        root.first_child = old_root_index;
+        root.child_mask = static_cast<uint8_t>(1u << octant);
+        root.point_count = old_root.point_count;
+        nodes_[0] = root;
+        countNode(root, 1);
+        
+        // Sample the existing points now: when the batch needs further doublings it lands
+        // in other octants, so the insert pass never reaches this root's old region and
+        // the next root up could only select from an empty range. The insert pass then
+        // adds the batch to the final root's samples.
+        if (old_root.point_count > 0) {
+            updateSamples(0, scratch);
+        }
     }
 }
 
-void Octree::queryRadiusRecursive(const OctreeNode* node,
-                                  const glm::vec3& center,
-                                  float radius,
-                                  std::vector<size_t>& results) const {
-    // Check if node bounding box intersects sphere
-    glm::vec3 closest = glm::clamp(center, node->getMinBound(), node->getMaxBound());
-    float dist_sq = glm::dot(center - closest, center - closest);
+uint32_t Octree::ensureChild(uint32_t node_index, int octant) {
+    const Node parent = nodes_[node_index];
+    const uint8_t bit = static_cast<uint8_t>(1u << octant);
+    if (parent.child_mask & bit) {
+        uint8_t lower = static_cast<uint8_t>(parent.child_mask & (bit - 1));
+        return parent.first_child + static_cast<uint32_t>(std::bitset<8>(lower).count());
+    }
+    
+    // Children must stay contiguous in octant order: move the block to the end with the new child
+    const uint32_t first_child = static_cast<uint32_t>(nodes_.size());
+    const glm::vec3 center = parent.getCenter();
+    uint32_t new_child = 0;
+    uint32_t old_child = parent.first_child;
     
-    if (dist_sq > radius * radius) {
-        return; // No intersection
+    for (int o = 0; o < 8; ++o) {
+        if (o == octant) {
+            Node child;
+            child.min_bound = childMinBound(parent.min_bound, center, o);
+            child.max_bound = childMaxBound(parent.max_bound, center, o);
+            child.depth = static_cast<uint8_t>(parent.depth + 1);
+            new_child = static_cast<uint32_t>(nodes_.size());
+            nodes_.push_back(child);
+            countNode(child, 1);
+        } else if (parent.child_mask & (1u << o)) {
+            nodes_.push_back(nodes_[old_child]);
+            releaseNode(old_child++);
+        }
     }
     
-    if (node->isLeaf()) {
-        // Check each point
-        float radius_sq = radius * radius;
-        for (size_t idx : node->getPointIndices()) {
-            glm::vec3 diff = cloud_[idx].position - center;
-            if (glm::dot(diff, diff) <= radius_sq) {
-                results.push_back(idx);
+    nodes_[node_index].first_child = first_child;
+    nodes_[node_index].child_mask = static_cast<uint8_t>(parent.child_mask | bit);
+    return new_child;
+}
+
+void Octree::releaseNode(uint32_t node_index) {
+    // Dead slots look like empty leaves, so linear scans over nodes_ pass over them
+    Node& node = nodes_[node_index];
+    node.child_mask = 0;
+    node.first_child = 0;
+    node.begin = node.end = 0;
+    node.capacity = 0;
+    node.point_count = 0;
+    node.sample_begin = node.sample_end = 0;
+    garbage_nodes_++;
+}
+
+void Octree::appendToLeaf(uint32_t node_index, const std::vector<uint32_t>& points) {
+    Node& node = nodes_[node_index];
+    const uint32_t count = node.end - node.begin;
+    const uint32_t required = count + static_cast<uint32_t>(points.size());
+    
+    if (required > node.capacity) {
+        // Relocate to the end of the index buffer with room to grow
+        uint32_t capacity = grownLeafCapacity(required);
+        uint32_t begin = static_cast<uint32_t>(indices_.size());
+        indices_.resize(indices_.size() + capacity);
+        std::copy(indices_.begin() + node.begin, indices_.begin() + node.end, indices_.begin() + begin);
+        
+        garbage_indices_ += node.capacity;
+        node.begin = begin;
+        node.end = begin + count;
+        node.capacity = capacity;
+    }
+    
+    std::copy(points.begin(), points.end(), indices_.begin() + node.end);
+    node.end += static_cast<uint32_t>(points.size());
+}
+
+void Octree::insertRecursive(uint32_t node_index, std::vector<uint32_t>& points, SampleScratch& scratch) {
+    nodes_[node_index].point_count += static_cast<uint32_t>(points.size());
+    
+    if (nodes_[node_index].isLeaf()) {
+        appendToLeaf(node_index, points);
+        
+        Node& leaf = nodes_[node_index];
+        if (leaf.point_count <= OctreeNode::MAX_POINTS_PER_LEAF || leaf.depth >= OctreeNode::MAX_DEPTH) {
+            return;
+        }
+        
+        // Overfull: release the leaf's slots and push all of its points down a level
+        points.assign(indices_.begin() + leaf.begin, indices_.begin() + leaf.end);
+        garbage_indices_ += leaf.capacity;
+        leaf.begin = leaf.end = 0;
+        leaf.capacity = 0;
+        leaf_count_--;
+    }
+    
+    // Partition the batch by octant and recurse
+    const glm::vec3 center = nodes_[node_index].getCenter();
+    std::array<std::vector<uint32_t>, 8> parts;
+    for (uint32_t idx : points) {
+        parts[octantOf(cloud_.getPosition(idx), center)].push_back(idx);
+    }
+    
+    for (int octant = 0; octant < 8; ++octant) {
+        if (parts[octant].empty()) continue;
+        uint32_t child = ensureChild(node_index, octant);
+        insertRecursive(child, parts[octant], scratch);
+    }
+    
+    addSamples(node_index, points, scratch);
+}
+
+uint32_t Octree::eraseRecursive(uint32_t node_index, std::vector<uint32_t>& points, SampleScratch& scratch) {
+    if (nodes_[node_index].isLeaf()) {
+        // One pass over the leaf against the sorted batch, keeping leaf order
+        std::sort(points.begin(), points.end());
+        Node& leaf = nodes_[node_index];
+        auto leaf_end = std::remove_if(indices_.begin() + leaf.begin, indices_.begin() + leaf.end,
+                                       [&points](uint32_t idx) {
+                                           return std::binary_search(points.begin(), points.end(), idx);
+                                       });
+        uint32_t new_end = static_cast<uint32_t>(leaf_end - indices_.begin());
+        uint32_t removed = leaf.end - new_end;
+        leaf.end = new_end;
+        leaf.point_count -= removed;
+        return removed;
+    }
+    
+    // Route each point to every child whose slightly padded box holds it; points on a
+    // split plane may have been placed on either side by the Morton quantization
+    const Node node = nodes_[node_index];
+    const int child_count = node.getChildCount();
+    const float tolerance = 1e-5f * (node.max_bound.x - node.min_bound.x);
+    std::array<std::vector<uint32_t>, 8> parts;
+    for (uint32_t idx : points) {
+        const glm::vec3& position = cloud_.getPosition(idx);
+        for (int c = 0; c < child_count; ++c) {
+            const Node& child = nodes_[node.first_child + c];
+            bool inside = true;
+            for (int axis = 0; axis < 3; ++axis) {
+                inside = inside && position[axis] >= child.min_bound[axis] - tolerance &&
+                         position[axis] <= child.max_bound[axis] + tolerance;
             }
+            if (inside) parts[c].push_back(idx);
         }
+    }
+    
+    uint32_t removed = 0;
+    for (int c = 0; c < child_count; ++c) {
+        if (parts[c].empty()) continue;
+        removed += eraseRecursive(node.first_child + c, parts[c], scratch);
+    }
+    
+    if (removed == 0) return 0;
+    
+    nodes_[node_index].point_count -= removed;
+    if (nodes_[node_index].point_count <= OctreeNode::MAX_POINTS_PER_LEAF / 2) {
+        mergeSubtree(node_index);
     } else {
-        // Recurse into children
-        for (int i = 0; i < 8; ++i) {
-            if (node->getChild(i)) {
-                queryRadiusRecursive(node->getChild(i), center, radius, results);
+        updateSamples(node_index, scratch);
+    }
+    return removed;
+}
+
+void Octree::mergeSubtree(uint32_t node_index) {
+    std::vector<uint32_t> points;
+    points.reserve(nodes_[node_index].point_count);
+    
+    // Collect the leaves' points and release every descendant
+    std::vector<uint32_t> stack(1, node_index);
+    while (!stack.empty()) {
+        uint32_t current = stack.back();
+        stack.pop_back();
+        
+        const Node node = nodes_[current];
+        if (node.isLeaf()) {
+            points.insert(points.end(), indices_.begin() + node.begin, indices_.begin() + node.end);
+            garbage_indices_ += node.capacity;
+        } else {
+            for (int i = 0; i < node.getChildCount(); ++i) {
+                stack.push_back(node.first_child + i);
             }
         }
+        
+        if (current != node_index) {
+            countNode(node, -1);
+            releaseNode(current);
+        }
+    }
+    
+    Node& merged = nodes_[node_index];
+    garbage_samples_ += merged.sample_end - merged.sample_begin;
+    merged.sample_begin = merged.sample_end = 0;
+    merged.child_mask = 0;
+    merged.first_child = 0;
+    merged.begin = static_cast<uint32_t>(indices_.size());
+    merged.end = merged.begin + static_cast<uint32_t>(points.size());
+    merged.capacity = static_cast<uint32_t>(points.size());
+    merged.point_count = static_cast<uint32_t>(points.size());
+    indices_.insert(indices_.end(), points.begin(), points.end());
+    leaf_count_++;
+}
+
+void Octree::updateSamples(uint32_t node_index, SampleScratch& scratch) {
+    const Node node = nodes_[node_index];
+    
+    auto& candidates = scratch.candidates;
+    candidates.clear();
+    for (int c = 0; c < node.getChildCount(); ++c) {
+        const Node& child = nodes_[node.first_child + c];
+        if (child.isLeaf()) {
+            candidates.insert(candidates.end(), indices_.begin() + child.begin, indices_.begin() + child.end);
+        } else {
+            candidates.insert(candidates.end(), samples_.begin() + child.sample_begin,
+                              samples_.begin() + child.sample_end);
+        }
     }
+    
+    std::vector<uint32_t> samples;
+    selectSamples(cloud_.getPositions(), node, scratch, samples);
+    
+    // Reuse the node's range when the new samples fit, otherwise append
+    Node& target = nodes_[node_index];
+    uint32_t old_size = target.sample_end - target.sample_begin;
+    if (samples.size() <= old_size) {
+        std::copy(samples.begin(), samples.end(), samples_.begin() + target.sample_begin);
+        garbage_samples_ += old_size - samples.size();
+    } else {
+        garbage_samples_ += old_size;
+        target.sample_begin = static_cast<uint32_t>(samples_.size());
+        samples_.insert(samples_.end(), samples.begin(), samples.end());
+    }
+    target.sample_end = target.sample_begin + static_cast<uint32_t>(samples.size());
 }
 
-void Octree::queryLODRecursive(const OctreeNode* node,
-                               const glm::vec3& view_position,
-                               const FrustumPlanes& frustum,
-                               float base_distance,
-                               std::vector<size_t>& results) const {
-    if (!isNodeInFrustum(node, frustum)) {
+void Octree::addSamples(uint32_t node_index, const std::vector<uint32_t>& points, SampleScratch& scratch) {
+    const Node node = nodes_[node_index];
+    if (node.sample_begin == node.sample_end) {
+        updateSamples(node_index, scratch); // Newly split or new root: select from children
         return;
     }
     
-    // Calculate distance from view to node center
-    float dist = glm::length(view_position - node->getCenter());
+    constexpr uint32_t cell_count = LOD_GRID_SIZE * LOD_GRID_SIZE * LOD_GRID_SIZE;
+    if (node.sample_end - node.sample_begin >= cell_count) return; // Every cell already has a sample
     
-    // Determine LOD level based on distance and node size
-    float node_size = glm::length(node->getMaxBound() - node->getMinBound());
-    float detail_ratio = node_size / dist;
+    // Existing samples stay; new points only fill cells that have no sample yet, so the
+    // cost is the node's samples plus the batch rather than all of its children
+    const auto& positions = cloud_.getPositions();
+    const float scale = lodCellScale(node);
+    scratch.voxel_of_cell.resize(cell_count, -1);
+    scratch.touched_cells.clear();
+    for (uint32_t i = node.sample_begin; i < node.sample_end; ++i) {
+        uint32_t cell_id = lodCell(node, scale, positions[samples_[i]]);
+        if (scratch.voxel_of_cell[cell_id] < 0) {
+            scratch.voxel_of_cell[cell_id] = 0;
+            scratch.touched_cells.push_back(cell_id);
+        }
+    }
     
-    // If node is small enough relative to distance, use simplified representation
-    if (detail_ratio < 0.01f || node->getDepth() >= 5) {
-        // Add only a subset of points for distant nodes
-        const auto& indices = node->getPointIndices();
-        if (!indices.empty()) {
-            // Simple decimation: take every Nth point based on distance
-            int stride = std::max(1, static_cast<int>(dist / base_distance));
-            for (size_t i = 0; i < indices.size(); i += stride) {
-                results.push_back(indices[i]);
-            }
+    std::vector<uint32_t> samples(samples_.begin() + node.sample_begin, samples_.begin() + node.sample_end);
+    const size_t old_size = samples.size();
+    for (uint32_t idx : points) {
+        uint32_t cell_id = lodCell(node, scale, positions[idx]);
+        if (scratch.voxel_of_cell[cell_id] < 0) {
+            scratch.voxel_of_cell[cell_id] = 0;
+            scratch.touched_cells.push_back(cell_id);
+            samples.push_back(idx);
+        }
+    }
+    for (uint32_t cell_id : scratch.touched_cells) {
+        scratch.voxel_of_cell[cell_id] = -1;
+    }
+    
+    if (samples.size() == old_size) return;
+    
+    Node& target = nodes_[node_index];
+    garbage_samples_ += old_size;
+    target.sample_begin = static_cast<uint32_t>(samples_.size());
+    target.sample_end = target.sample_begin + static_cast<uint32_t>(samples.size());
+    samples_.insert(samples_.end(), samples.begin(), samples.end());
+}
+
+void Octree::compactIfFragmented() {
+    size_t live_indices = nodes_.empty() ? 0 : nodes_[0].point_count;
+    size_t live_samples = samples_.size() - garbage_samples_;
+    
+    // Amortized: a full pass only after at least as much garbage as live data has built up
+    if (garbage_indices_ > std::max(live_indices, COMPACT_MIN_GARBAGE) ||
+        garbage_nodes_ > std::max(live_nodes_, COMPACT_MIN_GARBAGE) ||
+        garbage_samples_ > std::max(live_samples, COMPACT_MIN_GARBAGE)) {
+        compact();
+    }
+}
+
+void Octree::compact() {
+    if (nodes_.empty()) return;
+    revision_++;
+    
+    std::vector<Node> nodes;
+    std::vector<uint32_t> indices;
+    std::vector<uint32_t> samples;
+    getCompactLayout(nodes, indices, samples);
+    
+    nodes_.swap(nodes);
+    indices_.swap(indices);
+    samples_.swap(samples);
+    updateStatistics();
+}
+
+void Octree::getCompactLayout(std::vector<Node>& nodes, std::vector<uint32_t>& indices,
+                              std::vector<uint32_t>& samples) const {
+    nodes.clear();
+    indices.clear();
+    samples.clear();
+    if (nodes_.empty()) return;
+    
+    nodes.reserve(live_nodes_);
+    indices.reserve(nodes_[0].point_count);
+    samples.reserve(samples_.size() - garbage_samples_);
+    nodes.push_back(nodes_[0]);
+    compactRecursive(0, 0, nodes, indices, samples);
+}
+
+bool Octree::setLayout(std::vector<Node> nodes, std::vector<uint32_t> indices, std::vector<uint32_t> samples) {
+    const size_t cloud_size = cloud_.size();
+    if (nodes.empty() != indices.empty()) return false;
+    
+    // Children must come after their parent, so the layout cannot contain cycles
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        const Node& node = nodes[i];
+        if (node.begin > node.end || node.end > indices.size() ||
+            node.sample_begin > node.sample_end || node.sample_end > samples.size()) {
+            return false;
         }
-    } else if (node->isLeaf()) {
-        // Close enough - add all points
-        results.insert(results.end(), 
-                      node->getPointIndices().begin(), 
-                      node->getPointIndices().end());
+        if (!node.isLeaf() && (node.first_child <= i ||
+                               node.first_child + static_cast<size_t>(node.getChildCount()) > nodes.size())) {
+            return false;
+        }
+    }
+    if (std::any_of(indices.begin(), indices.end(), [&](uint32_t index) { return index >= cloud_size; }) ||
+        std::any_of(samples.begin(), samples.end(), [&](uint32_t index) { return index >= cloud_size; })) {
+        return false;
+    }
+    
+    revision_++;
+    nodes_ = std::move(nodes);
+    indices_ = std::move(indices);
+    samples_ = std::move(samples);
+    for (auto& node : nodes_) {
+        node.capacity = node.isLeaf() ? node.end - node.begin : 0;
+    }
+    updateStatistics();
+    return true;
+}
+
+void Octree::compactRecursive(uint32_t source_index, uint32_t target_index, std::vector<Node>& nodes,
+                              std::vector<uint32_t>& indices, std::vector<uint32_t>& samples) const {
+    // Same order as the builders: children block first, then each child's subtree
+    const Node& source = nodes_[source_index];
+    const uint32_t begin = static_cast<uint32_t>(indices.size());
+    
+    nodes[target_index].sample_begin = static_cast<uint32_t>(samples.size());
+    samples.insert(samples.end(), samples_.begin() + source.sample_begin, samples_.begin() + source.sample_end);
+    nodes[target_index].sample_end = static_cast<uint32_t>(samples.size());
+    
+    if (source.isLeaf()) {
+        indices.insert(indices.end(), indices_.begin() + source.begin, indices_.begin() + source.end);
     } else {
-        // Recurse into children
-        for (int i = 0; i < 8; ++i) {
-            if (node->getChild(i)) {
-                queryLODRecursive(node->getChild(i), view_position, frustum, base_distance, results);
-            }
+        const uint32_t first_child = static_cast<uint32_t>(nodes.size());
+        const int child_count = source.getChildCount();
+        nodes[target_index].first_child = first_child;
+        for (int i = 0; i < child_count; ++i) {
+            nodes.push_back(nodes_[source.first_child + i]);
+        }
+        for (int i = 0; i < child_count; ++i) {
+            compactRecursive(source.first_child + i, first_child + i, nodes, indices, samples);
         }
     }
+    
+    Node& target = nodes[target_index];
+    target.begin = begin;
+    target.end = static_cast<uint32_t>(indices.size());
+    target.capacity = source.isLeaf() ? target.end - target.begin : 0;
+}
+
+float Octree::getSampleSpacing(const Node& node) const {
+    glm::vec3 extent = node.max_bound - node.min_bound;
+    return std::max(extent.x, std::max(extent.y, extent.z)) / LOD_GRID_SIZE;
 }
 
-void Octree::queryBoxRecursive(const OctreeNode* node,
-                               const glm::vec3& min_bound,
-                               const glm::vec3& max_bound,
-                               std::vector<size_t>& results) const {
-    // Check if node bounding box intersects query box
-    if (node->getMaxBound().x < min_bound.x || node->getMinBound().x > max_bound.x ||
-        node->getMaxBound().y < min_bound.y || node->getMinBound().y > max_bound.y ||
-        node->getMaxBound().z < min_bound.z || node->getMinBound().z > max_bound.z) {
-        return; // No intersection
+float Octree::getProjectedSpacing(const Node& node, const glm::vec3& view_position,
+                                  const LODParameters& params) const {
+    // Project the sample spacing at the nearest point of the node; children halve the
+    // spacing and are never closer, so the projected size only shrinks on the way down
+    glm::vec3 closest = glm::clamp(view_position, node.min_bound, node.max_bound);
+    float dist = glm::length(view_position - closest);
+    if (dist <= 0.0f) {
+        return std::numeric_limits<float>::max();
     }
+    return getSampleSpacing(node) * params.projection_scale / dist;
+}
+
+void Octree::selectLODBudget(const glm::vec3& view_position, const FrustumPlanes& frustum,
+                             const LODParameters& params, std::vector<Span>& spans) const {
+    // Best-first refinement of the cut: split the node whose samples project coarsest
+    // until its visible children no longer fit in the budget. The root is always drawn.
+    struct Candidate {
+        float spacing;
+        uint32_t node;
+        bool operator<(const Candidate& other) const { return spacing < other.spacing; }
+    };
+    auto drawn = [](const Node& node) -> size_t {
+        return node.isLeaf() ? node.end - node.begin : node.sample_end - node.sample_begin;
+    };
     
-    if (node->isLeaf()) {
-        // Check each point in the leaf
-        for (size_t idx : node->getPointIndices()) {
-            const glm::vec3& pos = cloud_[idx].position;
-            if (pos.x >= min_bound.x && pos.x <= max_bound.x &&
-                pos.y >= min_bound.y && pos.y <= max_bound.y &&
-                pos.z >= min_bound.z && pos.z <= max_bound.z) {
-                results.push_back(idx);
-            }
+    if (!isNodeInFrustum(nodes_[0], frustum)) return;
+    
+    std::vector<Candidate> heap;
+    std::vector<Span> cut;
+    auto place = [&](uint32_t node_index) {
+        const Node& node = nodes_[node_index];
+        float spacing = node.isLeaf() ? 0.0f : getProjectedSpacing(node, view_position, params);
+        if (spacing > params.pixel_threshold) {
+            heap.push_back({spacing, node_index});
+            std::push_heap(heap.begin(), heap.end());
+        } else if (node.isLeaf()) {
+            cut.push_back({node.begin, node.end, false});
+        } else {
+            cut.push_back({node.sample_begin, node.sample_end, true});
         }
-    } else {
-        // Recurse into children
-        for (int i = 0; i < 8; ++i) {
-            if (node->getChild(i)) {
-                queryBoxRecursive(node->getChild(i), min_bound, max_bound, results);
+    };
+    
+    size_t total = drawn(nodes_[0]);
+    place(0);
+    while (!heap.empty()) {
+        const Node& node = nodes_[heap.front().node];
+        uint32_t visible[8];
+        int visible_count = 0;
+        size_t children = 0;
+        for (int i = 0; i < node.getChildCount(); ++i) {
+            const Node& child = nodes_[node.first_child + i];
+            if (isNodeInFrustum(child, frustum)) {
+                visible[visible_count++] = node.first_child + i;
+                children += drawn(child);
             }
         }
+        if (total - drawn(node) + children > params.point_budget) break;
+        
+        std::pop_heap(heap.begin(), heap.end());
+        heap.pop_back();
+        total = total - drawn(node) + children;
+        for (int i = 0; i < visible_count; ++i) {
+            place(visible[i]);
+        }
+    }
+    
+    // Nodes left unrefined draw their samples
+    for (const Candidate& candidate : heap) {
+        const Node& node = nodes_[candidate.node];
+        cut.push_back({node.sample_begin, node.sample_end, true});
+    }
+    
+    // Buffer order, so neighbouring nodes merge into one span
+    std::sort(cut.begin(), cut.end(), [](const Span& a, const Span& b) {
+        return a.samples != b.samples ? b.samples : a.begin < b.begin;
+    });
+    for (const Span& span : cut) {
+        appendSpan(spans, span);
     }
 }
 
-int Octree::getMaxDepth() const {
-    int max_depth = 0;
-    size_t total_count = 0;
-    size_t leaf_count = 0;
+std::vector<size_t> Octree::queryFrustum(const FrustumPlanes& frustum) const {
+    std::vector<size_t> results;
+    queryFrustum(frustum, results);
+    return results;
+}
+
+void Octree::queryFrustum(const FrustumPlanes& frustum, std::vector<size_t>& results) const {
+    visitFrustum(frustum, appendTo(results));
+}
+
+void Octree::queryFrustum(const FrustumPlanes& frustum, std::vector<uint32_t>& results) const {
+    visitFrustum(frustum, appendTo(results));
+}
+
+std::vector<size_t> Octree::queryRadius(const glm::vec3& center, float radius) const {
+    std::vector<size_t> results;
+    queryRadius(center, radius, results);
+    return results;
+}
+
+void Octree::queryRadius(const glm::vec3& center, float radius, std::vector<size_t>& results) const {
+    visitRadius(center, radius, appendTo(results));
+}
+
+void Octree::queryRadius(const glm::vec3& center, float radius, std::vector<uint32_t>& results) const {
+    visitRadius(center, radius, appendTo(results));
+}
+
+std::vector<size_t> Octree::queryBox(const glm::vec3& min_bound, const glm::vec3& max_bound) const {
+    std::vector<size_t> results;
+    queryBox(min_bound, max_bound, results);
+    return results;
+}
+
+void Octree::queryBox(const glm::vec3& min_bound, const glm::vec3& max_bound, std::vector<size_t>& results) const {
+    visitBox(min_bound, max_bound, appendTo(results));
+}
+
+void Octree::queryBox(const glm::vec3& min_bound, const glm::vec3& max_bound, std::vector<uint32_t>& results) const {
+    visitBox(min_bound, max_bound, appendTo(results));
+}
+
+std::vector<size_t> Octree::queryLOD(const glm::vec3& view_position, 
+                                     const FrustumPlanes& frustum,
+                                     const LODParameters& params) const {
+    std::vector<size_t> results;
+    queryLOD(view_position, frustum, params, results);
+    return results;
+}
+
+void Octree::queryLOD(const glm::vec3& view_position, const FrustumPlanes& frustum,
+                      const LODParameters& params, std::vector<size_t>& results) const {
+    visitLOD(view_position, frustum, params, appendTo(results));
+}
+
+void Octree::queryLOD(const glm::vec3& view_position, const FrustumPlanes& frustum,
+                      const LODParameters& params, std::vector<uint32_t>& results) const {
+    visitLOD(view_position, frustum, params, appendTo(results));
+}
+
+void Octree::queryFrustumSpans(const FrustumPlanes& frustum, std::vector<Span>& spans) const {
+    if (!nodes_.empty()) {
+        queryFrustumSpansRecursive(0, frustum, spans);
+    }
+}
+
+void Octree::queryLeafSpans(std::vector<Span>& spans) const {
+    std::vector<Span> leaves;
+    for (const auto& node : nodes_) {
+        if (node.isLeaf() && node.begin < node.end) {
+            leaves.push_back({node.begin, node.end, false});
+        }
+    }
     
-    if (root_) {
-        countNodesRecursive(root_.get(), total_count, leaf_count, max_depth);
+    // Node order is not index order once incremental updates have relocated leaves
+    std::sort(leaves.begin(), leaves.end(), [](const Span& a, const Span& b) { return a.begin < b.begin; });
+    for (const Span& leaf : leaves) {
+        appendSpan(spans, leaf);
     }
+}
+
+void Octree::queryLODSpans(const glm::vec3& view_position,
+                           const FrustumPlanes& frustum,
+                           const LODParameters& params,
+                           std::vector<Span>& spans) const {
+    if (nodes_.empty()) return;
     
-    return max_depth;
+    if (params.point_budget > 0) {
+        selectLODBudget(view_position, frustum, params, spans);
+    } else {
+        auto emit = [&spans](const Span& span) { appendSpan(spans, span); };
+        visitLODRecursive(0, view_position, frustum, params, emit);
+    }
 }
 
-size_t Octree::getNodeCount() const {
-    size_t total_count = 0;
-    size_t leaf_count = 0;
-    int max_depth = 0;
+bool Octree::isNodeInFrustum(const Node& node, const FrustumPlanes& frustum) const {
+    // Check if bounding box intersects frustum
+    const glm::vec3& min_bound = node.min_bound;
+    const glm::vec3& max_bound = node.max_bound;
     
-    if (root_) {
-        countNodesRecursive(root_.get(), total_count, leaf_count, max_depth);
+    for (const auto& plane : frustum) {
+        glm::vec3 p_vertex(
+            plane.x > 0 ? max_bound.x : min_bound.x,
+            plane.y > 0 ? max_bound.y : min_bound.y,
+            plane.z > 0 ? max_bound.z : min_bound.z
+        );
+        
+        if (distanceToPlane(p_vertex, plane) < 0) {
+            return false; // Outside this plane
+        }
     }
     
-    return total_count;
+    return true; // Inside all planes
 }
 
-size_t Octree::getLeafCount() const {
-    size_t total_count = 0;
-    size_t leaf_count = 0;
-    int max_depth = 0;
+Octree::Containment Octree::classifyFrustum(const Node& node, const FrustumPlanes& frustum) const {
+    // The p-vertex (farthest along the plane normal) rejects, the n-vertex (nearest)
+    // decides whether the whole box is on the inner side
+    const glm::vec3& min_bound = node.min_bound;
+    const glm::vec3& max_bound = node.max_bound;
     
-    if (root_) {
-        countNodesRecursive(root_.get(), total_count, leaf_count, max_depth);
+    Containment containment = INSIDE;
+    for (const auto& plane : frustum) {
+        glm::vec3 p_vertex(
+            plane.x > 0 ? max_bound.x : min_bound.x,
+            plane.y > 0 ? max_bound.y : min_bound.y,
+            plane.z > 0 ? max_bound.z : min_bound.z
+        );
+        if (distanceToPlane(p_vertex, plane) < 0) {
+            return OUTSIDE;
+        }
+        
+        glm::vec3 n_vertex(
+            plane.x > 0 ? min_bound.x : max_bound.x,
+            plane.y > 0 ? min_bound.y : max_bound.y,
+            plane.z > 0 ? min_bound.z : max_bound.z
+        );
+        if (distanceToPlane(n_vertex, plane) < 0) {
+            containment = INTERSECTS;
+        }
     }
-    
-    return leaf_count;
+    return containment;
+}
+
+float Octree::distanceToPlane(const glm::vec3& point, const glm::vec4& plane) const {
+    return plane.x * point.x + plane.y * point.y + plane.z * point.z + plane.w;
 }
 
-void Octree::countNodesRecursive(const OctreeNode* node, 
-                                size_t& total_count, 
-                                size_t& leaf_count,
-                                int& max_depth) const {
-    total_count++;
-    max_depth = std::max(max_depth, node->getDepth());
+void Octree::queryFrustumSpansRecursive(uint32_t node_index,
+                                        const FrustumPlanes& frustum,
+                                        std::vector<Span>& spans) const {
+    const Node& node = nodes_[node_index];
+    if (!isNodeInFrustum(node, frustum)) {
+        return;
+    }
     
-    if (node->isLeaf()) {
-        leaf_count++;
+    if (node.isLeaf()) {
+        appendSpan(spans, {node.begin, node.end, false});
     } else {
-        for (int i = 0; i < 8; ++i) {
-            if (node->getChild(i)) {
-                countNodesRecursive(node->getChild(i), total_count, leaf_count, max_depth);
-            }
+        for (int i = 0; i < node.getChildCount(); ++i) {
+            queryFrustumSpansRecursive(node.first_child + i, frustum, spans);
         }
     }
 }
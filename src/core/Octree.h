@@ -1,17 +1,31 @@
 #pragma once
 
 #include "core/PointCloud.h"
+#include "core/LeafKernels.h"
+#include "core/MemoryPool.h"
+#include <algorithm>
 #include <array>
+#include <cstdint>
+#include <limits>
 #include <memory>
 #include <functional>
 
 namespace pcv {
 
+// Pointer-based octree node used by the INSERTION build. Nodes come from a shared
+// MemoryPool and release their children to it.
 class OctreeNode {
 public:
-    using Ptr = std::unique_ptr<OctreeNode>;
+    using Pool = MemoryPool<OctreeNode>;
     
-    OctreeNode(const glm::vec3& min_bound, const glm::vec3& max_bound, int depth = 0);
+    static constexpr int MAX_POINTS_PER_LEAF = 100;
+    static constexpr int MAX_DEPTH = 10;
+    
+    OctreeNode(const glm::vec3& min_bound, const glm::vec3& max_bound, Pool& pool, int depth = 0);
+    ~OctreeNode();
+    
+    OctreeNode(const OctreeNode&) = delete;
+    OctreeNode& operator=(const OctreeNode&) = delete;
     
     // Node properties
     bool isLeaf() const { return children_[0] == nullptr; }
@@ -26,83 +40,478 @@ public:
     size_t getPointCount() const { return point_indices_.size(); }
     
     // Children access
-    OctreeNode* getChild(int index) { return children_[index].get(); }
-    const OctreeNode* getChild(int index) const { return children_[index].get(); }
+    OctreeNode* getChild(int index) { return children_[index]; }
+    const OctreeNode* getChild(int index) const { return children_[index]; }
     
 private:
     glm::vec3 min_bound_;
     glm::vec3 max_bound_;
     int depth_;
+    Pool& pool_;
     
-    static constexpr int MAX_POINTS_PER_LEAF = 100;
-    static constexpr int MAX_DEPTH = 10;
-    
-    std::array<Ptr, 8> children_;
+    std::array<OctreeNode*, 8> children_{};
     std::vector<size_t> point_indices_;
     
     void subdivide(const PointCloud& cloud);
     int getOctant(const glm::vec3& point) const;
 };
 
+// Octree stored as a flat node array over one permuted index buffer.
+// Each leaf's points are a contiguous [begin, end) range of the index buffer. After
+// build() or compact() every interior node's range also covers its whole subtree;
+// incremental insert()/erase() keep leaf ranges exact but may leave interior ranges
+// stale and dead slots (empty leaves) in the arrays until the next compaction.
 class Octree {
 public:
     using FrustumPlanes = std::array<glm::vec4, 6>;
     
-    explicit Octree(const PointCloud& cloud);
+    enum BuildMode {
+        MORTON,     // Sort points by Morton code once, then split sorted ranges
+        INSERTION   // Insert points one at a time into an OctreeNode tree, then flatten
+    };
+    
+    struct Node {
+        glm::vec3 min_bound;
+        glm::vec3 max_bound;
+        uint32_t begin = 0;         // Range into the index buffer
+        uint32_t end = 0;
+        uint32_t capacity = 0;      // Leaves: index slots reserved from begin
+        uint32_t point_count = 0;   // Points in the subtree
+        uint32_t first_child = 0;   // Children are stored contiguously; 0 for leaves
+        uint32_t sample_begin = 0;  // LOD sample range into the sample buffer (interior nodes;
+        uint32_t sample_end = 0;    // leaves draw their own points)
+        uint8_t child_mask = 0;     // Bit i set if octant i has a child
+        uint8_t depth = 0;
+        
+        bool isLeaf() const { return child_mask == 0; }
+        uint32_t getPointCount() const { return point_count; }
+        int getChildCount() const;
+        glm::vec3 getCenter() const { return (min_bound + max_bound) * 0.5f; }
+    };
     
-    // Build the octree
+    // Screen-space LOD selection
+    struct LODParameters {
+        float projection_scale;   // Pixels per world unit at distance 1: viewport_height / (2 * tan(fov_y / 2))
+        float pixel_threshold;    // Stop descending once a node's sample spacing projects below this
+        size_t point_budget;      // Most points to select (0 = no limit). Nodes that look
+                                  // coarsest on screen are refined first until it is spent.
+        
+        LODParameters() : projection_scale(1080.0f), pixel_threshold(2.0f), point_budget(0) {}
+    };
+    
+    // Contiguous run of points: [begin, end) of getIndices(), or of getSamples() when
+    // samples is set
+    struct Span {
+        uint32_t begin;
+        uint32_t end;
+        bool samples;
+    };
+    
+    // Interior-node samples are drawn from a grid of this many cells per axis
+    static constexpr int LOD_GRID_SIZE = 16;
+    
+    explicit Octree(const PointCloud& cloud, BuildMode mode = MORTON);
+    
+    // Build the octree and its LOD samples
     void build();
     
-    // Queries
+    void setBuildMode(BuildMode mode) { build_mode_ = mode; }
+    BuildMode getBuildMode() const { return build_mode_; }
+    
+    // Threads for the MORTON build (0 = all hardware threads, 1 = serial).
+    // The tree is identical for every thread count.
+    void setNumThreads(int num_threads) { num_threads_ = num_threads; }
+    int getNumThreads() const { return num_threads_; }
+    
+    // Incremental updates; cost scales with the batch, not the cloud.
+    // insert() adds cloud points [begin, end), e.g. ones just appended, growing the root
+    // if they fall outside it. erase() drops points from the tree only (the cloud is
+    // untouched); their positions must not have changed since they were inserted.
+    void insert(size_t begin, size_t end);
+    void erase(const std::vector<size_t>& point_indices);
+    
+    // Re-lay out nodes and buffers contiguously (run automatically once enough
+    // dead space accumulates)
+    void compact();
+    
+    // Serialization: a compact copy of the layout (as compact() would leave it), and
+    // adoption of such a layout in place of build(). setLayout() validates every range
+    // and index against the cloud and leaves the tree unchanged if any is out of bounds.
+    void getCompactLayout(std::vector<Node>& nodes, std::vector<uint32_t>& indices,
+                          std::vector<uint32_t>& samples) const;
+    bool setLayout(std::vector<Node> nodes, std::vector<uint32_t> indices, std::vector<uint32_t> samples);
+    
+    // Queries. The returning forms allocate a fresh list per call; the others append
+    // to results, so a buffer reused across queries stops allocating once it has grown.
+    // uint32_t results (cloud indices, like the index buffer) halve the bandwidth.
     std::vector<size_t> queryFrustum(const FrustumPlanes& frustum) const;
+    void queryFrustum(const FrustumPlanes& frustum, std::vector<size_t>& results) const;
+    void queryFrustum(const FrustumPlanes& frustum, std::vector<uint32_t>& results) const;
+    
     std::vector<size_t> queryRadius(const glm::vec3& center, float radius) const;
+    void queryRadius(const glm::vec3& center, float radius, std::vector<size_t>& results) const;
+    void queryRadius(const glm::vec3& center, float radius, std::vector<uint32_t>& results) const;
+    
     std::vector<size_t> queryBox(const glm::vec3& min_bound, const glm::vec3& max_bound) const;
+    void queryBox(const glm::vec3& min_bound, const glm::vec3& max_bound, std::vector<size_t>& results) const;
+    void queryBox(const glm::vec3& min_bound, const glm::vec3& max_bound, std::vector<uint32_t>& results) const;
     
-    // LOD support
-    std::vector<size_t> queryLOD(const glm::vec3& view_position, 
+    // LOD support: visible nodes whose samples are fine enough on screen contribute their
+    // samples instead of descending, so the result scales with screen size, not cloud size
+    std::vector<size_t> queryLOD(const glm::vec3& view_position,
                                  const FrustumPlanes& frustum,
-                                 float base_distance = 10.0f) const;
+                                 const LODParameters& params = LODParameters()) const;
+    void queryLOD(const glm::vec3& view_position, const FrustumPlanes& frustum,
+                  const LODParameters& params, std::vector<size_t>& results) const;
+    void queryLOD(const glm::vec3& view_position, const FrustumPlanes& frustum,
+                  const LODParameters& params, std::vector<uint32_t>& results) const;
+    
+    // Visitor forms of the queries: visit(const uint32_t* indices, size_t count) is called
+    // with the matching cloud indices in runs, and no index list is built. Whole nodes are
+    // passed straight from the index and sample buffers; boundary leaves pass their
+    // matches a LeafKernels block at a time. Runs are only valid during the call.
+    template<typename Visitor>
+    void visitFrustum(const FrustumPlanes& frustum, Visitor&& visit) const;
+    template<typename Visitor>
+    void visitRadius(const glm::vec3& center, float radius, Visitor&& visit) const;
+    template<typename Visitor>
+    void visitBox(const glm::vec3& min_bound, const glm::vec3& max_bound, Visitor&& visit) const;
+    template<typename Visitor>
+    void visitLOD(const glm::vec3& view_position, const FrustumPlanes& frustum,
+                  const LODParameters& params, Visitor&& visit) const;
+    
+    // Span variants for renderers that keep the index and sample buffers resident.
+    // Visible leaves are returned whole (the GPU clips them), so there is no per-point
+    // work. Spans are appended to the output; adjacent ones are merged.
+    void queryFrustumSpans(const FrustumPlanes& frustum, std::vector<Span>& spans) const;
+    void queryLODSpans(const glm::vec3& view_position,
+                       const FrustumPlanes& frustum,
+                       const LODParameters& params,
+                       std::vector<Span>& spans) const;
+    
+    // Every leaf's points, in index buffer order
+    void queryLeafSpans(std::vector<Span>& spans) const;
+    
+    // Flat layout access (root is node 0)
+    const std::vector<Node>& getNodes() const { return nodes_; }
+    const std::vector<uint32_t>& getIndices() const { return indices_; }
+    const std::vector<uint32_t>& getSamples() const { return samples_; }
+    
+    // Bumped by every change to the nodes, indices or samples, so cached copies
+    // (e.g. GPU buffers in index order) know when to refresh
+    uint64_t getRevision() const { return revision_; }
     
     // Statistics
     int getMaxDepth() const;
-    size_t getNodeCount() const;
-    size_t getLeafCount() const;
+    size_t getNodeCount() const { return live_nodes_; }
+    size_t getLeafCount() const { return leaf_count_; }
+    size_t getSampleCount() const { return samples_.size(); }
     
 private:
     const PointCloud& cloud_;
-    std::unique_ptr<OctreeNode> root_;
+    BuildMode build_mode_;
+    int num_threads_ = 0;
+    
+    std::vector<Node> nodes_;
+    std::vector<uint32_t> indices_;
+    std::vector<uint32_t> samples_;      // Cloud indices of interior-node LOD samples
+    uint64_t revision_ = 0;
+    
+    // Live statistics, maintained through incremental updates
+    size_t live_nodes_ = 0;
+    size_t leaf_count_ = 0;
+    std::vector<size_t> depth_counts_;
+    
+    // Dead entries left behind by incremental updates
+    size_t garbage_nodes_ = 0;
+    size_t garbage_indices_ = 0;
+    size_t garbage_samples_ = 0;
+    
+    struct SampleScratch;
+    
+    // Builders
+    void buildMorton(const glm::vec3& root_min, const glm::vec3& root_max);
+    void buildInsertion(const glm::vec3& root_min, const glm::vec3& root_max);
+    void buildMortonParallel(const std::vector<uint64_t>& keys, size_t num_threads);
+    void spliceSubtrees(const std::vector<Node>& top, const std::vector<int>& task_of,
+                        const std::vector<std::vector<Node>>& subtrees,
+                        uint32_t top_index, uint32_t node_index);
+    static void buildMortonRange(std::vector<Node>& nodes, uint32_t node_index,
+                                 const std::vector<uint64_t>& keys, int max_depth);
+    void flattenRecursive(const OctreeNode* source, uint32_t node_index);
+    void resetStatistics();
+    void updateStatistics();
+    void countNode(const Node& node, int delta);
+    
+    // LOD samples, built bottom-up from each node's children
+    void buildLOD();
+    void updateSamples(uint32_t node_index, SampleScratch& scratch);
+    void addSamples(uint32_t node_index, const std::vector<uint32_t>& points, SampleScratch& scratch);
+    static void selectSamples(const std::vector<glm::vec3>& positions, const Node& node,
+                              SampleScratch& scratch, std::vector<uint32_t>& samples);
+    float getSampleSpacing(const Node& node) const;
+    float getProjectedSpacing(const Node& node, const glm::vec3& view_position, const LODParameters& params) const;
+    void selectLODBudget(const glm::vec3& view_position, const FrustumPlanes& frustum,
+                         const LODParameters& params, std::vector<Span>& spans) const;
+    
+    // Incremental update helpers
+    void growRoot(const glm::vec3& min_bound, const glm::vec3& max_bound, SampleScratch& scratch);
+    uint32_t ensureChild(uint32_t node_index, int octant);
+    void releaseNode(uint32_t node_index);
+    void appendToLeaf(uint32_t node_index, const std::vector<uint32_t>& points);
+    void insertRecursive(uint32_t node_index, std::vector<uint32_t>& points, SampleScratch& scratch);
+    uint32_t eraseRecursive(uint32_t node_index, std::vector<uint32_t>& points, SampleScratch& scratch);
+    void mergeSubtree(uint32_t node_index);
+    void compactIfFragmented();
+    void compactRecursive(uint32_t source_index, uint32_t target_index, std::vector<Node>& nodes,
+                          std::vector<uint32_t>& indices, std::vector<uint32_t>& samples) const;
+    
+    // How a node's bounds relate to a query volume
+    enum Containment {
+        OUTSIDE,      // No point of the node can match
+        INTERSECTS,   // Points must be tested
+        INSIDE        // Every point of the node matches
+    };
     
     // Helper functions for frustum culling
-    bool isNodeInFrustum(const OctreeNode* node, const FrustumPlanes& frustum) const;
-    bool isPointInFrustum(const glm::vec3& point, const FrustumPlanes& frustum) const;
+    bool isNodeInFrustum(const Node& node, const FrustumPlanes& frustum) const;
+    Containment classifyFrustum(const Node& node, const FrustumPlanes& frustum) const;
     float distanceToPlane(const glm::vec3& point, const glm::vec4& plane) const;
     
-    // Recursive query helpers
-    void queryFrustumRecursive(const OctreeNode* node, 
+    // Recursive query helpers. Leaves are tested in LeafKernels blocks; subtrees fully
+    // inside the query are visited without per-point tests.
+    template<typename Visitor>
+    void visitSubtree(uint32_t node_index, Visitor& visit) const;
+    
+    template<typename Visitor, typename MaskFn>
+    void visitLeafMatches(const Node& node, Visitor& visit, MaskFn mask_of) const;
+    
+    template<typename Visitor>
+    void visitFrustumRecursive(uint32_t node_index,
                                const FrustumPlanes& frustum,
-                               std::vector<size_t>& results) const;
+                               Visitor& visit) const;
     
-    void queryRadiusRecursive(const OctreeNode* node,
+    template<typename Visitor>
+    void visitRadiusRecursive(uint32_t node_index,
                               const glm::vec3& center,
                               float radius,
-                              std::vector<size_t>& results) const;
+                              Visitor& visit) const;
     
-    void queryBoxRecursive(const OctreeNode* node,
+    template<typename Visitor>
+    void visitBoxRecursive(uint32_t node_index,
                            const glm::vec3& min_bound,
                            const glm::vec3& max_bound,
-                           std::vector<size_t>& results) const;
+                           Visitor& visit) const;
+    
+    void queryFrustumSpansRecursive(uint32_t node_index,
+                                    const FrustumPlanes& frustum,
+                                    std::vector<Span>& spans) const;
     
-    void queryLODRecursive(const OctreeNode* node,
+    // Calls emit(span) for every node the LOD selection draws
+    template<typename SpanFn>
+    void visitLODRecursive(uint32_t node_index,
                            const glm::vec3& view_position,
                            const FrustumPlanes& frustum,
-                           float base_distance,
-                           std::vector<size_t>& results) const;
-    
-    // Statistics helpers
-    void countNodesRecursive(const OctreeNode* node, 
-                            size_t& total_count, 
-                            size_t& leaf_count,
-                            int& max_depth) const;
+                           const LODParameters& params,
+                           SpanFn& emit) const;
 };
 
+template<typename Visitor>
+void Octree::visitFrustum(const FrustumPlanes& frustum, Visitor&& visit) const {
+    if (!nodes_.empty()) {
+        visitFrustumRecursive(0, frustum, visit);
+    }
+}
+
+template<typename Visitor>
+void Octree::visitRadius(const glm::vec3& center, float radius, Visitor&& visit) const {
+    if (!nodes_.empty()) {
+        visitRadiusRecursive(0, center, radius, visit);
+    }
+}
+
+template<typename Visitor>
+void Octree::visitBox(const glm::vec3& min_bound, const glm::vec3& max_bound, Visitor&& visit) const {
+    if (!nodes_.empty()) {
+        visitBoxRecursive(0, min_bound, max_bound, visit);
+    }
+}
+
+template<typename Visitor>
+void Octree::visitLOD(const glm::vec3& view_position, const FrustumPlanes& frustum,
+                      const LODParameters& params, Visitor&& visit) const {
+    auto emit = [this, &visit](const Span& span) {
+        const auto& source = span.samples ? samples_ : indices_;
+        if (span.begin < span.end) {
+            visit(source.data() + span.begin, static_cast<size_t>(span.end - span.begin));
+        }
+    };
+    if (nodes_.empty()) return;
+    
+    if (params.point_budget > 0) {
+        std::vector<Span> cut;
+        selectLODBudget(view_position, frustum, params, cut);
+        for (const Span& span : cut) {
+            emit(span);
+        }
+    } else {
+        visitLODRecursive(0, view_position, frustum, params, emit);
+    }
+}
+
+template<typename Visitor>
+void Octree::visitSubtree(uint32_t node_index, Visitor& visit) const {
+    // Interior ranges can be stale after incremental updates, so walk to the leaves
+    const Node& node = nodes_[node_index];
+    if (node.isLeaf()) {
+        if (node.begin < node.end) {
+            visit(indices_.data() + node.begin, static_cast<size_t>(node.end - node.begin));
+        }
+    } else {
+        for (int i = 0; i < node.getChildCount(); ++i) {
+            visitSubtree(node.first_child + i, visit);
+        }
+    }
+}
+
+template<typename Visitor, typename MaskFn>
+void Octree::visitLeafMatches(const Node& node, Visitor& visit, MaskFn mask_of) const {
+    const glm::vec3* positions = cloud_.getPositions().data();
+    uint32_t matches[LeafKernels::BLOCK_SIZE];
+    for (uint32_t i = node.begin; i < node.end; i += LeafKernels::BLOCK_SIZE) {
+        const uint32_t* block = indices_.data() + i;
+        size_t count = std::min<size_t>(LeafKernels::BLOCK_SIZE, node.end - i);
+        size_t found = LeafKernels::compact(block, mask_of(positions, block, count), matches);
+        if (found > 0) {
+            visit(static_cast<const uint32_t*>(matches), found);
+        }
+    }
+}
+
+template<typename Visitor>
+void Octree::visitFrustumRecursive(uint32_t node_index,
+                                   const FrustumPlanes& frustum,
+                                   Visitor& visit) const {
+    const Node& node = nodes_[node_index];
+    Containment containment = classifyFrustum(node, frustum);
+    if (containment == OUTSIDE) {
+        return; // Early rejection
+    }
+    if (containment == INSIDE) {
+        visitSubtree(node_index, visit);
+        return;
+    }
+    
+    if (node.isLeaf()) {
+        // Add all points in this leaf that are inside frustum
+        visitLeafMatches(node, visit, [&frustum](const glm::vec3* positions, const uint32_t* block, size_t count) {
+            return LeafKernels::frustumMask(positions, block, count, frustum);
+        });
+    } else {
+        // Recurse into children
+        for (int i = 0; i < node.getChildCount(); ++i) {
+            visitFrustumRecursive(node.first_child + i, frustum, visit);
+        }
+    }
+}
+
+template<typename Visitor>
+void Octree::visitRadiusRecursive(uint32_t node_index,
+                                  const glm::vec3& center,
+                                  float radius,
+                                  Visitor& visit) const {
+    const Node& node = nodes_[node_index];
+    
+    // Check if node bounding box intersects sphere
+    glm::vec3 closest = glm::clamp(center, node.min_bound, node.max_bound);
+    float dist_sq = glm::dot(center - closest, center - closest);
+    
+    float radius_sq = radius * radius;
+    if (dist_sq > radius_sq) {
+        return; // No intersection
+    }
+    
+    // Whole node within the sphere if its farthest corner is
+    glm::vec3 farthest = glm::max(glm::abs(center - node.min_bound), glm::abs(node.max_bound - center));
+    if (glm::dot(farthest, farthest) <= radius_sq) {
+        visitSubtree(node_index, visit);
+        return;
+    }
+    
+    if (node.isLeaf()) {
+        // Check each point
+        visitLeafMatches(node, visit, [&center, radius_sq](const glm::vec3* positions, const uint32_t* block, size_t count) {
+            return LeafKernels::sphereMask(positions, block, count, center, radius_sq);
+        });
+    } else {
+        // Recurse into children
+        for (int i = 0; i < node.getChildCount(); ++i) {
+            visitRadiusRecursive(node.first_child + i, center, radius, visit);
+        }
+    }
+}
+
+template<typename Visitor>
+void Octree::visitBoxRecursive(uint32_t node_index,
+                               const glm::vec3& min_bound,
+                               const glm::vec3& max_bound,
+                               Visitor& visit) const {
+    const Node& node = nodes_[node_index];
+    
+    // Check if node bounding box intersects query box
+    if (node.max_bound.x < min_bound.x || node.min_bound.x > max_bound.x ||
+        node.max_bound.y < min_bound.y || node.min_bound.y > max_bound.y ||
+        node.max_bound.z < min_bound.z || node.min_bound.z > max_bound.z) {
+        return; // No intersection
+    }
+    
+    // Node bounds contained in the query box
+    if (node.min_bound.x >= min_bound.x && node.max_bound.x <= max_bound.x &&
+        node.min_bound.y >= min_bound.y && node.max_bound.y <= max_bound.y &&
+        node.min_bound.z >= min_bound.z && node.max_bound.z <= max_bound.z) {
+        visitSubtree(node_index, visit);
+        return;
+    }
+    
+    if (node.isLeaf()) {
+        // Check each point in the leaf
+        visitLeafMatches(node, visit, [&min_bound, &max_bound](const glm::vec3* positions, const uint32_t* block, size_t count) {
+            return LeafKernels::boxMask(positions, block, count, min_bound, max_bound);
+        });
+    } else {
+        // Recurse into children
+        for (int i = 0; i < node.getChildCount(); ++i) {
+            visitBoxRecursive(node.first_child + i, min_bound, max_bound, visit);
+        }
+    }
+}
+
+template<typename SpanFn>
+void Octree::visitLODRecursive(uint32_t node_index,
+                               const glm::vec3& view_position,
+                               const FrustumPlanes& frustum,
+                               const LODParameters& params,
+                               SpanFn& emit) const {
+    const Node& node = nodes_[node_index];
+    if (!isNodeInFrustum(node, frustum)) {
+        return;
+    }
+    
+    if (node.isLeaf()) {
+        // Finest level - add all points
+        emit(Span{node.begin, node.end, false});
+        return;
+    }
+    
+    if (getProjectedSpacing(node, view_position, params) <= params.pixel_threshold) {
+        // Fine enough on screen - the node's samples stand in for its subtree
+        emit(Span{node.sample_begin, node.sample_end, true});
+    } else {
+        // Recurse into children
+        for (int i = 0; i < node.getChildCount(); ++i) {
+            visitLODRecursive(node.first_child + i, view_position, frustum, params, emit);
+        }
+    }
+}
+
 } // namespace pcv
\ No newline at end of file
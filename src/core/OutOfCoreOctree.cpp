@@ -0,0 +1,261 @@
+#include "core/OutOfCoreOctree.h"
+#include "utils/Parallel.h"
+#include <algorithm>
+#include <bitset>
+#include <iostream>
+#include <limits>
+
+namespace pcv {
+
+OutOfCoreOctree::OutOfCoreOctree(const Parameters& params) : params_(params) {
+}
+
+OutOfCoreOctree::~OutOfCoreOctree() {
+    close();
+}
+
+bool OutOfCoreOctree::open(const std::string& filename) {
+    close();
+    if (!cache_.open(filename, MappedFile::RANDOM)) {
+        return false;
+    }
+    
+    entries_ = std::vector<Entry>(cache_.getNodeCount());
+    in_flight_.assign(cache_.getNodeCount(), 0);
+    
+    size_t num_threads = resolveThreadCount(static_cast<size_t>(params_.num_threads));
+    for (size_t t = 0; t < num_threads; ++t) {
+        workers_.emplace_back(&OutOfCoreOctree::ioWorker, this);
+    }
+    return true;
+}
+
+void OutOfCoreOctree::close() {
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        stopping_ = true;
+    }
+    queue_condition_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workers_.clear();
+    
+    queue_ = std::priority_queue<Request>();
+    completed_.clear();
+    in_flight_.clear();
+    stopping_ = false;
+    
+    entries_.clear();
+    lru_.clear();
+    requests_.clear();
+    frame_ = 0;
+    resident_points_ = 0;
+    nodes_loaded_ = 0;
+    nodes_evicted_ = 0;
+    cache_.close();
+}
+
+void OutOfCoreOctree::update(const glm::vec3& view_position,
+                             const Octree::FrustumPlanes& frustum,
+                             const Octree::LODParameters& params,
+                             std::vector<uint32_t>& draw_nodes) {
+    draw_nodes.clear();
+    if (!isOpen() || entries_.empty()) return;
+    
+    frame_++;
+    takeCompleted();
+    
+    requests_.clear();
+    selectRecursive(0, view_position, frustum, params, draw_nodes);
+    
+    // Only this frame's most urgent loads stay queued; stale ones are dropped
+    std::sort(requests_.begin(), requests_.end(),
+              [](const Request& a, const Request& b) { return b < a; });
+    if (requests_.size() > params_.max_requests) {
+        requests_.resize(params_.max_requests);
+    }
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        while (!queue_.empty()) {
+            in_flight_[queue_.top().node] = 0;
+            queue_.pop();
+        }
+        for (const auto& pending : requests_) {
+            if (!in_flight_[pending.node]) {
+                in_flight_[pending.node] = 1;
+                queue_.push(pending);
+            }
+        }
+    }
+    queue_condition_.notify_all();
+    
+    evict();
+}
+
+const OutOfCoreOctree::NodeData* OutOfCoreOctree::getNodeData(uint32_t node) const {
+    return node < entries_.size() ? entries_[node].data.get() : nullptr;
+}
+
+OutOfCoreOctree::Statistics OutOfCoreOctree::getStatistics() const {
+    Statistics stats;
+    stats.resident_nodes = lru_.size();
+    stats.resident_points = resident_points_;
+    stats.nodes_loaded = nodes_loaded_;
+    stats.nodes_evicted = nodes_evicted_;
+    
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    stats.pending_requests = static_cast<size_t>(std::count(in_flight_.begin(), in_flight_.end(), 1));
+    return stats;
+}
+
+bool OutOfCoreOctree::selectRecursive(uint32_t node_index, const glm::vec3& view_position,
+                                      const Octree::FrustumPlanes& frustum,
+                                      const Octree::LODParameters& params,
+                                      std::vector<uint32_t>& draw_nodes) {
+    const PointCache::NodeRecord& node = cache_.getNodes()[node_index];
+    const glm::vec3 min_bound(node.min_bound[0], node.min_bound[1], node.min_bound[2]);
+    const glm::vec3 max_bound(node.max_bound[0], node.max_bound[1], node.max_bound[2]);
+    for (const auto& plane : frustum) {
+        glm::vec3 p_vertex(plane.x > 0 ? max_bound.x : min_bound.x,
+                           plane.y > 0 ? max_bound.y : min_bound.y,
+                           plane.z > 0 ? max_bound.z : min_bound.z);
+        if (glm::dot(glm::vec3(plane), p_vertex) + plane.w < 0.0f) {
+            return true; // Nothing to draw
+        }
+    }
+    
+    // Leaves draw their points; interior nodes fine enough on screen draw their samples
+    const bool leaf = node.child_mask == 0;
+    const float spacing = projectedSpacing(node, view_position, params);
+    if (leaf || spacing <= params.pixel_threshold) {
+        const uint32_t count = leaf ? node.end - node.begin : node.sample_end - node.sample_begin;
+        if (count == 0) return true;
+        if (touch(node_index)) {
+            draw_nodes.push_back(node_index);
+            return true;
+        }
+        request(node_index, spacing);
+        return false;
+    }
+    
+    // Visit every child so all missing ones are requested
+    const size_t mark = draw_nodes.size();
+    const int child_count = static_cast<int>(std::bitset<8>(node.child_mask).count());
+    bool covered = true;
+    for (int i = 0; i < child_count; ++i) {
+        covered = selectRecursive(node.first_child + i, view_position, frustum, params, draw_nodes) && covered;
+    }
+    if (covered) return true;
+    
+    // A visible child is still loading: this node's samples stand in for the whole
+    // subtree, so the view never shows holes or overlapping levels
+    draw_nodes.resize(mark);
+    if (touch(node_index)) {
+        draw_nodes.push_back(node_index);
+        return true;
+    }
+    request(node_index, spacing);
+    return false;
+}
+
+float OutOfCoreOctree::projectedSpacing(const PointCache::NodeRecord& node, const glm::vec3& view_position,
+                                        const Octree::LODParameters& params) const {
+    // Same measure as Octree::visitLODRecursive
+    const glm::vec3 min_bound(node.min_bound[0], node.min_bound[1], node.min_bound[2]);
+    const glm::vec3 max_bound(node.max_bound[0], node.max_bound[1], node.max_bound[2]);
+    glm::vec3 closest = glm::clamp(view_position, min_bound, max_bound);
+    float dist = glm::length(view_position - closest);
+    if (dist <= 0.0f) return std::numeric_limits<float>::max();
+    
+    glm::vec3 extent = max_bound - min_bound;
+    float sample_spacing = std::max(extent.x, std::max(extent.y, extent.z)) / Octree::LOD_GRID_SIZE;
+    return sample_spacing * params.projection_scale / dist;
+}
+
+bool OutOfCoreOctree::touch(uint32_t node) {
+    Entry& entry = entries_[node];
+    if (!entry.data) return false;
+    lru_.splice(lru_.begin(), lru_, entry.lru);
+    entry.last_used = frame_;
+    return true;
+}
+
+void OutOfCoreOctree::request(uint32_t node, float priority) {
+    requests_.push_back({priority, node});
+}
+
+void OutOfCoreOctree::takeCompleted() {
+    std::vector<std::pair<uint32_t, std::unique_ptr<NodeData>>> completed;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        completed.swap(completed_);
+        for (const auto& loaded : completed) {
+            in_flight_[loaded.first] = 0;
+        }
+    }
+    
+    for (auto& loaded : completed) {
+        Entry& entry = entries_[loaded.first];
+        resident_points_ += loaded.second->positions.size();
+        entry.data = std::move(loaded.second);
+        lru_.push_front(loaded.first);
+        entry.lru = lru_.begin();
+        nodes_loaded_++;
+    }
+}
+
+void OutOfCoreOctree::evict() {
+    // Never evict what this frame draws, even if that alone exceeds the budget
+    while (resident_points_ > params_.cpu_budget_points && !lru_.empty()) {
+        uint32_t victim = lru_.back();
+        Entry& entry = entries_[victim];
+        if (entry.last_used == frame_) break;
+        
+        resident_points_ -= entry.data->positions.size();
+        entry.data.reset();
+        lru_.pop_back();
+        nodes_evicted_++;
+    }
+}
+
+void OutOfCoreOctree::ioWorker() {
+    for (;;) {
+        Request next;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+            queue_condition_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+            if (stopping_) return;
+            next = queue_.top();
+            queue_.pop();
+        }
+        
+        // Reading the mapping pages the node in; no lock is held meanwhile
+        std::unique_ptr<NodeData> data = readNode(next.node);
+        
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        completed_.emplace_back(next.node, std::move(data));
+    }
+}
+
+std::unique_ptr<OutOfCoreOctree::NodeData> OutOfCoreOctree::readNode(uint32_t node_index) const {
+    const PointCache::NodeRecord& node = cache_.getNodes()[node_index];
+    const bool samples = node.child_mask != 0;   // Interior nodes draw their samples
+    const size_t begin = samples ? node.sample_begin : node.begin;
+    const size_t end = samples ? node.sample_end : node.end;
+    
+    auto data = std::make_unique<NodeData>();
+    const glm::vec3* positions = cache_.getPositions(samples);
+    data->positions.assign(positions + begin, positions + end);
+    if (const PackedColor* colors = cache_.getColors(samples)) {
+        data->colors.assign(colors + begin, colors + end);
+    }
+    if (const PackedNormal* normals = cache_.getNormals(samples)) {
+        data->normals.assign(normals + begin, normals + end);
+    }
+    return data;
+}
+
+} // namespace pcv
\ No newline at end of file
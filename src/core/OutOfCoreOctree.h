@@ -0,0 +1,127 @@
+#pragma once
+
+#include "core/Octree.h"
+#include "utils/PointCache.h"
+#include <atomic>
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pcv {
+
+// Octree of a .pcvc cache too large to load whole. The node array is traversed in
+// the mapped file; node points (leaves) and LOD samples (interior nodes) are read on
+// demand by background threads, most screen-space error first, into a CPU cache that
+// is bounded in points and evicts least recently used nodes. update() never waits for
+// IO: nodes still loading are stood in for by their nearest loaded ancestor.
+class OutOfCoreOctree {
+public:
+    struct Parameters {
+        size_t cpu_budget_points;   // Points held in loaded nodes
+        int num_threads;            // IO threads (0 = all hardware threads)
+        size_t max_requests;        // Loads queued per update, highest priority first
+        
+        Parameters() : cpu_budget_points(size_t(32) << 20), num_threads(2), max_requests(256) {}
+    };
+    
+    // Attributes of one node's points or samples
+    struct NodeData {
+        std::vector<glm::vec3> positions;
+        std::vector<PackedColor> colors;     // Empty without a color channel
+        std::vector<PackedNormal> normals;   // Empty without a normal channel
+    };
+    
+    struct Statistics {
+        size_t resident_nodes = 0;
+        size_t resident_points = 0;
+        size_t pending_requests = 0;   // Queued or loading
+        size_t nodes_loaded = 0;       // Totals since open()
+        size_t nodes_evicted = 0;
+    };
+    
+    explicit OutOfCoreOctree(const Parameters& params = Parameters());
+    ~OutOfCoreOctree();
+    
+    OutOfCoreOctree(const OutOfCoreOctree&) = delete;
+    OutOfCoreOctree& operator=(const OutOfCoreOctree&) = delete;
+    
+    // Map the cache and start the IO threads
+    bool open(const std::string& filename);
+    void close();
+    bool isOpen() const { return cache_.isOpen(); }
+    
+    // Take finished loads, select the loaded nodes to draw for this view (same LOD
+    // rule as Octree::queryLODSpans), queue loads for what is missing and evict past
+    // the budget. Nodes in draw_nodes stay loaded until the next update().
+    void update(const glm::vec3& view_position,
+                const Octree::FrustumPlanes& frustum,
+                const Octree::LODParameters& params,
+                std::vector<uint32_t>& draw_nodes);
+    
+    // Loaded data of a node, or nullptr
+    const NodeData* getNodeData(uint32_t node) const;
+    
+    uint32_t getChannels() const { return cache_.getChannels(); }
+    bool hasColors() const { return (cache_.getChannels() & PointCloud::COLOR) != 0; }
+    bool hasNormals() const { return (cache_.getChannels() & PointCloud::NORMAL) != 0; }
+    size_t getPointCount() const { return cache_.getPointCount(); }
+    size_t getNodeCount() const { return cache_.getNodeCount(); }
+    glm::vec3 getMinBound() const { return cache_.getMinBound(); }
+    glm::vec3 getMaxBound() const { return cache_.getMaxBound(); }
+    Statistics getStatistics() const;
+    
+private:
+    struct Request {
+        float priority;   // Projected sample spacing in pixels
+        uint32_t node;
+        
+        bool operator<(const Request& other) const { return priority < other.priority; }
+    };
+    
+    struct Entry {
+        std::unique_ptr<NodeData> data;
+        std::list<uint32_t>::iterator lru;   // Position in lru_ while loaded
+        uint64_t last_used = 0;              // update() frame that last drew it
+    };
+    
+    Parameters params_;
+    PointCache cache_;
+    
+    // Main-thread state
+    std::vector<Entry> entries_;
+    std::list<uint32_t> lru_;                // Loaded nodes, most recent first
+    std::vector<Request> requests_;          // Collected during selection
+    uint64_t frame_ = 0;
+    size_t resident_points_ = 0;
+    size_t nodes_loaded_ = 0;
+    size_t nodes_evicted_ = 0;
+    
+    // Shared with the IO threads
+    mutable std::mutex queue_mutex_;
+    std::condition_variable queue_condition_;
+    std::priority_queue<Request> queue_;
+    std::vector<uint8_t> in_flight_;          // Queued or loading
+    std::vector<std::pair<uint32_t, std::unique_ptr<NodeData>>> completed_;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+    
+    bool selectRecursive(uint32_t node_index, const glm::vec3& view_position,
+                         const Octree::FrustumPlanes& frustum, const Octree::LODParameters& params,
+                         std::vector<uint32_t>& draw_nodes);
+    float projectedSpacing(const PointCache::NodeRecord& node, const glm::vec3& view_position,
+                           const Octree::LODParameters& params) const;
+    bool touch(uint32_t node);
+    void request(uint32_t node, float priority);
+    void takeCompleted();
+    void evict();
+    
+    void ioWorker();
+    std::unique_ptr<NodeData> readNode(uint32_t node) const;
+};
+
+} // namespace pcv
\ No newline at end of file
@@ -1,19 +1,55 @@
 #include "core/PointCloud.h"
+#include "core/PointKernels.h"
+#include "processing/NormalEstimation.h"
+#include "utils/TextParser.h"
 #include <fstream>
-#include <sstream>
 #include <algorithm>
 #include <stdexcept>
+#include <cmath>
 #include <glm/gtc/matrix_transform.hpp>
 
 namespace pcv {
 
-PointCloud::PointCloud(size_t reserve_size) {
-    points_.reserve(reserve_size);
+PointCloud::PointCloud(size_t reserve_size, uint32_t channels) 
+    : channels_(channels | POSITION) {
+    reserve(reserve_size);
+}
+
+void PointCloud::setChannels(uint32_t channels) {
+    channels |= POSITION;
+    Point defaults;
+    
+    // Channels enabled after reserve() get the same capacity as the positions
+    if ((channels & COLOR) && !hasColors()) {
+        colors_.reserve(positions_.capacity());
+        colors_.assign(size(), packColor(defaults.color));
+    } else if (!(channels & COLOR)) {
+        std::vector<PackedColor>().swap(colors_);
+    }
+    
+    if ((channels & NORMAL) && !hasNormals()) {
+        normals_.reserve(positions_.capacity());
+        normals_.assign(size(), packNormal(defaults.normal));
+    } else if (!(channels & NORMAL)) {
+        std::vector<PackedNormal>().swap(normals_);
+    }
+    
+    if ((channels & INTENSITY) && !hasIntensities()) {
+        intensities_.reserve(positions_.capacity());
+        intensities_.assign(size(), defaults.intensity);
+    } else if (!(channels & INTENSITY)) {
+        std::vector<float>().swap(intensities_);
+    }
+    
+    channels_ = channels;
 }
 
 void PointCloud::addPoint(const Point& point) {
-    points_.push_back(point);
-    updateBounds(point);
+    positions_.push_back(point.position);
+    if (hasColors()) colors_.push_back(packColor(point.color));
+    if (hasNormals()) normals_.push_back(packNormal(point.normal));
+    if (hasIntensities()) intensities_.push_back(point.intensity);
+    updateBounds(point.position);
 }
 
 void PointCloud::addPoint(const glm::vec3& position) {
@@ -26,18 +62,172 @@ void PointCloud::addPoint(const glm::vec3& position, const glm::vec3& color) {
     addPoint(p);
 }
 
-Point& PointCloud::at(size_t idx) {
-    if (idx >= points_.size()) {
-        throw std::out_of_range("Index out of range");
+void PointCloud::append(const PointCloud& other) {
+    if (other.empty()) return;
+    
+    // Enable our missing channels first so every channel stays the same length
+    enableChannels(other.channels_);
+    Point defaults;
+    
+    positions_.insert(positions_.end(), other.positions_.begin(), other.positions_.end());
+    if (hasColors()) {
+        if (other.hasColors()) {
+            colors_.insert(colors_.end(), other.colors_.begin(), other.colors_.end());
+        } else {
+            colors_.resize(positions_.size(), packColor(defaults.color));
+        }
+    }
+    if (hasNormals()) {
+        if (other.hasNormals()) {
+            normals_.insert(normals_.end(), other.normals_.begin(), other.normals_.end());
+        } else {
+            normals_.resize(positions_.size(), packNormal(defaults.normal));
+        }
+    }
+    if (hasIntensities()) {
+        if (other.hasIntensities()) {
+            intensities_.insert(intensities_.end(), other.intensities_.begin(), other.intensities_.end());
+        } else {
+            intensities_.resize(positions_.size(), defaults.intensity);
+        }
     }
-    return points_[idx];
+    
+    expandBounds(other.min_bound_, other.max_bound_);
 }
 
-const Point& PointCloud::at(size_t idx) const {
-    if (idx >= points_.size()) {
+Point PointCloud::at(size_t idx) const {
+    if (idx >= size()) {
         throw std::out_of_range("Index out of range");
     }
-    return points_[idx];
+    return (*this)[idx];
+}
+
+void PointCloud::setPoint(size_t idx, const Point& point) {
+    positions_[idx] = point.position;
+    if (hasColors()) colors_[idx] = packColor(point.color);
+    if (hasNormals()) normals_[idx] = packNormal(point.normal);
+    if (hasIntensities()) intensities_[idx] = point.intensity;
+    updateBounds(point.position);
+}
+
+void PointCloud::setColor(size_t idx, const glm::vec3& color) {
+    enableChannels(COLOR);
+    colors_[idx] = packColor(color);
+}
+
+void PointCloud::setNormal(size_t idx, const glm::vec3& normal) {
+    enableChannels(NORMAL);
+    normals_[idx] = packNormal(normal);
+}
+
+void PointCloud::setIntensity(size_t idx, float intensity) {
+    enableChannels(INTENSITY);
+    intensities_[idx] = intensity;
+}
+
+void PointCloud::clear() {
+    positions_.clear();
+    colors_.clear();
+    normals_.clear();
+    intensities_.clear();
+    
+    // Empty box, as for a new cloud, so points added next define the bounds
+    min_bound_ = glm::vec3(std::numeric_limits<float>::max());
+    max_bound_ = glm::vec3(std::numeric_limits<float>::lowest());
+}
+
+void PointCloud::reserve(size_t size) {
+    // Absent channels stay unallocated; setChannels() reserves them when enabled
+    positions_.reserve(size);
+    if (hasColors()) colors_.reserve(size);
+    if (hasNormals()) normals_.reserve(size);
+    if (hasIntensities()) intensities_.reserve(size);
+}
+
+void PointCloud::resize(size_t size) {
+    Point defaults;
+    const size_t old_size = positions_.size();
+    positions_.resize(size, defaults.position);
+    if (hasColors()) colors_.resize(size, packColor(defaults.color));
+    if (hasNormals()) normals_.resize(size, packNormal(defaults.normal));
+    if (hasIntensities()) intensities_.resize(size, defaults.intensity);
+    
+    // Growing only adds default points
+    if (size < old_size || old_size == 0) {
+        updateBounds();
+    } else if (size > old_size) {
+        updateBounds(defaults.position);
+    }
+}
+
+template<typename T>
+void PointCloud::compactChannel(std::vector<T>& channel, const std::vector<uint8_t>& keep_mask) {
+    size_t count = std::min(keep_mask.size(), channel.size());
+    size_t write = 0;
+    
+    // Points past the end of the mask are removed
+    for (size_t read = 0; read < count; ++read) {
+        if (keep_mask[read]) {
+            if (write != read) {
+                channel[write] = channel[read];
+            }
+            write++;
+        }
+    }
+    
+    channel.resize(write);
+}
+
+template<typename T>
+void PointCloud::extractChannel(const std::vector<T>& channel, const std::vector<uint8_t>& keep_mask,
+                                size_t kept, std::vector<T>& output) {
+    output.clear();
+    if (channel.empty()) return;
+    
+    output.reserve(kept);
+    size_t count = std::min(keep_mask.size(), channel.size());
+    for (size_t read = 0; read < count; ++read) {
+        if (keep_mask[read]) {
+            output.push_back(channel[read]);
+        }
+    }
+}
+
+size_t PointCloud::compact(const std::vector<uint8_t>& keep_mask) {
+    size_t original_size = size();
+    
+    // One streaming pass per channel
+    compactChannel(positions_, keep_mask);
+    compactChannel(colors_, keep_mask);
+    compactChannel(normals_, keep_mask);
+    compactChannel(intensities_, keep_mask);
+    
+    updateBounds();
+    return original_size - size();
+}
+
+void PointCloud::extract(const std::vector<uint8_t>& keep_mask, PointCloud& output) const {
+    size_t count = std::min(keep_mask.size(), size());
+    size_t kept = static_cast<size_t>(std::count_if(keep_mask.begin(), keep_mask.begin() + count,
+                                                    [](uint8_t keep) { return keep != 0; }));
+    
+    // Each output channel is sized once and filled in one pass
+    output.channels_ = channels_;
+    extractChannel(positions_, keep_mask, kept, output.positions_);
+    extractChannel(colors_, keep_mask, kept, output.colors_);
+    extractChannel(normals_, keep_mask, kept, output.normals_);
+    extractChannel(intensities_, keep_mask, kept, output.intensities_);
+    output.updateBounds();
+}
+
+size_t PointCloud::removeIndices(const std::vector<size_t>& indices) {
+    std::vector<uint8_t> keep_mask(size(), 1);
+    for (size_t idx : indices) {
+        if (idx < keep_mask.size()) {
+            keep_mask[idx] = 0;
+        }
+    }
+    return compact(keep_mask);
 }
 
 float PointCloud::getDiagonalLength() const {
@@ -45,23 +235,26 @@ float PointCloud::getDiagonalLength() const {
 }
 
 void PointCloud::transform(const glm::mat4& transformation) {
-    for (auto& point : points_) {
-        glm::vec4 pos(point.position, 1.0f);
-        point.position = glm::vec3(transformation * pos);
-        
-        // Transform normal (use inverse transpose for correct normal transformation)
-        glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(transformation)));
-        point.normal = glm::normalize(normalMatrix * point.normal);
+    if (positions_.empty()) {
+        updateBounds();
+        return;
+    }
+    
+    // The bounds come out of the position pass
+    PointKernels::transformPositions(positions_.data(), positions_.size(), transformation, min_bound_, max_bound_);
+    if (!normals_.empty()) {
+        // Normals use the inverse transpose
+        glm::mat3 normal_matrix = glm::transpose(glm::inverse(glm::mat3(transformation)));
+        PointKernels::transformNormals(normals_.data(), normals_.size(), normal_matrix);
     }
-    updateBounds();
 }
 
 void PointCloud::translateCentroid(const glm::vec3& target) {
     glm::vec3 centroid = getCenter();
     glm::vec3 translation = target - centroid;
     
-    for (auto& point : points_) {
-        point.position += translation;
+    for (auto& position : positions_) {
+        position += translation;
     }
     
     min_bound_ += translation;
@@ -69,48 +262,33 @@ void PointCloud::translateCentroid(const glm::vec3& target) {
 }
 
 void PointCloud::scale(float factor) {
-    glm::vec3 center = getCenter();
-    
-    for (auto& point : points_) {
-        point.position = center + factor * (point.position - center);
+    if (positions_.empty()) {
+        updateBounds();
+        return;
     }
     
-    updateBounds();
+    // About the center, as one transform pass (normals keep their directions)
+    glm::vec3 center = getCenter();
+    glm::mat4 scaling = glm::translate(glm::mat4(1.0f), center) *
+                        glm::scale(glm::mat4(1.0f), glm::vec3(factor)) *
+                        glm::translate(glm::mat4(1.0f), -center);
+    PointKernels::transformPositions(positions_.data(), positions_.size(), scaling, min_bound_, max_bound_);
 }
 
 void PointCloud::computeNormals(int k_neighbors) {
-    // Simplified normal computation - in production, use KD-tree for neighbor search
-    // For now, we'll use a placeholder implementation
-    for (auto& point : points_) {
-        // This is a placeholder - real implementation would use PCA on k-nearest neighbors
-        point.normal = glm::normalize(point.position);
-    }
+    NormalEstimation::Parameters params;
+    params.k_neighbors = k_neighbors;
+    NormalEstimation::compute(*this, params);
 }
 
 bool PointCloud::loadFromFile(const std::string& filename) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        return false;
-    }
-    
     clear();
-    std::string line;
+    setChannels(POSITION);
     
     // Simple XYZ RGB format reader
-    while (std::getline(file, line)) {
-        if (line.empty() || line[0] == '#') continue;
-        
-        std::istringstream iss(line);
-        float x, y, z, r = 1.0f, g = 1.0f, b = 1.0f;
-        
-        if (iss >> x >> y >> z) {
-            // Try to read color
-            iss >> r >> g >> b;
-            addPoint(glm::vec3(x, y, z), glm::vec3(r, g, b));
-        }
+    if (!TextParser::parseFile(filename, 0, TextParser::xyzLayout(), *this)) {
+        return false;
     }
-    
-    file.close();
     return !empty();
 }
 
@@ -124,7 +302,7 @@ bool PointCloud::saveToFile(const std::string& filename) const {
     file << "# Format: X Y Z R G B\n";
     file << "# Points: " << size() << "\n";
     
-    for (const auto& point : points_) {
+    for (const auto& point : *this) {
         file << point.position.x << " " 
              << point.position.y << " " 
              << point.position.z << " "
@@ -138,27 +316,31 @@ bool PointCloud::saveToFile(const std::string& filename) const {
 }
 
 size_t PointCloud::getMemoryUsage() const {
-    return sizeof(PointCloud) + points_.capacity() * sizeof(Point);
+    return sizeof(PointCloud) + 
+           positions_.capacity() * sizeof(glm::vec3) +
+           colors_.capacity() * sizeof(PackedColor) +
+           normals_.capacity() * sizeof(PackedNormal) +
+           intensities_.capacity() * sizeof(float);
 }
 
 void PointCloud::updateBounds() {
-    if (points_.empty()) {
+    if (positions_.empty()) {
         min_bound_ = glm::vec3(0.0f);
         max_bound_ = glm::vec3(0.0f);
         return;
     }
     
-    min_bound_ = glm::vec3(std::numeric_limits<float>::max());
-    max_bound_ = glm::vec3(std::numeric_limits<float>::lowest());
-    
-    for (const auto& point : points_) {
-        updateBounds(point);
-    }
+    PointKernels::computeBounds(positions_.data(), positions_.size(), min_bound_, max_bound_);
+}
+
+void PointCloud::expandBounds(const glm::vec3& min_bound, const glm::vec3& max_bound) {
+    min_bound_ = glm::min(min_bound_, min_bound);
+    max_bound_ = glm::max(max_bound_, max_bound);
 }
 
-void PointCloud::updateBounds(const Point& point) {
-    min_bound_ = glm::min(min_bound_, point.position);
-    max_bound_ = glm::max(max_bound_, point.position);
+void PointCloud::updateBounds(const glm::vec3& position) {
+    min_bound_ = glm::min(min_bound_, position);
+    max_bound_ = glm::max(max_bound_, position);
 }
 
 } // namespace pcv
\ No newline at end of file
@@ -1,7 +1,12 @@
 #pragma once
 
 #include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
 #include <glm/glm.hpp>
+#include "core/PointEncoding.h"
 #include <memory>
 #include <string>
 
@@ -19,54 +24,144 @@ struct Point {
         : position(pos), color(col), normal(0.0f, 0.0f, 1.0f), intensity(1.0f) {}
 };
 
+// Point cloud stored as a structure of arrays: positions, colors, normals and
+// intensities each live in their own contiguous channel. Point is the
+// assembled per-point view; hot loops should read the channels directly.
+// Attribute channels are optional and stored compactly (8-bit RGBA colors,
+// octahedral 16-bit normals); absent channels read back as Point defaults.
 class PointCloud {
 public:
     using Ptr = std::shared_ptr<PointCloud>;
     using ConstPtr = std::shared_ptr<const PointCloud>;
     
+    // Channel presence flags
+    enum Channel : uint32_t {
+        POSITION  = 1u << 0,
+        COLOR     = 1u << 1,
+        NORMAL    = 1u << 2,
+        INTENSITY = 1u << 3,
+        ALL_CHANNELS = POSITION | COLOR | NORMAL | INTENSITY
+    };
+    
+    // Read-only iterator yielding assembled Points
+    class ConstIterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Point;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = Point;
+        
+        ConstIterator(const PointCloud* cloud, size_t index) : cloud_(cloud), index_(index) {}
+        
+        Point operator*() const { return (*cloud_)[index_]; }
+        ConstIterator& operator++() { ++index_; return *this; }
+        ConstIterator operator++(int) { ConstIterator tmp = *this; ++index_; return tmp; }
+        bool operator==(const ConstIterator& other) const { return index_ == other.index_; }
+        bool operator!=(const ConstIterator& other) const { return index_ != other.index_; }
+        
+    private:
+        const PointCloud* cloud_;
+        size_t index_;
+    };
+    
     PointCloud() = default;
-    explicit PointCloud(size_t reserve_size);
+    explicit PointCloud(size_t reserve_size, uint32_t channels = POSITION | COLOR);
     ~PointCloud() = default;
     
-    // Point access
+    // Channels - enabling fills new channels with defaults, disabling frees them
+    uint32_t getChannels() const { return channels_; }
+    void setChannels(uint32_t channels);
+    void enableChannels(uint32_t channels) { setChannels(channels_ | channels); }
+    bool hasColors() const { return (channels_ & COLOR) != 0; }
+    bool hasNormals() const { return (channels_ & NORMAL) != 0; }
+    bool hasIntensities() const { return (channels_ & INTENSITY) != 0; }
+    
+    // Point access - attributes of absent channels are dropped
     void addPoint(const Point& point);
     void addPoint(const glm::vec3& position);
     void addPoint(const glm::vec3& position, const glm::vec3& color);
     
-    Point& operator[](size_t idx) { return points_[idx]; }
-    const Point& operator[](size_t idx) const { return points_[idx]; }
+    // Append all points of other; channels present in either cloud are kept
+    void append(const PointCloud& other);
+    
+    Point operator[](size_t idx) const {
+        Point point(positions_[idx]);
+        if (hasColors()) point.color = unpackColor(colors_[idx]);
+        if (hasNormals()) point.normal = unpackNormal(normals_[idx]);
+        if (hasIntensities()) point.intensity = intensities_[idx];
+        return point;
+    }
     
-    Point& at(size_t idx);
-    const Point& at(size_t idx) const;
+    Point at(size_t idx) const;
+    
+    // Bounds grow to include the new position; call updateBounds() to tighten them
+    void setPoint(size_t idx, const Point& point);
+    
+    // Per-channel element access
+    const glm::vec3& getPosition(size_t idx) const { return positions_[idx]; }
+    glm::vec3 getColor(size_t idx) const {
+        return hasColors() ? unpackColor(colors_[idx]) : glm::vec3(1.0f);
+    }
+    glm::vec3 getNormal(size_t idx) const {
+        return hasNormals() ? unpackNormal(normals_[idx]) : glm::vec3(0.0f, 0.0f, 1.0f);
+    }
+    float getIntensity(size_t idx) const {
+        return hasIntensities() ? intensities_[idx] : 1.0f;
+    }
+    
+    // Setters enable the channel on first use
+    void setColor(size_t idx, const glm::vec3& color);
+    void setNormal(size_t idx, const glm::vec3& normal);
+    void setIntensity(size_t idx, float intensity);
     
     // Container operations
-    size_t size() const { return points_.size(); }
-    bool empty() const { return points_.empty(); }
-    void clear() { points_.clear(); updateBounds(); }
-    void reserve(size_t size) { points_.reserve(size); }
-    void resize(size_t size) { points_.resize(size); updateBounds(); }
+    size_t size() const { return positions_.size(); }
+    bool empty() const { return positions_.empty(); }
+    void clear();
+    void reserve(size_t size);   // Positions and the enabled channels only
+    void resize(size_t size);
+    
+    // Compaction - stable, single pass, refreshes bounds. Return number of points removed.
+    size_t compact(const std::vector<uint8_t>& keep_mask);
+    
+    // Copy only the kept points into output (same channels), leaving this cloud as is
+    void extract(const std::vector<uint8_t>& keep_mask, PointCloud& output) const;
+    size_t removeIndices(const std::vector<size_t>& indices);
+    template<typename Predicate>
+    size_t removeIf(Predicate predicate);
     
     // Iterators
-    std::vector<Point>::iterator begin() { return points_.begin(); }
-    std::vector<Point>::iterator end() { return points_.end(); }
-    std::vector<Point>::const_iterator begin() const { return points_.begin(); }
-    std::vector<Point>::const_iterator end() const { return points_.end(); }
+    ConstIterator begin() const { return ConstIterator(this, 0); }
+    ConstIterator end() const { return ConstIterator(this, size()); }
+    
+    // Channel access - contiguous arrays suitable for direct GPU upload.
+    // Absent channels are empty. Mutable positions require updateBounds() once edits are done.
+    const std::vector<glm::vec3>& getPositions() const { return positions_; }
+    const std::vector<PackedColor>& getColors() const { return colors_; }
+    const std::vector<PackedNormal>& getNormals() const { return normals_; }
+    const std::vector<float>& getIntensities() const { return intensities_; }
     
-    // Data access
-    const std::vector<Point>& getPoints() const { return points_; }
-    std::vector<Point>& getPoints() { return points_; }
+    std::vector<glm::vec3>& getPositions() { return positions_; }
+    std::vector<PackedColor>& getColors() { return colors_; }
+    std::vector<PackedNormal>& getNormals() { return normals_; }
+    std::vector<float>& getIntensities() { return intensities_; }
     
     // Bounds
     const glm::vec3& getMinBound() const { return min_bound_; }
     const glm::vec3& getMaxBound() const { return max_bound_; }
     glm::vec3 getCenter() const { return (min_bound_ + max_bound_) * 0.5f; }
     float getDiagonalLength() const;
+    void updateBounds();
+    
+    // Grow the bounds to cover a box, e.g. after appending through the mutable channels
+    void expandBounds(const glm::vec3& min_bound, const glm::vec3& max_bound);
     
     // Operations
-    void transform(const glm::mat4& transformation);
+    void transform(const glm::mat4& transformation);   // One parallel pass per channel, bounds included
     void translateCentroid(const glm::vec3& target = glm::vec3(0.0f));
     void scale(float factor);
-    void computeNormals(int k_neighbors = 10);
+    void computeNormals(int k_neighbors = 10);   // PCA over k-NN, see NormalEstimation
     
     // I/O
     bool loadFromFile(const std::string& filename);
@@ -76,12 +171,30 @@ public:
     size_t getMemoryUsage() const;
     
 private:
-    std::vector<Point> points_;
+    uint32_t channels_ = POSITION | COLOR;
+    std::vector<glm::vec3> positions_;
+    std::vector<PackedColor> colors_;
+    std::vector<PackedNormal> normals_;
+    std::vector<float> intensities_;
     glm::vec3 min_bound_{std::numeric_limits<float>::max()};
     glm::vec3 max_bound_{std::numeric_limits<float>::lowest()};
     
-    void updateBounds();
-    void updateBounds(const Point& point);
+    void updateBounds(const glm::vec3& position);
+    
+    template<typename T>
+    static void compactChannel(std::vector<T>& channel, const std::vector<uint8_t>& keep_mask);
+    template<typename T>
+    static void extractChannel(const std::vector<T>& channel, const std::vector<uint8_t>& keep_mask,
+                               size_t kept, std::vector<T>& output);
 };
 
+template<typename Predicate>
+size_t PointCloud::removeIf(Predicate predicate) {
+    std::vector<uint8_t> keep_mask(size());
+    for (size_t i = 0; i < size(); ++i) {
+        keep_mask[i] = !predicate((*this)[i]);
+    }
+    return compact(keep_mask);
+}
+
 } // namespace pcv
\ No newline at end of file
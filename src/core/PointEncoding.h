@@ -0,0 +1,99 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace pcv {
+
+// Compact attribute encodings shared by PointCloud storage, GPU buffers and files.
+// Layouts match the GL vertex formats they are uploaded as.
+
+// 8-bit RGBA color (GL_UNSIGNED_BYTE x4, normalized)
+struct PackedColor {
+    uint8_t r, g, b, a;
+};
+
+// Octahedral unit vector in two snorm16 components (GL_SHORT x2, normalized)
+struct PackedNormal {
+    int16_t x, y;
+};
+
+// Position quantized to 16 bits per axis within a bounding box (GL_UNSIGNED_SHORT x3, normalized)
+struct QuantizedPosition {
+    uint16_t x, y, z;
+};
+
+inline uint8_t encodeUnorm8(float value) {
+    return static_cast<uint8_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+}
+
+inline PackedColor packColor(const glm::vec3& color) {
+    return {encodeUnorm8(color.r), encodeUnorm8(color.g), encodeUnorm8(color.b), 255};
+}
+
+inline glm::vec3 unpackColor(const PackedColor& color) {
+    return glm::vec3(color.r, color.g, color.b) / 255.0f;
+}
+
+inline float signNotZero(float value) {
+    return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+inline PackedNormal packNormal(const glm::vec3& normal) {
+    float l1 = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    if (l1 <= 0.0f) {
+        return {0, 0}; // Decodes to +Z
+    }
+    
+    // Project onto the octahedron, fold the lower hemisphere over the diagonals
+    float x = normal.x / l1;
+    float y = normal.y / l1;
+    if (normal.z < 0.0f) {
+        float folded_x = (1.0f - std::abs(y)) * signNotZero(x);
+        float folded_y = (1.0f - std::abs(x)) * signNotZero(y);
+        x = folded_x;
+        y = folded_y;
+    }
+    
+    return {static_cast<int16_t>(std::lround(std::clamp(x, -1.0f, 1.0f) * 32767.0f)),
+            static_cast<int16_t>(std::lround(std::clamp(y, -1.0f, 1.0f) * 32767.0f))};
+}
+
+inline glm::vec3 unpackNormal(const PackedNormal& packed) {
+    float x = std::max(packed.x / 32767.0f, -1.0f);
+    float y = std::max(packed.y / 32767.0f, -1.0f);
+    float z = 1.0f - std::abs(x) - std::abs(y);
+    if (z < 0.0f) {
+        float unfolded_x = (1.0f - std::abs(y)) * signNotZero(x);
+        float unfolded_y = (1.0f - std::abs(x)) * signNotZero(y);
+        x = unfolded_x;
+        y = unfolded_y;
+    }
+    return glm::normalize(glm::vec3(x, y, z));
+}
+
+inline QuantizedPosition quantizePosition(const glm::vec3& position,
+                                          const glm::vec3& min_bound,
+                                          const glm::vec3& max_bound) {
+    glm::vec3 extent = max_bound - min_bound;
+    glm::vec3 t(0.0f);
+    for (int axis = 0; axis < 3; ++axis) {
+        if (extent[axis] > 0.0f) {
+            t[axis] = std::clamp((position[axis] - min_bound[axis]) / extent[axis], 0.0f, 1.0f);
+        }
+    }
+    return {static_cast<uint16_t>(std::lround(t.x * 65535.0f)),
+            static_cast<uint16_t>(std::lround(t.y * 65535.0f)),
+            static_cast<uint16_t>(std::lround(t.z * 65535.0f))};
+}
+
+inline glm::vec3 dequantizePosition(const QuantizedPosition& quantized,
+                                    const glm::vec3& min_bound,
+                                    const glm::vec3& max_bound) {
+    glm::vec3 t = glm::vec3(quantized.x, quantized.y, quantized.z) / 65535.0f;
+    return min_bound + t * (max_bound - min_bound);
+}
+
+} // namespace pcv
\ No newline at end of file
@@ -0,0 +1,158 @@
+#include "core/PointKernels.h"
+
+#include "core/SimdLanes.h"
+#include "utils/Parallel.h"
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace pcv {
+
+namespace {
+
+using simd::Lanes;
+
+constexpr size_t BLOCK_SIZE = 64;
+static_assert(BLOCK_SIZE % Lanes::WIDTH == 0, "point blocks must be whole lane groups");
+
+struct Block {
+    alignas(32) float x[BLOCK_SIZE];
+    alignas(32) float y[BLOCK_SIZE];
+    alignas(32) float z[BLOCK_SIZE];
+};
+
+// Lanes past the point count repeat the first point, so they never widen the bounds
+void loadBlock(const glm::vec3* positions, size_t count, Block& block) {
+    for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+        const glm::vec3& position = positions[i < count ? i : 0];
+        block.x[i] = position.x;
+        block.y[i] = position.y;
+        block.z[i] = position.z;
+    }
+}
+
+void storeBlock(const Block& block, size_t count, glm::vec3* positions) {
+    for (size_t i = 0; i < count; ++i) {
+        positions[i] = glm::vec3(block.x[i], block.y[i], block.z[i]);
+    }
+}
+
+struct Bounds {
+    glm::vec3 min_bound{std::numeric_limits<float>::max()};
+    glm::vec3 max_bound{std::numeric_limits<float>::lowest()};
+};
+
+// Per-lane bounds over the blocks of one task, folded into Bounds at its end
+struct LaneBounds {
+    Lanes::Float min_x, min_y, min_z;
+    Lanes::Float max_x, max_y, max_z;
+    
+    LaneBounds()
+        : min_x(Lanes::splat(std::numeric_limits<float>::max())), min_y(min_x), min_z(min_x),
+          max_x(Lanes::splat(std::numeric_limits<float>::lowest())), max_y(max_x), max_z(max_x) {}
+    
+    void add(Lanes::Float x, Lanes::Float y, Lanes::Float z) {
+        min_x = Lanes::min(min_x, x);
+        min_y = Lanes::min(min_y, y);
+        min_z = Lanes::min(min_z, z);
+        max_x = Lanes::max(max_x, x);
+        max_y = Lanes::max(max_y, y);
+        max_z = Lanes::max(max_z, z);
+    }
+    
+    void foldInto(Bounds& bounds) const {
+        alignas(32) float values[6][Lanes::WIDTH];
+        Lanes::store(values[0], min_x);
+        Lanes::store(values[1], min_y);
+        Lanes::store(values[2], min_z);
+        Lanes::store(values[3], max_x);
+        Lanes::store(values[4], max_y);
+        Lanes::store(values[5], max_z);
+        for (size_t lane = 0; lane < Lanes::WIDTH; ++lane) {
+            bounds.min_bound = glm::min(bounds.min_bound, glm::vec3(values[0][lane], values[1][lane], values[2][lane]));
+            bounds.max_bound = glm::max(bounds.max_bound, glm::vec3(values[3][lane], values[4][lane], values[5][lane]));
+        }
+    }
+};
+
+// Runs task(begin, end, bounds) over [0, count) and merges the per-thread bounds
+template<typename Task>
+void reduceBounds(size_t count, size_t num_threads, glm::vec3& min_bound, glm::vec3& max_bound, Task task) {
+    std::vector<Bounds> partial(resolveThreadCount(num_threads));
+    parallelFor(count, num_threads, [&](size_t thread_index, size_t begin, size_t end) {
+        task(begin, end, partial[thread_index]);
+    }, PointKernels::GRAIN_SIZE);
+    
+    Bounds total;
+    for (const Bounds& bounds : partial) {
+        total.min_bound = glm::min(total.min_bound, bounds.min_bound);
+        total.max_bound = glm::max(total.max_bound, bounds.max_bound);
+    }
+    min_bound = total.min_bound;
+    max_bound = total.max_bound;
+}
+
+} // namespace
+
+void PointKernels::transformPositions(glm::vec3* positions, size_t count, const glm::mat4& transformation,
+                                      glm::vec3& min_bound, glm::vec3& max_bound, size_t num_threads) {
+    // Column c, row r is transformation[c][r]
+    const glm::mat4& m = transformation;
+    reduceBounds(count, num_threads, min_bound, max_bound, [&](size_t begin, size_t end, Bounds& bounds) {
+        const Lanes::Float m00 = Lanes::splat(m[0][0]), m01 = Lanes::splat(m[0][1]), m02 = Lanes::splat(m[0][2]);
+        const Lanes::Float m10 = Lanes::splat(m[1][0]), m11 = Lanes::splat(m[1][1]), m12 = Lanes::splat(m[1][2]);
+        const Lanes::Float m20 = Lanes::splat(m[2][0]), m21 = Lanes::splat(m[2][1]), m22 = Lanes::splat(m[2][2]);
+        const Lanes::Float m30 = Lanes::splat(m[3][0]), m31 = Lanes::splat(m[3][1]), m32 = Lanes::splat(m[3][2]);
+        LaneBounds lane_bounds;
+        Block block;
+        for (size_t i = begin; i < end; i += BLOCK_SIZE) {
+            size_t block_count = std::min(BLOCK_SIZE, end - i);
+            loadBlock(positions + i, block_count, block);
+            for (size_t lane = 0; lane < BLOCK_SIZE; lane += Lanes::WIDTH) {
+                Lanes::Float x = Lanes::load(block.x + lane);
+                Lanes::Float y = Lanes::load(block.y + lane);
+                Lanes::Float z = Lanes::load(block.z + lane);
+                
+                // glm: (m[0] * x + m[1] * y) + (m[2] * z + m[3] * 1)
+                Lanes::Float tx = Lanes::add(Lanes::add(Lanes::mul(m00, x), Lanes::mul(m10, y)),
+                                             Lanes::add(Lanes::mul(m20, z), m30));
+                Lanes::Float ty = Lanes::add(Lanes::add(Lanes::mul(m01, x), Lanes::mul(m11, y)),
+                                             Lanes::add(Lanes::mul(m21, z), m31));
+                Lanes::Float tz = Lanes::add(Lanes::add(Lanes::mul(m02, x), Lanes::mul(m12, y)),
+                                             Lanes::add(Lanes::mul(m22, z), m32));
+                Lanes::store(block.x + lane, tx);
+                Lanes::store(block.y + lane, ty);
+                Lanes::store(block.z + lane, tz);
+                lane_bounds.add(tx, ty, tz);
+            }
+            storeBlock(block, block_count, positions + i);
+        }
+        lane_bounds.foldInto(bounds);
+    });
+}
+
+void PointKernels::transformNormals(PackedNormal* normals, size_t count, const glm::mat3& normal_matrix,
+                                    size_t num_threads) {
+    parallelFor(count, num_threads, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            normals[i] = packNormal(normal_matrix * unpackNormal(normals[i]));
+        }
+    }, GRAIN_SIZE);
+}
+
+void PointKernels::computeBounds(const glm::vec3* positions, size_t count,
+                                 glm::vec3& min_bound, glm::vec3& max_bound, size_t num_threads) {
+    reduceBounds(count, num_threads, min_bound, max_bound, [&](size_t begin, size_t end, Bounds& bounds) {
+        LaneBounds lane_bounds;
+        Block block;
+        for (size_t i = begin; i < end; i += BLOCK_SIZE) {
+            loadBlock(positions + i, std::min(BLOCK_SIZE, end - i), block);
+            for (size_t lane = 0; lane < BLOCK_SIZE; lane += Lanes::WIDTH) {
+                lane_bounds.add(Lanes::load(block.x + lane), Lanes::load(block.y + lane), Lanes::load(block.z + lane));
+            }
+        }
+        lane_bounds.foldInto(bounds);
+    });
+}
+
+} // namespace pcv
\ No newline at end of file
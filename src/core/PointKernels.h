@@ -0,0 +1,36 @@
+#pragma once
+
+#include "core/PointEncoding.h"
+#include <glm/glm.hpp>
+#include <cstddef>
+
+namespace pcv {
+
+// Bulk passes over whole point channels, in place.
+// Points are processed in parallel tasks of GRAIN_SIZE, each converting blocks to SoA
+// lanes (the LeafKernels instruction sets) with the matrix work hoisted out of the loop.
+// Position passes reduce the bounds of their result in the same pass instead of a second
+// one over the channel. Positions are evaluated in glm's mat4 * vec4 order and this file
+// is built with -ffp-contract=off, so they match a scalar glm loop built the same way
+// (benchmarks/test_point_kernels.cpp checks this). Channels smaller than one task run
+// on the calling thread.
+class PointKernels {
+public:
+    static constexpr size_t GRAIN_SIZE = size_t(1) << 16;
+    
+    // positions[i] = transformation * (positions[i], 1); the result's bounds go to
+    // min_bound and max_bound (an empty box, min > max, for no points)
+    static void transformPositions(glm::vec3* positions, size_t count, const glm::mat4& transformation,
+                                   glm::vec3& min_bound, glm::vec3& max_bound, size_t num_threads = 0);
+    
+    // normals[i] = normal_matrix * normals[i], re-encoded. The octahedral encoding
+    // divides by the L1 norm, so non-unit results need no normalize.
+    static void transformNormals(PackedNormal* normals, size_t count, const glm::mat3& normal_matrix,
+                                 size_t num_threads = 0);
+    
+    // Bounds of positions (an empty box for no points)
+    static void computeBounds(const glm::vec3* positions, size_t count,
+                              glm::vec3& min_bound, glm::vec3& max_bound, size_t num_threads = 0);
+};
+
+} // namespace pcv
\ No newline at end of file
@@ -0,0 +1,122 @@
+#pragma once
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+
+namespace pcv {
+namespace simd {
+
+// Per-instruction-set lane operations for the point kernels (LeafKernels, PointKernels),
+// which are written once against them. AVX, SSE2 or NEON is chosen at compile time,
+// with a scalar fallback. load() and store() need WIDTH * 4 byte aligned addresses.
+#if defined(__AVX__)
+
+struct Lanes {
+    static constexpr size_t WIDTH = 8;
+    using Float = __m256;
+    using Bool = __m256;
+    
+    static Float load(const float* values) { return _mm256_load_ps(values); }
+    static void store(float* values, Float a) { _mm256_store_ps(values, a); }
+    static Float splat(float value) { return _mm256_set1_ps(value); }
+    static Float add(Float a, Float b) { return _mm256_add_ps(a, b); }
+    static Float sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+    static Float mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+    static Float min(Float a, Float b) { return _mm256_min_ps(a, b); }
+    static Float max(Float a, Float b) { return _mm256_max_ps(a, b); }
+    static Bool both(Bool a, Bool b) { return _mm256_and_ps(a, b); }
+    static Bool greaterEqual(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+    static Bool lessEqual(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+    static Bool notLess(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_NLT_UQ); }
+    static Bool all() { return _mm256_castsi256_ps(_mm256_set1_epi32(-1)); }
+    static uint32_t bits(Bool b) { return static_cast<uint32_t>(_mm256_movemask_ps(b)); }
+};
+constexpr const char* INSTRUCTION_SET = "AVX";
+
+#elif defined(__SSE2__) || defined(_M_X64)
+
+struct Lanes {
+    static constexpr size_t WIDTH = 4;
+    using Float = __m128;
+    using Bool = __m128;
+    
+    static Float load(const float* values) { return _mm_load_ps(values); }
+    static void store(float* values, Float a) { _mm_store_ps(values, a); }
+    static Float splat(float value) { return _mm_set1_ps(value); }
+    static Float add(Float a, Float b) { return _mm_add_ps(a, b); }
+    static Float sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+    static Float mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+    static Float min(Float a, Float b) { return _mm_min_ps(a, b); }
+    static Float max(Float a, Float b) { return _mm_max_ps(a, b); }
+    static Bool both(Bool a, Bool b) { return _mm_and_ps(a, b); }
+    static Bool greaterEqual(Float a, Float b) { return _mm_cmpge_ps(a, b); }
+    static Bool lessEqual(Float a, Float b) { return _mm_cmple_ps(a, b); }
+    static Bool notLess(Float a, Float b) { return _mm_cmpnlt_ps(a, b); }
+    static Bool all() { return _mm_castsi128_ps(_mm_set1_epi32(-1)); }
+    static uint32_t bits(Bool b) { return static_cast<uint32_t>(_mm_movemask_ps(b)); }
+};
+constexpr const char* INSTRUCTION_SET = "SSE2";
+
+#elif defined(__ARM_NEON)
+
+struct Lanes {
+    static constexpr size_t WIDTH = 4;
+    using Float = float32x4_t;
+    using Bool = uint32x4_t;
+    
+    static Float load(const float* values) { return vld1q_f32(values); }
+    static void store(float* values, Float a) { vst1q_f32(values, a); }
+    static Float splat(float value) { return vdupq_n_f32(value); }
+    static Float add(Float a, Float b) { return vaddq_f32(a, b); }
+    static Float sub(Float a, Float b) { return vsubq_f32(a, b); }
+    static Float mul(Float a, Float b) { return vmulq_f32(a, b); }
+    static Float min(Float a, Float b) { return vminq_f32(a, b); }
+    static Float max(Float a, Float b) { return vmaxq_f32(a, b); }
+    static Bool both(Bool a, Bool b) { return vandq_u32(a, b); }
+    static Bool greaterEqual(Float a, Float b) { return vcgeq_f32(a, b); }
+    static Bool lessEqual(Float a, Float b) { return vcleq_f32(a, b); }
+    static Bool notLess(Float a, Float b) { return vmvnq_u32(vcltq_f32(a, b)); }
+    static Bool all() { return vdupq_n_u32(~0u); }
+    static uint32_t bits(Bool b) {
+        return (vgetq_lane_u32(b, 0) & 1u) | (vgetq_lane_u32(b, 1) & 2u) |
+               (vgetq_lane_u32(b, 2) & 4u) | (vgetq_lane_u32(b, 3) & 8u);
+    }
+};
+constexpr const char* INSTRUCTION_SET = "NEON";
+
+#else
+
+struct Lanes {
+    static constexpr size_t WIDTH = 1;
+    using Float = float;
+    using Bool = bool;
+    
+    static Float load(const float* values) { return *values; }
+    static void store(float* values, Float a) { *values = a; }
+    static Float splat(float value) { return value; }
+    static Float add(Float a, Float b) { return a + b; }
+    static Float sub(Float a, Float b) { return a - b; }
+    static Float mul(Float a, Float b) { return a * b; }
+    static Float min(Float a, Float b) { return a < b ? a : b; }
+    static Float max(Float a, Float b) { return a > b ? a : b; }
+    static Bool both(Bool a, Bool b) { return a && b; }
+    static Bool greaterEqual(Float a, Float b) { return a >= b; }
+    static Bool lessEqual(Float a, Float b) { return a <= b; }
+    static Bool notLess(Float a, Float b) { return !(a < b); }
+    static Bool all() { return true; }
+    static uint32_t bits(Bool b) { return b ? 1u : 0u; }
+};
+constexpr const char* INSTRUCTION_SET = "scalar";
+
+#endif
+
+} // namespace simd
+} // namespace pcv
\ No newline at end of file
@@ -4,13 +4,24 @@
 #include <memory>
 #include <chrono>
 #include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <limits>
+#include <future>
+#include <string>
+#include <vector>
 
 #include "core/PointCloud.h"
 #include "core/Octree.h"
+#include "core/OutOfCoreOctree.h"
 #include "rendering/Renderer.h"
 #include "rendering/Camera.h"
+#include "rendering/CameraPath.h"
 #include "processing/OutlierRemoval.h"
 #include "processing/VoxelDownsampling.h"
+#include "utils/AsyncLoader.h"
+#include "utils/PointCache.h"
+#include "utils/Profiler.h"
 #include "utils/Timer.h"
 
 using namespace pcv;
@@ -20,6 +31,9 @@ Camera* g_camera = nullptr;
 float g_lastX = 400, g_lastY = 300;
 bool g_firstMouse = true;
 bool g_mouseCaptured = false;
+bool g_showProfiler = false;
+bool g_edl = false;
+Renderer* g_renderer = nullptr;
 
 // Window dimensions
 const unsigned int WINDOW_WIDTH = 1280;
@@ -62,21 +76,118 @@ PointCloud::Ptr generateSamplePointCloud(size_t num_points = 100000) {  // Chang
     return cloud;
 }
 
+// Report what the filters would do to the cloud
+void analyzePointCloud(const PointCloud& cloud) {
+    std::cout << "Applying filters..." << std::endl;
+    Timer filter_timer;
+    
+    // Voxel downsampling
+    VoxelDownsampling::Parameters voxel_params;
+    voxel_params.leaf_size = 0.05f;
+    auto stats = VoxelDownsampling::getStatistics(cloud, voxel_params);
+    std::cout << "Voxel downsampling would reduce from " << stats.original_points 
+              << " to " << stats.downsampled_points << " points" << std::endl;
+    
+    // Outlier detection (k-NN queries through a KD-tree)
+    OutlierRemoval::StatisticalParams outlier_params;
+    outlier_params.k_neighbors = 50;
+    outlier_params.std_multiplier = 1.0f;
+    auto outliers = OutlierRemoval::findStatisticalOutliers(cloud, outlier_params);
+    std::cout << "Found " << outliers.size() << " outliers" << std::endl;
+    
+    std::cout << "Filters processed in " << filter_timer.elapsed() << " ms" << std::endl;
+}
+
+// Save the cloud and its octree for instant reopening
+void writeCache(const std::string& filename, const PointCloud& cloud, const Octree& octree) {
+    Timer cache_timer;
+    if (PointCache::write(filename, cloud, octree)) {
+        std::cout << "Cache written to " << filename << " in " << cache_timer.elapsed() << " ms" << std::endl;
+    }
+}
+
+// Print rolling per-stage percentiles
+void printProfile(const Profiler& profiler) {
+    std::cout << std::left << std::setw(16) << "Stage" << std::right << std::setw(9) << "p50 ms"
+              << std::setw(9) << "p95 ms" << std::setw(9) << "p99 ms" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+    for (const auto& stage : profiler.getSummary()) {
+        std::string name = stage.name + (stage.domain == Profiler::Domain::GPU ? " (gpu)" : "");
+        std::cout << std::left << std::setw(16) << name << std::right << std::setw(9) << stage.p50_ms
+                  << std::setw(9) << stage.p95_ms << std::setw(9) << stage.p99_ms << std::endl;
+    }
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << std::setprecision(6);
+}
+
 int main(int argc, char* argv[]) {
+    // Command line: [--gpu-culling] [--async-culling] [--edl] [--frame-reuse] [--quantize] [--point-budget N]
+    //               [--target-fps F]
+    //               [--profile prefix] [--record-path out.path] [--cache out.pcvc] [--out-of-core]
+    //               [point cloud file...]
+    // Several files are drawn together as one scene of tiles, e.g. registered scans.
+    std::vector<const char*> input_files;
+    const char* cache_file = nullptr;
+    bool gpu_culling = false;
+    bool async_culling = false;
+    bool frame_reuse = false;
+    bool quantize = false;
+    size_t point_budget = 0;
+    float target_fps = 0.0f;
+    const char* profile_prefix = nullptr;
+    const char* record_path = nullptr;
+    bool out_of_core = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--gpu-culling") {
+            gpu_culling = true;
+        } else if (arg == "--async-culling") {
+            async_culling = true;
+        } else if (arg == "--frame-reuse") {
+            frame_reuse = true;
+        } else if (arg == "--quantize") {
+            quantize = true;
+        } else if (arg == "--edl") {
+            g_edl = true;
+        } else if (arg == "--out-of-core") {
+            out_of_core = true;
+        } else if (arg == "--point-budget" && i + 1 < argc) {
+            point_budget = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--target-fps" && i + 1 < argc) {
+            target_fps = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--profile" && i + 1 < argc) {
+            profile_prefix = argv[++i];
+        } else if (arg == "--record-path" && i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (arg == "--cache" && i + 1 < argc) {
+            cache_file = argv[++i];
+        } else {
+            input_files.push_back(argv[i]);
+        }
+    }
+    const bool scene = input_files.size() > 1;
+    const char* input_file = input_files.size() == 1 ? input_files[0] : nullptr;
+    
     // Initialize GLFW
     if (!glfwInit()) {
         std::cerr << "Failed to initialize GLFW" << std::endl;
         return -1;
     }
     
-    // Configure GLFW
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    // Configure GLFW: GPU culling needs compute shaders (4.3), otherwise 3.3 core
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, gpu_culling ? 4 : 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     
     // Create window
     GLFWwindow* window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, 
                                           "3D Point Cloud Viewer", nullptr, nullptr);
+    if (!window && gpu_culling) {
+        std::cerr << "OpenGL 4.3 unavailable, falling back to 3.3 with CPU culling" << std::endl;
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT,
+                                  "3D Point Cloud Viewer", nullptr, nullptr);
+    }
     if (!window) {
         std::cerr << "Failed to create GLFW window" << std::endl;
         glfwTerminate();
@@ -100,63 +211,128 @@ int main(int argc, char* argv[]) {
     camera.setPerspective(45.0f, (float)WINDOW_WIDTH / WINDOW_HEIGHT, 0.1f, 100.0f);
     g_camera = &camera;
     
+    // Stage timings for the overlay (P) and, with --profile, trace files written on exit
+    Profiler profiler;
+    
     // Create renderer
     Renderer renderer(WINDOW_WIDTH, WINDOW_HEIGHT);
     if (!renderer.initialize()) {
         std::cerr << "Failed to initialize renderer" << std::endl;
         return -1;
     }
+    renderer.enableGPUCulling(gpu_culling && renderer.isGPUCullingSupported());
+    renderer.enableAsyncCulling(async_culling);
+    renderer.enableFrameReuse(frame_reuse);
+    renderer.enablePositionQuantization(quantize);
+    renderer.setPointBudget(point_budget);
+    renderer.setTargetFrameTime(target_fps > 0.0f ? 1000.0f / target_fps : 0.0f);
+    renderer.setProfiler(&profiler);
+    g_renderer = &renderer;
     
-    // Load or generate point cloud
-    PointCloud::Ptr cloud;
-    if (argc > 1) {
-        cloud = std::make_shared<PointCloud>();
-        if (!cloud->loadFromFile(argv[1])) {
-            std::cerr << "Failed to load point cloud from: " << argv[1] << std::endl;
-            std::cerr << "Generating sample point cloud instead..." << std::endl;
-            cloud = generateSamplePointCloud();
+    // Out-of-core: render a cache straight from disk, loading nodes as the view needs them
+    OutOfCoreOctree streamed;
+    if (out_of_core) {
+        bool is_cache = input_file && FileIO::getFormatFromExtension(input_file) == FileIO::Format::PCVC;
+        if (is_cache && streamed.open(input_file)) {
+            std::cout << "Streaming cache " << input_file << ": " << streamed.getPointCount() << " points, "
+                      << streamed.getNodeCount() << " nodes" << std::endl;
+            input_file = nullptr;
+        } else {
+            std::cerr << "--out-of-core needs a .pcvc cache, loading normally" << std::endl;
         }
-    } else {
-        std::cout << "No point cloud file specified. Generating sample point cloud..." << std::endl;
-        cloud = generateSamplePointCloud();
     }
     
-    std::cout << "Point cloud loaded: " << cloud->size() << " points" << std::endl;
-    std::cout << "Memory usage: " << cloud->getMemoryUsage() / (1024.0 * 1024.0) << " MB" << std::endl;
-    
-    // Apply filters
-    std::cout << "Applying filters..." << std::endl;
-    Timer filter_timer;
-    
-    // Voxel downsampling
-    VoxelDownsampling::Parameters voxel_params;
-    voxel_params.leaf_size = 0.05f;
-    auto stats = VoxelDownsampling::getStatistics(*cloud, voxel_params);
-    std::cout << "Voxel downsampling would reduce from " << stats.original_points 
-              << " to " << stats.downsampled_points << " points" << std::endl;
+    // Reopen a cache directly, load in the background (points stream in while
+    // rendering) or generate. Caches keep the (already centered) coordinates they were
+    // written with.
+    PointCloud::Ptr cloud = std::make_shared<PointCloud>();
+    AsyncLoader::Parameters loader_params;
+    loader_params.recenter = true;
+    AsyncLoader loader(loader_params);
     
-    // Outlier removal - COMMENTED OUT FOR PERFORMANCE
-    // This is O(n^2) and very slow for large point clouds
-    /*
-    OutlierRemoval::StatisticalParams outlier_params;
-    outlier_params.k_neighbors = 50;
-    outlier_params.std_multiplier = 1.0f;
-    auto outliers = OutlierRemoval::findStatisticalOutliers(*cloud, outlier_params);
-    std::cout << "Found " << outliers.size() << " outliers" << std::endl;
-    */
+    Timer load_timer;
+    PointCache cache;
+    bool from_cache = input_file &&
+                      FileIO::getFormatFromExtension(input_file) == FileIO::Format::PCVC &&
+                      cache.open(input_file) && cache.load(*cloud) && !cloud->empty();
+    bool loading = !from_cache && input_file && loader.start(input_file);
+    if (from_cache) {
+        std::cout << "Opened cache " << input_file << " in " << load_timer.elapsed() << " ms" << std::endl;
+    } else if (loading) {
+        std::cout << "Loading " << input_file << " in the background..." << std::endl;
+    } else if (streamed.isOpen() || scene) {
+        // Nothing to load into memory
+    } else {
+        if (input_file) {
+            std::cerr << "Failed to load point cloud from: " << input_file << std::endl;
+            std::cerr << "Generating sample point cloud instead..." << std::endl;
+        } else {
+            std::cout << "No point cloud file specified. Generating sample point cloud..." << std::endl;
+        }
+        cloud = generateSamplePointCloud();
+        
+        // Center the point cloud before the octree indexes it
+        cloud->translateCentroid(glm::vec3(0.0f));
+    }
     
-    std::cout << "Filters processed in " << filter_timer.elapsed() << " ms" << std::endl;
+    // Scene tiles: each file keeps its coordinates, and the tile transforms center the union
+    std::vector<std::unique_ptr<PointCloud>> tile_clouds;
+    std::vector<std::unique_ptr<Octree>> tile_octrees;
+    size_t scene_points = 0;
+    if (scene) {
+        glm::vec3 scene_min(std::numeric_limits<float>::max());
+        glm::vec3 scene_max(std::numeric_limits<float>::lowest());
+        for (const char* file : input_files) {
+            auto tile_cloud = std::make_unique<PointCloud>();
+            if (!FileIO::load(file, *tile_cloud) || tile_cloud->empty()) {
+                std::cerr << "Failed to load point cloud from: " << file << std::endl;
+                continue;
+            }
+            auto tile_octree = std::make_unique<Octree>(*tile_cloud);
+            tile_octree->build();
+            scene_min = glm::min(scene_min, tile_cloud->getMinBound());
+            scene_max = glm::max(scene_max, tile_cloud->getMaxBound());
+            scene_points += tile_cloud->size();
+            tile_clouds.push_back(std::move(tile_cloud));
+            tile_octrees.push_back(std::move(tile_octree));
+        }
+        
+        glm::mat4 transform = glm::translate(glm::mat4(1.0f), -0.5f * (scene_min + scene_max));
+        for (size_t i = 0; i < tile_clouds.size(); ++i) {
+            renderer.addTile(*tile_clouds[i], tile_octrees[i].get(), transform);
+        }
+        std::cout << "Scene loaded: " << renderer.getTileCount() << " tiles, " << scene_points
+                  << " points in " << load_timer.elapsed() << " ms" << std::endl;
+    }
     
-    // Build octree
-    std::cout << "Building octree..." << std::endl;
-    Timer octree_timer;
     Octree octree(*cloud);
-    octree.build();
-    std::cout << "Octree built in " << octree_timer.elapsed() << " ms" << std::endl;
-    std::cout << "Max depth: " << octree.getMaxDepth() << std::endl;
-    
-    // Center the point cloud
-    cloud->translateCentroid(glm::vec3(0.0f));
+    std::future<void> analysis;
+    if (!loading && !streamed.isOpen() && !scene) {
+        std::cout << "Point cloud loaded: " << cloud->size() << " points" << std::endl;
+        std::cout << "Memory usage: " << cloud->getMemoryUsage() / (1024.0 * 1024.0) << " MB" << std::endl;
+        if (!from_cache) {
+            analyzePointCloud(*cloud);
+        }
+        
+        Timer octree_timer;
+        if (from_cache && cache.loadOctree(octree)) {
+            std::cout << "Octree restored from cache in " << octree_timer.elapsed() << " ms" << std::endl;
+        } else {
+            std::cout << "Building octree..." << std::endl;
+            octree.build();
+            std::cout << "Octree built in " << octree_timer.elapsed() << " ms" << std::endl;
+        }
+        std::cout << "Max depth: " << octree.getMaxDepth() << std::endl;
+        cache.close();
+        
+        if (cache_file) {
+            writeCache(cache_file, *cloud, octree);
+        }
+        if (from_cache) {
+            analysis = std::async(std::launch::async, analyzePointCloud, std::cref(*cloud));
+        }
+    }
+    Timer handoff_timer;
     
     // Timing variables
     float deltaTime = 0.0f;
@@ -165,6 +341,9 @@ int main(int argc, char* argv[]) {
     // Rendering options
     bool use_octree = true;
     bool show_stats = true;
+    bool show_profiler = false;
+    bool edl = false;
+    CameraPath recorded_path;     // Replayed by benchmarks/render_benchmark
     
     // Main loop
     while (!glfwWindowShouldClose(window)) {
@@ -172,12 +351,61 @@ int main(int argc, char* argv[]) {
         float currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
+        profiler.beginFrame();
         
         // Process input
         processInput(window, deltaTime);
+        if (record_path) {
+            recorded_path.record(currentFrame, camera);
+        }
+        
+        // Move streamed points into the cloud and octree. Hand-offs wait until the pending
+        // points are a good fraction of the cloud, so the octree update and full buffer
+        // re-upload they trigger stay amortized over the load.
+        if (loading) {
+            AsyncLoader::Progress progress = loader.getProgress();
+            bool worth_it = progress.points_parsed - cloud->size() >= cloud->size() / 4;
+            if (progress.finished || (worth_it && handoff_timer.elapsed() > 250.0f)) {
+                size_t first = cloud->size();
+                if (loader.poll(*cloud) > 0) {
+                    renderer.waitForCulling();
+                    octree.insert(first, cloud->size());
+                }
+                handoff_timer.reset();
+            }
+            
+            if (progress.finished) {
+                loading = false;
+                if (progress.failed) {
+                    std::cerr << "Loading stopped early: " << input_file << std::endl;
+                }
+                std::cout << "Point cloud loaded: " << cloud->size() << " points in "
+                          << load_timer.elapsed() << " ms" << std::endl;
+                std::cout << "Memory usage: " << cloud->getMemoryUsage() / (1024.0 * 1024.0) << " MB" << std::endl;
+                std::cout << "Octree: " << octree.getNodeCount() << " nodes, max depth "
+                          << octree.getMaxDepth() << std::endl;
+                
+                // The cloud and octree are final now, so the cache and the filter report
+                // can read them off-thread
+                analysis = std::async(std::launch::async, [&cloud, &octree, cache_file]() {
+                    if (cache_file) {
+                        writeCache(cache_file, *cloud, octree);
+                    }
+                    analyzePointCloud(*cloud);
+                });
+            }
+        }
         
-        // Render
-        if (use_octree) {
+        // Render; the renderer falls back to basic shading if EDL targets can't be made
+        if (g_edl != edl) {
+            edl = g_edl;
+            renderer.setShading(edl ? Renderer::Shading::EDL : Renderer::Shading::BASIC);
+        }
+        if (scene) {
+            renderer.renderScene(camera);
+        } else if (streamed.isOpen()) {
+            renderer.renderOutOfCore(streamed, camera);
+        } else if (use_octree) {
             renderer.renderWithOctree(*cloud, octree, camera);
         } else {
             renderer.render(*cloud, camera);
@@ -186,24 +414,74 @@ int main(int argc, char* argv[]) {
         // Display statistics
         if (show_stats) {
             const auto& stats = renderer.getStatistics();
+            std::string loading_status;
+            if (loading) {
+                AsyncLoader::Progress progress = loader.getProgress();
+                int percent = progress.bytes_total > 0 ?
+                    static_cast<int>(100.0 * progress.bytes_read / progress.bytes_total) : 0;
+                loading_status = " | Loading: " + std::to_string(percent) + "%";
+            }
+            size_t total_points = scene ? scene_points : cloud->size();
+            if (streamed.isOpen()) {
+                OutOfCoreOctree::Statistics streaming = streamed.getStatistics();
+                total_points = streamed.getPointCount();
+                loading_status = " | Resident: " + std::to_string(streaming.resident_points) +
+                                 " | Pending: " + std::to_string(streaming.pending_requests);
+            }
             glfwSetWindowTitle(window, 
                 ("3D Point Cloud Viewer - FPS: " + std::to_string(static_cast<int>(stats.fps)) +
-                 " | Points: " + std::to_string(stats.points_rendered) + "/" + std::to_string(cloud->size()) +
-                 " | Frame: " + std::to_string(stats.frame_time_ms) + "ms").c_str());
+                 " | Points: " + std::to_string(stats.points_rendered) + "/" + std::to_string(total_points) +
+                 " | Frame: " + std::to_string(stats.frame_interval_ms) + "ms" +
+                 " | GPU: " + std::to_string(stats.gpu_time_ms) + "ms" +
+                 (stats.image_reused ? " | Refined: " + std::to_string(stats.refinement_level) : "") +
+                 loading_status).c_str());
+        }
+        
+        // Stage bars over the scene; the console gets the numbers when they are shown
+        if (g_showProfiler != show_profiler) {
+            show_profiler = g_showProfiler;
+            renderer.enableProfilerOverlay(show_profiler);
+            if (show_profiler) {
+                printProfile(profiler);
+            }
         }
+        renderer.renderProfilerOverlay();
         
         // Swap buffers and poll events
-        glfwSwapBuffers(window);
+        {
+            ScopedTimer stage(&profiler, "swap");
+            glfwSwapBuffers(window);
+        }
         glfwPollEvents();
     }
     
     // Cleanup
+    renderer.waitForCulling();
+    if (record_path && recorded_path.save(record_path)) {
+        std::cout << "Camera path (" << recorded_path.size() << " frames) written to " << record_path << std::endl;
+    }
+    if (profile_prefix) {
+        std::string prefix = profile_prefix;
+        if (profiler.writeChromeTrace(prefix + ".json") && profiler.writeCSV(prefix + ".csv")) {
+            std::cout << "Profile written to " << prefix << ".json and " << prefix << ".csv" << std::endl;
+        }
+        printProfile(profiler);
+    }
+    loader.cancel();
+    streamed.close();
+    if (analysis.valid()) {
+        analysis.wait();
+    }
     glfwTerminate();
     return 0;
 }
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
-    glViewport(0, 0, width, height);
+    if (g_renderer) {
+        g_renderer->resize(width, height);
+    } else {
+        glViewport(0, 0, width, height);
+    }
     if (g_camera) {
         g_camera->setPerspective(g_camera->getZoom(), 
                                 (float)width / height, 0.1f, 100.0f);
@@ -248,6 +526,12 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
                                 g_mouseCaptured ? GLFW_CURSOR_DISABLED : GLFW_CURSOR_NORMAL);
                 g_firstMouse = true;
                 break;
+            case GLFW_KEY_L:
+                g_edl = !g_edl;
+                break;
+            case GLFW_KEY_P:
+                g_showProfiler = !g_showProfiler;
+                break;
         }
     }
 }
@@ -29,25 +29,60 @@ FilterPipeline& FilterPipeline::addRadiusOutlierRemoval(float radius, int min_ne
 }
 
 void FilterPipeline::apply(PointCloud& cloud) const {
-    for (const auto& filter : filters_) {
-        switch (filter.type) {
-            case Filter::VOXEL:
-                VoxelDownsampling::downsample(cloud, filter.voxel_params);
-                break;
-            case Filter::STATISTICAL_OUTLIER:
-                OutlierRemoval::removeStatisticalOutliers(cloud, filter.statistical_params);
-                break;
-            case Filter::RADIUS_OUTLIER:
-                OutlierRemoval::removeRadiusOutliers(cloud, filter.radius_params);
-                break;
-        }
-    }
+    applyStages(cloud, 0);
 }
 
 PointCloud::Ptr FilterPipeline::apply(const PointCloud& cloud) const {
-    auto result = std::make_shared<PointCloud>(cloud);
-    apply(*result);
+    auto result = std::make_shared<PointCloud>();
+    if (filters_.empty()) {
+        *result = cloud;
+        return result;
+    }
+    
+    size_t stage = 0;
+    if (!isOutlierStage(0)) {
+        result = VoxelDownsampling::createDownsampled(cloud, filters_[0].voxel_params);
+        stage = 1;
+    } else {
+        while (stage < filters_.size() && isOutlierStage(stage)) stage++;
+        cloud.extract(computeOutlierMask(cloud, 0, stage), *result);
+    }
+    
+    applyStages(*result, stage);
     return result;
 }
 
+void FilterPipeline::applyStages(PointCloud& cloud, size_t first_stage) const {
+    size_t stage = first_stage;
+    while (stage < filters_.size()) {
+        if (!isOutlierStage(stage)) {
+            VoxelDownsampling::downsample(cloud, filters_[stage].voxel_params);
+            stage++;
+            continue;
+        }
+        
+        size_t end = stage;
+        while (end < filters_.size() && isOutlierStage(end)) end++;
+        cloud.compact(computeOutlierMask(cloud, stage, end));
+        stage = end;
+    }
+}
+
+std::vector<uint8_t> FilterPipeline::computeOutlierMask(const PointCloud& cloud, size_t begin, size_t end) const {
+    std::vector<uint8_t> keep_mask(cloud.size(), 1);
+    if (cloud.empty()) return keep_mask;
+    
+    KDTree tree(cloud);
+    tree.build();
+    for (size_t stage = begin; stage < end; ++stage) {
+        const Filter& filter = filters_[stage];
+        if (filter.type == Filter::STATISTICAL_OUTLIER) {
+            OutlierRemoval::markStatisticalOutliers(cloud, tree, filter.statistical_params, keep_mask);
+        } else {
+            OutlierRemoval::markRadiusOutliers(cloud, tree, filter.radius_params, keep_mask);
+        }
+    }
+    return keep_mask;
+}
+
 } // namespace pcv
\ No newline at end of file
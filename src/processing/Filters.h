@@ -6,7 +6,9 @@
 
 namespace pcv {
 
-// Filter pipeline for applying multiple filters in sequence
+// Filter pipeline for applying multiple filters in sequence.
+// Consecutive outlier stages run as one pass: they share a KD-tree over the cloud and
+// narrow a single keep mask, so each run compacts (or copies) the cloud once.
 class FilterPipeline {
 public:
     FilterPipeline() = default;
@@ -16,8 +18,11 @@ public:
     FilterPipeline& addStatisticalOutlierRemoval(int k_neighbors, float std_multiplier);
     FilterPipeline& addRadiusOutlierRemoval(float radius, int min_neighbors);
     
-    // Apply all filters
+    // Apply all filters in place
     void apply(PointCloud& cloud) const;
+    
+    // Filtered copy; the first stage writes only the points it keeps, so the input
+    // is never copied whole
     PointCloud::Ptr apply(const PointCloud& cloud) const;
     
     // Clear pipeline
@@ -35,6 +40,12 @@ private:
     };
     
     std::vector<Filter> filters_;
+    
+    bool isOutlierStage(size_t stage) const { return filters_[stage].type != Filter::VOXEL; }
+    
+    // Keep mask of the outlier stages in [begin, end) applied in order
+    std::vector<uint8_t> computeOutlierMask(const PointCloud& cloud, size_t begin, size_t end) const;
+    void applyStages(PointCloud& cloud, size_t first_stage) const;
 };
 
 } // namespace pcv
\ No newline at end of file
@@ -0,0 +1,195 @@
+#include "processing/NormalEstimation.h"
+#include "utils/Parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace pcv {
+
+namespace {
+
+constexpr int LANES = 8;
+
+// Per-thread neighborhood, gathered as structure of arrays
+struct Scratch {
+    std::vector<KDTree::Neighbor> neighbors;
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+};
+
+// Covariance of offsets from the query point. Sums run in LANES independent
+// accumulators so the loop vectorizes without reassociating float adds.
+glm::mat3 neighborhoodCovariance(const Scratch& scratch, size_t count) {
+    float sx[LANES] = {}, sy[LANES] = {}, sz[LANES] = {};
+    float sxx[LANES] = {}, sxy[LANES] = {}, sxz[LANES] = {};
+    float syy[LANES] = {}, syz[LANES] = {}, szz[LANES] = {};
+    
+    const float* xs = scratch.x.data();
+    const float* ys = scratch.y.data();
+    const float* zs = scratch.z.data();
+    size_t i = 0;
+    for (; i + LANES <= count; i += LANES) {
+        for (int l = 0; l < LANES; ++l) {
+            float x = xs[i + l], y = ys[i + l], z = zs[i + l];
+            sx[l] += x; sy[l] += y; sz[l] += z;
+            sxx[l] += x * x; sxy[l] += x * y; sxz[l] += x * z;
+            syy[l] += y * y; syz[l] += y * z; szz[l] += z * z;
+        }
+    }
+    for (int l = 0; i < count; ++i, ++l) {
+        float x = xs[i], y = ys[i], z = zs[i];
+        sx[l] += x; sy[l] += y; sz[l] += z;
+        sxx[l] += x * x; sxy[l] += x * y; sxz[l] += x * z;
+        syy[l] += y * y; syz[l] += y * z; szz[l] += z * z;
+    }
+    
+    for (int l = 1; l < LANES; ++l) {
+        sx[0] += sx[l]; sy[0] += sy[l]; sz[0] += sz[l];
+        sxx[0] += sxx[l]; sxy[0] += sxy[l]; sxz[0] += sxz[l];
+        syy[0] += syy[l]; syz[0] += syz[l]; szz[0] += szz[l];
+    }
+    
+    // Offsets are small (a neighborhood), so E[dd^T] - E[d]E[d]^T keeps its precision
+    float inv = 1.0f / static_cast<float>(count);
+    glm::vec3 mean(sx[0] * inv, sy[0] * inv, sz[0] * inv);
+    float xx = sxx[0] * inv - mean.x * mean.x;
+    float xy = sxy[0] * inv - mean.x * mean.y;
+    float xz = sxz[0] * inv - mean.x * mean.z;
+    float yy = syy[0] * inv - mean.y * mean.y;
+    float yz = syz[0] * inv - mean.y * mean.z;
+    float zz = szz[0] * inv - mean.z * mean.z;
+    return glm::mat3(glm::vec3(xx, xy, xz),
+                     glm::vec3(xy, yy, yz),
+                     glm::vec3(xz, yz, zz));
+}
+
+glm::vec3 anyOrthogonal(const glm::vec3& v) {
+    glm::vec3 orthogonal = std::abs(v.x) > std::abs(v.z) ? glm::vec3(-v.y, v.x, 0.0f)
+                                                         : glm::vec3(0.0f, -v.z, v.y);
+    return glm::normalize(orthogonal);
+}
+
+} // namespace
+
+void NormalEstimation::compute(PointCloud& cloud, const Parameters& params) {
+    if (cloud.size() < 3) return;
+    
+    KDTree tree(cloud);
+    tree.build();
+    compute(cloud, tree, params);
+}
+
+void NormalEstimation::compute(PointCloud& cloud, const KDTree& tree, const Parameters& params) {
+    const bool use_radius = params.radius > 0.0f;
+    if (cloud.size() < 3 || (!use_radius && params.k_neighbors < 3)) return;
+    
+    cloud.enableChannels(PointCloud::NORMAL);
+    const auto& positions = cloud.getPositions();
+    auto& normals = cloud.getNormals();
+    const glm::vec3 center = cloud.getCenter();
+    const PackedNormal default_normal = packNormal(Point().normal);
+    
+    const size_t num_threads = resolveThreadCount(static_cast<size_t>(std::max(params.num_threads, 0)));
+    std::vector<Scratch> thread_scratch(num_threads);
+    
+    // Points are visited in tree order, so neighborhoods of consecutive queries overlap
+    // and stay in cache
+    const auto& order = tree.getIndices();
+    parallelFor(order.size(), num_threads, [&](size_t thread_index, size_t begin, size_t end) {
+        Scratch& scratch = thread_scratch[thread_index];
+        
+        for (size_t o = begin; o < end; ++o) {
+            const size_t i = order[o];
+            const glm::vec3& position = positions[i];
+            if (use_radius) {
+                tree.radiusSearch(position, params.radius, scratch.neighbors);
+            } else {
+                tree.knnSearch(position, static_cast<size_t>(params.k_neighbors), scratch.neighbors);
+            }
+            
+            const size_t count = scratch.neighbors.size();
+            if (count < 3) {
+                normals[i] = default_normal;
+                continue;
+            }
+            
+            scratch.x.resize(count);
+            scratch.y.resize(count);
+            scratch.z.resize(count);
+            for (size_t n = 0; n < count; ++n) {
+                glm::vec3 offset = positions[scratch.neighbors[n].index] - position;
+                scratch.x[n] = offset.x;
+                scratch.y[n] = offset.y;
+                scratch.z[n] = offset.z;
+            }
+            
+            // Surface normal is the direction of least variance
+            glm::vec3 normal = smallestEigenvector(neighborhoodCovariance(scratch, count));
+            
+            if (params.orientation == Parameters::AWAY_FROM_CENTER) {
+                if (glm::dot(normal, position - center) < 0.0f) normal = -normal;
+            } else if (params.orientation == Parameters::TOWARD_VIEWPOINT) {
+                if (glm::dot(normal, params.viewpoint - position) < 0.0f) normal = -normal;
+            }
+            normals[i] = packNormal(normal);
+        }
+    }, 1024);
+}
+
+glm::vec3 NormalEstimation::smallestEigenvector(const glm::mat3& matrix) {
+    // Scale to unit magnitude so tiny or huge neighborhoods keep float precision
+    float max_abs = 0.0f;
+    for (int c = 0; c < 3; ++c) {
+        for (int r = 0; r < 3; ++r) {
+            max_abs = std::max(max_abs, std::abs(matrix[c][r]));
+        }
+    }
+    if (max_abs <= 0.0f) return glm::vec3(0.0f, 0.0f, 1.0f);
+    
+    const glm::mat3 a = matrix * (1.0f / max_abs);
+    const float a00 = a[0][0], a01 = a[0][1], a02 = a[0][2];
+    const float a11 = a[1][1], a12 = a[1][2], a22 = a[2][2];
+    
+    // Eigenvalues q + 2p cos(phi + 2 pi k / 3) of A = qI + pB; k = 1 is the smallest
+    const float q = (a00 + a11 + a22) / 3.0f;
+    const float b00 = a00 - q, b11 = a11 - q, b22 = a22 - q;
+    const float p = std::sqrt((b00 * b00 + b11 * b11 + b22 * b22 +
+                               2.0f * (a01 * a01 + a02 * a02 + a12 * a12)) / 6.0f);
+    if (p < 1e-7f) return glm::vec3(0.0f, 0.0f, 1.0f); // Isotropic - every direction
+    
+    const float det_b = b00 * (b11 * b22 - a12 * a12) -
+                        a01 * (a01 * b22 - a12 * a02) +
+                        a02 * (a01 * a12 - b11 * a02);
+    const float half_det = std::min(1.0f, std::max(-1.0f, det_b / (2.0f * p * p * p)));
+    const float phi = std::acos(half_det) / 3.0f;
+    const float lambda = q + 2.0f * p * std::cos(phi + 2.0943951f);
+    
+    // The eigenvector is orthogonal to the rows of A - lambda I; take the best-conditioned
+    // cross product of two rows
+    const glm::vec3 r0(a00 - lambda, a01, a02);
+    const glm::vec3 r1(a01, a11 - lambda, a12);
+    const glm::vec3 r2(a02, a12, a22 - lambda);
+    const glm::vec3 c01 = glm::cross(r0, r1);
+    const glm::vec3 c02 = glm::cross(r0, r2);
+    const glm::vec3 c12 = glm::cross(r1, r2);
+    const float d01 = glm::dot(c01, c01);
+    const float d02 = glm::dot(c02, c02);
+    const float d12 = glm::dot(c12, c12);
+    
+    float best = std::max(d01, std::max(d02, d12));
+    if (best > 1e-12f) {
+        const glm::vec3& c = best == d01 ? c01 : (best == d02 ? c02 : c12);
+        return c / std::sqrt(best);
+    }
+    
+    // Rank one: the smallest eigenvalue is repeated, any vector orthogonal to the rows works
+    const float n0 = glm::dot(r0, r0);
+    const float n1 = glm::dot(r1, r1);
+    const float n2 = glm::dot(r2, r2);
+    const glm::vec3& row = n0 >= n1 && n0 >= n2 ? r0 : (n1 >= n2 ? r1 : r2);
+    if (glm::dot(row, row) <= 0.0f) return glm::vec3(0.0f, 0.0f, 1.0f);
+    return anyOrthogonal(row);
+}
+
+} // namespace pcv
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "core/PointCloud.h"
+#include "core/KDTree.h"
+#include <glm/glm.hpp>
+
+namespace pcv {
+
+// Surface normals from principal component analysis of point neighborhoods.
+// Each point's k nearest neighbors (or all neighbors within a radius) give a 3x3
+// covariance whose smallest eigenvector, solved in closed form, is the normal.
+// Points are processed concurrently with per-thread neighbor buffers.
+class NormalEstimation {
+public:
+    struct Parameters {
+        enum Orientation {
+            AWAY_FROM_CENTER,   // Flip normals to point away from the cloud's bounding box center
+            TOWARD_VIEWPOINT,   // Flip normals to face viewpoint (e.g. the scanner position)
+            UNORIENTED          // Keep the solver's sign
+        };
+        
+        int k_neighbors;          // Neighborhood size (including the point itself)
+        float radius;             // > 0: use all neighbors within radius instead of k
+        Orientation orientation;
+        glm::vec3 viewpoint;
+        int num_threads;          // 0 = use all hardware threads, 1 = serial
+        
+        Parameters() : k_neighbors(10), radius(0.0f), orientation(AWAY_FROM_CENTER),
+                       viewpoint(0.0f), num_threads(0) {}
+    };
+    
+    // Fill the cloud's normal channel (enabling it). Points with fewer than three
+    // neighbors get the default normal.
+    static void compute(PointCloud& cloud, const Parameters& params = Parameters());
+    
+    // Same, with an already built tree over cloud
+    static void compute(PointCloud& cloud, const KDTree& tree, const Parameters& params);
+    
+    // Unit eigenvector of the smallest eigenvalue of a symmetric 3x3 matrix, from the
+    // trigonometric eigenvalue formula. It is any unit vector when that eigenvalue is
+    // repeated.
+    static glm::vec3 smallestEigenvector(const glm::mat3& matrix);
+};
+
+} // namespace pcv
\ No newline at end of file
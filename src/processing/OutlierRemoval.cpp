@@ -1,4 +1,5 @@
 #include "processing/OutlierRemoval.h"
+#include "utils/Parallel.h"
 #include <algorithm>
 #include <numeric>
 #include <cmath>
@@ -7,138 +8,166 @@
 namespace pcv {
 
 void OutlierRemoval::removeStatisticalOutliers(PointCloud& cloud, const StatisticalParams& params) {
-    auto outlier_indices = findStatisticalOutliers(cloud, params);
-    
-    // Sort indices in descending order for safe removal
-    std::sort(outlier_indices.begin(), outlier_indices.end(), std::greater<size_t>());
-    
-    // Remove outliers
-    auto& points = cloud.getPoints();
-    for (size_t idx : outlier_indices) {
-        points.erase(points.begin() + idx);
-    }
+    cloud.compact(computeStatisticalInlierMask(cloud, params));
 }
 
 void OutlierRemoval::removeRadiusOutliers(PointCloud& cloud, const RadiusParams& params) {
-    auto outlier_indices = findRadiusOutliers(cloud, params);
-    
-    // Sort indices in descending order for safe removal
-    std::sort(outlier_indices.begin(), outlier_indices.end(), std::greater<size_t>());
-    
-    // Remove outliers
-    auto& points = cloud.getPoints();
-    for (size_t idx : outlier_indices) {
-        points.erase(points.begin() + idx);
-    }
+    cloud.compact(computeRadiusInlierMask(cloud, params));
 }
 
 std::vector<size_t> OutlierRemoval::findStatisticalOutliers(const PointCloud& cloud, 
                                                             const StatisticalParams& params) {
-    std::vector<size_t> outliers;
-    
-    // Compute nearest neighbor distances for all points
-    auto distances = computeNearestNeighborDistances(cloud, params.k_neighbors);
+    return maskToOutlierIndices(computeStatisticalInlierMask(cloud, params));
+}
+
+std::vector<size_t> OutlierRemoval::findRadiusOutliers(const PointCloud& cloud,
+                                                       const RadiusParams& params) {
+    return maskToOutlierIndices(computeRadiusInlierMask(cloud, params));
+}
+
+std::vector<uint8_t> OutlierRemoval::computeStatisticalInlierMask(const PointCloud& cloud,
+                                                                  const StatisticalParams& params) {
+    // Build spatial index once for all neighbor queries
+    KDTree tree(cloud);
+    tree.build();
+    
+    std::vector<uint8_t> keep_mask(cloud.size(), 1);
+    markStatisticalOutliers(cloud, tree, params, keep_mask);
+    return keep_mask;
+}
+
+std::vector<uint8_t> OutlierRemoval::computeRadiusInlierMask(const PointCloud& cloud,
+                                                             const RadiusParams& params) {
+    KDTree tree(cloud);
+    tree.build();
+    
+    std::vector<uint8_t> keep_mask(cloud.size(), 1);
+    markRadiusOutliers(cloud, tree, params, keep_mask);
+    return keep_mask;
+}
+
+void OutlierRemoval::markStatisticalOutliers(const PointCloud& cloud, const KDTree& tree,
+                                             const StatisticalParams& params, std::vector<uint8_t>& keep_mask) {
+    // Compute nearest neighbor distances for all kept points
+    const uint8_t* active = keep_mask.data();
+    auto distances = computeNearestNeighborDistances(cloud, tree, params.k_neighbors, 
+                                                     params.num_threads, active);
     
     // Compute mean and standard deviation
     float mean, stddev;
-    computeMeanStdDev(distances, mean, stddev);
+    computeMeanStdDev(distances, mean, stddev, active);
     
     // Threshold for outlier detection
     float threshold = mean + params.std_multiplier * stddev;
     
-    // Find outliers
     for (size_t i = 0; i < distances.size(); ++i) {
         if (distances[i] > threshold) {
-            outliers.push_back(i);
+            keep_mask[i] = 0;
         }
     }
-    
-    return outliers;
 }
 
-std::vector<size_t> OutlierRemoval::findRadiusOutliers(const PointCloud& cloud,
-                                                       const RadiusParams& params) {
+void OutlierRemoval::markRadiusOutliers(const PointCloud& cloud, const KDTree& tree,
+                                        const RadiusParams& params, std::vector<uint8_t>& keep_mask) {
+    // Points are classified against the mask as it was on entry, so every thread
+    // writes its own range to a separate result first
+    const std::vector<uint8_t> active(keep_mask);
+    parallelFor(cloud.size(), std::max(params.num_threads, 0), [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            if (!active[i]) continue;
+            int neighbor_count = countNeighborsInRadius(cloud, tree, i, params.radius, params.min_neighbors,
+                                                        active.data());
+            keep_mask[i] = neighbor_count >= params.min_neighbors;
+        }
+    });
+}
+
+std::vector<size_t> OutlierRemoval::maskToOutlierIndices(const std::vector<uint8_t>& keep_mask) {
     std::vector<size_t> outliers;
-    
-    for (size_t i = 0; i < cloud.size(); ++i) {
-        int neighbor_count = countNeighborsInRadius(cloud, i, params.radius);
-        
-        if (neighbor_count < params.min_neighbors) {
+    for (size_t i = 0; i < keep_mask.size(); ++i) {
+        if (!keep_mask[i]) {
             outliers.push_back(i);
         }
     }
-    
     return outliers;
 }
 
-std::vector<float> OutlierRemoval::computeNearestNeighborDistances(const PointCloud& cloud, int k) {
+std::vector<float> OutlierRemoval::computeNearestNeighborDistances(const PointCloud& cloud, 
+                                                                   const KDTree& tree, int k,
+                                                                   int num_threads,
+                                                                   const uint8_t* active) {
     std::vector<float> avg_distances(cloud.size(), 0.0f);
+    if (k <= 0) return avg_distances;
+    
+    // One neighbor buffer per thread so the k-NN heaps never reallocate
+    num_threads = std::max(num_threads, 0);
+    std::vector<std::vector<KDTree::Neighbor>> thread_neighbors(resolveThreadCount(num_threads));
+    for (auto& neighbors : thread_neighbors) {
+        neighbors.reserve(k + 1);
+    }
     
-    // For each point
-    for (size_t i = 0; i < cloud.size(); ++i) {
-        const glm::vec3& point = cloud[i].position;
-        std::vector<float> distances;
+    parallelFor(cloud.size(), num_threads, [&](size_t thread_index, size_t begin, size_t end) {
+        auto& neighbors = thread_neighbors[thread_index];
         
-        // Compute distances to all other points
-        for (size_t j = 0; j < cloud.size(); ++j) {
-            if (i != j) {
-                float dist = glm::distance(point, cloud[j].position);
-                distances.push_back(dist);
+        for (size_t i = begin; i < end; ++i) {
+            if (active && !active[i]) continue;
+            
+            // Query one extra neighbor since the point itself is returned
+            tree.knnSearch(cloud.getPosition(i), k + 1, neighbors, active);
+            
+            // Compute average of k nearest neighbors, excluding the point itself
+            float sum = 0.0f;
+            int count = 0;
+            bool skipped_self = false;
+            for (const auto& neighbor : neighbors) {
+                if (!skipped_self && neighbor.index == i) {
+                    skipped_self = true;
+                    continue;
+                }
+                if (count == k) break;
+                sum += std::sqrt(neighbor.squared_distance);
+                count++;
             }
+            
+            avg_distances[i] = count > 0 ? sum / count : 0.0f;
         }
-        
-        // Sort distances and take k nearest
-        std::sort(distances.begin(), distances.end());
-        
-        // Compute average of k nearest neighbors
-        float sum = 0.0f;
-        int count = std::min(k, static_cast<int>(distances.size()));
-        for (int j = 0; j < count; ++j) {
-            sum += distances[j];
-        }
-        
-        avg_distances[i] = count > 0 ? sum / count : 0.0f;
-    }
+    });
     
     return avg_distances;
 }
 
-void OutlierRemoval::computeMeanStdDev(const std::vector<float>& values, float& mean, float& stddev) {
-    if (values.empty()) {
+void OutlierRemoval::computeMeanStdDev(const std::vector<float>& values, float& mean, float& stddev,
+                                       const uint8_t* active) {
+    size_t count = active ? static_cast<size_t>(std::count_if(active, active + values.size(),
+                                                              [](uint8_t flag) { return flag != 0; }))
+                          : values.size();
+    if (count == 0) {
         mean = 0.0f;
         stddev = 0.0f;
         return;
     }
     
-    // Compute mean
-    mean = std::accumulate(values.begin(), values.end(), 0.0f) / values.size();
+    // Compute mean (inactive values are 0 and add nothing)
+    mean = std::accumulate(values.begin(), values.end(), 0.0f) / count;
     
     // Compute standard deviation
     float variance = 0.0f;
-    for (float value : values) {
-        float diff = value - mean;
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (active && !active[i]) continue;
+        float diff = values[i] - mean;
         variance += diff * diff;
     }
-    variance /= values.size();
+    variance /= count;
     stddev = std::sqrt(variance);
 }
 
-int OutlierRemoval::countNeighborsInRadius(const PointCloud& cloud, size_t point_idx, float radius) {
-    const glm::vec3& point = cloud[point_idx].position;
-    float radius_sq = radius * radius;
-    int count = 0;
-    
-    for (size_t i = 0; i < cloud.size(); ++i) {
-        if (i != point_idx) {
-            float dist = glm::distance(point, cloud[i].position);
-            float dist_sq = dist * dist;
-            if (dist_sq <= radius_sq) {
-                count++;
-            }
-        }
-    }
-    
-    return count;
+int OutlierRemoval::countNeighborsInRadius(const PointCloud& cloud, const KDTree& tree,
+                                           size_t point_idx, float radius, int max_count,
+                                           const uint8_t* active) {
+    // The count includes the point itself, so ask for one more than needed
+    size_t count = tree.radiusCount(cloud.getPosition(point_idx), radius, 
+                                    static_cast<size_t>(std::max(max_count, 0)) + 1, active);
+    return count > 0 ? static_cast<int>(count) - 1 : 0;
 }
 
 } // namespace pcv
\ No newline at end of file
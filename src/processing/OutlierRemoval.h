@@ -1,6 +1,7 @@
 #pragma once
 
 #include "core/PointCloud.h"
+#include "core/KDTree.h"
 #include <vector>
 
 namespace pcv {
@@ -11,16 +12,18 @@ public:
     struct StatisticalParams {
         int k_neighbors;
         float std_multiplier;
+        int num_threads;      // 0 = use all hardware threads, 1 = serial
         
-        StatisticalParams() : k_neighbors(50), std_multiplier(1.0f) {}
+        StatisticalParams() : k_neighbors(50), std_multiplier(1.0f), num_threads(0) {}
     };
     
     // Radius outlier removal parameters
     struct RadiusParams {
         float radius;
         int min_neighbors;
+        int num_threads;      // 0 = use all hardware threads, 1 = serial
         
-        RadiusParams() : radius(0.1f), min_neighbors(2) {}
+        RadiusParams() : radius(0.1f), min_neighbors(2), num_threads(0) {}
     };
     
     // Statistical outlier removal
@@ -38,11 +41,31 @@ public:
     static std::vector<size_t> findRadiusOutliers(const PointCloud& cloud,
                                                   const RadiusParams& params = RadiusParams());
     
+    // Clear the keep_mask flags of outliers among the points still kept, with tree built
+    // over all of cloud. Removed points are neither classified nor counted as
+    // neighbors, so chained calls match filtering stage by stage while sharing one
+    // tree and one compaction.
+    static void markStatisticalOutliers(const PointCloud& cloud, const KDTree& tree,
+                                        const StatisticalParams& params, std::vector<uint8_t>& keep_mask);
+    static void markRadiusOutliers(const PointCloud& cloud, const KDTree& tree,
+                                   const RadiusParams& params, std::vector<uint8_t>& keep_mask);
+                                   
 private:
     // Helper functions
-    static std::vector<float> computeNearestNeighborDistances(const PointCloud& cloud, int k);
-    static void computeMeanStdDev(const std::vector<float>& values, float& mean, float& stddev);
-    static int countNeighborsInRadius(const PointCloud& cloud, size_t point_idx, float radius);
+    static std::vector<uint8_t> computeStatisticalInlierMask(const PointCloud& cloud,
+                                                             const StatisticalParams& params);
+    static std::vector<uint8_t> computeRadiusInlierMask(const PointCloud& cloud,
+                                                        const RadiusParams& params);
+    static std::vector<size_t> maskToOutlierIndices(const std::vector<uint8_t>& keep_mask);
+    static std::vector<float> computeNearestNeighborDistances(const PointCloud& cloud, 
+                                                              const KDTree& tree, int k,
+                                                              int num_threads,
+                                                              const uint8_t* active = nullptr);
+    static void computeMeanStdDev(const std::vector<float>& values, float& mean, float& stddev,
+                                  const uint8_t* active = nullptr);
+    static int countNeighborsInRadius(const PointCloud& cloud, const KDTree& tree,
+                                      size_t point_idx, float radius, int max_count,
+                                      const uint8_t* active = nullptr);
 };
 
 } // namespace pcv
\ No newline at end of file
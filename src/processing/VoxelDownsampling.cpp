@@ -1,8 +1,32 @@
 #include "processing/VoxelDownsampling.h"
+#include "utils/Parallel.h"
+#include "utils/RadixSort.h"
+#include <algorithm>
 #include <cmath>
+#include <limits>
 
 namespace pcv {
 
+namespace {
+
+constexpr size_t RUN_BLOCK_SIZE = size_t(1) << 16;
+
+int bitsFor(int count) {
+    int bits = 0;
+    while ((int64_t(1) << bits) < count) bits++;
+    return bits;
+}
+
+// Writes channel data only; bounds are refreshed once by the caller
+void storeRepresentative(PointCloud& cloud, size_t idx, const Point& point) {
+    cloud.getPositions()[idx] = point.position;
+    if (cloud.hasColors()) cloud.getColors()[idx] = packColor(point.color);
+    if (cloud.hasNormals()) cloud.getNormals()[idx] = packNormal(point.normal);
+    if (cloud.hasIntensities()) cloud.getIntensities()[idx] = point.intensity;
+}
+
+} // namespace
+
 void VoxelDownsampling::Voxel::addPoint(const Point& point) {
     position_sum += point.position;
     color_sum += point.color;
@@ -11,42 +35,120 @@ void VoxelDownsampling::Voxel::addPoint(const Point& point) {
     point_count++;
 }
 
+void VoxelDownsampling::Voxel::addPoint(const PointCloud& cloud, size_t index) {
+    // Only decode the channels the cloud actually stores
+    position_sum += cloud.getPosition(index);
+    if (cloud.hasColors()) color_sum += cloud.getColor(index);
+    if (cloud.hasNormals()) normal_sum += cloud.getNormal(index);
+    if (cloud.hasIntensities()) intensity_sum += cloud.getIntensity(index);
+    point_count++;
+}
+
 Point VoxelDownsampling::Voxel::getRepresentative() const {
     Point rep;
     if (point_count > 0) {
         rep.position = position_sum / static_cast<float>(point_count);
         rep.color = color_sum / static_cast<float>(point_count);
-        rep.normal = glm::normalize(normal_sum);
+        float normal_length = glm::length(normal_sum);
+        if (normal_length > 0.0f) {
+            rep.normal = normal_sum / normal_length;
+        }
         rep.intensity = intensity_sum / static_cast<float>(point_count);
     }
     return rep;
 }
 
+uint32_t VoxelDownsampling::VoxelPacking::pack(const glm::vec3& point, float leaf_size) const {
+    // Clamped so rounding at the bounds cannot step outside the grid
+    glm::ivec3 voxel = glm::ivec3(glm::floor(point / leaf_size)) - origin;
+    voxel = glm::clamp(voxel, glm::ivec3(0), dims - 1);
+    
+    // Shifted in 64 bits: with a single voxel along x, shift_x can reach 32
+    return static_cast<uint32_t>((static_cast<uint64_t>(voxel.x) << shift_x) |
+                                 (static_cast<uint64_t>(voxel.y) << shift_y) |
+                                 static_cast<uint64_t>(voxel.z));
+}
+
 void VoxelDownsampling::downsample(PointCloud& cloud, const Parameters& params) {
-    auto downsampled = createDownsampled(cloud, params);
-    cloud = *downsampled;
+    if (cloud.empty() || params.leaf_size <= 0.0f) return;
+    
+    VoxelPacking packing;
+    if (!computePacking(cloud, params.leaf_size, packing)) {
+        VoxelGrid grid = buildVoxelGrid(cloud, params.leaf_size);
+        
+        // Write each representative over the voxel's first point, then drop the rest
+        std::vector<uint8_t> keep_mask(cloud.size(), 0);
+        for (const auto& [key, voxel] : grid) {
+            storeRepresentative(cloud, voxel.first_index, voxel.getRepresentative());
+            keep_mask[voxel.first_index] = 1;
+        }
+        cloud.compact(keep_mask);
+        return;
+    }
+    
+    const size_t num_threads = resolveThreadCount(static_cast<size_t>(params.num_threads));
+    std::vector<uint64_t> keys;
+    std::vector<uint32_t> runs;
+    buildSortedKeys(cloud, params.leaf_size, packing, num_threads, keys);
+    findVoxelRuns(keys, num_threads, runs);
+    
+    // Points keep cloud order within a run, so each run starts at its voxel's first
+    // point; runs write disjoint points and reduce concurrently
+    std::vector<uint8_t> keep_mask(cloud.size(), 0);
+    parallelFor(runs.size() - 1, num_threads, [&](size_t, size_t begin, size_t end) {
+        for (size_t run = begin; run < end; ++run) {
+            Voxel voxel;
+            for (uint32_t k = runs[run]; k < runs[run + 1]; ++k) {
+                voxel.addPoint(cloud, static_cast<uint32_t>(keys[k]));
+            }
+            uint32_t first_index = static_cast<uint32_t>(keys[runs[run]]);
+            storeRepresentative(cloud, first_index, voxel.getRepresentative());
+            keep_mask[first_index] = 1;
+        }
+    }, 1024);
+    
+    cloud.compact(keep_mask);
 }
 
 PointCloud::Ptr VoxelDownsampling::createDownsampled(const PointCloud& cloud, 
                                                      const Parameters& params) {
-    auto result = std::make_shared<PointCloud>();
+    auto result = std::make_shared<PointCloud>(0, cloud.getChannels());
     
     if (cloud.empty() || params.leaf_size <= 0.0f) {
         *result = cloud;
         return result;
     }
     
-    // Build voxel grid
-    VoxelGrid grid = buildVoxelGrid(cloud, params.leaf_size);
+    VoxelPacking packing;
+    if (!computePacking(cloud, params.leaf_size, packing)) {
+        VoxelGrid grid = buildVoxelGrid(cloud, params.leaf_size);
+        result->reserve(grid.size());
+        for (const auto& [key, voxel] : grid) {
+            result->addPoint(voxel.getRepresentative());
+        }
+        return result;
+    }
     
-    // Reserve space for result
-    result->reserve(grid.size());
+    const size_t num_threads = resolveThreadCount(static_cast<size_t>(params.num_threads));
+    std::vector<uint64_t> keys;
+    std::vector<uint32_t> runs;
+    buildSortedKeys(cloud, params.leaf_size, packing, num_threads, keys);
+    findVoxelRuns(keys, num_threads, runs);
     
-    // Extract representative points
-    for (const auto& [key, voxel] : grid) {
-        result->addPoint(voxel.getRepresentative());
-    }
+    // One representative per run, in voxel key order
+    result->resize(runs.size() - 1);
+    PointCloud& output = *result;
+    parallelFor(runs.size() - 1, num_threads, [&](size_t, size_t begin, size_t end) {
+        for (size_t run = begin; run < end; ++run) {
+            Voxel voxel;
+            for (uint32_t k = runs[run]; k < runs[run + 1]; ++k) {
+                voxel.addPoint(cloud, static_cast<uint32_t>(keys[k]));
+            }
+            storeRepresentative(output, run, voxel.getRepresentative());
+        }
+    }, 1024);
     
+    result->updateBounds();
     return result;
 }
 
@@ -62,10 +164,7 @@ VoxelDownsampling::Statistics VoxelDownsampling::getStatistics(const PointCloud&
         return stats;
     }
     
-    // Build voxel grid to count voxels
-    VoxelGrid grid = buildVoxelGrid(cloud, params.leaf_size);
-    
-    stats.voxel_count = grid.size();
+    stats.voxel_count = countVoxels(cloud, params);
     stats.downsampled_points = stats.voxel_count;
     stats.compression_ratio = stats.original_points > 0 ? 
         static_cast<float>(stats.downsampled_points) / stats.original_points : 1.0f;
@@ -73,6 +172,41 @@ VoxelDownsampling::Statistics VoxelDownsampling::getStatistics(const PointCloud&
     return stats;
 }
 
+size_t VoxelDownsampling::countVoxels(const PointCloud& cloud, const Parameters& params) {
+    if (cloud.empty() || params.leaf_size <= 0.0f) return cloud.size();
+    
+    VoxelPacking packing;
+    if (!computePacking(cloud, params.leaf_size, packing)) {
+        return buildVoxelGrid(cloud, params.leaf_size).size();
+    }
+    
+    // Sorting the bare 32-bit keys is enough to count distinct voxels
+    const size_t num_threads = resolveThreadCount(static_cast<size_t>(params.num_threads));
+    const auto& positions = cloud.getPositions();
+    std::vector<uint32_t> keys(cloud.size());
+    parallelFor(keys.size(), num_threads, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            keys[i] = packing.pack(positions[i], params.leaf_size);
+        }
+    }, RUN_BLOCK_SIZE);
+    radixSort(keys, 0, packing.key_bits, num_threads);
+    
+    std::vector<size_t> block_counts((keys.size() + RUN_BLOCK_SIZE - 1) / RUN_BLOCK_SIZE, 0);
+    parallelFor(keys.size(), num_threads, [&](size_t, size_t begin, size_t end) {
+        size_t count = 0;
+        for (size_t i = std::max<size_t>(begin, 1); i < end; ++i) {
+            count += keys[i] != keys[i - 1];
+        }
+        block_counts[begin / RUN_BLOCK_SIZE] = count;
+    }, RUN_BLOCK_SIZE);
+    
+    size_t voxel_count = 1;
+    for (size_t count : block_counts) {
+        voxel_count += count;
+    }
+    return voxel_count;
+}
+
 VoxelDownsampling::VoxelKey VoxelDownsampling::computeVoxelKey(const glm::vec3& point, 
                                                                float leaf_size) {
     VoxelKey key;
@@ -86,12 +220,82 @@ VoxelDownsampling::VoxelGrid VoxelDownsampling::buildVoxelGrid(const PointCloud&
                                                                float leaf_size) {
     VoxelGrid grid;
     
-    for (const auto& point : cloud) {
-        VoxelKey key = computeVoxelKey(point.position, leaf_size);
-        grid[key].addPoint(point);
+    for (size_t i = 0; i < cloud.size(); ++i) {
+        Voxel& voxel = grid[computeVoxelKey(cloud.getPosition(i), leaf_size)];
+        if (voxel.point_count == 0) {
+            voxel.first_index = i;
+        }
+        voxel.addPoint(cloud, i);
     }
     
     return grid;
 }
 
+bool VoxelDownsampling::computePacking(const PointCloud& cloud, float leaf_size, VoxelPacking& packing) {
+    if (cloud.size() > std::numeric_limits<uint32_t>::max()) return false;
+    
+    // Voxel extents in doubles, so huge or tiny leaf sizes cannot overflow an int
+    glm::dvec3 first = glm::floor(glm::dvec3(cloud.getMinBound()) / static_cast<double>(leaf_size));
+    glm::dvec3 last = glm::floor(glm::dvec3(cloud.getMaxBound()) / static_cast<double>(leaf_size));
+    glm::dvec3 dims = last - first + 1.0;
+    const double limit = static_cast<double>(int64_t(1) << 31);
+    for (int axis = 0; axis < 3; ++axis) {
+        if (!(dims[axis] >= 1.0 && dims[axis] < limit && std::abs(first[axis]) < limit)) return false;
+    }
+    
+    packing.origin = glm::ivec3(first);
+    packing.dims = glm::ivec3(dims);
+    int bits_y = bitsFor(packing.dims.y);
+    int bits_z = bitsFor(packing.dims.z);
+    packing.key_bits = bitsFor(packing.dims.x) + bits_y + bits_z;
+    packing.shift_y = bits_z;
+    packing.shift_x = bits_y + bits_z;
+    return packing.key_bits <= 32;
+}
+
+void VoxelDownsampling::buildSortedKeys(const PointCloud& cloud, float leaf_size, const VoxelPacking& packing,
+                                        size_t num_threads, std::vector<uint64_t>& keys) {
+    // The point index rides in the low half, under the sorted key bits
+    const auto& positions = cloud.getPositions();
+    keys.resize(cloud.size());
+    parallelFor(keys.size(), num_threads, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            keys[i] = (static_cast<uint64_t>(packing.pack(positions[i], leaf_size)) << 32) | i;
+        }
+    }, RUN_BLOCK_SIZE);
+    radixSort(keys, 32, 32 + packing.key_bits, num_threads);
+}
+
+void VoxelDownsampling::findVoxelRuns(const std::vector<uint64_t>& keys, size_t num_threads,
+                                      std::vector<uint32_t>& runs) {
+    // Count run starts per block, then every block writes its own starts
+    const size_t block_count = (keys.size() + RUN_BLOCK_SIZE - 1) / RUN_BLOCK_SIZE;
+    std::vector<size_t> offsets(block_count + 1, 0);
+    auto starts_run = [&keys](size_t i) {
+        return i == 0 || (keys[i] >> 32) != (keys[i - 1] >> 32);
+    };
+    
+    parallelFor(keys.size(), num_threads, [&](size_t, size_t begin, size_t end) {
+        size_t count = 0;
+        for (size_t i = begin; i < end; ++i) {
+            count += starts_run(i);
+        }
+        offsets[begin / RUN_BLOCK_SIZE + 1] = count;
+    }, RUN_BLOCK_SIZE);
+    for (size_t block = 0; block < block_count; ++block) {
+        offsets[block + 1] += offsets[block];
+    }
+    
+    runs.resize(offsets.back() + 1);
+    parallelFor(keys.size(), num_threads, [&](size_t, size_t begin, size_t end) {
+        size_t write = offsets[begin / RUN_BLOCK_SIZE];
+        for (size_t i = begin; i < end; ++i) {
+            if (starts_run(i)) {
+                runs[write++] = static_cast<uint32_t>(i);
+            }
+        }
+    }, RUN_BLOCK_SIZE);
+    runs.back() = static_cast<uint32_t>(keys.size());
+}
+
 } // namespace pcv
\ No newline at end of file
@@ -1,18 +1,26 @@
 #pragma once
 
 #include "core/PointCloud.h"
+#include "core/MemoryPool.h"
+#include <cstdint>
+#include <functional>
 #include <unordered_map>
+#include <vector>
 
 namespace pcv {
 
+// Voxel grid downsampling. Points get packed voxel keys that are radix sorted in
+// parallel, and each run of equal keys is reduced to one representative point; clouds
+// spanning more voxels than a 32-bit key addresses fall back to a hash grid.
 class VoxelDownsampling {
 public:
     // Voxel grid parameters
     struct Parameters {
         float leaf_size;      // Size of voxel in each dimension
         bool compute_mean;    // Use mean position vs. centroid
+        int num_threads;      // 0 = use all hardware threads, 1 = serial
         
-        Parameters() : leaf_size(0.01f), compute_mean(true) {}
+        Parameters() : leaf_size(0.01f), compute_mean(true), num_threads(0) {}
     };
     
     // Apply voxel grid downsampling
@@ -33,6 +41,23 @@ public:
     static Statistics getStatistics(const PointCloud& cloud, 
                                    const Parameters& params = Parameters());
     
+    // Number of occupied voxels, from the sorted keys alone (no per-voxel sums)
+    static size_t countVoxels(const PointCloud& cloud, const Parameters& params = Parameters());
+    
+    // Per-voxel accumulator (also used for octree LOD samples)
+    struct Voxel {
+        glm::vec3 position_sum{0.0f};
+        glm::vec3 color_sum{0.0f};
+        glm::vec3 normal_sum{0.0f};
+        float intensity_sum = 0.0f;
+        size_t point_count = 0;
+        size_t first_index = 0;   // First cloud point that fell into this voxel
+        
+        void addPoint(const Point& point);
+        void addPoint(const PointCloud& cloud, size_t index);
+        Point getRepresentative() const;
+    };
+    
 private:
     // Voxel key for spatial hashing
     struct VoxelKey {
@@ -43,32 +68,45 @@ private:
         }
     };
     
-    // Hash function for VoxelKey
+    // Hash function for VoxelKey; each axis is spread by its own odd multiplier so
+    // regular grids do not collide
     struct VoxelKeyHash {
         std::size_t operator()(const VoxelKey& key) const {
-            // Simple hash combination
-            return ((std::hash<int>()(key.x) ^ 
-                    (std::hash<int>()(key.y) << 1)) >> 1) ^ 
-                    (std::hash<int>()(key.z) << 1);
+            uint64_t h = static_cast<uint64_t>(static_cast<uint32_t>(key.x)) * 0x9E3779B97F4A7C15ull ^
+                         static_cast<uint64_t>(static_cast<uint32_t>(key.y)) * 0xC2B2AE3D27D4EB4Full ^
+                         static_cast<uint64_t>(static_cast<uint32_t>(key.z)) * 0x165667B19E3779F9ull;
+            return static_cast<std::size_t>(h ^ (h >> 32));
         }
     };
     
-    // Voxel data
-    struct Voxel {
-        glm::vec3 position_sum{0.0f};
-        glm::vec3 color_sum{0.0f};
-        glm::vec3 normal_sum{0.0f};
-        float intensity_sum = 0.0f;
-        size_t point_count = 0;
+    // Hash grid fallback; entries come from a slab pool rather than one heap block each
+    using VoxelGrid = std::unordered_map<VoxelKey, Voxel, VoxelKeyHash, std::equal_to<VoxelKey>,
+                                         PoolAllocator<std::pair<const VoxelKey, Voxel>>>;
+    
+    // Voxel coordinates relative to the cloud's first voxel, packed x-major
+    struct VoxelPacking {
+        glm::ivec3 origin;
+        glm::ivec3 dims;
+        int shift_x;
+        int shift_y;
+        int key_bits;
         
-        void addPoint(const Point& point);
-        Point getRepresentative() const;
+        uint32_t pack(const glm::vec3& point, float leaf_size) const;
     };
     
-    using VoxelGrid = std::unordered_map<VoxelKey, Voxel, VoxelKeyHash>;
-    
     static VoxelKey computeVoxelKey(const glm::vec3& point, float leaf_size);
     static VoxelGrid buildVoxelGrid(const PointCloud& cloud, float leaf_size);
+    
+    // False when the cloud spans more voxels than 32 key bits (or 32-bit indices) hold
+    static bool computePacking(const PointCloud& cloud, float leaf_size, VoxelPacking& packing);
+    
+    // (voxel key << 32 | point index) sorted by voxel, points in cloud order within voxels
+    static void buildSortedKeys(const PointCloud& cloud, float leaf_size, const VoxelPacking& packing,
+                                size_t num_threads, std::vector<uint64_t>& keys);
+    
+    // Start of every run of equal voxel keys, followed by keys.size()
+    static void findVoxelRuns(const std::vector<uint64_t>& keys, size_t num_threads,
+                              std::vector<uint32_t>& runs);
 };
 
 } // namespace pcv
\ No newline at end of file
@@ -12,6 +12,13 @@ glm::mat4 Camera::getViewMatrix() const {
     return glm::lookAt(position_, position_ + front_, up_);
 }
 
+void Camera::setPose(const glm::vec3& position, float yaw, float pitch) {
+    position_ = position;
+    yaw_ = yaw;
+    pitch_ = std::clamp(pitch, -89.0f, 89.0f);
+    updateCameraVectors();
+}
+
 void Camera::processKeyboard(Movement direction, float deltaTime) {
     float velocity = movement_speed_ * deltaTime;
     
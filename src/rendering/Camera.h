@@ -31,6 +31,11 @@ public:
     const glm::vec3& getFront() const { return front_; }
     const glm::vec3& getUp() const { return up_; }
     const glm::vec3& getRight() const { return right_; }
+    float getYaw() const { return yaw_; }
+    float getPitch() const { return pitch_; }
+    
+    // Jump to a position and orientation (degrees), e.g. to replay a recorded path
+    void setPose(const glm::vec3& position, float yaw, float pitch);
     
     // Movement
     void processKeyboard(Movement direction, float deltaTime);
@@ -0,0 +1,76 @@
+#include "rendering/CameraPath.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace pcv {
+
+void CameraPath::record(float time, const Camera& camera) {
+    poses_.push_back({time, camera.getPosition(), camera.getYaw(), camera.getPitch()});
+}
+
+void CameraPath::apply(size_t frame, Camera& camera) const {
+    if (poses_.empty()) return;
+    const Pose& pose = poses_[std::min(frame, poses_.size() - 1)];
+    camera.setPose(pose.position, pose.yaw, pose.pitch);
+}
+
+bool CameraPath::load(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file: " << filename << std::endl;
+        return false;
+    }
+    
+    poses_.clear();
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        
+        std::istringstream fields(line);
+        Pose pose;
+        if (!(fields >> pose.time >> pose.position.x >> pose.position.y >> pose.position.z >> pose.yaw >> pose.pitch)) {
+            std::cerr << "Invalid camera pose in " << filename << ": " << line << std::endl;
+            return false;
+        }
+        poses_.push_back(pose);
+    }
+    return !poses_.empty();
+}
+
+bool CameraPath::save(const std::string& filename) const {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file for writing: " << filename << std::endl;
+        return false;
+    }
+    
+    file << "# time x y z yaw pitch\n";
+    file << std::fixed << std::setprecision(6);
+    for (const Pose& pose : poses_) {
+        file << pose.time << " " << pose.position.x << " " << pose.position.y << " " << pose.position.z
+             << " " << pose.yaw << " " << pose.pitch << "\n";
+    }
+    return file.good();
+}
+
+CameraPath CameraPath::orbit(const glm::vec3& center, float radius, float height, size_t frames) {
+    CameraPath path;
+    path.poses_.reserve(frames);
+    for (size_t i = 0; i < frames; ++i) {
+        float angle = 2.0f * static_cast<float>(M_PI) * i / std::max<size_t>(frames, 1);
+        glm::vec3 position = center + glm::vec3(radius * std::cos(angle), height, radius * std::sin(angle));
+        
+        // Yaw and pitch of the direction back to the center (Camera's convention)
+        glm::vec3 to_center = center - position;
+        float yaw = glm::degrees(std::atan2(to_center.z, to_center.x));
+        float pitch = glm::degrees(std::atan2(to_center.y, std::sqrt(to_center.x * to_center.x + to_center.z * to_center.z)));
+        path.poses_.push_back({i / 60.0f, position, yaw, pitch});
+    }
+    return path;
+}
+
+} // namespace pcv
\ No newline at end of file
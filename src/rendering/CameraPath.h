@@ -0,0 +1,41 @@
+#pragma once
+
+#include "rendering/Camera.h"
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+namespace pcv {
+
+// Camera poses recorded once per frame, for replaying a view sequence exactly.
+// Stored as text, one pose per line: "time x y z yaw pitch" (seconds, degrees);
+// lines starting with '#' are comments.
+class CameraPath {
+public:
+    struct Pose {
+        float time;
+        glm::vec3 position;
+        float yaw;
+        float pitch;
+    };
+    
+    void record(float time, const Camera& camera);
+    
+    // Pose of a frame; replays the last pose past the end
+    void apply(size_t frame, Camera& camera) const;
+    
+    bool load(const std::string& filename);
+    bool save(const std::string& filename) const;
+    
+    // Circle of frames around center at the given radius and height, looking at center
+    static CameraPath orbit(const glm::vec3& center, float radius, float height, size_t frames);
+    
+    size_t size() const { return poses_.size(); }
+    bool empty() const { return poses_.empty(); }
+    const std::vector<Pose>& getPoses() const { return poses_; }
+    
+private:
+    std::vector<Pose> poses_;
+};
+
+} // namespace pcv
\ No newline at end of file
@@ -0,0 +1,90 @@
+#include "rendering/CullingWorker.h"
+#include "utils/Timer.h"
+
+namespace pcv {
+
+CullingWorker::CullingWorker() : thread_(&CullingWorker::run, this) {
+}
+
+CullingWorker::~CullingWorker() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    request_cv_.notify_one();
+    thread_.join();
+}
+
+void CullingWorker::submit(const View& view) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_ = view;
+        has_pending_ = true;
+    }
+    request_cv_.notify_one();
+}
+
+const CullingWorker::Result* CullingWorker::acquire() {
+    // The exchange hands our old slot back to the worker as its next middle slot
+    if (middle_.load(std::memory_order_acquire) & FRESH) {
+        front_ = middle_.exchange(front_, std::memory_order_acq_rel) & ~FRESH;
+        has_result_ = true;
+    }
+    return has_result_ ? &slots_[front_] : nullptr;
+}
+
+void CullingWorker::wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_cv_.wait(lock, [this]() { return !has_pending_ && !busy_; });
+}
+
+void CullingWorker::cull(const View& view, Result& result, Profiler* profiler) {
+    Timer cull_timer;
+    result.view = view;
+    result.spans.clear();
+    {
+        ScopedTimer stage(profiler, "cull");
+        if (view.mode == Mode::LOD) {
+            view.octree->queryLODSpans(view.position, view.frustum, view.lod, result.spans);
+        } else if (view.mode == Mode::FRUSTUM) {
+            view.octree->queryFrustumSpans(view.frustum, result.spans);
+        } else {
+            view.octree->queryLeafSpans(result.spans);
+        }
+    }
+    
+    ScopedTimer stage(profiler, "gather");
+    result.firsts.clear();
+    result.counts.clear();
+    result.point_count = 0;
+    for (const auto& span : result.spans) {
+        result.firsts.push_back(static_cast<GLint>(span.begin) + (span.samples ? view.sample_offset : 0));
+        result.counts.push_back(static_cast<GLsizei>(span.end - span.begin));
+        result.point_count += span.end - span.begin;
+    }
+    result.cull_time_ms = cull_timer.elapsed();
+}
+
+void CullingWorker::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        request_cv_.wait(lock, [this]() { return has_pending_ || stop_; });
+        if (stop_) return;
+        
+        View view = pending_;
+        has_pending_ = false;
+        busy_ = true;
+        lock.unlock();
+        
+        cull(view, slots_[back_], profiler_.load(std::memory_order_relaxed));
+        back_ = middle_.exchange(back_ | FRESH, std::memory_order_acq_rel) & ~FRESH;
+        
+        lock.lock();
+        busy_ = false;
+        if (!has_pending_) {
+            idle_cv_.notify_all();
+        }
+    }
+}
+
+} // namespace pcv
\ No newline at end of file
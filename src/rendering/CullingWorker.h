@@ -0,0 +1,94 @@
+#pragma once
+
+#include "core/Octree.h"
+#include "utils/Profiler.h"
+#include <GL/glew.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pcv {
+
+// Culls octree views on a background thread, so the GL thread only submits draws.
+// submit() posts a snapshot of the view (a newer one replaces a pending one); the
+// worker builds its draw lists in the back slot of a triple buffer and publishes them
+// with a single atomic exchange. acquire() swaps in the newest published set without
+// waiting, so neither thread ever blocks on the other while frames are being drawn.
+// The worker reads the octree: call wait() before changing it.
+class CullingWorker {
+public:
+    enum class Mode {
+        LEAVES,     // Every leaf
+        FRUSTUM,    // Leaves in the frustum
+        LOD         // LOD cut in the frustum
+    };
+    
+    // Everything culling needs, copied out of the camera on the GL thread
+    struct View {
+        const Octree* octree = nullptr;
+        uint64_t revision = 0;      // Octree revision the result is valid for
+        Mode mode = Mode::LOD;
+        glm::vec3 position{0.0f};
+        Octree::FrustumPlanes frustum{};
+        Octree::LODParameters lod;
+        GLint sample_offset = 0;    // Where LOD samples start in the vertex buffers
+    };
+    
+    // Draw lists for one view, ready for glMultiDrawArrays
+    struct Result {
+        View view;
+        std::vector<Octree::Span> spans;
+        std::vector<GLint> firsts;
+        std::vector<GLsizei> counts;
+        size_t point_count = 0;
+        float cull_time_ms = 0.0f;
+    };
+    
+    CullingWorker();
+    ~CullingWorker();
+    
+    CullingWorker(const CullingWorker&) = delete;
+    CullingWorker& operator=(const CullingWorker&) = delete;
+    
+    // Queue a view for culling; returns immediately
+    void submit(const View& view);
+    
+    // Newest published result, or the one returned last time if nothing newer is
+    // ready; null before the first result. Valid until the next acquire().
+    const Result* acquire();
+    
+    // Block until no view is queued or being culled
+    void wait();
+    
+    // Time the worker's culling as "cull" and "gather" stages (null = off)
+    void setProfiler(Profiler* profiler) { profiler_.store(profiler, std::memory_order_relaxed); }
+    
+    // Cull a view on the calling thread
+    static void cull(const View& view, Result& result, Profiler* profiler = nullptr);
+    
+private:
+    static constexpr uint32_t FRESH = 4;    // Set on the middle slot when it holds an unread result
+    
+    Result slots_[3];
+    uint32_t back_ = 0;                     // Worker's slot
+    std::atomic<uint32_t> middle_{1};       // Last published slot, possibly FRESH
+    uint32_t front_ = 2;                    // Reader's slot
+    bool has_result_ = false;               // Reader side: front_ holds a result
+    
+    std::mutex mutex_;
+    std::condition_variable request_cv_;
+    std::condition_variable idle_cv_;
+    View pending_;
+    bool has_pending_ = false;
+    bool busy_ = false;
+    bool stop_ = false;
+    std::atomic<Profiler*> profiler_{nullptr};
+    std::thread thread_;
+    
+    void run();
+};
+
+} // namespace pcv
\ No newline at end of file
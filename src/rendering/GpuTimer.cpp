@@ -0,0 +1,85 @@
+#include "rendering/GpuTimer.h"
+
+namespace pcv {
+
+GpuTimer::~GpuTimer() {
+    release();
+}
+
+void GpuTimer::begin(const char* stage, double cpu_time_ms) {
+    if (active_) return;
+    
+    GLuint id = 0;
+    if (free_.empty()) {
+        glGenQueries(1, &id);
+    } else {
+        id = free_.back();
+        free_.pop_back();
+    }
+    glBeginQuery(GL_TIME_ELAPSED, id);
+    pending_.push_back({id, stage, cpu_time_ms, frame_});
+    active_ = true;
+}
+
+void GpuTimer::end() {
+    if (!active_) return;
+    glEndQuery(GL_TIME_ELAPSED);
+    active_ = false;
+}
+
+float GpuTimer::collect(Profiler* profiler) {
+    // Queries finish in order, so stop at the first one still in flight
+    float frame_ms = -1.0f;
+    float sum_ms = 0.0f;
+    uint64_t sum_frame = 0;
+    bool has_sum = false;
+    size_t in_flight = active_ ? 1 : 0;
+    while (pending_.size() > in_flight) {
+        const Query& query = pending_.front();
+        GLint available = 0;
+        glGetQueryObjectiv(query.id, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) break;
+        
+        GLuint64 elapsed_ns = 0;
+        glGetQueryObjectui64v(query.id, GL_QUERY_RESULT, &elapsed_ns);
+        float elapsed_ms = static_cast<float>(elapsed_ns / 1.0e6);
+        if (profiler) {
+            profiler->record(query.stage, query.cpu_time_ms, elapsed_ms, Profiler::Domain::GPU);
+        }
+        
+        if (has_sum && query.frame != sum_frame) {
+            frame_ms = sum_ms;
+            sum_ms = 0.0f;
+        }
+        sum_ms += elapsed_ms;
+        sum_frame = query.frame;
+        has_sum = true;
+        
+        free_.push_back(query.id);
+        pending_.pop_front();
+    }
+    
+    // The newest frame counts as complete once nothing of it is still pending
+    if (has_sum && (pending_.empty() || pending_.front().frame != sum_frame)) {
+        frame_ms = sum_ms;
+    }
+    frame_++;
+    return frame_ms;
+}
+
+void GpuTimer::release() {
+    if (active_) {
+        glEndQuery(GL_TIME_ELAPSED);
+        active_ = false;
+    }
+    for (const Query& query : pending_) {
+        glDeleteQueries(1, &query.id);
+    }
+    pending_.clear();
+    if (!free_.empty()) {
+        glDeleteQueries(static_cast<GLsizei>(free_.size()), free_.data());
+    }
+    free_.clear();
+}
+
+} // namespace pcv
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "utils/Profiler.h"
+#include <GL/glew.h>
+#include <deque>
+#include <vector>
+
+namespace pcv {
+
+// GL_TIME_ELAPSED queries around GPU stages. Results are read back only once the GPU
+// reports them available, normally a few frames later, so timing never stalls the
+// pipeline. Elapsed-time queries cannot nest: end() a stage before beginning the next.
+// Needs a current GL context for every call.
+class GpuTimer {
+public:
+    GpuTimer() = default;
+    ~GpuTimer();
+    
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+    
+    // stage must outlive the query (a string literal)
+    void begin(const char* stage, double cpu_time_ms);
+    void end();
+    
+    // Read every finished query, recording it as a GPU stage when profiler is set; call
+    // once per frame. Returns the summed milliseconds of the newest frame whose queries
+    // all finished, or a negative value if none did.
+    float collect(Profiler* profiler);
+    
+    void release();
+    
+private:
+    struct Query {
+        GLuint id;
+        const char* stage;
+        double cpu_time_ms;    // When the commands were issued
+        uint64_t frame;
+    };
+    
+    std::deque<Query> pending_;
+    std::vector<GLuint> free_;
+    bool active_ = false;
+    uint64_t frame_ = 0;     // Bumped when collect() is called, i.e. once per frame
+};
+
+} // namespace pcv
\ No newline at end of file
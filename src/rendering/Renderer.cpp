@@ -1,11 +1,157 @@
 #include "rendering/Renderer.h"
 #include "utils/Timer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <iostream>
+#include <iterator>
 
 namespace pcv {
 
+namespace {
+
+// Returns the bytes uploaded
+template<typename T>
+size_t uploadBuffer(GLuint vbo, const std::vector<T>& data) {
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(T), data.data(), GL_STATIC_DRAW);
+    return data.size() * sizeof(T);
+}
+
+// Sorted, merged [first, first + count) vertex ranges
+using Ranges = std::vector<std::pair<GLint, GLsizei>>;
+
+void appendRanges(const std::vector<GLint>& firsts, const std::vector<GLsizei>& counts, Ranges& ranges) {
+    for (size_t i = 0; i < firsts.size(); ++i) {
+        ranges.emplace_back(firsts[i], counts[i]);
+    }
+    std::sort(ranges.begin(), ranges.end());
+    
+    size_t merged = 0;
+    for (const auto& range : ranges) {
+        if (range.second <= 0) continue;
+        if (merged > 0 && ranges[merged - 1].first + ranges[merged - 1].second >= range.first) {
+            GLint end = std::max(ranges[merged - 1].first + ranges[merged - 1].second, range.first + range.second);
+            ranges[merged - 1].second = end - ranges[merged - 1].first;
+        } else {
+            ranges[merged++] = range;
+        }
+    }
+    ranges.resize(merged);
+}
+
+// Parts of the draw lists outside the covered ranges, as draw lists
+void subtractRanges(const std::vector<GLint>& firsts, const std::vector<GLsizei>& counts, const Ranges& covered,
+                    std::vector<GLint>& out_firsts, std::vector<GLsizei>& out_counts) {
+    out_firsts.clear();
+    out_counts.clear();
+    for (size_t i = 0; i < firsts.size(); ++i) {
+        GLint begin = firsts[i];
+        const GLint end = firsts[i] + counts[i];
+        
+        // First covered range ending past begin; merged ranges end in order
+        auto it = std::upper_bound(covered.begin(), covered.end(), begin,
+                                   [](GLint value, const Ranges::value_type& range) {
+                                       return value < range.first + range.second;
+                                   });
+        while (begin < end) {
+            GLint gap_end = it == covered.end() ? end : std::min(std::max(it->first, begin), end);
+            if (gap_end > begin) {
+                out_firsts.push_back(begin);
+                out_counts.push_back(gap_end - begin);
+            }
+            if (it == covered.end()) break;
+            begin = std::max(begin, it->first + it->second);
+            ++it;
+        }
+    }
+}
+
+// Planes of a view-projection matrix, pointing inwards and normalized
+void extractFrustumPlanes(const glm::mat4& vp, Octree::FrustumPlanes& planes) {
+    // Left plane
+    planes[0] = glm::vec4(
+        vp[0][3] + vp[0][0],
+        vp[1][3] + vp[1][0],
+        vp[2][3] + vp[2][0],
+        vp[3][3] + vp[3][0]
+    );
+    
+    // Right plane
+    planes[1] = glm::vec4(
+        vp[0][3] - vp[0][0],
+        vp[1][3] - vp[1][0],
+        vp[2][3] - vp[2][0],
+        vp[3][3] - vp[3][0]
+    );
+    
+    // Bottom plane
+    planes[2] = glm::vec4(
+        vp[0][3] + vp[0][1],
+        vp[1][3] + vp[1][1],
+        vp[2][3] + vp[2][1],
+        vp[3][3] + vp[3][1]
+    );
+    
+    // Top plane
+    planes[3] = glm::vec4(
+        vp[0][3] - vp[0][1],
+        vp[1][3] - vp[1][1],
+        vp[2][3] - vp[2][1],
+        vp[3][3] - vp[3][1]
+    );
+    
+    // Near plane
+    planes[4] = glm::vec4(
+        vp[0][3] + vp[0][2],
+        vp[1][3] + vp[1][2],
+        vp[2][3] + vp[2][2],
+        vp[3][3] + vp[3][2]
+    );
+    
+    // Far plane
+    planes[5] = glm::vec4(
+        vp[0][3] - vp[0][2],
+        vp[1][3] - vp[1][2],
+        vp[2][3] - vp[2][2],
+        vp[3][3] - vp[3][2]
+    );
+    
+    // Normalize planes
+    for (auto& plane : planes) {
+        float length = glm::length(glm::vec3(plane));
+        plane /= length;
+    }
+}
+
+// Whether a box may intersect the frustum: the p-vertex test of Octree's node culling
+bool isBoxInFrustum(const glm::vec3& min_bound, const glm::vec3& max_bound, const Octree::FrustumPlanes& frustum) {
+    for (const auto& plane : frustum) {
+        glm::vec3 p_vertex(
+            plane.x > 0 ? max_bound.x : min_bound.x,
+            plane.y > 0 ? max_bound.y : min_bound.y,
+            plane.z > 0 ? max_bound.z : min_bound.z
+        );
+        if (glm::dot(glm::vec3(plane), p_vertex) + plane.w < 0) return false;
+    }
+    return true;
+}
+
+template<typename T>
+std::vector<T> gatherChannel(const std::vector<T>& channel, const std::vector<uint32_t>& indices) {
+    std::vector<T> gathered;
+    gathered.reserve(indices.size());
+    for (uint32_t idx : indices) {
+        gathered.push_back(channel[idx]);
+    }
+    return gathered;
+}
+
+} // namespace
+
 Renderer::Renderer(int width, int height) : width_(width), height_(height) {
 }
 
@@ -25,9 +171,22 @@ bool Renderer::initialize() {
     glEnable(GL_PROGRAM_POINT_SIZE);
     glPointSize(point_size_);
     
+    // Compute shaders and indirect draws need GL 4.3
+    gpu_culling_supported_ = GLEW_VERSION_4_3;
+    
+    // Persistent mapping needs immutable buffer storage (GL 4.4 or ARB_buffer_storage)
+    staging_supported_ = GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+    
     // Setup shaders
     setupShaders();
     
+    // Scene tile transforms, read by every point shader through the Tiles block
+    glGenBuffers(1, &scene_.ubo_transforms);
+    glBindBuffer(GL_UNIFORM_BUFFER, scene_.ubo_transforms);
+    glBufferData(GL_UNIFORM_BUFFER, MAX_TILES * sizeof(glm::mat4), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, TILE_BLOCK_BINDING, scene_.ubo_transforms);
+    
     return true;
 }
 
@@ -38,12 +197,63 @@ void Renderer::shutdown() {
         glDeleteBuffers(1, &pair.second.vbo_positions);
         glDeleteBuffers(1, &pair.second.vbo_colors);
         glDeleteBuffers(1, &pair.second.vbo_normals);
+        glDeleteBuffers(1, &pair.second.ssbo_nodes);
+        glDeleteBuffers(1, &pair.second.ibo_commands);
+        glDeleteBuffers(1, &pair.second.tbo_range_bases);
+        glDeleteBuffers(1, &pair.second.tbo_range_bounds);
+        glDeleteTextures(1, &pair.second.tex_range_bases);
+        glDeleteTextures(1, &pair.second.tex_range_bounds);
     }
     vaos_.clear();
+    deleteScene();
+    deleteStreamingBuffers();
+    deleteStagingRing();
+    culling_worker_.reset();
+    gpu_timer_.release();
+    glDeleteVertexArrays(1, &overlay_vao_);
+    glDeleteBuffers(1, &overlay_vbo_);
+    overlay_vao_ = 0;
+    overlay_vbo_ = 0;
+    deleteSplatTargets();
+    deleteReuseTargets();
+    glDeleteVertexArrays(1, &fullscreen_vao_);
+    fullscreen_vao_ = 0;
+}
+
+void Renderer::enableAsyncCulling(bool enable) {
+    if (enable && !culling_worker_) {
+        culling_worker_ = std::make_unique<CullingWorker>();
+        culling_worker_->setProfiler(profiler_);
+    } else if (!enable) {
+        culling_worker_.reset();
+    }
+}
+
+void Renderer::setProfiler(Profiler* profiler) {
+    profiler_ = profiler;
+    if (culling_worker_) {
+        culling_worker_->setProfiler(profiler);
+    }
+}
+
+void Renderer::enableFrameReuse(bool enable, const FrameReuseParameters& params) {
+    reuse_.params = params;
+    if (!enable) {
+        deleteReuseTargets();
+    }
+    reuse_.enabled = enable;
+}
+
+void Renderer::waitForCulling() {
+    if (culling_worker_) {
+        culling_worker_->wait();
+    }
 }
 
 void Renderer::render(const PointCloud& cloud, const Camera& camera) {
     Timer frame_timer;
+    beginFrame();
+    reuse_.image_valid = false;
     
     // Clear the screen
     glClearColor(background_color_.r, background_color_.g, background_color_.b, 1.0f);
@@ -51,34 +261,33 @@ void Renderer::render(const PointCloud& cloud, const Camera& camera) {
     
     if (cloud.empty()) return;
     
-    // Create or update VAO
-    if (vaos_.find(&cloud) == vaos_.end()) {
-        createVAO(cloud);
+    const VAO* acquired = nullptr;
+    {
+        ScopedTimer stage(profiler_, "upload");
+        acquired = &acquireVAO(cloud, nullptr);
     }
-    
-    // Set up shader
-    point_shader_->use();
-    point_shader_->setMat4("view", camera.getViewMatrix());
-    point_shader_->setMat4("projection", camera.getProjectionMatrix());
-    point_shader_->setVec3("viewPos", camera.getPosition());
-    point_shader_->setFloat("pointSize", point_size_);
+    const VAO& vao = *acquired;
     
     // Render
-    const VAO& vao = vaos_[&cloud];
-    glBindVertexArray(vao.vao);
-    glDrawArrays(GL_POINTS, 0, vao.point_count);
-    glBindVertexArray(0);
+    {
+        ScopedTimer stage(profiler_, "draw");
+        gpu_timer_.begin("draw", profilerTime());
+        drawPoints(vao, camera, [&vao]() {
+            glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(vao.point_count));
+        });
+        gpu_timer_.end();
+    }
     
     // Update statistics
     stats_.points_rendered = vao.point_count;
     stats_.points_culled = 0;
     stats_.draw_calls = 1;
     stats_.frame_time_ms = frame_timer.elapsed();
-    stats_.fps = 1000.0f / stats_.frame_time_ms;
 }
 
 void Renderer::renderWithOctree(const PointCloud& cloud, const Octree& octree, const Camera& camera) {
     Timer frame_timer;
+    beginFrame();
     
     // Clear the screen
     glClearColor(background_color_.r, background_color_.g, background_color_.b, 1.0f);
@@ -90,43 +299,497 @@ void Renderer::renderWithOctree(const PointCloud& cloud, const Octree& octree, c
     Octree::FrustumPlanes frustum;
     calculateFrustumPlanes(camera, frustum);
     
-    // Query visible points
-    std::vector<size_t> visible_indices;
+    // Buffers are uploaded once in octree order and only refreshed when the octree changes
+    const VAO* acquired = nullptr;
+    {
+        ScopedTimer stage(profiler_, "upload");
+        acquired = &acquireVAO(cloud, &octree);
+    }
+    const VAO& vao = *acquired;
     
-    if (use_lod_ && use_frustum_culling_) {
-        visible_indices = octree.queryLOD(camera.getPosition(), frustum);
-    } else if (use_frustum_culling_) {
-        visible_indices = octree.queryFrustum(frustum);
-    } else {
-        // Render all points
-        visible_indices.resize(cloud.size());
-        for (size_t i = 0; i < cloud.size(); ++i) {
-            visible_indices[i] = i;
+    // projection[1][1] = 1 / tan(fov_y / 2)
+    Octree::LODParameters lod_params;
+    lod_params.projection_scale = 0.5f * height_ * camera.getProjectionMatrix()[1][1];
+    lod_params.pixel_threshold = lod_pixel_threshold_;
+    
+    if (use_gpu_culling_ && gpu_culling_supported_ && use_frustum_culling_ && vao.node_count > 0) {
+        reuse_.image_valid = false;
+        {
+            ScopedTimer stage(profiler_, "cull");
+            gpu_timer_.begin("cull", profilerTime());
+            cullOnGPU(vao, frustum, camera, use_lod_);
+            gpu_timer_.end();
         }
+        
+        ScopedTimer stage(profiler_, "draw");
+        gpu_timer_.begin("draw", profilerTime());
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, vao.ibo_commands);
+        drawPoints(vao, camera, [&vao]() {
+            glMultiDrawArraysIndirect(GL_POINTS, nullptr, vao.node_count, 0);
+        });
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        gpu_timer_.end();
+        
+        // Visible counts stay on the GPU
+        stats_.points_rendered = 0;
+        stats_.points_culled = 0;
+        stats_.draw_calls = 1;
+        stats_.frame_time_ms = frame_timer.elapsed();
+        return;
     }
     
-    // Update VAO with visible points
-    updateVAO(cloud, visible_indices);
+    // Visible spans of the resident buffers, as draw lists
+    CullingWorker::View view;
+    view.octree = &octree;
+    view.revision = octree.getRevision();
+    view.mode = !use_frustum_culling_ ? CullingWorker::Mode::LEAVES :
+                use_lod_ ? CullingWorker::Mode::LOD : CullingWorker::Mode::FRUSTUM;
+    view.position = camera.getPosition();
+    view.frustum = frustum;
+    view.lod = lod_params;
+    view.lod.point_budget = point_budget_;
+    view.sample_offset = vao.sample_offset;
     
-    // Set up shader
-    point_shader_->use();
-    point_shader_->setMat4("view", camera.getViewMatrix());
-    point_shader_->setMat4("projection", camera.getProjectionMatrix());
-    point_shader_->setVec3("viewPos", camera.getPosition());
-    point_shader_->setFloat("pointSize", point_size_);
+    // An unchanged view refines or just shows the image it already has
+    const bool reuse = reuse_.enabled && acquireReuseTargets();
+    const SceneKey key = getSceneKey(octree, vao);
+    const glm::mat4 view_matrix = camera.getViewMatrix();
+    const glm::mat4 projection = camera.getProjectionMatrix();
+    const bool same_scene = reuse && reuse_.image_valid && key == reuse_.key;
+    if (same_scene && view_matrix == reuse_.view && projection == reuse_.projection) {
+        refineReuseImage(vao, camera, view);
+        presentReuseImage();
+        stats_.points_culled = cloud.size() - std::min(stats_.points_rendered, cloud.size());
+        stats_.point_budget = use_lod_ && use_frustum_culling_ ? point_budget_ : 0;
+        stats_.frame_time_ms = frame_timer.elapsed();
+        return;
+    }
+    
+    updatePointBudget();
+    view.lod.point_budget = point_budget_;
+    
+    const CullingWorker::Result* visible = nullptr;
+    bool exact = true;     // The set is the cut for this camera, not a nearby one
+    if (culling_worker_) {
+        // Last frame's view was culled while it was drawn; post this one for the next
+        visible = culling_worker_->acquire();
+        culling_worker_->submit(view);
+        bool current = visible && visible->view.octree == &octree && visible->view.revision == view.revision &&
+                       visible->view.mode == view.mode && visible->view.sample_offset == view.sample_offset;
+        if (!current) visible = nullptr;
+        exact = visible && visible->view.position == view.position && visible->view.frustum == view.frustum;
+    } else if (reuse && same_scene && reuse_.set_valid && withinGuard(reuse_.set_guard, camera)) {
+        visible = &visible_set_;
+        exact = false;
+        stats_.visible_set_reused = true;
+    } else if (reuse) {
+        // Cull a little wider than the view so the set covers the next small motions
+        reuse_.set_guard = getGuardBand(octree, view.position, view_matrix, projection);
+        float widen = 1.0f / (1.0f + reuse_.params.guard_band);
+        extractFrustumPlanes(glm::scale(glm::mat4(1.0f), glm::vec3(widen, widen, 1.0f)) * projection * view_matrix,
+                             view.frustum);
+        for (auto& plane : view.frustum) {
+            plane.w += reuse_.set_guard.distance;
+        }
+        CullingWorker::cull(view, visible_set_, profiler_);
+        visible = &visible_set_;
+        reuse_.set_valid = true;
+    }
+    if (!visible) {
+        CullingWorker::cull(view, visible_set_, profiler_);
+        visible = &visible_set_;
+        exact = true;
+        reuse_.set_valid = false;
+    }
+    cut_points_ = visible->point_count;
     
     // Render
-    const VAO& vao = vaos_[&cloud];
-    glBindVertexArray(vao.vao);
-    glDrawArrays(GL_POINTS, 0, visible_indices.size());
-    glBindVertexArray(0);
+    {
+        ScopedTimer stage(profiler_, "draw");
+        gpu_timer_.begin("draw", profilerTime());
+        bool reproject = false;
+        int target = 0;
+        if (reuse) {
+            // A small step from the last image's camera starts from that image
+            reproject = shading_ == Shading::BASIC && same_scene && projection == reuse_.projection &&
+                        withinGuard(getGuardBand(octree, reuse_.position, reuse_.view, reuse_.projection), camera);
+            target = reproject ? 1 - reuse_.current : reuse_.current;
+            glBindFramebuffer(GL_FRAMEBUFFER, reuse_.framebuffers[target]);
+            glClearColor(background_color_.r, background_color_.g, background_color_.b, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            if (reproject) {
+                reprojectImage(reuse_.current, projection * view_matrix);
+            }
+            output_framebuffer_ = reuse_.framebuffers[target];
+        }
+        drawPoints(vao, camera, [visible]() {
+            if (!visible->counts.empty()) {
+                glMultiDrawArrays(GL_POINTS, visible->firsts.data(), visible->counts.data(),
+                                  static_cast<GLsizei>(visible->counts.size()));
+            }
+        });
+        if (reuse) {
+            output_framebuffer_ = 0;
+            reuse_.current = target;
+            reuse_.image_valid = true;
+            reuse_.key = key;
+            reuse_.view = view_matrix;
+            reuse_.projection = projection;
+            reuse_.position = view.position;
+            reuse_.level = exact ? 0 : -1;
+            reuse_.drawn.clear();
+            appendRanges(visible->firsts, visible->counts, reuse_.drawn);
+            stats_.image_reused = reproject;
+            presentReuseImage();
+        }
+        gpu_timer_.end();
+    }
     
     // Update statistics
-    stats_.points_rendered = visible_indices.size();
-    stats_.points_culled = cloud.size() - visible_indices.size();
-    stats_.draw_calls = 1;
+    stats_.points_rendered = visible->point_count;
+    stats_.points_culled = cloud.size() - std::min(visible->point_count, cloud.size());
+    stats_.draw_calls = visible->counts.size();
+    stats_.point_budget = use_lod_ && use_frustum_culling_ ? point_budget_ : 0;
+    stats_.cull_time_ms = visible->cull_time_ms;
     stats_.frame_time_ms = frame_timer.elapsed();
-    stats_.fps = 1000.0f / stats_.frame_time_ms;
+}
+
+void Renderer::renderOutOfCore(OutOfCoreOctree& octree, const Camera& camera) {
+    Timer frame_timer;
+    beginFrame();
+    frame_arena_.reset();
+    reuse_.image_valid = false;
+    
+    // Clear the screen
+    glClearColor(background_color_.r, background_color_.g, background_color_.b, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    
+    if (!octree.isOpen() || octree.getNodeCount() == 0) return;
+    
+    Octree::FrustumPlanes frustum;
+    calculateFrustumPlanes(camera, frustum);
+    
+    // Without LOD every visible leaf is selected
+    Octree::LODParameters lod_params;
+    lod_params.projection_scale = 0.5f * height_ * camera.getProjectionMatrix()[1][1];
+    lod_params.pixel_threshold = use_lod_ ? lod_pixel_threshold_ : 0.0f;
+    {
+        ScopedTimer stage(profiler_, "cull");
+        octree.update(camera.getPosition(), frustum, lod_params, draw_nodes_);
+    }
+    
+    acquireStreamingBuffers(octree);
+    acquireStagingRing();
+    streaming_.frame++;
+    stats_.staged_bytes = 0;
+    
+    // Upload what is missing, within this frame's budget
+    ScopedTimer upload_stage(profiler_, "upload");
+    gpu_timer_.begin("upload", profilerTime());
+    draw_firsts_.clear();
+    draw_counts_.clear();
+    size_t visible_count = 0;
+    size_t uploaded = 0;
+    for (uint32_t node : draw_nodes_) {
+        auto it = streaming_.slots.find(node);
+        if (it == streaming_.slots.end()) {
+            const OutOfCoreOctree::NodeData* data = octree.getNodeData(node);
+            GLsizei count = static_cast<GLsizei>(data->positions.size());
+            GLint first = 0;
+            if (uploaded + count > streaming_upload_points_ && uploaded > 0) continue;
+            if (!allocateStreaming(count, first)) continue;
+            
+            uploadStreaming(streaming_.vao.vbo_positions, first * sizeof(glm::vec3),
+                            data->positions.data(), count * sizeof(glm::vec3));
+            if (streaming_.vao.has_colors) {
+                uploadStreaming(streaming_.vao.vbo_colors, first * sizeof(PackedColor),
+                                data->colors.data(), count * sizeof(PackedColor));
+            }
+            if (streaming_.vao.has_normals) {
+                uploadStreaming(streaming_.vao.vbo_normals, first * sizeof(PackedNormal),
+                                data->normals.data(), count * sizeof(PackedNormal));
+            }
+            uploaded += count;
+            it = streaming_.slots.emplace(node, StreamingSlot{first, count, 0}).first;
+        }
+        
+        it->second.last_used = streaming_.frame;
+        draw_firsts_.push_back(it->second.first);
+        draw_counts_.push_back(it->second.count);
+        visible_count += it->second.count;
+    }
+    finishStaging();
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    gpu_timer_.end();
+    upload_stage.stop();
+    
+    // Render
+    {
+        ScopedTimer stage(profiler_, "draw");
+        gpu_timer_.begin("draw", profilerTime());
+        drawPoints(streaming_.vao, camera, [this]() {
+            if (!draw_counts_.empty()) {
+                glMultiDrawArrays(GL_POINTS, draw_firsts_.data(), draw_counts_.data(),
+                                  static_cast<GLsizei>(draw_counts_.size()));
+            }
+        });
+        gpu_timer_.end();
+    }
+    
+    // Update statistics
+    stats_.points_rendered = visible_count;
+    stats_.points_culled = octree.getPointCount() - std::min(visible_count, octree.getPointCount());
+    stats_.draw_calls = draw_counts_.size();
+    ArenaStatistics scratch = frame_arena_.getStatistics();
+    stats_.scratch_allocations = scratch.allocations;
+    stats_.scratch_bytes = scratch.bytes_used;
+    stats_.frame_time_ms = frame_timer.elapsed();
+}
+
+void Renderer::renderScene(const Camera& camera) {
+    Timer frame_timer;
+    beginFrame();
+    reuse_.image_valid = false;
+    
+    // Clear the screen
+    glClearColor(background_color_.r, background_color_.g, background_color_.b, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    
+    if (scene_.tiles.empty() || scene_.capacity == 0) return;
+    
+    Octree::FrustumPlanes frustum;
+    calculateFrustumPlanes(camera, frustum);
+    
+    Octree::LODParameters lod_params;
+    lod_params.projection_scale = 0.5f * height_ * camera.getProjectionMatrix()[1][1];
+    lod_params.pixel_threshold = lod_pixel_threshold_;
+    
+    // Each tile is culled in its own space, and its spans join one draw list
+    Timer cull_timer;
+    draw_firsts_.clear();
+    draw_counts_.clear();
+    size_t total_count = 0;
+    size_t visible_count = 0;
+    {
+        ScopedTimer stage(profiler_, "cull");
+        for (const auto& pair : scene_.tiles) {
+            const SceneTile& tile = pair.second;
+            total_count += tile.point_count;
+            if (!tile.visible || tile.count == 0) continue;
+            if (tile.octree && tile.octree->getRevision() != tile.octree_revision) continue;
+            
+            // A world plane p becomes transpose(M) * p for tile-space points
+            const glm::mat4& transform = scene_.transforms[tile.slot];
+            const glm::mat4 transposed = glm::transpose(transform);
+            Octree::FrustumPlanes local_frustum;
+            for (int i = 0; i < 6; ++i) {
+                glm::vec4 plane = transposed * frustum[i];
+                float length = glm::length(glm::vec3(plane));
+                local_frustum[i] = length > 0.0f ? plane / length : plane;
+            }
+            
+            if (!tile.octree) {
+                if (!use_frustum_culling_ || isBoxInFrustum(tile.min_bound, tile.max_bound, local_frustum)) {
+                    draw_firsts_.push_back(tile.first);
+                    draw_counts_.push_back(tile.count);
+                    visible_count += tile.count;
+                }
+                continue;
+            }
+            
+            CullingWorker::View view;
+            view.octree = tile.octree;
+            view.revision = tile.octree_revision;
+            view.mode = !use_frustum_culling_ ? CullingWorker::Mode::LEAVES :
+                        use_lod_ ? CullingWorker::Mode::LOD : CullingWorker::Mode::FRUSTUM;
+            view.position = glm::vec3(glm::inverse(transform) * glm::vec4(camera.getPosition(), 1.0f));
+            view.frustum = local_frustum;
+            view.lod = lod_params;
+            view.sample_offset = tile.sample_offset;
+            CullingWorker::cull(view, scene_.culled);
+            for (size_t i = 0; i < scene_.culled.firsts.size(); ++i) {
+                draw_firsts_.push_back(tile.first + scene_.culled.firsts[i]);
+                draw_counts_.push_back(scene_.culled.counts[i]);
+            }
+            visible_count += scene_.culled.point_count;
+        }
+    }
+    float cull_time_ms = cull_timer.elapsed();
+    
+    if (scene_.transforms_dirty) {
+        glBindBuffer(GL_UNIFORM_BUFFER, scene_.ubo_transforms);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, scene_.transforms.size() * sizeof(glm::mat4), scene_.transforms.data());
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        scene_.transforms_dirty = false;
+    }
+    
+    // Render every tile at once
+    {
+        ScopedTimer stage(profiler_, "draw");
+        gpu_timer_.begin("draw", profilerTime());
+        drawPoints(scene_.vao, camera, [this]() {
+            if (!draw_counts_.empty()) {
+                glMultiDrawArrays(GL_POINTS, draw_firsts_.data(), draw_counts_.data(),
+                                  static_cast<GLsizei>(draw_counts_.size()));
+            }
+        });
+        gpu_timer_.end();
+    }
+    
+    // Update statistics
+    stats_.points_rendered = visible_count;
+    stats_.points_culled = total_count - std::min(visible_count, total_count);
+    stats_.draw_calls = draw_counts_.size();
+    stats_.point_budget = 0;
+    stats_.cull_time_ms = cull_time_ms;
+    stats_.frame_time_ms = frame_timer.elapsed();
+}
+
+void Renderer::beginFrame() {
+    // Unlike frame_time_ms this includes the swap and any wait for the GPU
+    stats_.frame_interval_ms = frame_started_ ? frame_interval_timer_.elapsed() : 0.0f;
+    frame_interval_timer_.reset();
+    frame_started_ = true;
+    if (stats_.frame_interval_ms > 0.0f) {
+        stats_.fps = 1000.0f / stats_.frame_interval_ms;
+    }
+    
+    stats_.uploaded_bytes = 0;
+    stats_.image_reused = false;
+    stats_.visible_set_reused = false;
+    stats_.refinement_level = 0;
+    
+    float gpu_ms = gpu_timer_.collect(profiler_);
+    if (gpu_ms >= 0.0f) {
+        stats_.gpu_time_ms = gpu_ms;
+    }
+}
+
+void Renderer::updatePointBudget() {
+    float interval = stats_.frame_interval_ms;
+    if (target_frame_time_ms_ <= 0.0f) {
+        point_budget_ = max_point_budget_;
+        point_budget_started_ = false;
+        return;
+    }
+    
+    // The first interval spans whatever ran before rendering started
+    if (!point_budget_started_ || interval <= 0.0f) {
+        point_budget_started_ = true;
+        smoothed_frame_ms_ = target_frame_time_ms_;
+        if (point_budget_ == 0) {
+            point_budget_ = max_point_budget_ > 0 ? max_point_budget_ : DEFAULT_POINT_BUDGET;
+        }
+        return;
+    }
+    
+    // Smooth out single slow frames (e.g. a buffer refresh after an octree update), then
+    // scale the budget towards the target: quickly down, slowly up, not at all within 5%
+    interval = std::min(interval, 4.0f * target_frame_time_ms_);
+    smoothed_frame_ms_ += 0.25f * (interval - smoothed_frame_ms_);
+    float ratio = target_frame_time_ms_ / smoothed_frame_ms_;
+    double budget = static_cast<double>(point_budget_);
+    if (ratio < 0.95f || ratio > 1.05f) {
+        budget *= std::min(std::max(ratio, 0.8f), 1.1f);
+    }
+    
+    // A view that drew less than its budget says nothing about a larger one, so don't let
+    // the budget run far ahead of what was drawn
+    if (cut_points_ < point_budget_) {
+        budget = std::min(budget, 2.0 * static_cast<double>(cut_points_));
+    }
+    
+    budget = std::max(budget, static_cast<double>(MIN_POINT_BUDGET));
+    if (max_point_budget_ > 0) {
+        budget = std::min(budget, static_cast<double>(max_point_budget_));
+    }
+    point_budget_ = static_cast<size_t>(budget);
+}
+
+void Renderer::renderProfilerOverlay() {
+    if (!show_overlay_ || !profiler_ || !overlay_shader_) return;
+    
+    std::vector<Profiler::StageSummary> stages = profiler_->getSummary();
+    std::stable_partition(stages.begin(), stages.end(), [](const Profiler::StageSummary& stage) {
+        return stage.domain == Profiler::Domain::CPU;
+    });
+    if (stages.empty()) return;
+    
+    // The target frame time sits at two thirds of the panel; longer bars are clipped
+    const float margin = 10.0f;
+    const float row_height = 8.0f;
+    const float row_gap = 3.0f;
+    const float panel_width = 0.4f * width_;
+    const float panel_height = stages.size() * (row_height + row_gap) + row_gap;
+    const float marker_ms = target_frame_time_ms_ > 0.0f ? target_frame_time_ms_ : 1000.0f / 60.0f;
+    const float pixels_per_ms = panel_width * (2.0f / 3.0f) / marker_ms;
+    
+    // One colour per stage name, darker for the GPU side of a stage
+    static const glm::vec4 palette[] = {
+        {0.90f, 0.30f, 0.25f, 0.9f}, {0.95f, 0.65f, 0.20f, 0.9f}, {0.35f, 0.75f, 0.35f, 0.9f},
+        {0.25f, 0.55f, 0.90f, 0.9f}, {0.70f, 0.40f, 0.85f, 0.9f}, {0.30f, 0.80f, 0.80f, 0.9f},
+        {0.85f, 0.45f, 0.65f, 0.9f}, {0.60f, 0.60f, 0.60f, 0.9f}};
+    const size_t palette_size = sizeof(palette) / sizeof(palette[0]);
+    std::vector<std::string> names;
+    
+    overlay_vertices_.clear();
+    addOverlayBar(margin, margin, panel_width, panel_height, glm::vec4(0.0f, 0.0f, 0.0f, 0.5f));
+    for (size_t i = 0; i < stages.size(); ++i) {
+        const Profiler::StageSummary& stage = stages[i];
+        size_t name = std::find(names.begin(), names.end(), stage.name) - names.begin();
+        if (name == names.size()) {
+            names.push_back(stage.name);
+        }
+        glm::vec4 color = palette[name % palette_size];
+        if (stage.domain == Profiler::Domain::GPU) {
+            color = glm::vec4(glm::vec3(color) * 0.6f, color.a);
+        }
+        
+        float y = margin + panel_height - (i + 1) * (row_height + row_gap);
+        float p50 = std::min(stage.p50_ms * pixels_per_ms, panel_width);
+        float p95 = std::min(stage.p95_ms * pixels_per_ms, panel_width);
+        addOverlayBar(margin, y, p50, row_height, color);
+        addOverlayBar(margin + std::max(p95 - 1.0f, 0.0f), y, 2.0f, row_height, glm::vec4(1.0f));
+    }
+    addOverlayBar(margin + marker_ms * pixels_per_ms, margin, 1.0f, panel_height, glm::vec4(1.0f, 1.0f, 1.0f, 0.8f));
+    
+    if (overlay_vao_ == 0) {
+        glGenVertexArrays(1, &overlay_vao_);
+        glGenBuffers(1, &overlay_vbo_);
+        glBindVertexArray(overlay_vao_);
+        glBindBuffer(GL_ARRAY_BUFFER, overlay_vbo_);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(OverlayVertex),
+                              reinterpret_cast<void*>(offsetof(OverlayVertex, position)));
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(OverlayVertex),
+                              reinterpret_cast<void*>(offsetof(OverlayVertex, color)));
+        glEnableVertexAttribArray(1);
+    }
+    glBindVertexArray(overlay_vao_);
+    glBindBuffer(GL_ARRAY_BUFFER, overlay_vbo_);
+    glBufferData(GL_ARRAY_BUFFER, overlay_vertices_.size() * sizeof(OverlayVertex),
+                 overlay_vertices_.data(), GL_STREAM_DRAW);
+    
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    overlay_shader_->use();
+    overlay_shader_->setVec2("viewport", static_cast<float>(width_), static_cast<float>(height_));
+    glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(overlay_vertices_.size()));
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+    
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Renderer::addOverlayBar(float x, float y, float width, float height, const glm::vec4& color) {
+    if (width <= 0.0f || height <= 0.0f) return;
+    const glm::vec2 corners[6] = {{x, y}, {x + width, y}, {x + width, y + height},
+                                  {x, y}, {x + width, y + height}, {x, y + height}};
+    for (const glm::vec2& corner : corners) {
+        overlay_vertices_.push_back({corner, color});
+    }
 }
 
 void Renderer::resize(int width, int height) {
@@ -135,161 +798,1010 @@ void Renderer::resize(int width, int height) {
     glViewport(0, 0, width, height);
 }
 
-void Renderer::createVAO(const PointCloud& cloud) {
+const Renderer::VAO& Renderer::acquireVAO(const PointCloud& cloud, const Octree* octree) {
+    auto it = vaos_.find(&cloud);
+    if (it != vaos_.end()) {
+        const VAO& vao = it->second;
+        // A new cloud at a freed cloud's address usually differs in size
+        size_t point_count = octree ? octree->getIndices().size() + octree->getSamples().size() : cloud.size();
+        bool current = vao.has_colors == cloud.hasColors() && vao.has_normals == cloud.hasNormals() &&
+                       vao.point_count == point_count && vao.octree == octree &&
+                       (!octree || vao.octree_revision == octree->getRevision());
+        if (current) return vao;
+        deleteVAO(cloud);
+    }
+    
+    createVAO(cloud, octree);
+    return vaos_[&cloud];
+}
+
+void Renderer::createVAO(const PointCloud& cloud, const Octree* octree) {
     VAO vao;
+    vao.has_colors = cloud.hasColors();
+    vao.has_normals = cloud.hasNormals();
+    
+    // Octree order: leaf ranges, then interior-node samples. Spare leaf slots hold
+    // stale but valid indices and are never drawn.
+    std::vector<uint32_t> order;
+    if (octree) {
+        order = octree->getIndices();
+        order.insert(order.end(), octree->getSamples().begin(), octree->getSamples().end());
+        vao.octree = octree;
+        vao.octree_revision = octree->getRevision();
+        vao.sample_offset = static_cast<GLint>(octree->getIndices().size());
+    }
+    vao.point_count = octree ? order.size() : cloud.size();
     
     // Generate and bind VAO
     glGenVertexArrays(1, &vao.vao);
     glBindVertexArray(vao.vao);
     
-    // Position buffer
+    // Position buffer: float xyz, or unorm16 xyz within the vertex's octree node and the
+    // node's range index (quantized positions need node bounds, so octree order only)
     glGenBuffers(1, &vao.vbo_positions);
     glBindBuffer(GL_ARRAY_BUFFER, vao.vbo_positions);
-    std::vector<glm::vec3> positions;
-    positions.reserve(cloud.size());
-    for (const auto& point : cloud) {
-        positions.push_back(point.position);
+    if (quantize_positions_ && octree && createQuantizedPositions(vao, cloud, *octree, order)) {
+        glVertexAttribPointer(0, 4, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(QuantizedVertex), nullptr);
+    } else {
+        if (octree) {
+            stats_.uploaded_bytes += uploadBuffer(vao.vbo_positions, gatherChannel(cloud.getPositions(), order));
+        } else {
+            stats_.uploaded_bytes += uploadBuffer(vao.vbo_positions, cloud.getPositions());
+        }
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), nullptr);
     }
-    glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec3), 
-                 positions.data(), GL_DYNAMIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), nullptr);
     glEnableVertexAttribArray(0);
     
-    // Color buffer
+    // Color buffer: RGBA8, or a constant white attribute when the cloud has no colors
     glGenBuffers(1, &vao.vbo_colors);
     glBindBuffer(GL_ARRAY_BUFFER, vao.vbo_colors);
-    std::vector<glm::vec3> colors;
-    colors.reserve(cloud.size());
-    for (const auto& point : cloud) {
-        colors.push_back(point.color);
-    }
-    glBufferData(GL_ARRAY_BUFFER, colors.size() * sizeof(glm::vec3), 
-                 colors.data(), GL_DYNAMIC_DRAW);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), nullptr);
-    glEnableVertexAttribArray(1);
+    if (vao.has_colors) {
+        glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PackedColor), nullptr);
+        glEnableVertexAttribArray(1);
+    }
     
-    // Normal buffer
+    // Normal buffer: octahedral snorm16x2
     glGenBuffers(1, &vao.vbo_normals);
     glBindBuffer(GL_ARRAY_BUFFER, vao.vbo_normals);
-    std::vector<glm::vec3> normals;
-    normals.reserve(cloud.size());
-    for (const auto& point : cloud) {
-        normals.push_back(point.normal);
+    if (vao.has_normals) {
+        glVertexAttribPointer(2, 2, GL_SHORT, GL_TRUE, sizeof(PackedNormal), nullptr);
+        glEnableVertexAttribArray(2);
     }
-    glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(glm::vec3), 
-                 normals.data(), GL_DYNAMIC_DRAW);
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), nullptr);
-    glEnableVertexAttribArray(2);
     
     glBindVertexArray(0);
     
-    vao.point_count = cloud.size();
+    if (octree) {
+        if (vao.has_colors) stats_.uploaded_bytes += uploadBuffer(vao.vbo_colors, gatherChannel(cloud.getColors(), order));
+        if (vao.has_normals) stats_.uploaded_bytes += uploadBuffer(vao.vbo_normals, gatherChannel(cloud.getNormals(), order));
+        if (gpu_culling_supported_) {
+            createCullBuffers(vao, *octree);
+        }
+        vaos_[&cloud] = vao;
+        return;
+    }
+    
+    // Channels are contiguous, so each one uploads without repacking
+    if (vao.has_colors) stats_.uploaded_bytes += uploadBuffer(vao.vbo_colors, cloud.getColors());
+    if (vao.has_normals) stats_.uploaded_bytes += uploadBuffer(vao.vbo_normals, cloud.getNormals());
     vaos_[&cloud] = vao;
 }
 
-void Renderer::updateVAO(const PointCloud& cloud, const std::vector<size_t>& indices) {
-    if (vaos_.find(&cloud) == vaos_.end()) {
-        createVAO(cloud);
-        return;
+bool Renderer::createQuantizedPositions(VAO& vao, const PointCloud& cloud, const Octree& octree,
+                                        const std::vector<uint32_t>& order) {
+    // A range per leaf with points and per interior node with samples, by first vertex
+    struct NodeRange {
+        uint32_t first;
+        glm::vec3 min_bound;
+        glm::vec3 max_bound;
+    };
+    std::vector<NodeRange> ranges;
+    for (const auto& node : octree.getNodes()) {
+        if (node.isLeaf() && node.end > node.begin) {
+            ranges.push_back({node.begin, node.min_bound, node.max_bound});
+        } else if (!node.isLeaf() && node.sample_end > node.sample_begin) {
+            ranges.push_back({static_cast<uint32_t>(vao.sample_offset) + node.sample_begin, node.min_bound, node.max_bound});
+        }
     }
+    if (ranges.empty()) return false;
+    std::sort(ranges.begin(), ranges.end(), [](const NodeRange& a, const NodeRange& b) { return a.first < b.first; });
     
-    VAO& vao = vaos_[&cloud];
-    glBindVertexArray(vao.vao);
+    // Two texels per range: offset, then scale
+    GLint max_texels = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &max_texels);
+    if (2 * ranges.size() > static_cast<size_t>(max_texels)) {
+        std::cerr << "Failed to quantize positions: " << ranges.size() << " octree ranges exceed the texture buffer size" << std::endl;
+        return false;
+    }
     
-    // Update position buffer
-    std::vector<glm::vec3> positions;
-    positions.reserve(indices.size());
-    for (size_t idx : indices) {
-        positions.push_back(cloud[idx].position);
+    // Each vertex belongs to the last range starting at or before it (vertices ahead of
+    // the first range and stale spare slots are never drawn, so they just clamp). The
+    // index is stored relative to the range of the first vertex in its window: fewer
+    // than 2^16 ranges start inside one window, so it fits 16 bits.
+    const size_t window = size_t(1) << RANGE_WINDOW_BITS;
+    std::vector<QuantizedVertex> vertices(order.size());
+    std::vector<uint32_t> window_bases((order.size() + window - 1) / window);
+    size_t range = 0;
+    for (size_t i = 0; i < order.size(); ++i) {
+        while (range + 1 < ranges.size() && ranges[range + 1].first <= i) {
+            ++range;
+        }
+        if (i % window == 0) {
+            window_bases[i / window] = static_cast<uint32_t>(range);
+        }
+        const NodeRange& node = ranges[range];
+        vertices[i].position = quantizePosition(cloud.getPosition(order[i]), node.min_bound, node.max_bound);
+        vertices[i].range = static_cast<uint16_t>(range - window_bases[i / window]);
+    }
+    std::vector<glm::vec4> bounds;
+    bounds.reserve(2 * ranges.size());
+    for (const NodeRange& node : ranges) {
+        bounds.emplace_back(node.min_bound, 0.0f);
+        bounds.emplace_back(node.max_bound - node.min_bound, 0.0f);
     }
+    
+    stats_.uploaded_bytes += uploadBuffer(vao.vbo_positions, vertices);
+    
+    auto createTextureBuffer = [this](GLuint& buffer, GLuint& texture, GLenum format, const void* data, size_t bytes) {
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+        glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(bytes), data, GL_STATIC_DRAW);
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_BUFFER, texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+        stats_.uploaded_bytes += bytes;
+    };
+    createTextureBuffer(vao.tbo_range_bases, vao.tex_range_bases, GL_R32UI,
+                        window_bases.data(), window_bases.size() * sizeof(uint32_t));
+    createTextureBuffer(vao.tbo_range_bounds, vao.tex_range_bounds, GL_RGBA32F,
+                        bounds.data(), bounds.size() * sizeof(glm::vec4));
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
     glBindBuffer(GL_ARRAY_BUFFER, vao.vbo_positions);
-    glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec3), 
-                 positions.data(), GL_DYNAMIC_DRAW);
     
-    // Update color buffer
-    std::vector<glm::vec3> colors;
-    colors.reserve(indices.size());
-    for (size_t idx : indices) {
-        colors.push_back(cloud[idx].color);
+    vao.quantized_positions = true;
+    return true;
+}
+
+void Renderer::createCullBuffers(VAO& vao, const Octree& octree) {
+    const auto& nodes = octree.getNodes();
+    std::vector<CullNode> cull_nodes(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        const auto& node = nodes[i];
+        CullNode& cull_node = cull_nodes[i];
+        glm::vec3 extent = node.max_bound - node.min_bound;
+        float spacing = std::max(extent.x, std::max(extent.y, extent.z)) / Octree::LOD_GRID_SIZE;
+        cull_node.min_bound = glm::vec4(node.min_bound, spacing);
+        cull_node.max_bound = glm::vec4(node.max_bound, 0.0f);
+        cull_node.parent = 0xFFFFFFFFu;
+        cull_node.leaf = node.isLeaf() ? 1u : 0u;
+        if (node.isLeaf()) {
+            cull_node.first = node.begin;
+            cull_node.count = node.end - node.begin;
+        } else {
+            cull_node.first = node.sample_begin + static_cast<uint32_t>(vao.sample_offset);
+            cull_node.count = node.sample_end - node.sample_begin;
+        }
+    }
+    
+    // Nodes only store their children, so fill in parents (dead slots keep none)
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        for (int c = 0; c < nodes[i].getChildCount(); ++c) {
+            cull_nodes[nodes[i].first_child + c].parent = static_cast<uint32_t>(i);
+        }
+    }
+    
+    glGenBuffers(1, &vao.ssbo_nodes);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, vao.ssbo_nodes);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, cull_nodes.size() * sizeof(CullNode), cull_nodes.data(), GL_STATIC_DRAW);
+    
+    // Rewritten by the compute shader every frame
+    glGenBuffers(1, &vao.ibo_commands);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, vao.ibo_commands);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, nodes.size() * 4 * sizeof(GLuint), nullptr, GL_DYNAMIC_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    
+    vao.node_count = static_cast<GLsizei>(nodes.size());
+}
+
+void Renderer::cullOnGPU(const VAO& vao, const Octree::FrustumPlanes& frustum,
+                         const Camera& camera, bool use_lod) {
+    cull_shader_->use();
+    for (int i = 0; i < 6; ++i) {
+        cull_shader_->setVec4("frustumPlanes[" + std::to_string(i) + "]", frustum[i]);
     }
+    cull_shader_->setVec3("viewPos", camera.getPosition());
+    cull_shader_->setFloat("projectionScale", 0.5f * height_ * camera.getProjectionMatrix()[1][1]);
+    cull_shader_->setFloat("pixelThreshold", lod_pixel_threshold_);
+    cull_shader_->setBool("lodEnabled", use_lod);
+    cull_shader_->setInt("nodeCount", vao.node_count);
+    
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, vao.ssbo_nodes);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, vao.ibo_commands);
+    glDispatchCompute((static_cast<GLuint>(vao.node_count) + 63) / 64, 1, 1);
+    
+    // Commands are consumed as indirect draw arguments
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+}
+
+void Renderer::deleteVAO(const PointCloud& cloud) {
+    auto it = vaos_.find(&cloud);
+    if (it == vaos_.end()) return;
+    
+    glDeleteVertexArrays(1, &it->second.vao);
+    glDeleteBuffers(1, &it->second.vbo_positions);
+    glDeleteBuffers(1, &it->second.vbo_colors);
+    glDeleteBuffers(1, &it->second.vbo_normals);
+    glDeleteBuffers(1, &it->second.ssbo_nodes);
+    glDeleteBuffers(1, &it->second.ibo_commands);
+    glDeleteBuffers(1, &it->second.tbo_range_bases);
+    glDeleteBuffers(1, &it->second.tbo_range_bounds);
+    glDeleteTextures(1, &it->second.tex_range_bases);
+    glDeleteTextures(1, &it->second.tex_range_bounds);
+    vaos_.erase(it);
+}
+
+Renderer::TileHandle Renderer::addTile(const PointCloud& cloud, const Octree* octree, const glm::mat4& transform) {
+    if (scene_.free_slots.empty() && scene_.transforms.size() >= MAX_TILES) {
+        std::cerr << "Failed to add tile: a scene holds at most " << MAX_TILES << " tiles" << std::endl;
+        return 0;
+    }
+    
+    SceneTile tile;
+    if (!scene_.free_slots.empty()) {
+        tile.slot = scene_.free_slots.back();
+        scene_.free_slots.pop_back();
+        scene_.transforms[tile.slot] = transform;
+    } else {
+        tile.slot = static_cast<uint32_t>(scene_.transforms.size());
+        scene_.transforms.push_back(transform);
+    }
+    scene_.transforms_dirty = true;
+    uploadTile(tile, cloud, octree);
+    
+    TileHandle handle = scene_.next_handle++;
+    scene_.tiles.emplace(handle, tile);
+    return handle;
+}
+
+bool Renderer::updateTile(TileHandle tile, const PointCloud& cloud, const Octree* octree) {
+    auto it = scene_.tiles.find(tile);
+    if (it == scene_.tiles.end()) return false;
+    
+    // Slot, transform and visibility stay
+    giveRange(scene_.free_ranges, it->second.first, it->second.count);
+    uploadTile(it->second, cloud, octree);
+    return true;
+}
+
+bool Renderer::setTileTransform(TileHandle tile, const glm::mat4& transform) {
+    auto it = scene_.tiles.find(tile);
+    if (it == scene_.tiles.end()) return false;
+    
+    scene_.transforms[it->second.slot] = transform;
+    scene_.transforms_dirty = true;
+    return true;
+}
+
+bool Renderer::setTileVisible(TileHandle tile, bool visible) {
+    auto it = scene_.tiles.find(tile);
+    if (it == scene_.tiles.end()) return false;
+    
+    it->second.visible = visible;
+    return true;
+}
+
+bool Renderer::removeTile(TileHandle tile) {
+    auto it = scene_.tiles.find(tile);
+    if (it == scene_.tiles.end()) return false;
+    
+    // The range is reused by later tiles; the buffers only grow
+    giveRange(scene_.free_ranges, it->second.first, it->second.count);
+    scene_.free_slots.push_back(it->second.slot);
+    scene_.tiles.erase(it);
+    return true;
+}
+
+void Renderer::uploadTile(SceneTile& tile, const PointCloud& cloud, const Octree* octree) {
+    // Same layouts as createVAO: octree order (leaf ranges, then samples) or cloud order
+    std::vector<uint32_t> order;
+    if (octree) {
+        order = octree->getIndices();
+        order.insert(order.end(), octree->getSamples().begin(), octree->getSamples().end());
+    }
+    const size_t count = octree ? order.size() : cloud.size();
+    
+    tile.count = static_cast<GLsizei>(count);
+    tile.first = 0;
+    tile.point_count = cloud.size();
+    tile.min_bound = cloud.getMinBound();
+    tile.max_bound = cloud.getMaxBound();
+    tile.octree = octree;
+    tile.octree_revision = octree ? octree->getRevision() : 0;
+    tile.sample_offset = octree ? static_cast<GLint>(octree->getIndices().size()) : 0;
+    if (count == 0) return;
+    
+    if (!takeRange(scene_.free_ranges, tile.count, tile.first)) {
+        growSceneBuffers(std::max(scene_.capacity + count, std::max(2 * scene_.capacity, MIN_SCENE_CAPACITY)));
+        takeRange(scene_.free_ranges, tile.count, tile.first);
+    }
+    
+    // Cloud-order channels upload as they are
+    const std::vector<glm::vec3>* positions = &cloud.getPositions();
+    const std::vector<PackedColor>* colors = &cloud.getColors();
+    std::vector<glm::vec3> gathered_positions;
+    std::vector<PackedColor> gathered_colors;
+    if (octree) {
+        gathered_positions = gatherChannel(cloud.getPositions(), order);
+        positions = &gathered_positions;
+        if (cloud.hasColors()) {
+            gathered_colors = gatherChannel(cloud.getColors(), order);
+            colors = &gathered_colors;
+        }
+    }
+    if (!cloud.hasColors()) {
+        gathered_colors.assign(count, PackedColor{255, 255, 255, 255});
+        colors = &gathered_colors;
+    }
+    std::vector<uint8_t> tile_indices(count, static_cast<uint8_t>(tile.slot));
+    
+    const VAO& vao = scene_.vao;
+    const GLintptr first = tile.first;
+    glBindBuffer(GL_ARRAY_BUFFER, vao.vbo_positions);
+    glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(glm::vec3), count * sizeof(glm::vec3), positions->data());
     glBindBuffer(GL_ARRAY_BUFFER, vao.vbo_colors);
-    glBufferData(GL_ARRAY_BUFFER, colors.size() * sizeof(glm::vec3), 
-                 colors.data(), GL_DYNAMIC_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(PackedColor), count * sizeof(PackedColor), colors->data());
+    glBindBuffer(GL_ARRAY_BUFFER, vao.vbo_tiles);
+    glBufferSubData(GL_ARRAY_BUFFER, first, count, tile_indices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    stats_.uploaded_bytes += count * (sizeof(glm::vec3) + sizeof(PackedColor) + sizeof(uint8_t));
+}
+
+void Renderer::growSceneBuffers(size_t capacity) {
+    VAO vao;
+    vao.has_colors = true;
+    vao.has_normals = false;
+    vao.tile_transforms = true;
+    
+    glGenVertexArrays(1, &vao.vao);
+    glBindVertexArray(vao.vao);
+    
+    // Float positions and RGBA8 colours as in createVAO, plus a tile index per point
+    glGenBuffers(1, &vao.vbo_positions);
+    glBindBuffer(GL_ARRAY_BUFFER, vao.vbo_positions);
+    glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(glm::vec3), nullptr, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), nullptr);
+    glEnableVertexAttribArray(0);
+    
+    glGenBuffers(1, &vao.vbo_colors);
+    glBindBuffer(GL_ARRAY_BUFFER, vao.vbo_colors);
+    glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(PackedColor), nullptr, GL_STATIC_DRAW);
+    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PackedColor), nullptr);
+    glEnableVertexAttribArray(1);
     
-    // Update normal buffer
-    std::vector<glm::vec3> normals;
-    normals.reserve(indices.size());
-    for (size_t idx : indices) {
-        normals.push_back(cloud[idx].normal);
+    glGenBuffers(1, &vao.vbo_tiles);
+    glBindBuffer(GL_ARRAY_BUFFER, vao.vbo_tiles);
+    glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(uint8_t), nullptr, GL_STATIC_DRAW);
+    glVertexAttribIPointer(3, 1, GL_UNSIGNED_BYTE, sizeof(uint8_t), nullptr);
+    glEnableVertexAttribArray(3);
+    
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    
+    // Tiles keep their ranges: copy the old buffers over on the GPU
+    VAO& old = scene_.vao;
+    const size_t old_capacity = scene_.capacity;
+    if (old_capacity > 0) {
+        auto copy = [](GLuint source, GLuint target, size_t bytes) {
+            glBindBuffer(GL_COPY_READ_BUFFER, source);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, target);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, static_cast<GLsizeiptr>(bytes));
+        };
+        copy(old.vbo_positions, vao.vbo_positions, old_capacity * sizeof(glm::vec3));
+        copy(old.vbo_colors, vao.vbo_colors, old_capacity * sizeof(PackedColor));
+        copy(old.vbo_tiles, vao.vbo_tiles, old_capacity * sizeof(uint8_t));
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
     }
+    glDeleteVertexArrays(1, &old.vao);
+    glDeleteBuffers(1, &old.vbo_positions);
+    glDeleteBuffers(1, &old.vbo_colors);
+    glDeleteBuffers(1, &old.vbo_tiles);
+    
+    vao.point_count = capacity;
+    scene_.vao = vao;
+    scene_.capacity = capacity;
+    giveRange(scene_.free_ranges, static_cast<GLint>(old_capacity), static_cast<GLsizei>(capacity - old_capacity));
+}
+
+void Renderer::deleteScene() {
+    glDeleteVertexArrays(1, &scene_.vao.vao);
+    glDeleteBuffers(1, &scene_.vao.vbo_positions);
+    glDeleteBuffers(1, &scene_.vao.vbo_colors);
+    glDeleteBuffers(1, &scene_.vao.vbo_tiles);
+    glDeleteBuffers(1, &scene_.ubo_transforms);
+    scene_ = SceneBuffers();
+}
+
+void Renderer::acquireStreamingBuffers(const OutOfCoreOctree& octree) {
+    bool current = streaming_.octree == &octree && streaming_.capacity == streaming_budget_points_ &&
+                   streaming_.vao.has_colors == octree.hasColors() &&
+                   streaming_.vao.has_normals == octree.hasNormals();
+    if (current) return;
+    deleteStreamingBuffers();
+    
+    VAO& vao = streaming_.vao;
+    vao.has_colors = octree.hasColors();
+    vao.has_normals = octree.hasNormals();
+    
+    glGenVertexArrays(1, &vao.vao);
+    glBindVertexArray(vao.vao);
+    
+    // Same vertex formats as createVAO with float positions; storage only, filled per node
+    glGenBuffers(1, &vao.vbo_positions);
+    glBindBuffer(GL_ARRAY_BUFFER, vao.vbo_positions);
+    glBufferData(GL_ARRAY_BUFFER, streaming_budget_points_ * sizeof(glm::vec3), nullptr, GL_DYNAMIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), nullptr);
+    glEnableVertexAttribArray(0);
+    
+    glGenBuffers(1, &vao.vbo_colors);
+    glBindBuffer(GL_ARRAY_BUFFER, vao.vbo_colors);
+    if (vao.has_colors) {
+        glBufferData(GL_ARRAY_BUFFER, streaming_budget_points_ * sizeof(PackedColor), nullptr, GL_DYNAMIC_DRAW);
+        glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PackedColor), nullptr);
+        glEnableVertexAttribArray(1);
+    }
+    
+    glGenBuffers(1, &vao.vbo_normals);
     glBindBuffer(GL_ARRAY_BUFFER, vao.vbo_normals);
-    glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(glm::vec3), 
-                 normals.data(), GL_DYNAMIC_DRAW);
+    if (vao.has_normals) {
+        glBufferData(GL_ARRAY_BUFFER, streaming_budget_points_ * sizeof(PackedNormal), nullptr, GL_DYNAMIC_DRAW);
+        glVertexAttribPointer(2, 2, GL_SHORT, GL_TRUE, sizeof(PackedNormal), nullptr);
+        glEnableVertexAttribArray(2);
+    }
     
     glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    
+    streaming_.octree = &octree;
+    streaming_.capacity = streaming_budget_points_;
+    if (streaming_.capacity > 0) {
+        streaming_.free_ranges.emplace(0, static_cast<GLsizei>(streaming_.capacity));
+    }
 }
 
-void Renderer::setupShaders() {
-    point_shader_ = std::make_unique<Shader>("shaders/point.vert", "shaders/point.frag");
+void Renderer::deleteStreamingBuffers() {
+    glDeleteVertexArrays(1, &streaming_.vao.vao);
+    glDeleteBuffers(1, &streaming_.vao.vbo_positions);
+    glDeleteBuffers(1, &streaming_.vao.vbo_colors);
+    glDeleteBuffers(1, &streaming_.vao.vbo_normals);
+    streaming_ = StreamingBuffers();
 }
 
-void Renderer::calculateFrustumPlanes(const Camera& camera, Octree::FrustumPlanes& planes) {
-    glm::mat4 vp = camera.getProjectionMatrix() * camera.getViewMatrix();
+void Renderer::acquireStagingRing() {
+    // A region holds one frame's upload budget of every channel
+    size_t region_bytes = streaming_upload_points_ * (sizeof(glm::vec3) + sizeof(PackedColor) + sizeof(PackedNormal));
+    region_bytes = (region_bytes + 255) / 256 * 256;
+    if (!staging_supported_ || region_bytes == staging_.region_bytes) return;
+    deleteStagingRing();
+    if (region_bytes == 0) return;
     
-    // Extract frustum planes from view-projection matrix
-    // Left plane
-    planes[0] = glm::vec4(
-        vp[0][3] + vp[0][0],
-        vp[1][3] + vp[1][0],
-        vp[2][3] + vp[2][0],
-        vp[3][3] + vp[3][0]
-    );
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    const GLsizeiptr bytes = static_cast<GLsizeiptr>(region_bytes * STAGING_REGIONS);
+    glGenBuffers(1, &staging_.buffer);
+    glBindBuffer(GL_COPY_READ_BUFFER, staging_.buffer);
+    glBufferStorage(GL_COPY_READ_BUFFER, bytes, nullptr, flags);
+    staging_.mapped = static_cast<unsigned char*>(glMapBufferRange(GL_COPY_READ_BUFFER, 0, bytes, flags));
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    staging_.region_bytes = region_bytes;
     
-    // Right plane
-    planes[1] = glm::vec4(
-        vp[0][3] - vp[0][0],
-        vp[1][3] - vp[1][0],
-        vp[2][3] - vp[2][0],
-        vp[3][3] - vp[3][0]
-    );
+    if (!staging_.mapped) {
+        // Uploads go through glBufferSubData as without the extension
+        std::cerr << "Failed to map the staging buffer" << std::endl;
+        deleteStagingRing();
+        staging_supported_ = false;
+    }
+}
+
+void Renderer::deleteStagingRing() {
+    for (GLsync& fence : staging_.fences) {
+        if (fence) glDeleteSync(fence);
+    }
+    if (staging_.buffer) {
+        if (staging_.mapped) {
+            glBindBuffer(GL_COPY_READ_BUFFER, staging_.buffer);
+            glUnmapBuffer(GL_COPY_READ_BUFFER);
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        }
+        glDeleteBuffers(1, &staging_.buffer);
+    }
+    staging_ = StagingRing();
+}
+
+void Renderer::uploadStreaming(GLuint vbo, size_t offset, const void* data, size_t bytes) {
+    StagingRing& ring = staging_;
+    stats_.uploaded_bytes += bytes;
+    size_t padded = (bytes + 15) / 16 * 16;
+    if (!ring.mapped || ring.offset + padded > ring.region_bytes) {
+        // No ring, or a node larger than the upload budget
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferSubData(GL_ARRAY_BUFFER, offset, bytes, data);
+        return;
+    }
     
-    // Bottom plane
-    planes[2] = glm::vec4(
-        vp[0][3] + vp[0][1],
-        vp[1][3] + vp[1][1],
-        vp[2][3] + vp[2][1],
-        vp[3][3] + vp[3][1]
-    );
+    if (!ring.in_use) {
+        // First upload this frame: the GPU may still be copying out of this region
+        // from STAGING_REGIONS frames ago
+        GLsync& fence = ring.fences[ring.region];
+        if (fence) {
+            GLenum status = GL_TIMEOUT_EXPIRED;
+            while (status == GL_TIMEOUT_EXPIRED) {
+                status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);   // 1 ms
+            }
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+        ring.in_use = true;
+    }
     
-    // Top plane
-    planes[3] = glm::vec4(
-        vp[0][3] - vp[0][1],
-        vp[1][3] - vp[1][1],
-        vp[2][3] - vp[2][1],
-        vp[3][3] - vp[3][1]
-    );
+    const size_t source = ring.region * ring.region_bytes + ring.offset;
+    std::memcpy(ring.mapped + source, data, bytes);
+    glBindBuffer(GL_COPY_READ_BUFFER, ring.buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, vbo);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(source),
+                        static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(bytes));
+    ring.offset += padded;
+    stats_.staged_bytes += bytes;
+}
+
+void Renderer::finishStaging() {
+    StagingRing& ring = staging_;
+    if (!ring.in_use) return;
     
-    // Near plane
-    planes[4] = glm::vec4(
-        vp[0][3] + vp[0][2],
-        vp[1][3] + vp[1][2],
-        vp[2][3] + vp[2][2],
-        vp[3][3] + vp[3][2]
-    );
+    ring.fences[ring.region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    ring.region = (ring.region + 1) % STAGING_REGIONS;
+    ring.offset = 0;
+    ring.in_use = false;
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+bool Renderer::takeRange(FreeRanges& free_ranges, GLsizei count, GLint& first) {
+    // First fit
+    for (auto it = free_ranges.begin(); it != free_ranges.end(); ++it) {
+        if (it->second < count) continue;
+        first = it->first;
+        GLint rest_first = it->first + count;
+        GLsizei rest = it->second - count;
+        free_ranges.erase(it);
+        if (rest > 0) {
+            free_ranges.emplace(rest_first, rest);
+        }
+        return true;
+    }
+    return false;
+}
+
+void Renderer::giveRange(FreeRanges& free_ranges, GLint first, GLsizei count) {
+    if (count <= 0) return;
     
-    // Far plane
-    planes[5] = glm::vec4(
-        vp[0][3] - vp[0][2],
-        vp[1][3] - vp[1][2],
-        vp[2][3] - vp[2][2],
-        vp[3][3] - vp[3][2]
-    );
+    // Merge with the free neighbours on either side
+    auto next = free_ranges.lower_bound(first);
+    if (next != free_ranges.end() && first + count == next->first) {
+        count += next->second;
+        next = free_ranges.erase(next);
+    }
+    if (next != free_ranges.begin()) {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == first) {
+            prev->second += count;
+            return;
+        }
+    }
+    free_ranges.emplace(first, count);
+}
+
+bool Renderer::allocateStreaming(GLsizei count, GLint& first) {
+    if (count <= 0 || static_cast<size_t>(count) > streaming_.capacity) return false;
+    if (takeRange(streaming_.free_ranges, count, first)) return true;
     
-    // Normalize planes
-    for (auto& plane : planes) {
-        float length = glm::length(glm::vec3(plane));
-        plane /= length;
+    // Free least recently drawn nodes (never ones drawn this frame) until it fits
+    using Candidate = std::pair<uint64_t, uint32_t>;
+    std::vector<Candidate, ArenaAllocator<Candidate>> candidates{ArenaAllocator<Candidate>(frame_arena_)};
+    candidates.reserve(streaming_.slots.size());
+    for (const auto& slot : streaming_.slots) {
+        if (slot.second.last_used < streaming_.frame) {
+            candidates.emplace_back(slot.second.last_used, slot.first);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+    for (const auto& candidate : candidates) {
+        auto it = streaming_.slots.find(candidate.second);
+        releaseStreaming(it->second.first, it->second.count);
+        streaming_.slots.erase(it);
+        if (takeRange(streaming_.free_ranges, count, first)) return true;
     }
+    return false;
+}
+
+void Renderer::releaseStreaming(GLint first, GLsizei count) {
+    giveRange(streaming_.free_ranges, first, count);
+}
+
+void Renderer::bindVAOUniforms(const Shader& shader, const VAO& vao) {
+    shader.setBool("quantizedPositions", vao.quantized_positions);
+    if (vao.quantized_positions) {
+        glActiveTexture(GL_TEXTURE0 + RANGE_BASES_UNIT);
+        glBindTexture(GL_TEXTURE_BUFFER, vao.tex_range_bases);
+        glActiveTexture(GL_TEXTURE0 + RANGE_BOUNDS_UNIT);
+        glBindTexture(GL_TEXTURE_BUFFER, vao.tex_range_bounds);
+        glActiveTexture(GL_TEXTURE0);
+    }
+    shader.setBool("useTiles", vao.tile_transforms);
+    
+    // Absent channels read from constant attributes
+    if (!vao.has_colors) {
+        glVertexAttrib4f(1, 1.0f, 1.0f, 1.0f, 1.0f);
+    }
+    if (!vao.has_normals) {
+        glVertexAttrib2f(2, 0.0f, 0.0f);
+    }
+}
+
+void Renderer::setCameraUniforms(const Shader& shader, const Camera& camera) {
+    shader.setMat4("view", camera.getViewMatrix());
+    shader.setMat4("projection", camera.getProjectionMatrix());
+    shader.setFloat("pointSize", point_size_);
+}
+
+template<typename Draw>
+void Renderer::drawPoints(const VAO& vao, const Camera& camera, Draw draw) {
+    if (shading_ == Shading::BASIC || !acquireSplatTargets()) {
+        point_shader_->use();
+        setCameraUniforms(*point_shader_, camera);
+        point_shader_->setVec3("viewPos", camera.getPosition());
+        point_shader_->setBool("hasNormals", vao.has_normals);
+        bindVAOUniforms(*point_shader_, vao);
+        glBindVertexArray(vao.vao);
+        draw();
+        glBindVertexArray(0);
+        return;
+    }
+    
+    glBindFramebuffer(GL_FRAMEBUFFER, splat_targets_.framebuffer);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glBindVertexArray(vao.vao);
+    const float projection_scale = 0.5f * height_ * camera.getProjectionMatrix()[1][1];
+    
+    // Visibility: depth of the front surface, pushed back by a splat radius
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    splat_depth_shader_->use();
+    setCameraUniforms(*splat_depth_shader_, camera);
+    splat_depth_shader_->setFloat("projectionScale", projection_scale);
+    splat_depth_shader_->setFloat("depthOffset", 1.0f);
+    bindVAOUniforms(*splat_depth_shader_, vao);
+    draw();
+    
+    // Attributes: only fragments within that radius of the surface pass, and add up
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glDepthMask(GL_FALSE);
+    glDepthFunc(GL_LEQUAL);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE);
+    splat_shader_->use();
+    setCameraUniforms(*splat_shader_, camera);
+    splat_shader_->setFloat("projectionScale", projection_scale);
+    splat_shader_->setFloat("depthOffset", 0.0f);
+    bindVAOUniforms(*splat_shader_, vao);
+    draw();
+    glDisable(GL_BLEND);
+    glDepthFunc(GL_LESS);
+    glDepthMask(GL_TRUE);
+    glBindVertexArray(0);
+    
+    resolveEDL(camera);
+}
+
+bool Renderer::acquireSplatTargets() {
+    if (splat_targets_.framebuffer && splat_targets_.width == width_ && splat_targets_.height == height_) {
+        return true;
+    }
+    deleteSplatTargets();
+    
+    glGenTextures(1, &splat_targets_.accumulation);
+    glBindTexture(GL_TEXTURE_2D, splat_targets_.accumulation);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width_, height_, 0, GL_RGBA, GL_HALF_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    
+    glGenTextures(1, &splat_targets_.depth);
+    glBindTexture(GL_TEXTURE_2D, splat_targets_.depth);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F, width_, height_, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    
+    glGenFramebuffers(1, &splat_targets_.framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, splat_targets_.framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, splat_targets_.accumulation, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, splat_targets_.depth, 0);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    splat_targets_.width = width_;
+    splat_targets_.height = height_;
+    
+    if (!complete) {
+        // Points are drawn with basic shading from then on
+        std::cerr << "Failed to create the EDL framebuffer" << std::endl;
+        deleteSplatTargets();
+        shading_ = Shading::BASIC;
+        return false;
+    }
+    
+    if (fullscreen_vao_ == 0) {
+        glGenVertexArrays(1, &fullscreen_vao_);
+    }
+    return true;
+}
+
+void Renderer::deleteSplatTargets() {
+    glDeleteFramebuffers(1, &splat_targets_.framebuffer);
+    glDeleteTextures(1, &splat_targets_.accumulation);
+    glDeleteTextures(1, &splat_targets_.depth);
+    splat_targets_ = SplatTargets();
+}
+
+void Renderer::resolveEDL(const Camera& camera) {
+    // Every pixel is written, background included; the target's depth buffer keeps its clear
+    glBindFramebuffer(GL_FRAMEBUFFER, output_framebuffer_);
+    glDisable(GL_DEPTH_TEST);
+    
+    const glm::mat4 projection = camera.getProjectionMatrix();
+    edl_shader_->use();
+    edl_shader_->setInt("accumulation", 0);
+    edl_shader_->setInt("depthTexture", 1);
+    edl_shader_->setVec3("backgroundColor", background_color_);
+    edl_shader_->setVec3("projectionDepth", projection[2][2], projection[3][2], projection[2][3] != 0.0f ? 1.0f : 0.0f);
+    edl_shader_->setFloat("edlStrength", edl_strength_);
+    edl_shader_->setFloat("edlRadius", edl_radius_);
+    
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, splat_targets_.accumulation);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, splat_targets_.depth);
+    glBindVertexArray(fullscreen_vao_);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    
+    glEnable(GL_DEPTH_TEST);
+}
+
+bool Renderer::SceneKey::operator==(const SceneKey& other) const {
+    return octree == other.octree && revision == other.revision && vao == other.vao && shading == other.shading &&
+           point_size == other.point_size && lod_pixel_threshold == other.lod_pixel_threshold &&
+           use_lod == other.use_lod && use_frustum_culling == other.use_frustum_culling &&
+           max_point_budget == other.max_point_budget && background_color == other.background_color &&
+           width == other.width && height == other.height;
+}
+
+Renderer::SceneKey Renderer::getSceneKey(const Octree& octree, const VAO& vao) const {
+    SceneKey key;
+    key.octree = &octree;
+    key.revision = octree.getRevision();
+    key.vao = vao.vao;
+    key.shading = shading_;
+    key.point_size = point_size_;
+    key.lod_pixel_threshold = lod_pixel_threshold_;
+    key.use_lod = use_lod_;
+    key.use_frustum_culling = use_frustum_culling_;
+    key.max_point_budget = max_point_budget_;
+    key.background_color = background_color_;
+    key.width = width_;
+    key.height = height_;
+    return key;
+}
+
+Renderer::GuardBand Renderer::getGuardBand(const Octree& octree, const glm::vec3& position, const glm::mat4& view,
+                                           const glm::mat4& projection) const {
+    GuardBand guard;
+    guard.view = view;
+    guard.position = position;
+    
+    // Moving by d shifts every frustum plane by at most d; scaled by the distance to the
+    // cloud, which also bounds how much the LOD cut would change
+    if (!octree.getNodes().empty()) {
+        const auto& root = octree.getNodes()[0];
+        glm::vec3 outside = glm::max(glm::max(root.min_bound - position, position - root.max_bound), glm::vec3(0.0f));
+        float diagonal = glm::length(root.max_bound - root.min_bound);
+        guard.distance = reuse_.params.guard_band * std::max(glm::length(outside), 0.01f * diagonal);
+    }
+    
+    // Widening tan(fov / 2) by 1 + guard_band covers this much rotation on the narrower axis
+    const float widen = 1.0f + reuse_.params.guard_band;
+    const float tan_x = 1.0f / projection[0][0];
+    const float tan_y = 1.0f / projection[1][1];
+    guard.angle = std::min(std::atan(widen * tan_x) - std::atan(tan_x), std::atan(widen * tan_y) - std::atan(tan_y));
+    return guard;
+}
+
+bool Renderer::withinGuard(const GuardBand& guard, const Camera& camera) {
+    if (glm::length(camera.getPosition() - guard.position) > guard.distance) return false;
+    
+    // Angle of the rotation between the two views: cos = (trace(A^T B) - 1) / 2
+    glm::mat3 delta = glm::transpose(glm::mat3(guard.view)) * glm::mat3(camera.getViewMatrix());
+    float cosine = std::min(std::max((delta[0][0] + delta[1][1] + delta[2][2] - 1.0f) * 0.5f, -1.0f), 1.0f);
+    return std::acos(cosine) <= guard.angle;
+}
+
+bool Renderer::acquireReuseTargets() {
+    if (reuse_.framebuffers[0] && reuse_.width == width_ && reuse_.height == height_) return true;
+    deleteReuseTargets();
+    
+    bool complete = true;
+    for (int i = 0; i < 2; ++i) {
+        glGenTextures(1, &reuse_.colors[i]);
+        glBindTexture(GL_TEXTURE_2D, reuse_.colors[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width_, height_, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        
+        glGenTextures(1, &reuse_.depths[i]);
+        glBindTexture(GL_TEXTURE_2D, reuse_.depths[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F, width_, height_, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        
+        glGenFramebuffers(1, &reuse_.framebuffers[i]);
+        glBindFramebuffer(GL_FRAMEBUFFER, reuse_.framebuffers[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, reuse_.colors[i], 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, reuse_.depths[i], 0);
+        complete = complete && glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    reuse_.width = width_;
+    reuse_.height = height_;
+    
+    if (!complete) {
+        // Frames are drawn straight to the window from then on
+        std::cerr << "Failed to create the frame reuse framebuffers" << std::endl;
+        deleteReuseTargets();
+        reuse_.enabled = false;
+        return false;
+    }
+    
+    if (fullscreen_vao_ == 0) {
+        glGenVertexArrays(1, &fullscreen_vao_);
+    }
+    return true;
+}
+
+void Renderer::deleteReuseTargets() {
+    glDeleteFramebuffers(2, reuse_.framebuffers);
+    glDeleteTextures(2, reuse_.colors);
+    glDeleteTextures(2, reuse_.depths);
+    FrameReuse reset;
+    reset.enabled = reuse_.enabled;
+    reset.params = reuse_.params;
+    reuse_ = std::move(reset);
+}
+
+void Renderer::refineReuseImage(const VAO& vao, const Camera& camera, const CullingWorker::View& base) {
+    stats_.image_reused = true;
+    stats_.points_rendered = 0;
+    stats_.draw_calls = 0;
+    stats_.cull_time_ms = 0.0f;
+    
+    // Only LOD has finer cuts; the other modes are done once their exact cut is drawn
+    const int max_level = base.mode == CullingWorker::Mode::LOD ? reuse_.params.refine_levels : 0;
+    const int level = reuse_.level + 1;
+    stats_.refinement_level = std::max(std::min(reuse_.level, max_level), 0);
+    if (level > max_level) return;
+    
+    CullingWorker::View view = base;
+    view.lod.pixel_threshold = base.lod.pixel_threshold / static_cast<float>(1 << level);
+    if (base.lod.point_budget > 0) {
+        view.lod.point_budget = base.lod.point_budget * (level + 1);
+    }
+    CullingWorker::cull(view, reuse_.refined, profiler_);
+    const CullingWorker::Result& refined = reuse_.refined;
+    
+    ScopedTimer stage(profiler_, "draw");
+    gpu_timer_.begin("draw", profilerTime());
+    glBindFramebuffer(GL_FRAMEBUFFER, reuse_.framebuffers[reuse_.current]);
+    output_framebuffer_ = reuse_.framebuffers[reuse_.current];
+    if (shading_ == Shading::BASIC) {
+        // Points already in the image stay; draw what the finer cut adds
+        subtractRanges(refined.firsts, refined.counts, reuse_.drawn, draw_firsts_, draw_counts_);
+        drawPoints(vao, camera, [this]() {
+            if (!draw_counts_.empty()) {
+                glMultiDrawArrays(GL_POINTS, draw_firsts_.data(), draw_counts_.data(),
+                                  static_cast<GLsizei>(draw_counts_.size()));
+            }
+        });
+        appendRanges(draw_firsts_, draw_counts_, reuse_.drawn);
+        for (GLsizei count : draw_counts_) {
+            stats_.points_rendered += count;
+        }
+        stats_.draw_calls = draw_counts_.size();
+    } else {
+        // Splats blend over the whole front surface, so the cut is redrawn
+        glClearColor(background_color_.r, background_color_.g, background_color_.b, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        drawPoints(vao, camera, [&refined]() {
+            if (!refined.counts.empty()) {
+                glMultiDrawArrays(GL_POINTS, refined.firsts.data(), refined.counts.data(),
+                                  static_cast<GLsizei>(refined.counts.size()));
+            }
+        });
+        reuse_.drawn.clear();
+        appendRanges(refined.firsts, refined.counts, reuse_.drawn);
+        stats_.points_rendered = refined.point_count;
+        stats_.draw_calls = refined.counts.size();
+    }
+    output_framebuffer_ = 0;
+    gpu_timer_.end();
+    
+    reuse_.level = level;
+    stats_.refinement_level = level;
+    stats_.cull_time_ms = refined.cull_time_ms;
+}
+
+void Renderer::reprojectImage(int source, const glm::mat4& view_projection) {
+    // One point per pixel of the last image, moved to where its depth puts it in this view
+    reproject_shader_->use();
+    reproject_shader_->setMat4("reprojection", view_projection * glm::inverse(reuse_.projection * reuse_.view));
+    reproject_shader_->setInt("previousColor", 0);
+    reproject_shader_->setInt("previousDepth", 1);
+    
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, reuse_.colors[source]);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, reuse_.depths[source]);
+    glBindVertexArray(fullscreen_vao_);
+    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(reuse_.width) * reuse_.height);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Renderer::presentReuseImage() {
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, reuse_.framebuffers[reuse_.current]);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, reuse_.width, reuse_.height, 0, 0, reuse_.width, reuse_.height,
+                      GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void Renderer::setupShaders() {
+    point_shader_ = std::make_unique<Shader>("shaders/point.vert", "shaders/point.frag");
+    if (gpu_culling_supported_) {
+        cull_shader_ = std::make_unique<Shader>("shaders/cull.comp");
+    }
+    overlay_shader_ = std::make_unique<Shader>("shaders/overlay.vert", "shaders/overlay.frag");
+    splat_depth_shader_ = std::make_unique<Shader>("shaders/splat.vert", "shaders/splat_depth.frag");
+    splat_shader_ = std::make_unique<Shader>("shaders/splat.vert", "shaders/splat.frag");
+    edl_shader_ = std::make_unique<Shader>("shaders/edl.vert", "shaders/edl.frag");
+    reproject_shader_ = std::make_unique<Shader>("shaders/reproject.vert", "shaders/reproject.frag");
+    
+    // Every program reading positions gets the tile block and the dequantization
+    // tables; the samplers need their own units even while unused
+    for (Shader* shader : {point_shader_.get(), splat_depth_shader_.get(), splat_shader_.get()}) {
+        shader->setUniformBlock("Tiles", TILE_BLOCK_BINDING);
+        shader->use();
+        shader->setInt("rangeBases", RANGE_BASES_UNIT);
+        shader->setInt("rangeBounds", RANGE_BOUNDS_UNIT);
+    }
+    glUseProgram(0);
+}
+
+void Renderer::calculateFrustumPlanes(const Camera& camera, Octree::FrustumPlanes& planes) {
+    // Extract frustum planes from view-projection matrix
+    extractFrustumPlanes(camera.getProjectionMatrix() * camera.getViewMatrix(), planes);
 }
 
 } // namespace pcv
\ No newline at end of file
@@ -2,9 +2,16 @@
 
 #include "core/PointCloud.h"
 #include "core/Octree.h"
+#include "core/OutOfCoreOctree.h"
+#include "core/MemoryPool.h"
 #include "rendering/Camera.h"
+#include "rendering/CullingWorker.h"
+#include "rendering/GpuTimer.h"
 #include "rendering/Shader.h"
+#include "utils/Profiler.h"
+#include "utils/Timer.h"
 #include <GL/glew.h>
+#include <map>
 #include <memory>
 #include <unordered_map>
 
@@ -13,9 +20,20 @@ namespace pcv {
 struct RenderStatistics {
     size_t points_rendered = 0;
     size_t points_culled = 0;
-    float frame_time_ms = 0.0f;
-    float fps = 0.0f;
+    float frame_time_ms = 0.0f;       // CPU time in the render call; the GPU may still be drawing
+    float frame_interval_ms = 0.0f;   // Wall-clock time since the previous frame started
+    float gpu_time_ms = 0.0f;         // GPU time of the timed stages, a few frames old
+    float fps = 0.0f;                 // From frame_interval_ms
     size_t draw_calls = 0;
+    size_t scratch_allocations = 0;   // Per-frame arena use (out-of-core path)
+    size_t scratch_bytes = 0;
+    size_t point_budget = 0;          // LOD point budget for the frame (0 = none)
+    float cull_time_ms = 0.0f;        // CPU culling for the drawn set, on whichever thread ran it
+    size_t uploaded_bytes = 0;        // Vertex data sent to the GPU this frame
+    size_t staged_bytes = 0;          // Out-of-core uploads copied through the staging ring
+    bool image_reused = false;        // Frame reuse kept the last image instead of redrawing it
+    bool visible_set_reused = false;  // Frame reuse drew the cached visible set without culling
+    int refinement_level = 0;         // LOD levels refined into the kept image
 };
 
 class Renderer {
@@ -31,12 +49,127 @@ public:
     void render(const PointCloud& cloud, const Camera& camera);
     void renderWithOctree(const PointCloud& cloud, const Octree& octree, const Camera& camera);
     
+    // Draw the nodes an out-of-core octree has loaded for this view. Nodes are copied
+    // into fixed-size GPU buffers (at most the upload budget per frame) and stay there
+    // until the space is needed, least recently drawn first. Nodes still waiting for
+    // upload are skipped for the frame.
+    void renderOutOfCore(OutOfCoreOctree& octree, const Camera& camera);
+    void setStreamingBudget(size_t gpu_points, size_t upload_points_per_frame) {
+        streaming_budget_points_ = gpu_points;
+        streaming_upload_points_ = upload_points_per_frame;
+    }
+    
+    // Buffers for render() and renderWithOctree() are cached per cloud address and
+    // refreshed when the octree revision, channels or point count change. Release a
+    // cloud's buffers before destroying it, so a new cloud at the same address doesn't
+    // pick them up.
+    void releaseCloud(const PointCloud& cloud) { deleteVAO(cloud); }
+    
+    // Scene of clouds ("tiles", e.g. registered scans) drawn together in one frame. Each
+    // tile gets a range of vertex buffers shared by all tiles (grown as needed), its own
+    // model transform and visibility; renderScene() culls each tile in its own space and
+    // draws every visible one in a single multi-draw. Handles are never reused, so a
+    // removed tile's handle can't name a later one; calls with a stale handle return
+    // false. The cloud is copied at addTile(); a tile's octree must stay alive until the
+    // tile is removed or updated, and tiles whose octree changed aren't drawn until
+    // updateTile(). LOD assumes rigid or uniformly scaled transforms. The point budget
+    // and frame reuse don't apply to scenes.
+    using TileHandle = uint64_t;                // 0 = none
+    static constexpr size_t MAX_TILES = 256;    // Transforms fill GL 3.3's minimum 16 KB uniform block
+    TileHandle addTile(const PointCloud& cloud, const Octree* octree = nullptr,
+                       const glm::mat4& transform = glm::mat4(1.0f));
+    bool updateTile(TileHandle tile, const PointCloud& cloud, const Octree* octree = nullptr);
+    bool setTileTransform(TileHandle tile, const glm::mat4& transform);
+    bool setTileVisible(TileHandle tile, bool visible);
+    bool removeTile(TileHandle tile);
+    size_t getTileCount() const { return scene_.tiles.size(); }
+    void renderScene(const Camera& camera);
+    
     // Settings
     void setPointSize(float size) { point_size_ = size; }
     void setBackgroundColor(const glm::vec3& color) { background_color_ = color; }
     void enableLOD(bool enable) { use_lod_ = enable; }
+    void setLODPixelThreshold(float pixels) { lod_pixel_threshold_ = pixels; }
+    
+    // Most points drawn per frame with LOD (0 = no cap): the LOD cut is refined coarsest
+    // node first, by projected sample spacing, until the budget is spent. Applies to
+    // CPU-culled octree rendering.
+    void setPointBudget(size_t points) {
+        max_point_budget_ = points;
+        point_budget_ = points;
+    }
+    
+    // Adjust the point budget every frame from the measured frame interval so frames
+    // take about this long, e.g. 16.7 ms for 60 FPS or 11.1 ms for 90 (0 = off). The
+    // budget stays at or below setPointBudget() if one was set.
+    void setTargetFrameTime(float ms) { target_frame_time_ms_ = ms; }
     void enableFrustumCulling(bool enable) { use_frustum_culling_ = enable; }
     
+    // Point shading. BASIC draws lit round sprites in one pass, discarding outside the
+    // circle. EDL splats in three passes: square sprites into depth only, then colours
+    // weighted towards the sprite centre and blended over the front surface, then a
+    // screen-space eye-dome lighting resolve that shades by depth differences between
+    // neighbouring pixels. No pass discards, so early depth testing keeps shading close
+    // to one fragment per pixel, and normals aren't needed.
+    enum class Shading { BASIC, EDL };
+    void setShading(Shading shading) { shading_ = shading; }
+    Shading getShading() const { return shading_; }
+    
+    // EDL response (0 = blended splats without lighting) and neighbour distance in pixels
+    void setEDLStrength(float strength) { edl_strength_ = strength; }
+    void setEDLRadius(float pixels) { edl_radius_ = pixels; }
+    
+    // Cull octree nodes and select LOD in a compute shader that writes the indirect draw
+    // commands, leaving no per-frame culling work on the CPU. Needs a GL 4.3 context;
+    // without one the CPU path is used. Point counts are then not known on the CPU.
+    void enableGPUCulling(bool enable) { use_gpu_culling_ = enable; }
+    bool isGPUCullingSupported() const { return gpu_culling_supported_; }
+    
+    // Cull on a worker thread: each frame draws the set culled from the previous frame's
+    // camera and posts the current camera for the next one, so CPU culling overlaps GL
+    // submission at the cost of one frame of culling latency. Sets culled for another
+    // octree revision are dropped and the frame is culled in place instead. The worker
+    // reads the octree, so call waitForCulling() before modifying it.
+    void enableAsyncCulling(bool enable);
+    void waitForCulling();
+    
+    // Reuse work between frames while the camera is still or moving slowly (octree
+    // rendering with CPU culling). The scene is drawn into an offscreen image that is
+    // copied to the window:
+    // - A still camera keeps the image and refines it by one LOD level (half the pixel
+    //   threshold, or one more point budget) per frame up to refine_levels, drawing only
+    //   the vertex ranges the finer cut adds; after that frames are copied, not drawn.
+    // - Small motion draws the visible set cached from an earlier cull with a guard band
+    //   around the frustum instead of culling again, over the previous image reprojected
+    //   to the new view, so refined detail stays until the fresh cut covers it.
+    // With EDL shading each refinement step redraws the whole cut and nothing is
+    // reprojected. Async culling keeps its own sets; only the image is reused then.
+    struct FrameReuseParameters {
+        int refine_levels;    // LOD levels added while the camera is still
+        float guard_band;     // Cached sets cover a frustum this fraction wider, moved out by
+                              // this fraction of the camera's distance to the cloud
+        
+        FrameReuseParameters() : refine_levels(3), guard_band(0.05f) {}
+    };
+    void enableFrameReuse(bool enable, const FrameReuseParameters& params = FrameReuseParameters());
+    
+    // Upload octree-ordered positions as 16-bit values within the bounds of their octree
+    // node, plus a 16-bit node range index: 8 bytes a point instead of 12, with
+    // precision that follows the node size (applies to new buffers; cloud order,
+    // scenes and out-of-core buffers stay float)
+    void enablePositionQuantization(bool enable) { quantize_positions_ = enable; }
+    
+    // Report CPU stages (cull, gather, upload, draw) and GL timer query results for
+    // the GPU ones to profiler (null = off). The profiler must outlive the renderer or
+    // be detached first.
+    void setProfiler(Profiler* profiler);
+    
+    // Bars for the profiler's stages over the scene: p50 solid, p95 as a thin line,
+    // CPU stages above GPU ones, scaled so the marker line is the target frame time
+    // (or 60 FPS). Call after the scene is rendered.
+    void enableProfilerOverlay(bool enable) { show_overlay_ = enable; }
+    void renderProfilerOverlay();
+    
     // Window management
     void resize(int width, int height);
     
@@ -49,7 +182,27 @@ private:
     float point_size_ = 2.0f;
     glm::vec3 background_color_{0.1f, 0.1f, 0.1f};
     bool use_lod_ = true;
+    float lod_pixel_threshold_ = 2.0f;
     bool use_frustum_culling_ = true;
+    bool quantize_positions_ = false;
+    bool use_gpu_culling_ = false;
+    bool gpu_culling_supported_ = false;
+    bool staging_supported_ = false;
+    size_t max_point_budget_ = 0;
+    size_t point_budget_ = 0;
+    float target_frame_time_ms_ = 0.0f;
+    float smoothed_frame_ms_ = 0.0f;     // Frame interval, exponentially smoothed
+    Timer frame_interval_timer_;
+    bool frame_started_ = false;
+    bool point_budget_started_ = false;
+    Profiler* profiler_ = nullptr;
+    GpuTimer gpu_timer_;
+    bool show_overlay_ = false;
+    Shading shading_ = Shading::BASIC;
+    float edl_strength_ = 1.0f;
+    float edl_radius_ = 1.4f;
+    size_t streaming_budget_points_ = size_t(16) << 20;
+    size_t streaming_upload_points_ = size_t(1) << 20;
     
     // OpenGL resources
     struct VAO {
@@ -58,19 +211,270 @@ private:
         GLuint vbo_colors = 0;
         GLuint vbo_normals = 0;
         size_t point_count = 0;
+        
+        // Octree-ordered buffers hold the octree's index buffer followed by its LOD
+        // samples, so visible spans draw straight from them; null for cloud order
+        const Octree* octree = nullptr;
+        uint64_t octree_revision = 0;
+        GLint sample_offset = 0;
+        
+        // GPU culling: one CullNode and one indirect draw command per octree node
+        GLuint ssbo_nodes = 0;
+        GLuint ibo_commands = 0;
+        GLsizei node_count = 0;
+        
+        // Scene buffers: a per-point tile index selects the model transform
+        GLuint vbo_tiles = 0;
+        bool tile_transforms = false;
+        
+        // Vertex formats chosen at creation
+        bool quantized_positions = false;
+        bool has_colors = true;
+        bool has_normals = true;
+        
+        // Quantized positions: node range of each 2^RANGE_WINDOW_BITS-vertex window's
+        // first vertex (R32UI), and per range the node's min bound and extent (RGBA32F)
+        GLuint tbo_range_bases = 0;
+        GLuint tex_range_bases = 0;
+        GLuint tbo_range_bounds = 0;
+        GLuint tex_range_bounds = 0;
+    };
+    
+    // Quantized position within its node and the node's range index from its window's base
+    struct QuantizedVertex {
+        QuantizedPosition position;
+        uint16_t range;
+    };
+    static constexpr int RANGE_WINDOW_BITS = 16;
+    static constexpr GLint RANGE_BASES_UNIT = 4;     // Texture units of the range tables
+    static constexpr GLint RANGE_BOUNDS_UNIT = 5;
+    
+    // Octree node as read by shaders/cull.comp (std430)
+    struct CullNode {
+        glm::vec4 min_bound;     // w: LOD sample spacing
+        glm::vec4 max_bound;
+        uint32_t parent;         // 0xFFFFFFFF for the root and dead slots
+        uint32_t leaf;
+        uint32_t first;          // Leaf points or interior samples in the vertex buffers
+        uint32_t count;
     };
     
+    // Free vertex ranges of a shared buffer set, first point -> count, coalesced. Nodes
+    // come and go every frame while streaming, so they come from a slab pool.
+    using FreeRanges = std::map<GLint, GLsizei, std::less<GLint>, PoolAllocator<std::pair<const GLint, GLsizei>>>;
+    static bool takeRange(FreeRanges& free_ranges, GLsizei count, GLint& first);
+    static void giveRange(FreeRanges& free_ranges, GLint first, GLsizei count);
+    
+    // Out-of-core node storage: one buffer set of budget points carved up first-fit
+    struct StreamingSlot {
+        GLint first;
+        GLsizei count;
+        uint64_t last_used;   // Frame that last drew it
+    };
+    
+    struct StreamingBuffers {
+        VAO vao;
+        const OutOfCoreOctree* octree = nullptr;
+        size_t capacity = 0;
+        // Both change every frame while streaming, so their nodes come from slab pools
+        FreeRanges free_ranges;
+        std::unordered_map<uint32_t, StreamingSlot, std::hash<uint32_t>, std::equal_to<uint32_t>,
+                           PoolAllocator<std::pair<const uint32_t, StreamingSlot>>> slots;   // Uploaded nodes
+        uint64_t frame = 0;
+    };
+    
+    // Persistent-mapped upload buffer for streamed nodes, split into one region per frame
+    // in flight. Node data is copied into the current region and from there into the
+    // vertex buffers on the GPU; a fence per region tells when it may be written again.
+    static constexpr size_t STAGING_REGIONS = 3;
+    struct StagingRing {
+        GLuint buffer = 0;
+        unsigned char* mapped = nullptr;
+        size_t region_bytes = 0;
+        GLsync fences[STAGING_REGIONS] = {};
+        size_t region = 0;
+        size_t offset = 0;       // Into the current region
+        bool in_use = false;     // Current region written this frame
+    };
+    
+    // A tile's range of the scene buffers: octree order (indices, then samples) when it
+    // has an octree, cloud order otherwise
+    struct SceneTile {
+        uint32_t slot = 0;              // Transform index and per-point tile index
+        GLint first = 0;
+        GLsizei count = 0;
+        size_t point_count = 0;         // Cloud points; count also holds LOD samples
+        glm::vec3 min_bound{0.0f};      // Tile space
+        glm::vec3 max_bound{0.0f};
+        const Octree* octree = nullptr;
+        uint64_t octree_revision = 0;
+        GLint sample_offset = 0;        // From first
+        bool visible = true;
+    };
+    
+    struct SceneBuffers {
+        VAO vao;                        // Float positions, RGBA8 colours, tile indices; no normals
+        size_t capacity = 0;
+        FreeRanges free_ranges;
+        std::unordered_map<TileHandle, SceneTile> tiles;
+        TileHandle next_handle = 1;
+        std::vector<uint32_t> free_slots;
+        std::vector<glm::mat4> transforms;     // By slot
+        bool transforms_dirty = false;
+        GLuint ubo_transforms = 0;      // Bound to TILE_BLOCK_BINDING for every point shader
+        CullingWorker::Result culled;   // Scratch for one tile
+    };
+    static constexpr GLuint TILE_BLOCK_BINDING = 0;
+    static constexpr size_t MIN_SCENE_CAPACITY = size_t(1) << 20;
+    
     std::unordered_map<const PointCloud*, VAO> vaos_;
+    SceneBuffers scene_;
+    StreamingBuffers streaming_;
+    StagingRing staging_;
+    std::unique_ptr<CullingWorker> culling_worker_;
     std::unique_ptr<Shader> point_shader_;
+    std::unique_ptr<Shader> cull_shader_;
+    std::unique_ptr<Shader> overlay_shader_;
+    GLuint overlay_vao_ = 0;
+    GLuint overlay_vbo_ = 0;
+    
+    // Overlay bar corner, in pixels from the bottom left
+    struct OverlayVertex {
+        glm::vec2 position;
+        glm::vec4 color;
+    };
+    std::vector<OverlayVertex> overlay_vertices_;
+    
+    // Offscreen targets of EDL shading, sized to the viewport
+    struct SplatTargets {
+        GLuint framebuffer = 0;
+        GLuint accumulation = 0;    // RGBA16F: weighted colour sum, weight sum
+        GLuint depth = 0;           // DEPTH_COMPONENT32F
+        int width = 0;
+        int height = 0;
+    };
+    SplatTargets splat_targets_;
+    std::unique_ptr<Shader> splat_depth_shader_;
+    std::unique_ptr<Shader> splat_shader_;
+    std::unique_ptr<Shader> edl_shader_;
+    GLuint fullscreen_vao_ = 0;
+    GLuint output_framebuffer_ = 0;     // Where EDL resolves: the window or the reuse image
+    
+    // Settings an image depends on besides the camera
+    struct SceneKey {
+        const Octree* octree = nullptr;
+        uint64_t revision = 0;
+        GLuint vao = 0;
+        Shading shading = Shading::BASIC;
+        float point_size = 0.0f;
+        float lod_pixel_threshold = 0.0f;
+        bool use_lod = false;
+        bool use_frustum_culling = false;
+        size_t max_point_budget = 0;
+        glm::vec3 background_color{0.0f};
+        int width = 0;
+        int height = 0;
+        
+        bool operator==(const SceneKey& other) const;
+    };
+    
+    // Camera motion a cached visible set or a reprojection still covers
+    struct GuardBand {
+        glm::mat4 view{1.0f};
+        glm::vec3 position{0.0f};
+        float distance = 0.0f;
+        float angle = 0.0f;         // Radians
+    };
+    
+    // Two images, so the last one can be reprojected into the other
+    struct FrameReuse {
+        bool enabled = false;
+        FrameReuseParameters params;
+        GLuint framebuffers[2] = {};
+        GLuint colors[2] = {};      // RGBA8
+        GLuint depths[2] = {};      // DEPTH_COMPONENT32F
+        int width = 0;
+        int height = 0;
+        int current = 0;            // Holds the last image
+        
+        bool image_valid = false;
+        SceneKey key;
+        glm::mat4 view{1.0f};       // Camera the image was drawn with
+        glm::mat4 projection{1.0f};
+        glm::vec3 position{0.0f};
+        int level = -1;             // LOD levels refined in; -1 until an exact cut for the camera
+        std::vector<std::pair<GLint, GLsizei>> drawn;   // Vertex ranges in the image, sorted and merged
+        
+        bool set_valid = false;     // visible_set_ was culled with set_guard
+        GuardBand set_guard;
+        CullingWorker::Result refined;
+    };
+    FrameReuse reuse_;
+    std::unique_ptr<Shader> reproject_shader_;
+    size_t cut_points_ = 0;         // Points in the last full cut, for the budget feedback
+    
+    // Per-frame draw lists, kept to reuse their storage
+    CullingWorker::Result visible_set_;
+    std::vector<GLint> draw_firsts_;
+    std::vector<GLsizei> draw_counts_;
+    std::vector<uint32_t> draw_nodes_;
+    
+    // Scratch memory for one frame, reset when the next one starts
+    Arena frame_arena_;
     
     // Statistics
     RenderStatistics stats_;
     
     // Helper functions
-    void createVAO(const PointCloud& cloud);
-    void updateVAO(const PointCloud& cloud, const std::vector<size_t>& indices);
+    const VAO& acquireVAO(const PointCloud& cloud, const Octree* octree);
+    void createVAO(const PointCloud& cloud, const Octree* octree);
+    bool createQuantizedPositions(VAO& vao, const PointCloud& cloud, const Octree& octree,
+                                  const std::vector<uint32_t>& order);
+    void createCullBuffers(VAO& vao, const Octree& octree);
+    void cullOnGPU(const VAO& vao, const Octree::FrustumPlanes& frustum,
+                   const Camera& camera, bool use_lod);
     void deleteVAO(const PointCloud& cloud);
     
+    void growSceneBuffers(size_t capacity);
+    void deleteScene();
+    void uploadTile(SceneTile& tile, const PointCloud& cloud, const Octree* octree);
+    void bindVAOUniforms(const Shader& shader, const VAO& vao);
+    void setCameraUniforms(const Shader& shader, const Camera& camera);
+    
+    // Draw with the current shading; draw() issues the draw calls for the bound VAO and
+    // runs once per pass
+    template<typename Draw>
+    void drawPoints(const VAO& vao, const Camera& camera, Draw draw);
+    bool acquireSplatTargets();
+    void deleteSplatTargets();
+    void resolveEDL(const Camera& camera);
+    
+    SceneKey getSceneKey(const Octree& octree, const VAO& vao) const;
+    GuardBand getGuardBand(const Octree& octree, const glm::vec3& position, const glm::mat4& view,
+                           const glm::mat4& projection) const;
+    static bool withinGuard(const GuardBand& guard, const Camera& camera);
+    bool acquireReuseTargets();
+    void deleteReuseTargets();
+    void refineReuseImage(const VAO& vao, const Camera& camera, const CullingWorker::View& view);
+    void reprojectImage(int source, const glm::mat4& view_projection);
+    void presentReuseImage();
+    
+    void acquireStreamingBuffers(const OutOfCoreOctree& octree);
+    void deleteStreamingBuffers();
+    bool allocateStreaming(GLsizei count, GLint& first);
+    void releaseStreaming(GLint first, GLsizei count);
+    void acquireStagingRing();
+    void deleteStagingRing();
+    void uploadStreaming(GLuint vbo, size_t offset, const void* data, size_t bytes);
+    void finishStaging();
+    
+    static constexpr size_t MIN_POINT_BUDGET = size_t(1) << 16;
+    static constexpr size_t DEFAULT_POINT_BUDGET = size_t(4) << 20;
+    void updatePointBudget();
+    void beginFrame();
+    double profilerTime() const { return profiler_ ? profiler_->now() : 0.0; }
+    void addOverlayBar(float x, float y, float width, float height, const glm::vec4& color);
+    
     void setupShaders();
     void calculateFrustumPlanes(const Camera& camera, Octree::FrustumPlanes& planes);
 };
@@ -38,6 +38,25 @@ Shader::Shader(const std::string& vertexPath, const std::string& fragmentPath) {
     glDeleteShader(fragment);
 }
 
+Shader::Shader(const std::string& computePath) {
+    std::string computeCode = readFile(computePath);
+    const char* cShaderCode = computeCode.c_str();
+    
+    // Compile compute shader
+    GLuint compute = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(compute, 1, &cShaderCode, nullptr);
+    glCompileShader(compute);
+    checkCompileErrors(compute, "COMPUTE");
+    
+    // Create shader program
+    program_ = glCreateProgram();
+    glAttachShader(program_, compute);
+    glLinkProgram(program_);
+    checkCompileErrors(program_, "PROGRAM");
+    
+    glDeleteShader(compute);
+}
+
 Shader::~Shader() {
     glDeleteProgram(program_);
 }
@@ -94,6 +113,13 @@ void Shader::setMat4(const std::string& name, const glm::mat4& mat) const {
     glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, glm::value_ptr(mat));
 }
 
+void Shader::setUniformBlock(const std::string& name, GLuint binding) const {
+    GLuint index = glGetUniformBlockIndex(program_, name.c_str());
+    if (index != GL_INVALID_INDEX) {
+        glUniformBlockBinding(program_, index, binding);
+    }
+}
+
 std::string Shader::readFile(const std::string& filePath) {
     std::ifstream file(filePath);
     if (!file.is_open()) {
@@ -11,6 +11,9 @@ class Shader {
 public:
     // Constructor reads and builds the shader
     Shader(const std::string& vertexPath, const std::string& fragmentPath);
+    
+    // Compute shader program (needs a GL 4.3 context)
+    explicit Shader(const std::string& computePath);
     ~Shader();
     
     // Use/activate the shader
@@ -30,6 +33,9 @@ public:
     void setMat3(const std::string& name, const glm::mat3& mat) const;
     void setMat4(const std::string& name, const glm::mat4& mat) const;
     
+    // Bind a uniform block to a buffer binding point (no-op if the program lacks it)
+    void setUniformBlock(const std::string& name, GLuint binding) const;
+    
     // Get program ID
     GLuint getProgram() const { return program_; }
     
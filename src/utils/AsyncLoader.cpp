@@ -0,0 +1,224 @@
+#include "utils/AsyncLoader.h"
+#include "utils/Parallel.h"
+#include <algorithm>
+#include <iostream>
+
+namespace pcv {
+
+AsyncLoader::AsyncLoader(const Parameters& params) : params_(params) {
+    params_.chunk_size = std::max<size_t>(params_.chunk_size, 4096);
+}
+
+AsyncLoader::~AsyncLoader() {
+    cancel();
+}
+
+bool AsyncLoader::start(const std::string& filename, FileIO::Format format) {
+    if (!workers_.empty()) {
+        std::cerr << "AsyncLoader already started" << std::endl;
+        return false;
+    }
+    
+    filename_ = filename;
+    format_ = format == FileIO::Format::AUTO ? FileIO::getFormatFromExtension(filename) : format;
+    
+    file_.open(filename, std::ios::binary);
+    if (!file_.is_open()) {
+        std::cerr << "Failed to open file: " << filename << std::endl;
+        return false;
+    }
+    
+    file_.seekg(0, std::ios::end);
+    bytes_total_ = static_cast<size_t>(file_.tellg());
+    file_.seekg(0, std::ios::beg);
+    
+    if (!readHeader()) {
+        file_.close();
+        return false;
+    }
+    
+    if (!streaming_) {
+        // No chunked parser for this format - load it whole in the background
+        file_.close();
+        active_workers_ = 1;
+        workers_.emplace_back(&AsyncLoader::wholeFileWorker, this);
+        return true;
+    }
+    
+    size_t num_threads = resolveThreadCount(static_cast<size_t>(params_.num_threads));
+    active_workers_ = num_threads;
+    for (size_t t = 0; t < num_threads; ++t) {
+        workers_.emplace_back(&AsyncLoader::streamWorker, this);
+    }
+    return true;
+}
+
+void AsyncLoader::cancel() {
+    cancelled_ = true;
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+AsyncLoader::Progress AsyncLoader::getProgress() const {
+    Progress progress;
+    progress.bytes_read = bytes_read_;
+    progress.bytes_total = bytes_total_;
+    progress.points_parsed = points_parsed_;
+    progress.finished = !workers_.empty() && active_workers_ == 0;
+    progress.failed = failed_;
+    return progress;
+}
+
+size_t AsyncLoader::poll(PointCloud& cloud) {
+    // Take the consecutive run of finished chunks
+    std::vector<PointCloud> batches;
+    {
+        std::lock_guard<std::mutex> lock(ready_mutex_);
+        auto it = ready_.begin();
+        while (it != ready_.end() && it->first == next_poll_sequence_) {
+            batches.push_back(std::move(it->second));
+            it = ready_.erase(it);
+            next_poll_sequence_++;
+        }
+    }
+    
+    size_t appended = 0;
+    for (auto& batch : batches) {
+        // Lines past the header's vertex count (e.g. PLY faces) are not points
+        if (points_polled_ >= layout_.max_points) break;
+        if (batch.size() > layout_.max_points - points_polled_) {
+            batch.resize(layout_.max_points - points_polled_);
+        }
+        if (batch.empty()) continue;
+        
+        if (params_.recenter) {
+            if (!has_offset_) {
+                offset_ = -batch.getCenter();
+                has_offset_ = true;
+            }
+            batch.translateCentroid(batch.getCenter() + offset_);
+        }
+        
+        cloud.append(batch);
+        points_polled_ += batch.size();
+        appended += batch.size();
+    }
+    return appended;
+}
+
+bool AsyncLoader::readHeader() {
+    if (format_ == FileIO::Format::PLY) {
+        if (!FileIO::readPLYHeader(file_, layout_, streaming_)) {
+            std::cerr << "Invalid PLY header: " << filename_ << std::endl;
+            return false;
+        }
+        return true;
+    }
+    
+    if (format_ == FileIO::Format::PCD) {
+        if (!FileIO::readPCDHeader(file_, layout_, streaming_)) {
+            std::cerr << "Invalid PCD header: " << filename_ << std::endl;
+            return false;
+        }
+        return true;
+    }
+    
+    if (format_ == FileIO::Format::PCVC) {
+        streaming_ = false; // Binary cache, loaded whole
+        return true;
+    }
+    
+    // Headerless text; unknown extensions are read as XYZ like PointCloud::loadFromFile
+    layout_ = TextParser::xyzLayout();
+    streaming_ = true;
+    return true;
+}
+
+bool AsyncLoader::readChunk(std::string& chunk, size_t& sequence) {
+    std::lock_guard<std::mutex> lock(read_mutex_);
+    
+    while (!end_of_file_ && !cancelled_) {
+        // Continue from the partial line left by the previous chunk
+        chunk.swap(carry_);
+        carry_.clear();
+        size_t carried = chunk.size();
+        chunk.resize(carried + params_.chunk_size);
+        file_.read(&chunk[carried], static_cast<std::streamsize>(params_.chunk_size));
+        size_t count = static_cast<size_t>(file_.gcount());
+        chunk.resize(carried + count);
+        bytes_read_ += count;
+        
+        if (file_.bad()) {
+            failed_ = true;
+            return false;
+        }
+        
+        if (count < params_.chunk_size) {
+            end_of_file_ = true;
+        } else {
+            size_t last_newline = chunk.find_last_of('\n');
+            if (last_newline == std::string::npos) {
+                carry_.swap(chunk); // A line longer than a chunk - keep reading
+                continue;
+            }
+            carry_.assign(chunk, last_newline + 1, std::string::npos);
+            chunk.resize(last_newline + 1);
+        }
+        
+        sequence = next_read_sequence_++;
+        return true;
+    }
+    return false;
+}
+
+void AsyncLoader::parseChunk(const std::string& chunk, PointCloud& batch) const {
+    // Chunks already run in parallel, so each one is parsed serially.
+    // poll() applies the vertex count across chunks.
+    batch.setChannels(PointCloud::POSITION);
+    TextParser::Layout layout = layout_;
+    layout.max_points = static_cast<size_t>(-1);
+    TextParser::parse(chunk.data(), chunk.data() + chunk.size(), layout, batch, 1);
+}
+
+void AsyncLoader::streamWorker() {
+    try {
+        std::string chunk;
+        size_t sequence = 0;
+        while (readChunk(chunk, sequence)) {
+            PointCloud batch;
+            parseChunk(chunk, batch);
+            points_parsed_ += batch.size();
+            
+            std::lock_guard<std::mutex> lock(ready_mutex_);
+            ready_.emplace(sequence, std::move(batch));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to load " << filename_ << ": " << e.what() << std::endl;
+        failed_ = true;
+        cancelled_ = true;
+    }
+    active_workers_--;
+}
+
+void AsyncLoader::wholeFileWorker() {
+    try {
+        PointCloud batch;
+        if (!FileIO::load(filename_, batch, format_)) {
+            failed_ = true;
+        }
+        bytes_read_ = bytes_total_;
+        points_parsed_ = batch.size();
+        
+        std::lock_guard<std::mutex> lock(ready_mutex_);
+        ready_.emplace(0, std::move(batch));
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to load " << filename_ << ": " << e.what() << std::endl;
+        failed_ = true;
+    }
+    active_workers_--;
+}
+
+} // namespace pcv
\ No newline at end of file
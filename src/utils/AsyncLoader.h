@@ -0,0 +1,99 @@
+#pragma once
+
+#include "core/PointCloud.h"
+#include "utils/FileIO.h"
+#include "utils/TextParser.h"
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pcv {
+
+// Background point cloud loader.
+// ASCII XYZ/PLY/PCD files are read in line-aligned chunks that worker threads parse
+// concurrently; other files are loaded whole on one worker. poll() hands parsed
+// batches over in file order, so the caller can grow its cloud (and octree) and keep
+// rendering while the rest of the file is still being read.
+class AsyncLoader {
+public:
+    struct Parameters {
+        size_t chunk_size;   // Bytes read per parse task
+        int num_threads;     // Parse workers (0 = all hardware threads)
+        bool recenter;       // Shift every point by the offset that centers the first batch
+        
+        Parameters() : chunk_size(size_t(8) << 20), num_threads(0), recenter(false) {}
+    };
+    
+    struct Progress {
+        size_t bytes_read = 0;
+        size_t bytes_total = 0;
+        size_t points_parsed = 0;
+        bool finished = false;   // No more batches will be produced (done, failed or cancelled)
+        bool failed = false;
+    };
+    
+    explicit AsyncLoader(const Parameters& params = Parameters());
+    ~AsyncLoader();
+    
+    AsyncLoader(const AsyncLoader&) = delete;
+    AsyncLoader& operator=(const AsyncLoader&) = delete;
+    
+    // Open the file, read its header and start the workers. Returns false if the
+    // file cannot be opened or its header is invalid.
+    bool start(const std::string& filename, FileIO::Format format = FileIO::Format::AUTO);
+    
+    // Stop reading and wait for the workers; batches parsed so far can still be polled
+    void cancel();
+    
+    Progress getProgress() const;
+    
+    // Append every batch that is ready (in file order) to cloud.
+    // Returns the number of points appended. Call from the thread that owns cloud.
+    size_t poll(PointCloud& cloud);
+    
+    // Translation applied to loaded points when recentering
+    const glm::vec3& getOffset() const { return offset_; }
+    
+private:
+    Parameters params_;
+    std::string filename_;
+    FileIO::Format format_ = FileIO::Format::AUTO;
+    TextParser::Layout layout_;     // Columns and vertex count from the header
+    bool streaming_ = false;
+    
+    // Reader state, shared by the workers
+    std::mutex read_mutex_;
+    std::ifstream file_;
+    std::string carry_;              // Partial last line of the previous chunk
+    size_t next_read_sequence_ = 0;
+    bool end_of_file_ = false;
+    
+    // Parsed batches waiting for poll(), keyed by chunk sequence
+    mutable std::mutex ready_mutex_;
+    std::map<size_t, PointCloud> ready_;
+    size_t next_poll_sequence_ = 0;
+    size_t points_polled_ = 0;
+    
+    std::vector<std::thread> workers_;
+    std::atomic<size_t> active_workers_{0};
+    std::atomic<size_t> bytes_read_{0};
+    std::atomic<size_t> points_parsed_{0};
+    std::atomic<bool> cancelled_{false};
+    std::atomic<bool> failed_{false};
+    size_t bytes_total_ = 0;
+    
+    bool has_offset_ = false;
+    glm::vec3 offset_{0.0f};
+    
+    bool readHeader();
+    bool readChunk(std::string& chunk, size_t& sequence);
+    void parseChunk(const std::string& chunk, PointCloud& batch) const;
+    void streamWorker();
+    void wholeFileWorker();
+};
+
+} // namespace pcv
\ No newline at end of file
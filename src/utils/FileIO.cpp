@@ -1,12 +1,427 @@
 #include "utils/FileIO.h"
+#include "utils/LZF.h"
+#include "utils/MappedFile.h"
+#include "utils/PointCache.h"
+#include "utils/Parallel.h"
 #include <fstream>
 #include <sstream>
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <iomanip>
+#include <vector>
 
 namespace pcv {
 
+namespace {
+
+// Scalar types of binary PLY properties and PCD fields
+enum ScalarType { NONE, INT8, UINT8, INT16, UINT16, INT32, UINT32, FLOAT32, FLOAT64 };
+
+size_t scalarSize(ScalarType type) {
+    switch (type) {
+        case INT8: case UINT8: return 1;
+        case INT16: case UINT16: return 2;
+        case INT32: case UINT32: case FLOAT32: return 4;
+        case FLOAT64: return 8;
+        default: return 0;
+    }
+}
+
+ScalarType plyScalarType(const std::string& name) {
+    if (name == "char" || name == "int8") return INT8;
+    if (name == "uchar" || name == "uint8") return UINT8;
+    if (name == "short" || name == "int16") return INT16;
+    if (name == "ushort" || name == "uint16") return UINT16;
+    if (name == "int" || name == "int32") return INT32;
+    if (name == "uint" || name == "uint32") return UINT32;
+    if (name == "float" || name == "float32") return FLOAT32;
+    if (name == "double" || name == "float64") return FLOAT64;
+    return NONE;
+}
+
+ScalarType pcdScalarType(char type, int size) {
+    switch (type) {
+        case 'I': return size == 1 ? INT8 : size == 2 ? INT16 : size == 4 ? INT32 : NONE;
+        case 'U': return size == 1 ? UINT8 : size == 2 ? UINT16 : size == 4 ? UINT32 : NONE;
+        case 'F': return size == 4 ? FLOAT32 : size == 8 ? FLOAT64 : NONE;
+        default: return NONE;
+    }
+}
+
+// Integer colors are normalized by their type's range
+float colorScale(ScalarType type) {
+    switch (type) {
+        case UINT16: case INT16: return 1.0f / 65535.0f;
+        case FLOAT32: case FLOAT64: return 1.0f;
+        default: return 1.0f / 255.0f;
+    }
+}
+
+bool hostIsLittleEndian() {
+    const uint16_t probe = 1;
+    uint8_t first;
+    std::memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+template<typename T>
+T loadScalar(const uint8_t* data, bool swap) {
+    uint8_t bytes[sizeof(T)];
+    std::memcpy(bytes, data, sizeof(T));
+    if (swap) std::reverse(bytes, bytes + sizeof(T));
+    T value;
+    std::memcpy(&value, bytes, sizeof(T));
+    return value;
+}
+
+template<typename T>
+void storeScalar(uint8_t*& out, T value, bool swap) {
+    std::memcpy(out, &value, sizeof(T));
+    if (swap) std::reverse(out, out + sizeof(T));
+    out += sizeof(T);
+}
+
+float readScalar(const uint8_t* data, ScalarType type, bool swap) {
+    switch (type) {
+        case INT8: return static_cast<float>(static_cast<int8_t>(*data));
+        case UINT8: return static_cast<float>(*data);
+        case INT16: return static_cast<float>(loadScalar<int16_t>(data, swap));
+        case UINT16: return static_cast<float>(loadScalar<uint16_t>(data, swap));
+        case INT32: return static_cast<float>(loadScalar<int32_t>(data, swap));
+        case UINT32: return static_cast<float>(loadScalar<uint32_t>(data, swap));
+        case FLOAT32: return loadScalar<float>(data, swap);
+        case FLOAT64: return static_cast<float>(loadScalar<double>(data, swap));
+        default: return 0.0f;
+    }
+}
+
+// Where one scalar attribute lives: element i is at offset + i * stride.
+// Row-major records share a stride; column-major blocks use the scalar size.
+struct BinaryField {
+    ScalarType type = NONE;
+    size_t offset = 0;
+    size_t stride = 0;
+    
+    bool present() const { return type != NONE; }
+    const uint8_t* at(const uint8_t* data, size_t index) const { return data + offset + index * stride; }
+};
+
+struct BinaryLayout {
+    BinaryField position[3];
+    BinaryField color[3];
+    BinaryField normal[3];
+    BinaryField intensity;
+    bool packed_color = false;   // color[0] is one 0x00RRGGBB word (PCD rgb/rgba)
+    bool swap = false;           // File byte order differs from the host's
+};
+
+// Decode count points from a mapped binary body into cloud, in parallel blocks
+void decodeBinary(const uint8_t* data, size_t count, const BinaryLayout& layout, PointCloud& cloud) {
+    const bool has_colors = layout.color[0].present() &&
+                            (layout.packed_color || (layout.color[1].present() && layout.color[2].present()));
+    const bool has_normals = layout.normal[0].present() && layout.normal[1].present() && layout.normal[2].present();
+    const bool has_intensities = layout.intensity.present();
+    
+    cloud.clear();
+    cloud.setChannels(PointCloud::POSITION |
+                      (has_colors ? PointCloud::COLOR : 0u) |
+                      (has_normals ? PointCloud::NORMAL : 0u) |
+                      (has_intensities ? PointCloud::INTENSITY : 0u));
+    
+    auto& positions = cloud.getPositions();
+    auto& colors = cloud.getColors();
+    auto& normals = cloud.getNormals();
+    auto& intensities = cloud.getIntensities();
+    positions.resize(count);
+    if (has_colors) colors.resize(count);
+    if (has_normals) normals.resize(count);
+    if (has_intensities) intensities.resize(count);
+    
+    // Native-order float xyz triples are copied as they are
+    const BinaryField* position = layout.position;
+    const bool packed_positions = !layout.swap &&
+        position[0].type == FLOAT32 && position[1].type == FLOAT32 && position[2].type == FLOAT32 &&
+        position[1].offset == position[0].offset + 4 && position[2].offset == position[0].offset + 8 &&
+        position[1].stride == position[0].stride && position[2].stride == position[0].stride;
+    const bool byte_colors = !layout.packed_color &&
+        layout.color[0].type == UINT8 && layout.color[1].type == UINT8 && layout.color[2].type == UINT8;
+    
+    parallelFor(count, 0, [&](size_t, size_t begin, size_t end) {
+        if (packed_positions && position[0].stride == sizeof(glm::vec3)) {
+            std::memcpy(&positions[begin], position[0].at(data, begin), (end - begin) * sizeof(glm::vec3));
+        } else if (packed_positions) {
+            for (size_t i = begin; i < end; ++i) {
+                std::memcpy(&positions[i], position[0].at(data, i), sizeof(glm::vec3));
+            }
+        } else {
+            for (size_t i = begin; i < end; ++i) {
+                for (int axis = 0; axis < 3; ++axis) {
+                    positions[i][axis] = readScalar(position[axis].at(data, i), position[axis].type, layout.swap);
+                }
+            }
+        }
+        
+        if (has_colors && layout.packed_color) {
+            for (size_t i = begin; i < end; ++i) {
+                uint32_t rgb = loadScalar<uint32_t>(layout.color[0].at(data, i), layout.swap);
+                colors[i] = {static_cast<uint8_t>(rgb >> 16), static_cast<uint8_t>(rgb >> 8),
+                             static_cast<uint8_t>(rgb), 255};
+            }
+        } else if (has_colors && byte_colors) {
+            for (size_t i = begin; i < end; ++i) {
+                colors[i] = {*layout.color[0].at(data, i), *layout.color[1].at(data, i),
+                             *layout.color[2].at(data, i), 255};
+            }
+        } else if (has_colors) {
+            for (size_t i = begin; i < end; ++i) {
+                glm::vec3 color;
+                for (int channel = 0; channel < 3; ++channel) {
+                    const BinaryField& field = layout.color[channel];
+                    color[channel] = readScalar(field.at(data, i), field.type, layout.swap) * colorScale(field.type);
+                }
+                colors[i] = packColor(color);
+            }
+        }
+        
+        if (has_normals) {
+            for (size_t i = begin; i < end; ++i) {
+                glm::vec3 normal;
+                for (int axis = 0; axis < 3; ++axis) {
+                    const BinaryField& field = layout.normal[axis];
+                    normal[axis] = readScalar(field.at(data, i), field.type, layout.swap);
+                }
+                normals[i] = packNormal(normal);
+            }
+        }
+        
+        if (has_intensities) {
+            for (size_t i = begin; i < end; ++i) {
+                intensities[i] = readScalar(layout.intensity.at(data, i), layout.intensity.type, layout.swap);
+            }
+        }
+    }, 65536);
+    
+    cloud.updateBounds();
+}
+
+// Match a property/field name to its BinaryLayout slot
+void assignField(BinaryLayout& layout, const std::string& name, const BinaryField& field) {
+    static const char* const position_names[] = {"x", "y", "z"};
+    static const char* const color_names[][2] = {{"red", "r"}, {"green", "g"}, {"blue", "b"}};
+    static const char* const normal_names[][2] = {{"nx", "normal_x"}, {"ny", "normal_y"}, {"nz", "normal_z"}};
+    
+    for (int axis = 0; axis < 3; ++axis) {
+        if (name == position_names[axis]) {
+            layout.position[axis] = field;
+        } else if (name == color_names[axis][0] || name == color_names[axis][1]) {
+            layout.color[axis] = field;
+        } else if (name == normal_names[axis][0] || name == normal_names[axis][1]) {
+            layout.normal[axis] = field;
+        }
+    }
+    if (name == "intensity" || name == "scalar_intensity") {
+        layout.intensity = field;
+    } else if ((name == "rgb" || name == "rgba") && field.type != NONE && scalarSize(field.type) == 4) {
+        layout.color[0] = field;
+        layout.color[0].type = UINT32;
+        layout.packed_color = true;
+    }
+}
+
+bool hasPositions(const BinaryLayout& layout) {
+    return layout.position[0].present() && layout.position[1].present() && layout.position[2].present();
+}
+
+struct PLYProperty {
+    std::string name;
+    ScalarType type = NONE;
+    bool is_list = false;
+};
+
+struct PLYElement {
+    std::string name;
+    size_t count = 0;
+    std::vector<PLYProperty> properties;
+    
+    bool hasList() const {
+        return std::any_of(properties.begin(), properties.end(),
+                           [](const PLYProperty& property) { return property.is_list; });
+    }
+    
+    size_t recordSize() const {
+        size_t size = 0;
+        for (const auto& property : properties) size += scalarSize(property.type);
+        return size;
+    }
+};
+
+struct PLYHeader {
+    std::string encoding;   // ascii, binary_little_endian or binary_big_endian
+    std::vector<PLYElement> elements;
+};
+
+// Read the header; the stream is left at the first body byte
+bool parsePLYHeader(std::istream& stream, PLYHeader& header) {
+    std::string line;
+    if (!std::getline(stream, line) || line.compare(0, 3, "ply") != 0) {
+        return false;
+    }
+    
+    header = PLYHeader();
+    while (std::getline(stream, line)) {
+        std::istringstream iss(line);
+        std::string keyword;
+        iss >> keyword;
+        
+        if (keyword == "format") {
+            iss >> header.encoding;
+        } else if (keyword == "element") {
+            PLYElement element;
+            iss >> element.name >> element.count;
+            header.elements.push_back(element);
+        } else if (keyword == "property") {
+            if (header.elements.empty()) return false;
+            PLYProperty property;
+            std::string type;
+            iss >> type;
+            if (type == "list") {
+                std::string count_type, item_type;
+                iss >> count_type >> item_type;
+                property.is_list = true;
+            } else {
+                property.type = plyScalarType(type);
+                if (property.type == NONE) return false;
+            }
+            iss >> property.name;
+            header.elements.back().properties.push_back(property);
+        } else if (keyword == "end_header") {
+            return header.encoding == "ascii" || header.encoding == "binary_little_endian" ||
+                   header.encoding == "binary_big_endian";
+        }
+    }
+    return false;
+}
+
+// Text columns of the vertex element; other elements must follow it
+bool plyTextLayout(const PLYHeader& header, TextParser::Layout& layout) {
+    if (header.elements.empty() || header.elements.front().name != "vertex") {
+        return false;
+    }
+    
+    const PLYElement& vertex = header.elements.front();
+    if (vertex.hasList()) {
+        return false; // Variable width - columns cannot be located
+    }
+    
+    layout = TextParser::Layout();
+    layout.position_columns[0] = layout.position_columns[1] = layout.position_columns[2] = -1;
+    layout.max_points = vertex.count;
+    static const char* const position_names[] = {"x", "y", "z"};
+    static const char* const color_names[][2] = {{"red", "r"}, {"green", "g"}, {"blue", "b"}};
+    for (size_t column = 0; column < vertex.properties.size(); ++column) {
+        const PLYProperty& property = vertex.properties[column];
+        for (int axis = 0; axis < 3; ++axis) {
+            if (property.name == position_names[axis]) {
+                layout.position_columns[axis] = static_cast<int>(column);
+            } else if (property.name == color_names[axis][0] || property.name == color_names[axis][1]) {
+                layout.color_columns[axis] = static_cast<int>(column);
+                layout.color_scale = colorScale(property.type);
+            }
+        }
+    }
+    
+    if (layout.color_columns[0] < 0 || layout.color_columns[1] < 0 || layout.color_columns[2] < 0) {
+        layout.color_columns[0] = layout.color_columns[1] = layout.color_columns[2] = -1;
+    }
+    return layout.position_columns[0] >= 0 && layout.position_columns[1] >= 0 &&
+           layout.position_columns[2] >= 0;
+}
+
+struct PCDField {
+    std::string name;
+    int size = 4;
+    char type = 'F';
+    int count = 1;
+};
+
+struct PCDHeader {
+    std::vector<PCDField> fields;
+    size_t points = 0;
+    std::string encoding;   // ascii, binary or binary_compressed
+    
+    size_t recordSize() const {
+        size_t size = 0;
+        for (const auto& field : fields) size += static_cast<size_t>(field.size) * field.count;
+        return size;
+    }
+};
+
+// Read the header; the stream is left at the first body byte
+bool parsePCDHeader(std::istream& stream, PCDHeader& header) {
+    header = PCDHeader();
+    size_t width = 0, height = 1;
+    bool has_points = false;
+    std::string line;
+    
+    while (std::getline(stream, line)) {
+        std::istringstream iss(line);
+        std::string keyword;
+        iss >> keyword;
+        
+        if (keyword == "FIELDS") {
+            std::string name;
+            while (iss >> name) {
+                PCDField field;
+                field.name = name;
+                header.fields.push_back(field);
+            }
+        } else if (keyword == "SIZE") {
+            for (auto& field : header.fields) iss >> field.size;
+        } else if (keyword == "TYPE") {
+            for (auto& field : header.fields) iss >> field.type;
+        } else if (keyword == "COUNT") {
+            for (auto& field : header.fields) iss >> field.count;
+        } else if (keyword == "WIDTH") {
+            iss >> width;
+        } else if (keyword == "HEIGHT") {
+            iss >> height;
+        } else if (keyword == "POINTS") {
+            iss >> header.points;
+            has_points = true;
+        } else if (keyword == "DATA") {
+            iss >> header.encoding;
+            if (!has_points) header.points = width * height;
+            return !header.fields.empty() && !iss.fail();
+        }
+    }
+    return false;
+}
+
+// Text columns of x, y, z; a field with COUNT n spans n columns
+bool pcdTextLayout(const PCDHeader& header, TextParser::Layout& layout) {
+    layout = TextParser::Layout();
+    layout.position_columns[0] = layout.position_columns[1] = layout.position_columns[2] = -1;
+    layout.max_points = header.points;
+    static const char* const position_names[] = {"x", "y", "z"};
+    int column = 0;
+    for (const auto& field : header.fields) {
+        for (int axis = 0; axis < 3; ++axis) {
+            if (field.name == position_names[axis]) {
+                layout.position_columns[axis] = column;
+            }
+        }
+        column += field.count;
+    }
+    return layout.position_columns[0] >= 0 && layout.position_columns[1] >= 0 &&
+           layout.position_columns[2] >= 0;
+}
+
+// Stream rows of at most this many points through a reusable buffer when saving
+constexpr size_t WRITE_BLOCK_POINTS = 65536;
+
+} // namespace
+
 bool FileIO::load(const std::string& filename, PointCloud& cloud, Format format) {
     if (format == Format::AUTO) {
         format = getFormatFromExtension(filename);
@@ -20,13 +435,15 @@ bool FileIO::load(const std::string& filename, PointCloud& cloud, Format format)
             return loadPLY(filename, cloud);
         case Format::PCD:
             return loadPCD(filename, cloud);
+        case Format::PCVC:
+            return loadPCVC(filename, cloud);
         default:
             std::cerr << "Unsupported file format" << std::endl;
             return false;
     }
 }
 
-bool FileIO::save(const std::string& filename, const PointCloud& cloud, Format format) {
+bool FileIO::save(const std::string& filename, const PointCloud& cloud, Format format, Encoding encoding) {
     if (format == Format::AUTO) {
         format = getFormatFromExtension(filename);
     }
@@ -36,9 +453,11 @@ bool FileIO::save(const std::string& filename, const PointCloud& cloud, Format f
         case Format::XYZRGB:
             return saveXYZ(filename, cloud);
         case Format::PLY:
-            return savePLY(filename, cloud);
+            return savePLY(filename, cloud, encoding);
         case Format::PCD:
-            return savePCD(filename, cloud);
+            return savePCD(filename, cloud, encoding);
+        case Format::PCVC:
+            return savePCVC(filename, cloud);
         default:
             std::cerr << "Unsupported file format" << std::endl;
             return false;
@@ -60,38 +479,21 @@ FileIO::Format FileIO::getFormatFromExtension(const std::string& filename) {
         return Format::PLY;
     } else if (ext == "pcd") {
         return Format::PCD;
+    } else if (ext == "pcvc") {
+        return Format::PCVC;
     }
     
     return Format::AUTO;
 }
 
 bool FileIO::loadXYZ(const std::string& filename, PointCloud& cloud) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        std::cerr << "Failed to open file: " << filename << std::endl;
-        return false;
-    }
-    
     cloud.clear();
-    std::string line;
+    cloud.setChannels(PointCloud::POSITION);
     
-    while (std::getline(file, line)) {
-        // Skip empty lines and comments
-        if (line.empty() || line[0] == '#') {
-            continue;
-        }
-        
-        std::istringstream iss(line);
-        float x, y, z, r = 1.0f, g = 1.0f, b = 1.0f;
-        
-        if (iss >> x >> y >> z) {
-            // Try to read color
-            iss >> r >> g >> b;
-            cloud.addPoint(glm::vec3(x, y, z), glm::vec3(r, g, b));
-        }
+    // Only stores a color channel if the file has one
+    if (!TextParser::parseFile(filename, 0, TextParser::xyzLayout(), cloud)) {
+        return false;
     }
-    
-    file.close();
     return !cloud.empty();
 }
 
@@ -121,6 +523,17 @@ bool FileIO::saveXYZ(const std::string& filename, const PointCloud& cloud) {
     return true;
 }
 
+bool FileIO::readPLYHeader(std::istream& stream, TextParser::Layout& layout, bool& ascii) {
+    PLYHeader header;
+    if (!parsePLYHeader(stream, header)) {
+        return false;
+    }
+    
+    ascii = header.encoding == "ascii";
+    layout = TextParser::Layout();
+    return !ascii || plyTextLayout(header, layout);
+}
+
 bool FileIO::loadPLY(const std::string& filename, PointCloud& cloud) {
     std::ifstream file(filename, std::ios::binary);
     if (!file.is_open()) {
@@ -129,67 +542,94 @@ bool FileIO::loadPLY(const std::string& filename, PointCloud& cloud) {
     }
     
     cloud.clear();
-    std::string line;
+    cloud.setChannels(PointCloud::POSITION);
     
     // Read header
-    bool header_ended = false;
-    size_t vertex_count = 0;
-    bool has_color = false;
+    PLYHeader header;
+    if (!parsePLYHeader(file, header)) {
+        std::cerr << "Invalid PLY header: " << filename << std::endl;
+        return false;
+    }
+    std::streamoff data_offset = file.tellg();
     
-    while (std::getline(file, line) && !header_ended) {
-        std::istringstream iss(line);
-        std::string keyword;
-        iss >> keyword;
-        
-        if (keyword == "element") {
-            std::string element_type;
-            iss >> element_type;
-            if (element_type == "vertex") {
-                iss >> vertex_count;
-            }
-        } else if (keyword == "property") {
-            std::string type, name;
-            iss >> type >> name;
-            if (name == "red" || name == "r") {
-                has_color = true;
-            }
-        } else if (keyword == "end_header") {
-            header_ended = true;
+    if (header.encoding == "ascii") {
+        // Lines past the vertex count (e.g. faces) are ignored
+        TextParser::Layout layout;
+        if (!plyTextLayout(header, layout)) {
+            std::cerr << "Unsupported ASCII PLY vertex layout: " << filename << std::endl;
+            return false;
+        }
+        file.close();
+        if (!TextParser::parseFile(filename, data_offset, layout, cloud)) {
+            return false;
         }
+        return !cloud.empty();
     }
+    file.close();
     
-    // Read vertices
-    cloud.reserve(vertex_count);
-    
-    for (size_t i = 0; i < vertex_count; ++i) {
-        float x, y, z, r = 1.0f, g = 1.0f, b = 1.0f;
-        
-        file >> x >> y >> z;
-        if (has_color) {
-            int ir, ig, ib;
-            file >> ir >> ig >> ib;
-            r = ir / 255.0f;
-            g = ig / 255.0f;
-            b = ib / 255.0f;
+    // Binary body: skip fixed-size elements ahead of the vertices
+    size_t offset = static_cast<size_t>(data_offset);
+    const PLYElement* vertex = nullptr;
+    for (const auto& element : header.elements) {
+        if (element.name == "vertex") {
+            vertex = &element;
+            break;
         }
-        
-        cloud.addPoint(glm::vec3(x, y, z), glm::vec3(r, g, b));
+        if (element.hasList()) {
+            std::cerr << "Cannot skip list element '" << element.name << "' in PLY file: " << filename << std::endl;
+            return false;
+        }
+        offset += element.count * element.recordSize();
+    }
+    if (!vertex || vertex->hasList()) {
+        std::cerr << "Unsupported PLY vertex layout: " << filename << std::endl;
+        return false;
     }
     
-    file.close();
+    BinaryLayout layout;
+    layout.swap = (header.encoding == "binary_little_endian") != hostIsLittleEndian();
+    const size_t stride = vertex->recordSize();
+    size_t field_offset = 0;
+    for (const auto& property : vertex->properties) {
+        BinaryField field;
+        field.type = property.type;
+        field.offset = field_offset;
+        field.stride = stride;
+        assignField(layout, property.name, field);
+        field_offset += scalarSize(property.type);
+    }
+    layout.packed_color = false; // PLY colors are separate properties
+    if (!hasPositions(layout)) {
+        std::cerr << "PLY vertices have no x/y/z: " << filename << std::endl;
+        return false;
+    }
+    
+    MappedFile mapped(filename);
+    if (!mapped.isOpen() || offset + vertex->count * stride > mapped.size()) {
+        std::cerr << "Failed to map PLY body (truncated file?): " << filename << std::endl;
+        return false;
+    }
+    
+    decodeBinary(mapped.data() + offset, vertex->count, layout, cloud);
     return !cloud.empty();
 }
 
-bool FileIO::savePLY(const std::string& filename, const PointCloud& cloud) {
-    std::ofstream file(filename);
+bool FileIO::savePLY(const std::string& filename, const PointCloud& cloud, Encoding encoding) {
+    if (encoding == Encoding::BINARY_COMPRESSED) {
+        std::cerr << "PLY has no compressed encoding" << std::endl;
+        return false;
+    }
+    
+    std::ofstream file(filename, std::ios::binary);
     if (!file.is_open()) {
         std::cerr << "Failed to open PLY file for writing: " << filename << std::endl;
         return false;
     }
     
     // Write header
+    const bool binary = encoding == Encoding::BINARY;
     file << "ply\n";
-    file << "format ascii 1.0\n";
+    file << (binary ? "format binary_little_endian 1.0\n" : "format ascii 1.0\n");
     file << "element vertex " << cloud.size() << "\n";
     file << "property float x\n";
     file << "property float y\n";
@@ -197,8 +637,48 @@ bool FileIO::savePLY(const std::string& filename, const PointCloud& cloud) {
     file << "property uchar red\n";
     file << "property uchar green\n";
     file << "property uchar blue\n";
+    if (binary && cloud.hasNormals()) {
+        file << "property float nx\n";
+        file << "property float ny\n";
+        file << "property float nz\n";
+    }
+    if (binary && cloud.hasIntensities()) {
+        file << "property float intensity\n";
+    }
     file << "end_header\n";
     
+    if (binary) {
+        const bool swap = !hostIsLittleEndian();
+        const size_t stride = 15 + (cloud.hasNormals() ? 12 : 0) + (cloud.hasIntensities() ? 4 : 0);
+        std::vector<uint8_t> buffer(std::min(cloud.size(), WRITE_BLOCK_POINTS) * stride);
+        
+        for (size_t begin = 0; begin < cloud.size(); begin += WRITE_BLOCK_POINTS) {
+            size_t end = std::min(cloud.size(), begin + WRITE_BLOCK_POINTS);
+            uint8_t* out = buffer.data();
+            for (size_t i = begin; i < end; ++i) {
+                const glm::vec3& position = cloud.getPosition(i);
+                storeScalar(out, position.x, swap);
+                storeScalar(out, position.y, swap);
+                storeScalar(out, position.z, swap);
+                PackedColor color = cloud.hasColors() ? cloud.getColors()[i] : packColor(Point().color);
+                *out++ = color.r;
+                *out++ = color.g;
+                *out++ = color.b;
+                if (cloud.hasNormals()) {
+                    glm::vec3 normal = cloud.getNormal(i);
+                    storeScalar(out, normal.x, swap);
+                    storeScalar(out, normal.y, swap);
+                    storeScalar(out, normal.z, swap);
+                }
+                if (cloud.hasIntensities()) {
+                    storeScalar(out, cloud.getIntensities()[i], swap);
+                }
+            }
+            file.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(out - buffer.data()));
+        }
+        return file.good();
+    }
+    
     // Write vertices
     for (const auto& point : cloud) {
         file << point.position.x << " " 
@@ -213,61 +693,205 @@ bool FileIO::savePLY(const std::string& filename, const PointCloud& cloud) {
     return true;
 }
 
+bool FileIO::readPCDHeader(std::istream& stream, TextParser::Layout& layout, bool& ascii) {
+    PCDHeader header;
+    if (!parsePCDHeader(stream, header)) {
+        return false;
+    }
+    
+    ascii = header.encoding == "ascii";
+    layout = TextParser::Layout();
+    return !ascii || pcdTextLayout(header, layout);
+}
+
 bool FileIO::loadPCD(const std::string& filename, PointCloud& cloud) {
-    // Simplified PCD loader - full implementation would handle all PCD features
-    std::ifstream file(filename);
+    std::ifstream file(filename, std::ios::binary);
     if (!file.is_open()) {
         std::cerr << "Failed to open PCD file: " << filename << std::endl;
         return false;
     }
     
     cloud.clear();
-    std::string line;
-    size_t points = 0;
-    bool data_started = false;
-    
-    while (std::getline(file, line)) {
-        if (!data_started) {
-            if (line.find("POINTS") == 0) {
-                std::istringstream iss(line);
-                std::string keyword;
-                iss >> keyword >> points;
-                cloud.reserve(points);
-            } else if (line == "DATA ascii") {
-                data_started = true;
-            }
-        } else {
-            // Read point data
-            std::istringstream iss(line);
-            float x, y, z;
-            if (iss >> x >> y >> z) {
-                cloud.addPoint(glm::vec3(x, y, z));
-            }
-        }
+    cloud.setChannels(PointCloud::POSITION);
+    
+    PCDHeader header;
+    if (!parsePCDHeader(file, header)) {
+        std::cerr << "Invalid PCD header: " << filename << std::endl;
+        return false;
     }
+    std::streamoff data_offset = file.tellg();
     
+    if (header.encoding == "ascii") {
+        // Text bodies keep positions only; packed rgb is not decoded
+        TextParser::Layout layout;
+        if (!pcdTextLayout(header, layout)) {
+            std::cerr << "PCD fields have no x/y/z: " << filename << std::endl;
+            return false;
+        }
+        file.close();
+        if (!TextParser::parseFile(filename, data_offset, layout, cloud)) {
+            return false;
+        }
+        return !cloud.empty();
+    }
     file.close();
+    
+    const bool compressed = header.encoding == "binary_compressed";
+    if (!compressed && header.encoding != "binary") {
+        std::cerr << "Unsupported PCD data encoding '" << header.encoding << "': " << filename << std::endl;
+        return false;
+    }
+    
+    MappedFile mapped(filename);
+    if (!mapped.isOpen()) {
+        std::cerr << "Failed to map PCD file: " << filename << std::endl;
+        return false;
+    }
+    
+    // binary: row-major records; binary_compressed: LZF block of field-major columns
+    const size_t record_size = header.recordSize();
+    const size_t body_size = header.points * record_size;
+    const uint8_t* body = mapped.data() + data_offset;
+    const size_t available = mapped.size() - static_cast<size_t>(data_offset);
+    std::vector<uint8_t> decompressed;
+    
+    if (compressed) {
+        if (available < 8) {
+            std::cerr << "Truncated PCD file: " << filename << std::endl;
+            return false;
+        }
+        uint32_t compressed_size = loadScalar<uint32_t>(body, !hostIsLittleEndian());
+        uint32_t uncompressed_size = loadScalar<uint32_t>(body + 4, !hostIsLittleEndian());
+        // Check both sizes before allocating, so a corrupt header fails the load
+        if (uncompressed_size != body_size || compressed_size > available - 8) {
+            std::cerr << "Corrupt compressed PCD data: " << filename << std::endl;
+            return false;
+        }
+        decompressed.resize(uncompressed_size);
+        if (!LZF::decompress(body + 8, compressed_size, decompressed.data(), decompressed.size())) {
+            std::cerr << "Corrupt compressed PCD data: " << filename << std::endl;
+            return false;
+        }
+        body = decompressed.data();
+    } else if (body_size > available) {
+        std::cerr << "Truncated PCD file: " << filename << std::endl;
+        return false;
+    }
+    
+    BinaryLayout layout;
+    layout.swap = !hostIsLittleEndian();
+    size_t field_offset = 0;
+    for (const auto& field : header.fields) {
+        const size_t field_size = static_cast<size_t>(field.size) * field.count;
+        BinaryField binary;
+        binary.type = pcdScalarType(field.type, field.size);
+        binary.offset = compressed ? field_offset * header.points : field_offset;
+        binary.stride = compressed ? field_size : record_size;
+        assignField(layout, field.name, binary);
+        field_offset += field_size;
+    }
+    if (!hasPositions(layout)) {
+        std::cerr << "PCD fields have no x/y/z: " << filename << std::endl;
+        return false;
+    }
+    
+    decodeBinary(body, header.points, layout, cloud);
     return !cloud.empty();
 }
 
-bool FileIO::savePCD(const std::string& filename, const PointCloud& cloud) {
-    std::ofstream file(filename);
+bool FileIO::savePCD(const std::string& filename, const PointCloud& cloud, Encoding encoding) {
+    std::ofstream file(filename, std::ios::binary);
     if (!file.is_open()) {
         std::cerr << "Failed to open PCD file for writing: " << filename << std::endl;
         return false;
     }
     
+    // Binary bodies also carry normals and intensities when present
+    const bool binary = encoding != Encoding::ASCII;
+    const bool normals = binary && cloud.hasNormals();
+    const bool intensities = binary && cloud.hasIntensities();
+    const size_t field_count = 4 + (normals ? 3 : 0) + (intensities ? 1 : 0);
+    
     // Write PCD header
     file << "# .PCD v0.7 - Point Cloud Data file format\n";
     file << "VERSION 0.7\n";
-    file << "FIELDS x y z rgb\n";
-    file << "SIZE 4 4 4 4\n";
-    file << "TYPE F F F U\n";
-    file << "COUNT 1 1 1 1\n";
-    file << "WIDTH " << cloud.size() << "\n";
+    file << "FIELDS x y z rgb" << (normals ? " normal_x normal_y normal_z" : "")
+         << (intensities ? " intensity" : "") << "\n";
+    file << "SIZE";
+    for (size_t f = 0; f < field_count; ++f) file << " 4";
+    file << "\nTYPE F F F U" << (normals ? " F F F" : "") << (intensities ? " F" : "") << "\n";
+    file << "COUNT";
+    for (size_t f = 0; f < field_count; ++f) file << " 1";
+    file << "\nWIDTH " << cloud.size() << "\n";
     file << "HEIGHT 1\n";
     file << "VIEWPOINT 0 0 0 1 0 0 0\n";
     file << "POINTS " << cloud.size() << "\n";
+    
+    if (binary) {
+        // Every field is 4 bytes; compressed bodies store each field as one column
+        const bool compressed = encoding == Encoding::BINARY_COMPRESSED;
+        const bool swap = !hostIsLittleEndian();
+        const size_t count = cloud.size();
+        const size_t stride = field_count * 4;
+        file << (compressed ? "DATA binary_compressed\n" : "DATA binary\n");
+        
+        auto storeRecord = [&](size_t i, uint8_t* out, size_t field_step) {
+            auto next = [&](auto value) {
+                uint8_t* field = out;
+                storeScalar(field, value, swap);
+                out += field_step;
+            };
+            const glm::vec3& position = cloud.getPosition(i);
+            next(position.x);
+            next(position.y);
+            next(position.z);
+            PackedColor color = cloud.hasColors() ? cloud.getColors()[i] : packColor(Point().color);
+            next((uint32_t(color.r) << 16) | (uint32_t(color.g) << 8) | uint32_t(color.b));
+            if (normals) {
+                glm::vec3 normal = cloud.getNormal(i);
+                next(normal.x);
+                next(normal.y);
+                next(normal.z);
+            }
+            if (intensities) {
+                next(cloud.getIntensities()[i]);
+            }
+        };
+        
+        if (compressed) {
+            std::vector<uint8_t> columns(count * stride);
+            parallelFor(count, 0, [&](size_t, size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    storeRecord(i, columns.data() + i * 4, count * 4);
+                }
+            }, 65536);
+            
+            std::vector<uint8_t> packed(LZF::maxCompressedSize(columns.size()));
+            size_t packed_size = LZF::compress(columns.data(), columns.size(), packed.data(), packed.size());
+            if (packed_size == 0 && !columns.empty()) {
+                std::cerr << "Failed to compress PCD data: " << filename << std::endl;
+                return false;
+            }
+            
+            uint8_t sizes[8];
+            uint8_t* out = sizes;
+            storeScalar(out, static_cast<uint32_t>(packed_size), swap);
+            storeScalar(out, static_cast<uint32_t>(columns.size()), swap);
+            file.write(reinterpret_cast<const char*>(sizes), sizeof(sizes));
+            file.write(reinterpret_cast<const char*>(packed.data()), static_cast<std::streamsize>(packed_size));
+        } else {
+            std::vector<uint8_t> buffer(std::min(count, WRITE_BLOCK_POINTS) * stride);
+            for (size_t begin = 0; begin < count; begin += WRITE_BLOCK_POINTS) {
+                size_t end = std::min(count, begin + WRITE_BLOCK_POINTS);
+                for (size_t i = begin; i < end; ++i) {
+                    storeRecord(i, buffer.data() + (i - begin) * stride, 4);
+                }
+                file.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>((end - begin) * stride));
+            }
+        }
+        return file.good();
+    }
+    
     file << "DATA ascii\n";
     
     // Write point data
@@ -287,4 +911,19 @@ bool FileIO::savePCD(const std::string& filename, const PointCloud& cloud) {
     return true;
 }
 
+bool FileIO::loadPCVC(const std::string& filename, PointCloud& cloud) {
+    // Points come back in octree leaf order; use PointCache directly to keep the octree too
+    PointCache cache;
+    if (!cache.open(filename) || !cache.load(cloud)) {
+        return false;
+    }
+    return !cloud.empty();
+}
+
+bool FileIO::savePCVC(const std::string& filename, const PointCloud& cloud) {
+    Octree octree(cloud);
+    octree.build();
+    return PointCache::write(filename, cloud, octree);
+}
+
 } // namespace pcv
\ No newline at end of file
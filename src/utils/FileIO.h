@@ -1,6 +1,8 @@
 #pragma once
 
 #include "core/PointCloud.h"
+#include "utils/TextParser.h"
+#include <istream>
 #include <string>
 
 namespace pcv {
@@ -12,28 +14,45 @@ public:
         XYZ,      // Simple XYZ format
         XYZRGB,   // XYZ with RGB colors
         PLY,      // Stanford PLY format
-        PCD       // Point Cloud Data format
+        PCD,      // Point Cloud Data format
+        PCVC      // Native octree-ordered cache (see PointCache)
+    };
+    
+    // Body encoding used when saving PLY and PCD files
+    enum class Encoding {
+        ASCII,              // Text
+        BINARY,             // Little-endian binary records
+        BINARY_COMPRESSED   // LZF-compressed binary columns (PCD only)
     };
     
     // Load point cloud from file
     static bool load(const std::string& filename, PointCloud& cloud, Format format = Format::AUTO);
     
-    // Save point cloud to file
-    static bool save(const std::string& filename, const PointCloud& cloud, Format format = Format::AUTO);
+    // Save point cloud to file; XYZ is always ASCII
+    static bool save(const std::string& filename, const PointCloud& cloud, Format format = Format::AUTO,
+                     Encoding encoding = Encoding::ASCII);
     
     // Get format from file extension
     static Format getFormatFromExtension(const std::string& filename);
     
+    // Read a PLY/PCD header up to the first data line and describe the ASCII body.
+    // ascii is false for binary bodies, whose layout is left unset. Returns false for
+    // invalid headers and for ASCII bodies the text parser cannot read.
+    static bool readPLYHeader(std::istream& stream, TextParser::Layout& layout, bool& ascii);
+    static bool readPCDHeader(std::istream& stream, TextParser::Layout& layout, bool& ascii);
+    
 private:
     // Format-specific loaders
     static bool loadXYZ(const std::string& filename, PointCloud& cloud);
     static bool loadPLY(const std::string& filename, PointCloud& cloud);
     static bool loadPCD(const std::string& filename, PointCloud& cloud);
+    static bool loadPCVC(const std::string& filename, PointCloud& cloud);
     
     // Format-specific savers
     static bool saveXYZ(const std::string& filename, const PointCloud& cloud);
-    static bool savePLY(const std::string& filename, const PointCloud& cloud);
-    static bool savePCD(const std::string& filename, const PointCloud& cloud);
+    static bool savePLY(const std::string& filename, const PointCloud& cloud, Encoding encoding);
+    static bool savePCD(const std::string& filename, const PointCloud& cloud, Encoding encoding);
+    static bool savePCVC(const std::string& filename, const PointCloud& cloud);
 };
 
 } // namespace pcv
\ No newline at end of file
@@ -0,0 +1,116 @@
+#include "utils/LZF.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace pcv {
+
+namespace {
+
+constexpr int HASH_BITS = 14;
+constexpr size_t MAX_LITERAL = 32;          // Literal run length fits 5 bits
+constexpr size_t MAX_OFFSET = size_t(1) << 13;
+constexpr size_t MAX_MATCH = 264;           // 2 + 7 + 255 from the length encoding
+constexpr size_t NO_MATCH = static_cast<size_t>(-1);
+
+uint32_t hashTriple(const uint8_t* data) {
+    uint32_t value = (uint32_t(data[0]) << 16) | (uint32_t(data[1]) << 8) | data[2];
+    return (value * 2654435761u) >> (32 - HASH_BITS);
+}
+
+} // namespace
+
+size_t LZF::compress(const uint8_t* input, size_t input_size,
+                     uint8_t* output, size_t output_capacity) {
+    std::vector<size_t> table(size_t(1) << HASH_BITS, NO_MATCH);
+    size_t in = 0;
+    size_t out = 0;
+    size_t literal_start = 0;
+    
+    // Emit [literal_start, end) as runs of up to 32 literals
+    auto flushLiterals = [&](size_t end) {
+        while (literal_start < end) {
+            size_t count = std::min(MAX_LITERAL, end - literal_start);
+            if (out + 1 + count > output_capacity) return false;
+            output[out++] = static_cast<uint8_t>(count - 1);
+            std::memcpy(output + out, input + literal_start, count);
+            out += count;
+            literal_start += count;
+        }
+        return true;
+    };
+    
+    while (in + 2 < input_size) {
+        uint32_t hash = hashTriple(input + in);
+        size_t ref = table[hash];
+        table[hash] = in;
+        
+        if (ref == NO_MATCH || in - ref - 1 >= MAX_OFFSET ||
+            std::memcmp(input + ref, input + in, 3) != 0) {
+            in++;
+            continue;
+        }
+        
+        size_t max_length = std::min(MAX_MATCH, input_size - in);
+        size_t length = 3;
+        while (length < max_length && input[ref + length] == input[in + length]) {
+            length++;
+        }
+        
+        if (!flushLiterals(in) || out + 3 > output_capacity) return 0;
+        
+        // Back reference: 3 bits length (7 = extended), 13 bits offset
+        size_t offset = in - ref - 1;
+        size_t code = length - 2;
+        if (code < 7) {
+            output[out++] = static_cast<uint8_t>((code << 5) | (offset >> 8));
+        } else {
+            output[out++] = static_cast<uint8_t>((7 << 5) | (offset >> 8));
+            output[out++] = static_cast<uint8_t>(code - 7);
+        }
+        output[out++] = static_cast<uint8_t>(offset & 0xFF);
+        
+        in += length;
+        literal_start = in;
+    }
+    
+    if (!flushLiterals(input_size)) return 0;
+    return out;
+}
+
+bool LZF::decompress(const uint8_t* input, size_t input_size,
+                     uint8_t* output, size_t output_size) {
+    size_t in = 0;
+    size_t out = 0;
+    
+    while (in < input_size) {
+        size_t control = input[in++];
+        
+        if (control < MAX_LITERAL) {
+            size_t count = control + 1;
+            if (in + count > input_size || out + count > output_size) return false;
+            std::memcpy(output + out, input + in, count);
+            in += count;
+            out += count;
+            continue;
+        }
+        
+        size_t length = control >> 5;
+        if (length == 7) {
+            if (in >= input_size) return false;
+            length += input[in++];
+        }
+        if (in >= input_size) return false;
+        size_t offset = ((control & 0x1F) << 8) + input[in++] + 1;
+        length += 2;
+        if (offset > out || out + length > output_size) return false;
+        
+        // Byte by byte - the reference may overlap the output
+        for (size_t i = 0; i < length; ++i, ++out) {
+            output[out] = output[out - offset];
+        }
+    }
+    return out == output_size;
+}
+
+} // namespace pcv
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace pcv {
+
+// LZF block compression, the codec of binary_compressed PCD files.
+// Only whole blocks are supported; the caller stores the uncompressed size.
+class LZF {
+public:
+    // Worst-case compressed size of size input bytes
+    static size_t maxCompressedSize(size_t size) { return size + size / 32 + 16; }
+    
+    // Returns the compressed size, or 0 if output_capacity is too small
+    static size_t compress(const uint8_t* input, size_t input_size,
+                           uint8_t* output, size_t output_capacity);
+    
+    // Returns false for corrupt input or if the result is not exactly output_size bytes
+    static bool decompress(const uint8_t* input, size_t input_size,
+                           uint8_t* output, size_t output_size);
+};
+
+} // namespace pcv
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include "utils/MappedFile.h"
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace pcv {
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    swap(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        swap(other);
+    }
+    return *this;
+}
+
+void MappedFile::swap(MappedFile& other) noexcept {
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+    std::swap(open_, other.open_);
+#ifdef _WIN32
+    std::swap(file_handle_, other.file_handle_);
+    std::swap(mapping_handle_, other.mapping_handle_);
+#endif
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& filename, Access access) {
+    close();
+    
+    DWORD flags = access == RANDOM ? FILE_FLAG_RANDOM_ACCESS : FILE_FLAG_SEQUENTIAL_SCAN;
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, flags, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size)) {
+        CloseHandle(file);
+        return false;
+    }
+    
+    file_handle_ = file;
+    size_ = static_cast<size_t>(file_size.QuadPart);
+    open_ = true;
+    if (size_ == 0) {
+        return true; // Nothing to map
+    }
+    
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        if (mapping) CloseHandle(mapping);
+        close();
+        return false;
+    }
+    
+    mapping_handle_ = mapping;
+    data_ = static_cast<const uint8_t*>(view);
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_) UnmapViewOfFile(data_);
+    if (mapping_handle_) CloseHandle(static_cast<HANDLE>(mapping_handle_));
+    if (file_handle_) CloseHandle(static_cast<HANDLE>(file_handle_));
+    data_ = nullptr;
+    mapping_handle_ = nullptr;
+    file_handle_ = nullptr;
+    size_ = 0;
+    open_ = false;
+}
+
+#else
+
+bool MappedFile::open(const std::string& filename, Access access) {
+    close();
+    
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        return false;
+    }
+    
+    size_ = static_cast<size_t>(info.st_size);
+    open_ = true;
+    if (size_ == 0) {
+        ::close(fd);
+        return true; // Nothing to map
+    }
+    
+    // The mapping stays valid after the descriptor is closed
+    void* view = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        size_ = 0;
+        open_ = false;
+        return false;
+    }
+    
+    madvise(view, size_, access == RANDOM ? MADV_RANDOM : MADV_SEQUENTIAL);
+    data_ = static_cast<const uint8_t*>(view);
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_) {
+        munmap(const_cast<uint8_t*>(data_), size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    open_ = false;
+}
+
+#endif
+
+} // namespace pcv
\ No newline at end of file
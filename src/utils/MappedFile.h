@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace pcv {
+
+// Read-only memory mapping of a whole file.
+// Pages are loaded by the OS as they are touched, so large binary files can be
+// decoded in place without reading them through a stream first.
+class MappedFile {
+public:
+    // Access pattern hinted to the OS read-ahead
+    enum Access {
+        SEQUENTIAL,   // Decoded front to back: read ahead aggressively
+        RANDOM        // Scattered reads, e.g. out-of-core nodes: no read-ahead
+    };
+    
+    MappedFile() = default;
+    explicit MappedFile(const std::string& filename, Access access = SEQUENTIAL) { open(filename, access); }
+    ~MappedFile();
+    
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    
+    // Map the file, replacing any current mapping. Returns false if it cannot be mapped.
+    bool open(const std::string& filename, Access access = SEQUENTIAL);
+    void close();
+    
+    bool isOpen() const { return open_; }
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+    
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    bool open_ = false;
+#ifdef _WIN32
+    void* file_handle_ = nullptr;
+    void* mapping_handle_ = nullptr;
+#endif
+
+    void swap(MappedFile& other) noexcept;
+};
+
+} // namespace pcv
\ No newline at end of file
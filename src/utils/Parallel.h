@@ -0,0 +1,74 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pcv {
+
+// Resolve a requested thread count (0 = one per hardware thread)
+inline size_t resolveThreadCount(size_t requested) {
+    if (requested > 0) return requested;
+    size_t hardware = std::thread::hardware_concurrency();
+    return hardware > 0 ? hardware : 1;
+}
+
+// Calls fn(thread_index, begin, end) over [0, count) in blocks of grain_size.
+// Threads pull blocks dynamically, so uneven per-item cost still balances;
+// thread_index is stable per thread and can select per-thread scratch buffers.
+// Exceptions thrown by fn are rethrown on the calling thread.
+template<typename Fn>
+void parallelFor(size_t count, size_t num_threads, Fn&& fn, size_t grain_size = 4096) {
+    if (count == 0) return;
+    
+    grain_size = std::max<size_t>(1, grain_size);
+    size_t block_count = (count + grain_size - 1) / grain_size;
+    num_threads = std::min(resolveThreadCount(num_threads), block_count);
+    
+    if (num_threads <= 1) {
+        fn(size_t(0), size_t(0), count);
+        return;
+    }
+    
+    std::atomic<size_t> next_block{0};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    
+    auto worker = [&](size_t thread_index) {
+        try {
+            for (;;) {
+                size_t block = next_block.fetch_add(1, std::memory_order_relaxed);
+                if (block >= block_count) break;
+                
+                size_t begin = block * grain_size;
+                size_t end = std::min(count, begin + grain_size);
+                fn(thread_index, begin, end);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error) error = std::current_exception();
+            next_block.store(block_count, std::memory_order_relaxed);
+        }
+    };
+    
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads - 1);
+    for (size_t t = 1; t < num_threads; ++t) {
+        threads.emplace_back(worker, t);
+    }
+    worker(0);
+    
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+} // namespace pcv
\ No newline at end of file
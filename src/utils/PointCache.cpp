@@ -0,0 +1,362 @@
+#include "utils/PointCache.h"
+#include "utils/Parallel.h"
+#include <algorithm>
+#include <bitset>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace pcv {
+
+namespace {
+
+constexpr char MAGIC[4] = {'P', 'C', 'V', 'C'};
+constexpr size_t WRITE_BLOCK = size_t(1) << 20;   // Elements gathered per write
+constexpr size_t COPY_BLOCK = size_t(1) << 20;    // Elements per parallel copy task
+
+bool hostIsLittleEndian() {
+    const uint16_t probe = 1;
+    uint8_t first;
+    std::memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+// Write channel[index(i)] for i in [0, count) through a bounded buffer
+template<typename T, typename IndexFn>
+void writeGathered(std::ofstream& file, const std::vector<T>& channel, size_t count, IndexFn index) {
+    std::vector<T> buffer(std::min(count, WRITE_BLOCK));
+    for (size_t begin = 0; begin < count; begin += WRITE_BLOCK) {
+        size_t end = std::min(count, begin + WRITE_BLOCK);
+        for (size_t i = begin; i < end; ++i) {
+            buffer[i - begin] = channel[index(i)];
+        }
+        file.write(reinterpret_cast<const char*>(buffer.data()),
+                   static_cast<std::streamsize>((end - begin) * sizeof(T)));
+    }
+}
+
+// Parallel copy so page faults on the mapping overlap
+template<typename T>
+void copyChannel(const T* source, size_t count, std::vector<T>& target) {
+    target.resize(count);
+    parallelFor(count, 0, [&](size_t, size_t begin, size_t end) {
+        std::memcpy(target.data() + begin, source + begin, (end - begin) * sizeof(T));
+    }, COPY_BLOCK);
+}
+
+} // namespace
+
+static_assert(sizeof(PointCache::NodeRecord) == 52, "NodeRecord is a fixed on-disk layout");
+
+bool PointCache::write(const std::string& filename, const PointCloud& cloud, const Octree& octree) {
+    if (!hostIsLittleEndian()) {
+        std::cerr << "Point caches can only be written on little-endian hosts" << std::endl;
+        return false;
+    }
+    
+    std::vector<Octree::Node> nodes;
+    std::vector<uint32_t> indices;
+    std::vector<uint32_t> samples;
+    octree.getCompactLayout(nodes, indices, samples);
+    
+    // Point i of the file is cloud point indices[i]; samples refer to file positions
+    std::vector<uint32_t> file_samples(samples.size());
+    {
+        std::vector<uint32_t> rank(cloud.size(), 0);
+        for (uint32_t i = 0; i < indices.size(); ++i) {
+            rank[indices[i]] = i;
+        }
+        for (size_t i = 0; i < samples.size(); ++i) {
+            file_samples[i] = rank[samples[i]];
+        }
+    }
+    
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open cache file for writing: " << filename << std::endl;
+        return false;
+    }
+    
+    static_assert(sizeof(Header) <= PAGE_SIZE, "Header must fit its page");
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.channels = cloud.getChannels();
+    header.point_count = indices.size();
+    header.node_count = nodes.size();
+    header.sample_count = samples.size();
+    for (int axis = 0; axis < 3; ++axis) {
+        header.min_bound[axis] = nodes.empty() ? 0.0f : cloud.getMinBound()[axis];
+        header.max_bound[axis] = nodes.empty() ? 0.0f : cloud.getMaxBound()[axis];
+    }
+    
+    // The header page is rewritten once the section table is known
+    std::vector<char> padding(PAGE_SIZE, 0);
+    file.write(padding.data(), PAGE_SIZE);
+    
+    auto beginSection = [&](Section section) {
+        size_t offset = static_cast<size_t>(file.tellp());
+        size_t aligned = (offset + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+        file.write(padding.data(), static_cast<std::streamsize>(aligned - offset));
+        header.sections[section].offset = aligned;
+    };
+    auto endSection = [&](Section section) {
+        header.sections[section].size = static_cast<uint64_t>(file.tellp()) - header.sections[section].offset;
+    };
+    
+    // Point channels in leaf order, then each sample's attributes in sample order
+    for (int pass = 0; pass < 2; ++pass) {
+        const bool sample_pass = pass == 1;
+        const size_t count = sample_pass ? samples.size() : indices.size();
+        auto index = [&](size_t i) -> size_t { return sample_pass ? samples[i] : indices[i]; };
+        const int base = sample_pass ? SAMPLE_POSITIONS : POSITIONS;
+        
+        beginSection(static_cast<Section>(base));
+        writeGathered(file, cloud.getPositions(), count, index);
+        endSection(static_cast<Section>(base));
+        if (cloud.hasColors()) {
+            beginSection(static_cast<Section>(base + 1));
+            writeGathered(file, cloud.getColors(), count, index);
+            endSection(static_cast<Section>(base + 1));
+        }
+        if (cloud.hasNormals()) {
+            beginSection(static_cast<Section>(base + 2));
+            writeGathered(file, cloud.getNormals(), count, index);
+            endSection(static_cast<Section>(base + 2));
+        }
+        if (cloud.hasIntensities()) {
+            beginSection(static_cast<Section>(base + 3));
+            writeGathered(file, cloud.getIntensities(), count, index);
+            endSection(static_cast<Section>(base + 3));
+        }
+        
+        if (!sample_pass) {
+            std::vector<NodeRecord> records(nodes.size());
+            for (size_t i = 0; i < nodes.size(); ++i) {
+                const Octree::Node& node = nodes[i];
+                NodeRecord& record = records[i];
+                std::memset(&record, 0, sizeof(record));
+                for (int axis = 0; axis < 3; ++axis) {
+                    record.min_bound[axis] = node.min_bound[axis];
+                    record.max_bound[axis] = node.max_bound[axis];
+                }
+                record.begin = node.begin;
+                record.end = node.end;
+                record.point_count = node.point_count;
+                record.first_child = node.first_child;
+                record.sample_begin = node.sample_begin;
+                record.sample_end = node.sample_end;
+                record.child_mask = node.child_mask;
+                record.depth = node.depth;
+            }
+            beginSection(NODES);
+            file.write(reinterpret_cast<const char*>(records.data()),
+                       static_cast<std::streamsize>(records.size() * sizeof(NodeRecord)));
+            endSection(NODES);
+            
+            beginSection(SAMPLES);
+            file.write(reinterpret_cast<const char*>(file_samples.data()),
+                       static_cast<std::streamsize>(file_samples.size() * sizeof(uint32_t)));
+            endSection(SAMPLES);
+        }
+    }
+    
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (!file.good()) {
+        std::cerr << "Failed to write cache file: " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool PointCache::open(const std::string& filename, MappedFile::Access access) {
+    close();
+    if (!hostIsLittleEndian()) {
+        std::cerr << "Point caches can only be read on little-endian hosts" << std::endl;
+        return false;
+    }
+    if (!file_.open(filename, access)) {
+        std::cerr << "Failed to map cache file: " << filename << std::endl;
+        return false;
+    }
+    
+    const Header* header = reinterpret_cast<const Header*>(file_.data());
+    if (file_.size() < PAGE_SIZE || std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        header->version != VERSION) {
+        std::cerr << "Not a version " << VERSION << " point cache: " << filename << std::endl;
+        file_.close();
+        return false;
+    }
+    
+    // Every section must be page aligned, inside the file and exactly as large as its count says
+    const uint32_t channels = header->channels;
+    auto expected = [&](int section) -> uint64_t {
+        const bool sample = section >= SAMPLE_POSITIONS;
+        const uint64_t count = sample ? header->sample_count : header->point_count;
+        switch (sample ? section - SAMPLE_POSITIONS : section) {
+            case POSITIONS: return count * sizeof(glm::vec3);
+            case COLORS: return (channels & PointCloud::COLOR) ? count * sizeof(PackedColor) : 0;
+            case NORMALS: return (channels & PointCloud::NORMAL) ? count * sizeof(PackedNormal) : 0;
+            case INTENSITIES: return (channels & PointCloud::INTENSITY) ? count * sizeof(float) : 0;
+            case NODES: return header->node_count * sizeof(NodeRecord);
+            default: return header->sample_count * sizeof(uint32_t);
+        }
+    };
+    for (int section = 0; section < SECTION_COUNT; ++section) {
+        const SectionEntry& entry = header->sections[section];
+        if (entry.size != expected(section) || entry.offset % PAGE_SIZE != 0 ||
+            entry.offset > file_.size() || entry.size > file_.size() - entry.offset) {
+            std::cerr << "Corrupt point cache: " << filename << std::endl;
+            file_.close();
+            return false;
+        }
+    }
+    
+    // Readers use the node table in place, so check it once here, as Octree::setLayout
+    // does: ranges inside their sections, indices inside the cloud, and children after
+    // their parent (no cycles) and inside the table
+    header_ = header;
+    if (!validateNodes()) {
+        std::cerr << "Corrupt point cache nodes: " << filename << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool PointCache::validateNodes() const {
+    const NodeRecord* nodes = getNodes();
+    const uint32_t* samples = getSamples();
+    const uint64_t point_count = header_->point_count;
+    const uint64_t node_count = header_->node_count;
+    const uint64_t sample_count = header_->sample_count;
+    
+    for (uint64_t i = 0; i < node_count; ++i) {
+        const NodeRecord& node = nodes[i];
+        if (node.begin > node.end || node.end > point_count ||
+            node.sample_begin > node.sample_end || node.sample_end > sample_count) {
+            return false;
+        }
+        if (node.child_mask != 0) {
+            const uint64_t child_count = std::bitset<8>(node.child_mask).count();
+            if (node.first_child <= i || node.first_child + child_count > node_count) {
+                return false;
+            }
+        }
+    }
+    return std::none_of(samples, samples + sample_count, [&](uint32_t index) { return index >= point_count; });
+}
+
+void PointCache::close() {
+    header_ = nullptr;
+    file_.close();
+}
+
+size_t PointCache::getPointCount() const {
+    return header_ ? static_cast<size_t>(header_->point_count) : 0;
+}
+
+size_t PointCache::getNodeCount() const {
+    return header_ ? static_cast<size_t>(header_->node_count) : 0;
+}
+
+size_t PointCache::getSampleCount() const {
+    return header_ ? static_cast<size_t>(header_->sample_count) : 0;
+}
+
+uint32_t PointCache::getChannels() const {
+    return header_ ? header_->channels : 0;
+}
+
+glm::vec3 PointCache::getMinBound() const {
+    return header_ ? glm::vec3(header_->min_bound[0], header_->min_bound[1], header_->min_bound[2]) : glm::vec3(0.0f);
+}
+
+glm::vec3 PointCache::getMaxBound() const {
+    return header_ ? glm::vec3(header_->max_bound[0], header_->max_bound[1], header_->max_bound[2]) : glm::vec3(0.0f);
+}
+
+template<typename T>
+const T* PointCache::section(Section section) const {
+    if (!header_ || header_->sections[section].size == 0) return nullptr;
+    return reinterpret_cast<const T*>(file_.data() + header_->sections[section].offset);
+}
+
+const glm::vec3* PointCache::getPositions(bool samples) const {
+    return section<glm::vec3>(samples ? SAMPLE_POSITIONS : POSITIONS);
+}
+
+const PackedColor* PointCache::getColors(bool samples) const {
+    return section<PackedColor>(samples ? SAMPLE_COLORS : COLORS);
+}
+
+const PackedNormal* PointCache::getNormals(bool samples) const {
+    return section<PackedNormal>(samples ? SAMPLE_NORMALS : NORMALS);
+}
+
+const float* PointCache::getIntensities(bool samples) const {
+    return section<float>(samples ? SAMPLE_INTENSITIES : INTENSITIES);
+}
+
+const PointCache::NodeRecord* PointCache::getNodes() const {
+    return section<NodeRecord>(NODES);
+}
+
+const uint32_t* PointCache::getSamples() const {
+    return section<uint32_t>(SAMPLES);
+}
+
+bool PointCache::load(PointCloud& cloud) const {
+    if (!header_) return false;
+    
+    const size_t count = getPointCount();
+    cloud.clear();
+    cloud.setChannels(getChannels());
+    copyChannel(getPositions(), count, cloud.getPositions());
+    if (cloud.hasColors()) copyChannel(getColors(), count, cloud.getColors());
+    if (cloud.hasNormals()) copyChannel(getNormals(), count, cloud.getNormals());
+    if (cloud.hasIntensities()) copyChannel(getIntensities(), count, cloud.getIntensities());
+    
+    if (count > 0) {
+        cloud.expandBounds(getMinBound(), getMaxBound());
+    }
+    return true;
+}
+
+bool PointCache::loadOctree(Octree& octree) const {
+    if (!header_) return false;
+    
+    const NodeRecord* records = getNodes();
+    std::vector<Octree::Node> nodes(getNodeCount());
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        const NodeRecord& record = records[i];
+        Octree::Node& node = nodes[i];
+        node.min_bound = glm::vec3(record.min_bound[0], record.min_bound[1], record.min_bound[2]);
+        node.max_bound = glm::vec3(record.max_bound[0], record.max_bound[1], record.max_bound[2]);
+        node.begin = record.begin;
+        node.end = record.end;
+        node.point_count = record.point_count;
+        node.first_child = record.first_child;
+        node.sample_begin = record.sample_begin;
+        node.sample_end = record.sample_end;
+        node.child_mask = record.child_mask;
+        node.depth = record.depth;
+    }
+    
+    // Points are stored in leaf order, so the index buffer is the identity
+    std::vector<uint32_t> indices(getPointCount());
+    parallelFor(indices.size(), 0, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            indices[i] = static_cast<uint32_t>(i);
+        }
+    }, COPY_BLOCK);
+    
+    std::vector<uint32_t> samples;
+    copyChannel(getSamples(), getSampleCount(), samples);
+    return octree.setLayout(std::move(nodes), std::move(indices), std::move(samples));
+}
+
+} // namespace pcv
\ No newline at end of file
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "core/PointCloud.h"
+#include "core/Octree.h"
+#include "utils/MappedFile.h"
+#include <string>
+
+namespace pcv {
+
+// Native .pcvc cache: a cloud stored in octree leaf order together with its flat
+// node array and LOD samples, so reopening needs neither parsing nor an octree build.
+// Every section starts on a page boundary and every node's points (and an interior
+// node's samples, whose attributes are stored alongside) are one contiguous run, so a
+// mapped cache only pages in what is touched. Data is little-endian and used in place.
+class PointCache {
+public:
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t PAGE_SIZE = 4096;
+    
+    enum Section {
+        POSITIONS,            // glm::vec3 per point, leaf order
+        COLORS,               // PackedColor per point (if present)
+        NORMALS,              // PackedNormal per point (if present)
+        INTENSITIES,          // float per point (if present)
+        NODES,                // Node records, same layout as Octree::getNodes()
+        SAMPLES,              // uint32 point index per LOD sample
+        SAMPLE_POSITIONS,     // Sample attributes, copied so samples read contiguously
+        SAMPLE_COLORS,
+        SAMPLE_NORMALS,
+        SAMPLE_INTENSITIES,
+        SECTION_COUNT
+    };
+    
+    // Node as stored on disk; indices are implicit (point i of the file is index i)
+    struct NodeRecord {
+        float min_bound[3];
+        float max_bound[3];
+        uint32_t begin;
+        uint32_t end;
+        uint32_t point_count;
+        uint32_t first_child;
+        uint32_t sample_begin;
+        uint32_t sample_end;
+        uint8_t child_mask;
+        uint8_t depth;
+        uint8_t padding[2];
+    };
+    
+    // Write cloud in the leaf order of octree (built over cloud). Points the octree
+    // does not hold are dropped.
+    static bool write(const std::string& filename, const PointCloud& cloud, const Octree& octree);
+    
+    // Map and validate a cache: the header, section sizes and the node table are
+    // checked, attributes are not read until accessed. Out-of-core readers pass
+    // MappedFile::RANDOM so the OS does not read ahead past the nodes they touch.
+    bool open(const std::string& filename, MappedFile::Access access = MappedFile::SEQUENTIAL);
+    void close();
+    bool isOpen() const { return header_ != nullptr; }
+    
+    size_t getPointCount() const;
+    size_t getNodeCount() const;
+    size_t getSampleCount() const;
+    uint32_t getChannels() const;
+    glm::vec3 getMinBound() const;
+    glm::vec3 getMaxBound() const;
+    
+    // Mapped channels of the points, or of the LOD samples; nullptr when absent
+    const glm::vec3* getPositions(bool samples = false) const;
+    const PackedColor* getColors(bool samples = false) const;
+    const PackedNormal* getNormals(bool samples = false) const;
+    const float* getIntensities(bool samples = false) const;
+    const NodeRecord* getNodes() const;
+    const uint32_t* getSamples() const;
+    
+    // Copy the points into cloud (replacing its contents)
+    bool load(PointCloud& cloud) const;
+    
+    // Adopt the stored layout; octree must index a cloud filled by load()
+    bool loadOctree(Octree& octree) const;
+    
+private:
+    struct SectionEntry {
+        uint64_t offset;
+        uint64_t size;
+    };
+    
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint32_t channels;
+        uint32_t reserved;
+        uint64_t point_count;
+        uint64_t node_count;
+        uint64_t sample_count;
+        float min_bound[3];
+        float max_bound[3];
+        SectionEntry sections[SECTION_COUNT];
+    };
+    
+    MappedFile file_;
+    const Header* header_ = nullptr;
+    
+    template<typename T>
+    const T* section(Section section) const;
+    bool validateNodes() const;
+};
+
+} // namespace pcv
\ No newline at end of file
@@ -0,0 +1,201 @@
+#include "utils/Profiler.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace pcv {
+
+namespace {
+
+const char* domainName(Profiler::Domain domain) {
+    return domain == Profiler::Domain::GPU ? "gpu" : "cpu";
+}
+
+// Stage names are identifiers chosen in code, but keep the JSON valid regardless
+std::string escapeJSON(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (static_cast<unsigned char>(c) >= 0x20) {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+} // namespace
+
+Profiler::Profiler(const Parameters& params)
+    : params_(params), origin_(std::chrono::steady_clock::now()) {
+    params_.history_frames = std::max<size_t>(params_.history_frames, 1);
+    params_.max_events = std::max<size_t>(params_.max_events, 1);
+}
+
+double Profiler::now() const {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - origin_).count();
+}
+
+void Profiler::beginFrame() {
+    double start = now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (frame_start_ms_ >= 0.0) {
+        recordLocked("frame", frame_start_ms_, static_cast<float>(start - frame_start_ms_), Domain::CPU);
+    }
+    frame_start_ms_ = start;
+    frame_++;
+}
+
+uint64_t Profiler::getFrame() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return frame_;
+}
+
+void Profiler::record(const char* stage, double start_ms, float duration_ms, Domain domain) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    recordLocked(stage, start_ms, duration_ms, domain);
+}
+
+void Profiler::recordLocked(const char* stage, double start_ms, float duration_ms, Domain domain) {
+    uint32_t index = stageIndex(stage, domain);
+    Stage& entry = stages_[index];
+    entry.history[entry.next] = duration_ms;
+    entry.next = (entry.next + 1) % entry.history.size();
+    entry.count = std::min(entry.count + 1, entry.history.size());
+    
+    // GPU events get their own track in the trace
+    uint32_t thread = domain == Domain::GPU ? 0 : threadIndex(std::this_thread::get_id());
+    Event event{index, thread, frame_, start_ms, duration_ms};
+    if (events_.size() < params_.max_events) {
+        events_.push_back(event);
+    } else {
+        events_[next_event_] = event;
+        next_event_ = (next_event_ + 1) % events_.size();
+    }
+}
+
+uint32_t Profiler::stageIndex(const char* stage, Domain domain) {
+    for (size_t i = 0; i < stages_.size(); ++i) {
+        if (stages_[i].domain == domain && stages_[i].name == stage) {
+            return static_cast<uint32_t>(i);
+        }
+    }
+    
+    Stage entry;
+    entry.name = stage;
+    entry.domain = domain;
+    entry.history.assign(params_.history_frames, 0.0f);
+    stages_.push_back(std::move(entry));
+    return static_cast<uint32_t>(stages_.size() - 1);
+}
+
+uint32_t Profiler::threadIndex(std::thread::id id) {
+    // Track 0 is the GPU; CPU threads follow in order of their first event
+    for (size_t i = 0; i < threads_.size(); ++i) {
+        if (threads_[i] == id) {
+            return static_cast<uint32_t>(i + 1);
+        }
+    }
+    threads_.push_back(id);
+    return static_cast<uint32_t>(threads_.size());
+}
+
+std::vector<Profiler::StageSummary> Profiler::getSummary() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<StageSummary> summary;
+    std::vector<float> sorted;
+    for (const Stage& stage : stages_) {
+        StageSummary entry;
+        entry.name = stage.name;
+        entry.domain = stage.domain;
+        entry.samples = stage.count;
+        if (stage.count > 0) {
+            size_t last = (stage.next + stage.history.size() - 1) % stage.history.size();
+            entry.last_ms = stage.history[last];
+            
+            // Before the window fills, the valid durations are the first count slots
+            sorted.assign(stage.history.begin(), stage.history.begin() + stage.count);
+            std::sort(sorted.begin(), sorted.end());
+            double sum = 0.0;
+            for (float value : sorted) {
+                sum += value;
+            }
+            auto percentile = [&sorted](double p) {
+                return sorted[static_cast<size_t>(p * (sorted.size() - 1) + 0.5)];
+            };
+            entry.mean_ms = static_cast<float>(sum / sorted.size());
+            entry.p50_ms = percentile(0.50);
+            entry.p95_ms = percentile(0.95);
+            entry.p99_ms = percentile(0.99);
+        }
+        summary.push_back(entry);
+    }
+    return summary;
+}
+
+std::vector<Profiler::Event> Profiler::orderedEvents() const {
+    std::vector<Event> events;
+    events.reserve(events_.size());
+    events.insert(events.end(), events_.begin() + next_event_, events_.end());
+    events.insert(events.end(), events_.begin(), events_.begin() + next_event_);
+    return events;
+}
+
+bool Profiler::writeChromeTrace(const std::string& filename) const {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file for writing: " << filename << std::endl;
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    // Complete ("X") events in microseconds, plus a name for every track
+    file << std::fixed << std::setprecision(3);
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"GPU\"}}";
+    for (size_t t = 0; t < threads_.size(); ++t) {
+        file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << t + 1
+             << ",\"args\":{\"name\":\"CPU " << t << "\"}}";
+    }
+    for (const Event& event : orderedEvents()) {
+        const Stage& stage = stages_[event.stage];
+        file << ",\n{\"name\":\"" << escapeJSON(stage.name) << "\",\"cat\":\"" << domainName(stage.domain)
+             << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.thread
+             << ",\"ts\":" << event.start_ms * 1000.0 << ",\"dur\":" << event.duration_ms * 1000.0
+             << ",\"args\":{\"frame\":" << event.frame << "}}";
+    }
+    file << "\n]}\n";
+    return file.good();
+}
+
+bool Profiler::writeCSV(const std::string& filename) const {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file for writing: " << filename << std::endl;
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    file << std::fixed << std::setprecision(4);
+    file << "frame,stage,domain,thread,start_ms,duration_ms\n";
+    for (const Event& event : orderedEvents()) {
+        const Stage& stage = stages_[event.stage];
+        file << event.frame << ',' << stage.name << ',' << domainName(stage.domain) << ','
+             << event.thread << ',' << event.start_ms << ',' << event.duration_ms << '\n';
+    }
+    return file.good();
+}
+
+void Profiler::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stages_.clear();
+    events_.clear();
+    next_event_ = 0;
+    threads_.clear();
+    frame_start_ms_ = -1.0;
+}
+
+} // namespace pcv
\ No newline at end of file
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pcv {
+
+// Per-stage frame profiler.
+// Stages are named durations: CPU stages come from ScopedTimer around the code, GPU
+// stages from timer queries read back by the renderer. Every stage keeps a rolling
+// window of durations for percentiles, and the most recent events can be written as
+// a Chrome trace (chrome://tracing, Perfetto) or CSV. record() may be called from
+// any thread.
+class Profiler {
+public:
+    enum class Domain {
+        CPU,
+        GPU
+    };
+    
+    struct Parameters {
+        size_t history_frames;   // Durations kept per stage for the percentiles
+        size_t max_events;       // Trace events kept for export, oldest dropped first
+        
+        Parameters() : history_frames(240), max_events(size_t(1) << 16) {}
+    };
+    
+    struct StageSummary {
+        std::string name;
+        Domain domain = Domain::CPU;
+        size_t samples = 0;      // Durations in the window
+        float last_ms = 0.0f;
+        float mean_ms = 0.0f;
+        float p50_ms = 0.0f;
+        float p95_ms = 0.0f;
+        float p99_ms = 0.0f;
+    };
+    
+    explicit Profiler(const Parameters& params = Parameters());
+    
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+    
+    // Frame boundaries; the interval between two beginFrame() calls is recorded as the
+    // "frame" stage
+    void beginFrame();
+    uint64_t getFrame() const;
+    
+    // Milliseconds since the profiler was created; the time base of every event
+    double now() const;
+    
+    // Add a duration. GPU stages are placed at the time their commands were issued.
+    void record(const char* stage, double start_ms, float duration_ms, Domain domain = Domain::CPU);
+    
+    // Stages in first-recorded order, CPU and GPU stages of the same name kept apart
+    std::vector<StageSummary> getSummary() const;
+    
+    bool writeChromeTrace(const std::string& filename) const;
+    bool writeCSV(const std::string& filename) const;
+    
+    void clear();
+    
+private:
+    struct Stage {
+        std::string name;
+        Domain domain;
+        std::vector<float> history;   // Ring of durations
+        size_t next = 0;
+        size_t count = 0;
+    };
+    
+    struct Event {
+        uint32_t stage;
+        uint32_t thread;      // Index into threads_
+        uint64_t frame;
+        double start_ms;
+        float duration_ms;
+    };
+    
+    Parameters params_;
+    std::chrono::steady_clock::time_point origin_;
+    
+    mutable std::mutex mutex_;
+    std::vector<Stage> stages_;
+    std::vector<Event> events_;         // Ring once max_events is reached
+    size_t next_event_ = 0;
+    std::vector<std::thread::id> threads_;
+    uint64_t frame_ = 0;
+    double frame_start_ms_ = -1.0;
+    
+    uint32_t stageIndex(const char* stage, Domain domain);
+    uint32_t threadIndex(std::thread::id id);
+    void recordLocked(const char* stage, double start_ms, float duration_ms, Domain domain);
+    std::vector<Event> orderedEvents() const;
+};
+
+// Records the time until it goes out of scope as a CPU stage; does nothing without a
+// profiler
+class ScopedTimer {
+public:
+    ScopedTimer(Profiler* profiler, const char* stage)
+        : profiler_(profiler), stage_(stage), start_ms_(profiler ? profiler->now() : 0.0) {}
+    
+    ~ScopedTimer() { stop(); }
+    
+    // Record now instead of at the end of the scope
+    void stop() {
+        if (profiler_) {
+            profiler_->record(stage_, start_ms_, static_cast<float>(profiler_->now() - start_ms_));
+            profiler_ = nullptr;
+        }
+    }
+    
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+    
+private:
+    Profiler* profiler_;
+    const char* stage_;
+    double start_ms_;
+};
+
+} // namespace pcv
\ No newline at end of file
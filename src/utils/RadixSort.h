@@ -0,0 +1,91 @@
+#pragma once
+
+#include "utils/Parallel.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace pcv {
+
+// Stable LSD radix sort of unsigned keys by bits [begin_bit, end_bit).
+// Payloads can ride in the bits outside the range (e.g. a 32-bit index in the low
+// half of a 64-bit key sorted by its high half). Bits are split into as few passes
+// of at most 11 bits as possible, and passes whose digit is the same for every key
+// are skipped.
+//
+// With num_threads != 1 each pass histograms and scatters fixed blocks of keys
+// concurrently; blocks keep their relative order, so the result is the same
+// stable order for every thread count (0 = all hardware threads).
+template<typename Key>
+void radixSort(std::vector<Key>& keys, int begin_bit = 0,
+               int end_bit = static_cast<int>(sizeof(Key) * 8),
+               size_t num_threads = 1) {
+    static_assert(std::is_unsigned<Key>::value, "radix sort keys must be unsigned");
+    
+    const size_t count = keys.size();
+    const int total_bits = end_bit - begin_bit;
+    if (count < 2 || total_bits <= 0) return;
+    
+    constexpr int max_digit_bits = 11;
+    const int passes = (total_bits + max_digit_bits - 1) / max_digit_bits;
+    const int digit_bits = (total_bits + passes - 1) / passes;
+    
+    const size_t radix = size_t(1) << digit_bits;
+    
+    // Small inputs are not worth the threads; otherwise a few blocks per thread
+    constexpr size_t min_block_size = size_t(1) << 16;
+    num_threads = resolveThreadCount(num_threads);
+    size_t block_size = count;
+    if (num_threads > 1 && count > min_block_size) {
+        block_size = std::max(min_block_size, (count + num_threads * 4 - 1) / (num_threads * 4));
+    }
+    const size_t block_count = (count + block_size - 1) / block_size;
+    
+    std::vector<Key> scratch(count);
+    std::vector<size_t> histograms(block_count * radix);
+    
+    for (int shift = begin_bit; shift < end_bit; shift += digit_bits) {
+        const int bits = std::min(digit_bits, end_bit - shift);
+        const Key mask = static_cast<Key>((Key(1) << bits) - 1);
+        
+        parallelFor(count, num_threads, [&](size_t, size_t begin, size_t end) {
+            size_t* histogram = &histograms[(begin / block_size) * radix];
+            std::fill(histogram, histogram + radix, 0);
+            for (size_t i = begin; i < end; ++i) {
+                histogram[(keys[i] >> shift) & mask]++;
+            }
+        }, block_size);
+        
+        // Every key has the same digit - order is unchanged
+        const size_t first_digit = (keys[0] >> shift) & mask;
+        size_t first_digit_count = 0;
+        for (size_t block = 0; block < block_count; ++block) {
+            first_digit_count += histograms[block * radix + first_digit];
+        }
+        if (first_digit_count == count) continue;
+        
+        // Exclusive prefix sum, digit-major then block, so earlier blocks land first
+        size_t offset = 0;
+        for (size_t digit = 0; digit < radix; ++digit) {
+            for (size_t block = 0; block < block_count; ++block) {
+                size_t& bucket = histograms[block * radix + digit];
+                size_t bucket_count = bucket;
+                bucket = offset;
+                offset += bucket_count;
+            }
+        }
+        
+        parallelFor(count, num_threads, [&](size_t, size_t begin, size_t end) {
+            size_t* histogram = &histograms[(begin / block_size) * radix];
+            for (size_t i = begin; i < end; ++i) {
+                scratch[histogram[(keys[i] >> shift) & mask]++] = keys[i];
+            }
+        }, block_size);
+        
+        keys.swap(scratch);
+    }
+}
+
+} // namespace pcv
\ No newline at end of file
@@ -0,0 +1,284 @@
+#include "utils/TextParser.h"
+#include "utils/Parallel.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+namespace pcv {
+
+namespace {
+
+constexpr size_t MIN_CHUNK_BYTES = size_t(1) << 20;
+constexpr size_t FILE_BLOCK_BYTES = size_t(64) << 20;
+
+bool isSeparator(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == ',';
+}
+
+int maxColumn(const TextParser::Layout& layout, bool with_colors) {
+    int column = std::max(layout.position_columns[0],
+                          std::max(layout.position_columns[1], layout.position_columns[2]));
+    if (with_colors) {
+        column = std::max(column, std::max(layout.color_columns[0],
+                                           std::max(layout.color_columns[1], layout.color_columns[2])));
+    }
+    return column;
+}
+
+} // namespace
+
+TextParser::Layout TextParser::xyzLayout() {
+    Layout layout;
+    layout.color_columns[0] = 3;
+    layout.color_columns[1] = 4;
+    layout.color_columns[2] = 5;
+    return layout;
+}
+
+bool TextParser::parseFloat(const char*& cursor, const char* end, float& value) {
+    while (cursor < end && isSeparator(*cursor)) ++cursor;
+    if (cursor < end && *cursor == '+') ++cursor; // from_chars rejects a leading '+'
+    if (cursor >= end) return false;
+
+#if defined(__cpp_lib_to_chars)
+    auto result = std::from_chars(cursor, end, value);
+    if (result.ec != std::errc()) return false;
+    cursor = result.ptr;
+#else
+    // strtof needs a terminated token
+    char token[64];
+    size_t length = 0;
+    while (cursor + length < end && length < sizeof(token) - 1 && !isSeparator(cursor[length]) &&
+           cursor[length] != '\n') {
+        token[length] = cursor[length];
+        ++length;
+    }
+    token[length] = '\0';
+    char* token_end = nullptr;
+    value = std::strtof(token, &token_end);
+    if (token_end == token) return false;
+    cursor += token_end - token;
+#endif
+    return true;
+}
+
+size_t TextParser::parseLines(const char* begin, const char* end, const Layout& layout,
+                              glm::vec3* positions, PackedColor* colors, bool& found_colors,
+                              glm::vec3& min_bound, glm::vec3& max_bound) {
+    const int position_column = maxColumn(layout, false);
+    const int needed = colors ? maxColumn(layout, true) + 1 : position_column + 1;
+    
+    size_t count = 0;
+    float values[MAX_COLUMNS];
+    const char* cursor = begin;
+    while (cursor < end) {
+        const char* line_end = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+        if (!line_end) line_end = end;
+        
+        const char* field = cursor;
+        while (field < line_end && isSeparator(*field)) ++field;
+        
+        // Skip empty lines and comments
+        if (field < line_end && *field != '#') {
+            int value_count = 0;
+            while (value_count < needed && parseFloat(field, line_end, values[value_count])) {
+                value_count++;
+            }
+            
+            if (value_count > position_column) {
+                glm::vec3 position(values[layout.position_columns[0]],
+                                   values[layout.position_columns[1]],
+                                   values[layout.position_columns[2]]);
+                positions[count] = position;
+                min_bound = glm::min(min_bound, position);
+                max_bound = glm::max(max_bound, position);
+                
+                if (colors && value_count >= needed) {
+                    glm::vec3 color(values[layout.color_columns[0]],
+                                    values[layout.color_columns[1]],
+                                    values[layout.color_columns[2]]);
+                    colors[count] = packColor(color * layout.color_scale);
+                    found_colors = true;
+                }
+                count++;
+            }
+        }
+        
+        cursor = line_end + 1;
+    }
+    return count;
+}
+
+size_t TextParser::parse(const char* begin, const char* end, const Layout& layout,
+                         PointCloud& cloud, int num_threads) {
+    if (begin >= end || layout.max_points == 0) return 0;
+    
+    if (std::min(layout.position_columns[0], std::min(layout.position_columns[1], layout.position_columns[2])) < 0 ||
+        maxColumn(layout, false) >= MAX_COLUMNS) {
+        std::cerr << "Invalid text layout: position columns out of range" << std::endl;
+        return 0;
+    }
+    const bool parse_colors = layout.hasColors() && maxColumn(layout, true) < MAX_COLUMNS;
+    
+    // Line-aligned chunks, a few per thread so uneven lines still balance
+    const size_t threads = resolveThreadCount(static_cast<size_t>(num_threads));
+    const size_t bytes = static_cast<size_t>(end - begin);
+    const size_t chunk_count = threads > 1 ? std::max<size_t>(1, std::min(threads * 4, bytes / MIN_CHUNK_BYTES)) : 1;
+    
+    std::vector<const char*> chunk_bounds(chunk_count + 1, end);
+    chunk_bounds[0] = begin;
+    for (size_t c = 1; c < chunk_count; ++c) {
+        const char* split = std::max(chunk_bounds[c - 1], begin + bytes * c / chunk_count);
+        const char* newline = static_cast<const char*>(std::memchr(split, '\n', end - split));
+        chunk_bounds[c] = newline ? newline + 1 : end;
+    }
+    
+    // At most one point per line, so line counts give every chunk its output slots
+    std::vector<size_t> offsets(chunk_count + 1, 0);
+    parallelFor(chunk_count, threads, [&](size_t, size_t chunk_begin, size_t chunk_end) {
+        for (size_t c = chunk_begin; c < chunk_end; ++c) {
+            const char* first = chunk_bounds[c];
+            const char* last = chunk_bounds[c + 1];
+            size_t lines = static_cast<size_t>(std::count(first, last, '\n'));
+            if (last > first && last[-1] != '\n') lines++;
+            offsets[c + 1] = lines;
+        }
+    }, 1);
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    
+    const size_t base = cloud.size();
+    const bool had_colors = cloud.hasColors();
+    if (parse_colors) {
+        cloud.enableChannels(PointCloud::COLOR);
+    }
+    
+    auto& positions = cloud.getPositions();
+    auto& colors = cloud.getColors();
+    positions.resize(base + offsets.back());
+    if (cloud.hasColors()) {
+        colors.resize(base + offsets.back(), packColor(Point().color));
+    }
+    
+    std::vector<size_t> counts(chunk_count, 0);
+    std::vector<uint8_t> found_colors(chunk_count, 0);
+    std::vector<glm::vec3> min_bounds(chunk_count, glm::vec3(std::numeric_limits<float>::max()));
+    std::vector<glm::vec3> max_bounds(chunk_count, glm::vec3(std::numeric_limits<float>::lowest()));
+    
+    parallelFor(chunk_count, threads, [&](size_t, size_t chunk_begin, size_t chunk_end) {
+        for (size_t c = chunk_begin; c < chunk_end; ++c) {
+            bool found = false;
+            counts[c] = parseLines(chunk_bounds[c], chunk_bounds[c + 1], layout,
+                                   positions.data() + base + offsets[c],
+                                   parse_colors ? colors.data() + base + offsets[c] : nullptr,
+                                   found, min_bounds[c], max_bounds[c]);
+            found_colors[c] = found;
+        }
+    }, 1);
+    
+    // Close the gaps left by skipped lines
+    size_t write = base;
+    bool any_colors = false;
+    glm::vec3 min_bound(std::numeric_limits<float>::max());
+    glm::vec3 max_bound(std::numeric_limits<float>::lowest());
+    for (size_t c = 0; c < chunk_count; ++c) {
+        size_t count = std::min(counts[c], layout.max_points - (write - base));
+        size_t read = base + offsets[c];
+        if (read != write) {
+            std::copy(positions.begin() + read, positions.begin() + read + count, positions.begin() + write);
+            if (cloud.hasColors()) {
+                std::copy(colors.begin() + read, colors.begin() + read + count, colors.begin() + write);
+            }
+        }
+        
+        if (count == counts[c]) {
+            min_bound = glm::min(min_bound, min_bounds[c]);
+            max_bound = glm::max(max_bound, max_bounds[c]);
+        } else {
+            // Truncated by max_points - only the kept points count
+            for (size_t i = write; i < write + count; ++i) {
+                min_bound = glm::min(min_bound, positions[i]);
+                max_bound = glm::max(max_bound, positions[i]);
+            }
+        }
+        any_colors = any_colors || found_colors[c];
+        write += count;
+    }
+    
+    positions.resize(write);
+    if (cloud.hasColors()) {
+        colors.resize(write);
+    }
+    if (parse_colors && !had_colors && !any_colors) {
+        cloud.setChannels(cloud.getChannels() & ~PointCloud::COLOR);
+    }
+    if (write > base) {
+        cloud.expandBounds(min_bound, max_bound);
+    }
+    return write - base;
+}
+
+bool TextParser::parseFile(const std::string& filename, std::streamoff offset,
+                           const Layout& layout, PointCloud& cloud, int num_threads) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file: " << filename << std::endl;
+        return false;
+    }
+    
+    file.seekg(0, std::ios::end);
+    const size_t file_size = static_cast<size_t>(file.tellg());
+    file.seekg(offset, std::ios::beg);
+    
+    // Large blocks keep memory bounded; the partial last line carries over
+    std::vector<char> buffer;
+    size_t carried = 0;
+    size_t consumed = 0;
+    size_t parsed = 0;
+    Layout block_layout = layout;
+    
+    while (parsed < layout.max_points) {
+        buffer.resize(carried + FILE_BLOCK_BYTES);
+        file.read(buffer.data() + carried, static_cast<std::streamsize>(FILE_BLOCK_BYTES));
+        const size_t count = static_cast<size_t>(file.gcount());
+        const bool last_block = count < FILE_BLOCK_BYTES;
+        if (file.bad()) {
+            std::cerr << "Failed to read file: " << filename << std::endl;
+            return false;
+        }
+        
+        const char* data = buffer.data();
+        const char* data_end = data + carried + count;
+        const char* parse_end = data_end;
+        if (!last_block) {
+            while (parse_end > data && parse_end[-1] != '\n') --parse_end;
+            if (parse_end == data) {
+                carried += count; // A line longer than a block - keep reading
+                continue;
+            }
+        }
+        
+        block_layout.max_points = layout.max_points - parsed;
+        parsed += parse(data, parse_end, block_layout, cloud, num_threads);
+        
+        // Reserve once, extrapolating the first block's density to the whole file
+        if (consumed == 0 && !last_block && parse_end > data) {
+            double points_per_byte = static_cast<double>(parsed) / (parse_end - data);
+            size_t estimate = static_cast<size_t>(points_per_byte * (file_size - offset) * 1.05);
+            cloud.reserve(std::min(estimate, layout.max_points));
+        }
+        consumed += parse_end - data;
+        
+        if (last_block) break;
+        carried = data_end - parse_end;
+        std::memmove(buffer.data(), parse_end, carried);
+    }
+    return true;
+}
+
+} // namespace pcv
\ No newline at end of file
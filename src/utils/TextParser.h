@@ -0,0 +1,52 @@
+#pragma once
+
+#include "core/PointCloud.h"
+#include <ios>
+#include <string>
+
+namespace pcv {
+
+// Whitespace-separated ASCII point parser shared by the text loaders.
+// Text is split into line-aligned chunks that are parsed concurrently straight into
+// the cloud's channels (sized once per call), with std::from_chars and no per-line
+// allocation. Empty lines, lines starting with '#' and lines without all position
+// columns are skipped.
+class TextParser {
+public:
+    static constexpr int MAX_COLUMNS = 32;
+    
+    struct Layout {
+        int position_columns[3];   // Columns of x, y, z
+        int color_columns[3];      // Columns of r, g, b, or -1 when there are none
+        float color_scale;         // Takes stored colors to [0, 1] (1/255 for 8-bit)
+        size_t max_points;         // Stop after this many points (e.g. a header's count)
+        
+        Layout() : position_columns{0, 1, 2}, color_columns{-1, -1, -1},
+                   color_scale(1.0f), max_points(static_cast<size_t>(-1)) {}
+        
+        bool hasColors() const { return color_columns[0] >= 0; }
+    };
+    
+    // "x y z [r g b]" with colors in [0, 1]
+    static Layout xyzLayout();
+    
+    // Append the points in [begin, end) to cloud and return how many were added.
+    // A color channel is added only if some line has colors; lines without them
+    // get the default color.
+    static size_t parse(const char* begin, const char* end, const Layout& layout,
+                        PointCloud& cloud, int num_threads = 1);
+    
+    // Parse a file from offset (e.g. the end of its header) in large blocks
+    static bool parseFile(const std::string& filename, std::streamoff offset,
+                          const Layout& layout, PointCloud& cloud, int num_threads = 0);
+    
+    // Parse the next float among separators (spaces, tabs, commas, '\r') before end
+    static bool parseFloat(const char*& cursor, const char* end, float& value);
+    
+private:
+    static size_t parseLines(const char* begin, const char* end, const Layout& layout,
+                             glm::vec3* positions, PackedColor* colors, bool& found_colors,
+                             glm::vec3& min_bound, glm::vec3& max_bound);
+};
+
+} // namespace pcv
\ No newline at end of file